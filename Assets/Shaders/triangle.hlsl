@@ -20,7 +20,10 @@ struct Transform {
 [[vk::push_constant]] ConstantBuffer<Transform> u_Transform;
 
 void vert(in Vertex i, out V2F o) {
-    o.position = float4(i.position, 1.0) * u_Transform.model2world * u_Transform.projection;
+    // precise forbids the compiler from reordering or fusing these operations, so that the depth pre-pass and
+    // the main pass compute bit-identical positions, which the eEqual depth test relies on.
+    precise float4 position = float4(i.position, 1.0) * u_Transform.model2world * u_Transform.projection;
+    o.position = position;
     o.color = i.color;
 }
 
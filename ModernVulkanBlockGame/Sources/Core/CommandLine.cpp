@@ -0,0 +1,56 @@
+#include "CommandLine.h"
+
+#include <cstring>
+#include <vector>
+
+#include "Logging/Log.h"
+
+namespace Core::CommandLine {
+
+	static std::vector<const char*> g_Args;
+
+	void Parse(int argc, char** argv) {
+		// argv[0] is the executable path, we don't need it.
+		g_Args.assign(argv + 1, argv + argc);
+	}
+
+	/// <returns>Index of the given option in g_Args or -1</returns>
+	static int Find(const char* name) {
+		for (size_t i = 0; i < g_Args.size(); i++) {
+			if (strcmp(g_Args[i], name) == 0)
+				return (int)i;
+		}
+		return -1;
+	}
+
+	bool HasOption(const char* name) {
+		return Find(name) != -1;
+	}
+
+	std::string GetString(const char* name, const std::string& def) {
+		auto i = Find(name);
+		if (i == -1)
+			return def;
+
+		if (i + 1 >= (int)g_Args.size()) {
+			Log::Warning("Command line option {} expects a value", name);
+			return def;
+		}
+		return g_Args[i + 1];
+	}
+
+	int64_t GetInt(const char* name, int64_t def) {
+		auto str = GetString(name);
+		if (str.empty())
+			return def;
+
+		char* end;
+		auto res = strtoll(str.c_str(), &end, 10);
+		if (*end != '\0') {
+			Log::Warning("Command line option {} expects a number, got {}", name, str);
+			return def;
+		}
+		return res;
+	}
+
+}
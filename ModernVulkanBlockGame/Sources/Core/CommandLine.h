@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Core::CommandLine {
+
+	/// <summary>
+	/// Stores the command line arguments passed to main().
+	/// </summary>
+	///	<remarks>Must be called before any other function of this namespace.</remarks>
+	void Parse(int argc, char** argv);
+
+	/// <returns>True if the given option (e.g. "--headless") was passed</returns>
+	[[nodiscard]] bool HasOption(const char* name);
+
+	/// <returns>The value following the given option (e.g. "--bench-out file.json"), or def if the option was not passed</returns>
+	[[nodiscard]] std::string GetString(const char* name, const std::string& def = {});
+
+	/// <returns>The integer value following the given option, or def if the option was not passed or is not a number</returns>
+	[[nodiscard]] int64_t GetInt(const char* name, int64_t def = 0);
+
+}
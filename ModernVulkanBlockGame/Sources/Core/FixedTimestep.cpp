@@ -0,0 +1,30 @@
+#include "FixedTimestep.h"
+
+#include <algorithm>
+
+namespace Core {
+
+	FixedTimestep::FixedTimestep(double tickRate, uint32_t maxTicksPerUpdate)
+		: m_TickDuration{std::chrono::duration_cast<Duration>(std::chrono::duration<double>(1.0 / tickRate))},
+		  m_MaxTicksPerUpdate{std::max(maxTicksPerUpdate, 1u)},
+		  m_Accumulator{0}, m_Ticks{0}, m_Dropped{0}
+	{ }
+
+	uint32_t FixedTimestep::Advance(Duration elapsed) {
+		// Time is accumulated in integer nanoseconds, so summing up many small steps doesn't drift like floating point would.
+		m_Accumulator += std::max(elapsed, Duration{0});
+
+		auto ticks = (uint64_t)(m_Accumulator / m_TickDuration);
+		if (ticks > m_MaxTicksPerUpdate) {
+			// Keep the fraction of the next tick, but drop the time of every tick we can't afford.
+			auto dropped = m_TickDuration * (ticks - m_MaxTicksPerUpdate);
+			m_Dropped += dropped;
+			m_Accumulator -= dropped;
+			ticks = m_MaxTicksPerUpdate;
+		}
+		m_Accumulator -= m_TickDuration * ticks;
+		m_Ticks += ticks;
+		return (uint32_t)ticks;
+	}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Core {
+
+	/*
+	 * The simulation (physics, block updates, entities) advances in ticks of a fixed duration, independent of the frame rate.
+	 * This keeps its cost per second constant and its results reproducible, no matter whether frames are rendered at 30 or 240 Hz.
+	 * Real time is accumulated, and whenever a whole tick's worth has passed, a tick runs. The remainder is the fraction of a tick
+	 * the renderer interpolates by, which gives smooth motion on displays faster than the tick rate.
+	 */
+
+	/// <summary>
+	/// Decides how many fixed-duration simulation ticks have to run to keep up with real time.
+	/// </summary>
+	class FixedTimestep {
+	public:
+		using Duration = std::chrono::nanoseconds;
+
+		/// <param name="tickRate">Ticks per second</param>
+		/// <param name="maxTicksPerUpdate">
+		/// The most ticks Advance() returns at once. If the simulation can't keep up, e.g. after a hitch or while debugging,
+		/// the rest of the time is dropped and the simulation runs slower than real time, instead of running more and more ticks
+		/// to catch up, which would make it fall behind even further.
+		/// </param>
+		FixedTimestep(double tickRate, uint32_t maxTicksPerUpdate);
+
+		/// <summary>
+		/// Adds the real time that passed since the last call.
+		/// </summary>
+		/// <returns>The number of ticks to run now</returns>
+		[[nodiscard]] uint32_t Advance(Duration elapsed);
+
+		[[nodiscard]] Duration GetTickDuration() const { return m_TickDuration; }
+		[[nodiscard]] float GetTickSeconds() const { return std::chrono::duration<float>(m_TickDuration).count(); }
+		/// <returns>The number of ticks Advance() returned so far</returns>
+		[[nodiscard]] uint64_t GetTickCount() const { return m_Ticks; }
+		/// <returns>How far the current time is between the latest tick and the next one, from 0 to 1</returns>
+		[[nodiscard]] float GetAlpha() const { return (float)m_Accumulator.count() / (float)m_TickDuration.count(); }
+		/// <returns>Simulation time in seconds, including the fraction of the next tick</returns>
+		[[nodiscard]] double GetTime() const { return std::chrono::duration<double>(m_TickDuration * m_Ticks + m_Accumulator).count(); }
+		/// <returns>Real time that was skipped since the simulation couldn't keep up</returns>
+		[[nodiscard]] Duration GetDroppedTime() const { return m_Dropped; }
+
+	private:
+		Duration m_TickDuration;
+		uint32_t m_MaxTicksPerUpdate;
+		/// <summary>
+		/// Time that passed but was not simulated yet, always less than a tick after Advance().
+		/// </summary>
+		Duration m_Accumulator;
+		uint64_t m_Ticks;
+		Duration m_Dropped;
+	};
+
+}
@@ -0,0 +1,85 @@
+#include "FrameArena.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "LinearArena.h"
+#include "Trace.h"
+#include "Logging/Log.h"
+
+namespace Core::FrameArena {
+
+	/// <summary>
+	/// The arenas of a single thread, one per frame in flight.
+	/// </summary>
+	struct ThreadArenas {
+		std::vector<std::unique_ptr<LinearArena>> frames;
+		uint32_t thread;
+	};
+
+	/// <summary>
+	/// Protects g_Threads. Only taken when a thread allocates for the first time and when a frame begins.
+	/// </summary>
+	static std::mutex g_Mutex;
+	static std::vector<std::unique_ptr<ThreadArenas>> g_Threads;
+	static uint32_t g_FramesInFlight;
+	static std::atomic<uint32_t> g_CurrentFrame;
+	/// <summary>
+	/// Incremented by Terminate(), so threads notice that their arenas are gone.
+	/// </summary>
+	static std::atomic<uint32_t> g_Generation{ 1 };
+
+	static thread_local ThreadArenas* t_Arenas;
+	static thread_local uint32_t t_Generation;
+
+	void Initialize(uint32_t framesInFlight) {
+		g_FramesInFlight = framesInFlight;
+		g_CurrentFrame = 0;
+	}
+
+	void Terminate() {
+		std::lock_guard lock{ g_Mutex };
+		g_Threads.clear();
+		g_Generation.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void BeginFrame(uint32_t frameIndex) {
+		TRACE_ZONE("FrameArena::BeginFrame");
+		std::lock_guard lock{ g_Mutex };
+		for (auto& t : g_Threads)
+			t->frames[frameIndex]->Reset();
+		g_CurrentFrame.store(frameIndex, std::memory_order_release);
+	}
+
+	std::pmr::memory_resource* GetResource() {
+		if (t_Generation != g_Generation.load(std::memory_order_relaxed)) {
+			auto arenas = std::make_unique<ThreadArenas>();
+			for (uint32_t i = 0; i < g_FramesInFlight; i++)
+				arenas->frames.push_back(std::make_unique<LinearArena>(64 * 1024, MemoryTag::Transient));
+
+			std::lock_guard lock{ g_Mutex };
+			arenas->thread = (uint32_t)g_Threads.size();
+			t_Arenas = arenas.get();
+			t_Generation = g_Generation.load(std::memory_order_relaxed);
+			g_Threads.push_back(std::move(arenas));
+		}
+		return t_Arenas->frames[g_CurrentFrame.load(std::memory_order_acquire)].get();
+	}
+
+	void PrintReport() {
+		std::lock_guard lock{ g_Mutex };
+		if (g_Threads.empty())
+			return;
+
+		std::string report = "Frame arenas (peak bytes per frame in flight):";
+		for (const auto& t : g_Threads) {
+			report += Log::format("\n    Thread {:<3}", t->thread);
+			for (uint32_t i = 0; i < g_FramesInFlight; i++)
+				report += Log::format(" {:>10}", t->frames[i]->GetPeak());
+		}
+		Log::Info("{}", report);
+	}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+
+namespace Core::FrameArena {
+
+	/*
+	 * Data that only lives while a frame is recorded (draw lists, visible sets, interpolated transforms, temporary meshes)
+	 * is allocated from a LinearArena instead of the heap. Every thread has one arena per frame in flight, so allocating never takes a lock.
+	 * The arenas of a frame are reset once the fence of the frame that used them before has been waited on, which means the memory
+	 * may also be referenced by commands the GPU executes, e.g. when it is copied into a mapped buffer.
+	 *
+	 * Only the render thread and jobs it waits for before finishing the frame may allocate, since the arenas are reset by the render thread.
+	 */
+
+	/// <summary>
+	/// Creates the arenas. Threads that allocate later get their own arenas when they first call GetResource().
+	/// </summary>
+	void Initialize(uint32_t framesInFlight);
+	/// <summary>
+	/// Frees every arena. Memory allocated from them must not be used anymore.
+	/// </summary>
+	void Terminate();
+
+	/// <summary>
+	/// Resets the arenas of the given frame in flight on every thread and makes them the current ones.
+	/// Must be called after the fence of the frame that used them before has been waited on.
+	/// </summary>
+	void BeginFrame(uint32_t frameIndex);
+
+	/// <returns>The calling thread's arena of the current frame, e.g. for a std::pmr::vector</returns>
+	[[nodiscard]] std::pmr::memory_resource* GetResource();
+
+	/// <summary>
+	/// Logs how much memory the arenas of every thread needed at most.
+	/// </summary>
+	void PrintReport();
+
+}
@@ -0,0 +1,68 @@
+#include "FrameLimiter.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <ctime>
+#endif
+
+namespace Core {
+
+	FrameLimiter::FrameLimiter(double maxFps)
+		: m_Interval{0}, m_Next{Clock::now()}
+	{
+		SetMaxFps(maxFps);
+	}
+
+	void FrameLimiter::SetMaxFps(double maxFps) {
+		m_Interval = maxFps > 0.0
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxFps))
+			: Clock::duration{0};
+		m_Next = Clock::now();
+	}
+
+	void FrameLimiter::Wait() {
+		if (!IsEnabled())
+			return;
+
+		auto now = Clock::now();
+		if (m_Next > now)
+			PreciseSleepUntil(m_Next);
+
+		// Frames are scheduled on a fixed grid, so a frame that starts a bit late doesn't delay every following frame.
+		// If we fell behind by more than a frame though, we start over instead of rendering a burst of frames to catch up.
+		m_Next += m_Interval;
+		if (m_Next < now)
+			m_Next = now + m_Interval;
+	}
+
+	void PreciseSleepUntil(std::chrono::steady_clock::time_point time) {
+#ifdef _WIN32
+		// High resolution waitable timers (Windows 10 1803+) sleep with sub-millisecond precision without raising the global timer resolution.
+		thread_local HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		auto remaining = time - std::chrono::steady_clock::now();
+		if (remaining <= std::chrono::steady_clock::duration::zero())
+			return;
+		if (!timer) {
+			std::this_thread::sleep_until(time);
+			return;
+		}
+		// Negative due times are relative, in 100ns units.
+		LARGE_INTEGER due;
+		due.QuadPart = -(LONGLONG)(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count() / 100);
+		if (SetWaitableTimerEx(timer, &due, 0, nullptr, nullptr, nullptr, 0))
+			WaitForSingleObject(timer, INFINITE);
+#else
+		// steady_clock is CLOCK_MONOTONIC on Linux, so we can sleep until the absolute time, which doesn't accumulate errors when interrupted.
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+		timespec ts{ (time_t)(ns / 1'000'000'000), (long)(ns % 1'000'000'000) };
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) { }
+#endif
+	}
+
+}
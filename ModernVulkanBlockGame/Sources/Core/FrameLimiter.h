@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+
+namespace Core {
+
+	/// <summary>
+	/// Limits how often a loop runs by sleeping, e.g. to save power when rendering faster than needed.
+	/// </summary>
+	class FrameLimiter {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		/// <param name="maxFps">Maximum number of frames per second, 0 disables the limiter</param>
+		explicit FrameLimiter(double maxFps = 0.0);
+
+		void SetMaxFps(double maxFps);
+		[[nodiscard]] bool IsEnabled() const { return m_Interval.count() > 0; }
+
+		/// <summary>
+		/// Sleeps until the next frame may start. Returns immediately if the limiter is disabled or the frame is late.
+		/// </summary>
+		void Wait();
+
+	private:
+		Clock::duration m_Interval;
+		Clock::time_point m_Next;
+	};
+
+	/// <summary>
+	/// Sleeps until the given point in time, with an error far below a millisecond.
+	/// </summary>
+	/// <remarks>
+	/// std::this_thread::sleep_until() may oversleep by a whole scheduler tick (up to 15ms on Windows),
+	/// which is why frame limiters usually spin. This uses the most precise timer of the platform instead.
+	/// </remarks>
+	void PreciseSleepUntil(std::chrono::steady_clock::time_point time);
+
+}
@@ -0,0 +1,159 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+#include "MemoryTracker.h"
+#include "Logging/Log.h"
+
+namespace Core::FrameStats {
+
+	/*
+	 * Values are split into a bucket by the position of their highest bit, and into a sub bucket by the SUB_BUCKET_BITS bits below.
+	 * Values that fit into SUB_BUCKET_BITS bits get a bucket each. For larger values, every power of two shares SUB_BUCKET_COUNT / 2 buckets,
+	 * since the highest of the kept bits is always set. A bucket therefore covers at most 1 / (SUB_BUCKET_COUNT / 2) of its values.
+	 */
+
+	uint32_t Histogram::BucketIndex(uint64_t value) {
+		auto bits = (uint32_t)std::bit_width(value);
+		if (bits <= SUB_BUCKET_BITS)
+			return (uint32_t)value;
+		auto shift = bits - SUB_BUCKET_BITS;
+		return shift * (SUB_BUCKET_COUNT / 2) + (uint32_t)(value >> shift);
+	}
+
+	uint64_t Histogram::BucketStart(uint32_t index) {
+		if (index < SUB_BUCKET_COUNT)
+			return index;
+		auto shift = index / (SUB_BUCKET_COUNT / 2) - 1;
+		return (uint64_t)(index - shift * (SUB_BUCKET_COUNT / 2)) << shift;
+	}
+
+	void Histogram::Record(uint64_t value) {
+		m_Buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		m_Count.fetch_add(1, std::memory_order_relaxed);
+		m_Sum.fetch_add(value, std::memory_order_relaxed);
+
+		auto max = m_Max.load(std::memory_order_relaxed);
+		while (value > max && !m_Max.compare_exchange_weak(max, value, std::memory_order_relaxed)) { }
+	}
+
+	void Histogram::Reset() {
+		for (auto& b : m_Buckets)
+			b.store(0, std::memory_order_relaxed);
+		m_Count = 0;
+		m_Sum = 0;
+		m_Max = 0;
+	}
+
+	double Histogram::GetMean() const {
+		auto count = GetCount();
+		return count > 0 ? (double)m_Sum.load(std::memory_order_relaxed) / (double)count : 0.0;
+	}
+
+	uint64_t Histogram::GetPercentile(double p) const {
+		auto count = GetCount();
+		if (count == 0)
+			return 0;
+
+		auto target = std::max<uint64_t>((uint64_t)std::ceil(p * (double)count), 1);
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i < BUCKET_COUNT; i++) {
+			seen += m_Buckets[i].load(std::memory_order_relaxed);
+			if (seen >= target) {
+				// Report the middle of the bucket, which halves the worst case error. It can't be larger than the largest value though.
+				auto start = BucketStart(i);
+				auto end = i + 1 < BUCKET_COUNT ? BucketStart(i + 1) : UINT64_MAX;
+				return std::min(start + (end - start) / 2, GetMax());
+			}
+		}
+		return GetMax();
+	}
+
+	static std::array<Histogram, (size_t)Metric::Count> g_Histograms;
+	static std::atomic<uint64_t> g_LastPresent{ 0 };
+
+	static constexpr const char* METRIC_NAMES[] = { "cpu_frame", "fence_wait", "present_interval", "input_latency", "simulation_tick", "streaming_update" };
+	static_assert(std::size(METRIC_NAMES) == (size_t)Metric::Count);
+
+	static uint64_t Now() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Record(Metric metric, uint64_t ns) {
+		g_Histograms[(size_t)metric].Record(ns);
+	}
+
+	void RecordPresent() {
+		auto now = Now();
+		auto last = g_LastPresent.exchange(now, std::memory_order_relaxed);
+		if (last != 0)
+			Record(Metric::PresentInterval, now - last);
+	}
+
+	void Reset() {
+		for (auto& h : g_Histograms)
+			h.Reset();
+		// The next present starts a new interval instead of measuring the time since the last one before the reset.
+		g_LastPresent = 0;
+	}
+
+	Summary GetSummary(Metric metric) {
+		const auto& h = g_Histograms[(size_t)metric];
+		auto ms = [](double ns) { return ns / 1e6; };
+		return {
+			h.GetCount(),
+			ms(h.GetMean()),
+			ms((double)h.GetPercentile(0.5)),
+			ms((double)h.GetPercentile(0.95)),
+			ms((double)h.GetPercentile(0.99)),
+			ms((double)h.GetMax()),
+		};
+	}
+
+	void PrintReport() {
+		std::string report = "Frame statistics:";
+		for (size_t i = 0; i < (size_t)Metric::Count; i++) {
+			auto s = GetSummary((Metric)i);
+			report += Log::format("\n    {:<20} {:>6} samples, avg {:>7.3f} ms, p50 {:>7.3f} ms, p95 {:>7.3f} ms, p99 {:>7.3f} ms, max {:>7.3f} ms",
+				METRIC_NAMES[i], s.count, s.meanMs, s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs);
+		}
+		Log::Info("{}", report);
+	}
+
+	bool WriteJsonReport(const std::string& path) {
+		std::ofstream out{ path };
+		if (!out) {
+			Log::Error("Failed to open {} for writing", path);
+			return false;
+		}
+
+		out << "{\n";
+		for (size_t i = 0; i < (size_t)Metric::Count; i++) {
+			auto s = GetSummary((Metric)i);
+			out << Log::format("  \"{}\": {{ \"count\": {}, \"mean_ms\": {:.4f}, \"p50_ms\": {:.4f}, \"p95_ms\": {:.4f}, \"p99_ms\": {:.4f}, \"max_ms\": {:.4f} }},\n",
+				METRIC_NAMES[i], s.count, s.meanMs, s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs);
+		}
+
+		// Memory per subsystem, so benchmark runs also catch memory regressions.
+		constexpr const char* DOMAIN_NAMES[] = { "ram", "vram" };
+		out << "  \"memory\": {\n";
+		for (size_t d = 0; d < (size_t)MemoryDomain::Count; d++) {
+			out << Log::format("    \"{}\": {{\n", DOMAIN_NAMES[d]);
+			for (size_t t = 0; t < (size_t)MemoryTag::Count; t++) {
+				auto s = MemoryTracker::GetStats((MemoryTag)t, (MemoryDomain)d);
+				out << Log::format("      \"{}\": {{ \"live_bytes\": {}, \"peak_bytes\": {}, \"allocations\": {}, \"frees\": {}, \"average_allocations_per_second\": {:.1f} }}{}\n",
+					MEMORY_TAG_NAMES[t], s.liveBytes, s.peakBytes, s.allocations, s.frees, s.averageAllocationsPerSecond, t + 1 < (size_t)MemoryTag::Count ? "," : "");
+			}
+			out << Log::format("    }}{}\n", d + 1 < (size_t)MemoryDomain::Count ? "," : "");
+		}
+		out << "  }\n";
+		out << "}\n";
+		return true;
+	}
+
+}
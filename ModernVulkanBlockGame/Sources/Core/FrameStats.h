@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Core::FrameStats {
+
+	/*
+	 * Traces show what happened in a few individual frames, but performance regressions show up in the distribution of frame times:
+	 * an average hides the occasional 50ms hitch that players notice. Therefore every frame adds its timings to histograms,
+	 * which give exact counts and percentiles over an arbitrary number of frames with constant memory.
+	 */
+
+	/// <summary>
+	/// Histogram with logarithmic buckets that are subdivided linearly, like HdrHistogram.
+	/// Every value from 1ns to hours is recorded with a relative error below 1.6%.
+	/// </summary>
+	/// <remarks>Recording is lock-free and may happen on any thread.</remarks>
+	class Histogram {
+	public:
+		/// <summary>
+		/// Values below 2^SUB_BUCKET_BITS are recorded exactly, larger values keep their top SUB_BUCKET_BITS bits.
+		/// </summary>
+		static constexpr uint32_t SUB_BUCKET_BITS = 7;
+		static constexpr uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+		static constexpr uint32_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS) * (SUB_BUCKET_COUNT / 2) + SUB_BUCKET_COUNT;
+
+		void Record(uint64_t value);
+		void Reset();
+
+		[[nodiscard]] uint64_t GetCount() const { return m_Count.load(std::memory_order_relaxed); }
+		[[nodiscard]] uint64_t GetMax() const { return m_Max.load(std::memory_order_relaxed); }
+		[[nodiscard]] double GetMean() const;
+		/// <param name="p">Percentile between 0 and 1</param>
+		/// <returns>The value below which the given fraction of the recorded values lie, or 0 if nothing was recorded</returns>
+		[[nodiscard]] uint64_t GetPercentile(double p) const;
+
+	private:
+		static uint32_t BucketIndex(uint64_t value);
+		/// <returns>The smallest value that is recorded into the given bucket</returns>
+		static uint64_t BucketStart(uint32_t index);
+
+		std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_Buckets{};
+		std::atomic<uint64_t> m_Count{ 0 };
+		std::atomic<uint64_t> m_Sum{ 0 };
+		std::atomic<uint64_t> m_Max{ 0 };
+	};
+
+	enum class Metric : uint8_t {
+		/// <summary>
+		/// CPU time of a whole iteration of the main loop.
+		/// </summary>
+		CpuFrame,
+		/// <summary>
+		/// Time the CPU waited for the GPU to finish the frame that used the same per-frame resources.
+		/// </summary>
+		FenceWait,
+		/// <summary>
+		/// Time between two consecutive presents, i.e. what the player perceives as frame time.
+		/// </summary>
+		PresentInterval,
+		/// <summary>
+		/// Time from polling the input a frame is based on until the frame was presented. Doesn't include the latency of the display.
+		/// </summary>
+		InputLatency,
+		/// <summary>
+		/// CPU time of a single fixed simulation tick, see Core::FixedTimestep.
+		/// </summary>
+		SimulationTick,
+		/// <summary>
+		/// Main thread time of a chunk streaming update, see Game::ChunkStreaming.
+		/// </summary>
+		StreamingUpdate,
+		Count,
+	};
+
+	/// <summary>
+	/// Adds a duration in nanoseconds to the histogram of a metric.
+	/// </summary>
+	void Record(Metric metric, uint64_t ns);
+	/// <summary>
+	/// Records the time since the last call into Metric::PresentInterval.
+	/// </summary>
+	void RecordPresent();
+	/// <summary>
+	/// Clears every histogram, e.g. to exclude the first frames, which include startup work.
+	/// </summary>
+	void Reset();
+
+	struct Summary {
+		uint64_t count;
+		double meanMs;
+		double p50Ms;
+		double p95Ms;
+		double p99Ms;
+		double maxMs;
+	};
+
+	[[nodiscard]] Summary GetSummary(Metric metric);
+
+	/// <summary>
+	/// Prints the summary of every metric to the log.
+	/// </summary>
+	void PrintReport();
+	/// <summary>
+	/// Writes the summary of every metric and the memory usage of every subsystem as JSON, for comparing benchmark runs between builds.
+	/// </summary>
+	/// <returns>False if the file could not be written</returns>
+	bool WriteJsonReport(const std::string& path);
+
+}
@@ -0,0 +1,715 @@
+#include "IoService.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "CommandLine.h"
+#include "MemoryTracker.h"
+#include "Trace.h"
+#include "VirtualMemory.h"
+#include "Logging/Log.h"
+
+namespace Core::IoService {
+
+	/// <summary>
+	/// A request waiting for submission or in flight, with the counter it was submitted with.
+	/// </summary>
+	struct Pending {
+		Request request;
+		JobSystem::Counter* counter;
+	};
+
+	static constexpr uint32_t DEFAULT_THREADS = 4;
+
+	/// <summary>
+	/// Only changes from IoUring to Threads, if io_uring fails for good while running, see FallBackToThreads().
+	/// </summary>
+	static std::atomic<Backend> g_Backend = Backend::Threads;
+	static bool g_Running = false;
+	static std::mutex g_Mutex;
+	/// <summary>
+	/// Signals the I/O threads that there are requests.
+	/// </summary>
+	static std::condition_variable g_RequestCV;
+	/// <summary>
+	/// Signals Terminate() that every request completed.
+	/// </summary>
+	static std::condition_variable g_IdleCV;
+	/// <summary>
+	/// Requests that were not handed to io_uring or an I/O thread yet, in submission order, so chains stay together.
+	/// </summary>
+	static std::deque<Pending> g_Pending;
+	/// <summary>
+	/// Requests handed to io_uring or an I/O thread that haven't completed yet.
+	/// </summary>
+	static uint32_t g_InFlight = 0;
+	/// <summary>
+	/// The completion thread for io_uring, the I/O threads otherwise. Both after FallBackToThreads().
+	/// </summary>
+	static std::vector<std::thread> g_Threads;
+
+	static std::byte* g_Buffers = nullptr;
+	static std::vector<uint32_t> g_FreeBuffers;
+	static std::mutex g_BufferMutex;
+	/// <summary>
+	/// Whether io_uring knows the buffers. Otherwise they are used like any other memory.
+	/// </summary>
+	static bool g_BuffersRegistered = false;
+
+	static std::atomic<uint64_t> g_Reads;
+	static std::atomic<uint64_t> g_Writes;
+	static std::atomic<uint64_t> g_BytesRead;
+	static std::atomic<uint64_t> g_BytesWritten;
+	static std::atomic<uint64_t> g_Syncs;
+	static std::atomic<uint64_t> g_Failed;
+	static std::atomic<uint64_t> g_Submissions;
+	static std::atomic<uint64_t> g_Deferred;
+
+	static void StartIoThreads();
+
+	/// <summary>
+	/// Records a completed request and hands its callback to the job system.
+	/// </summary>
+	static void Complete(Pending& pending, int64_t result) {
+		auto& request = pending.request;
+		if (result < 0) {
+			g_Failed.fetch_add(1, std::memory_order_relaxed);
+		} else if (request.op == Op::Read) {
+			g_Reads.fetch_add(1, std::memory_order_relaxed);
+			g_BytesRead.fetch_add((uint64_t)result, std::memory_order_relaxed);
+		} else if (request.op == Op::Sync) {
+			g_Syncs.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			g_Writes.fetch_add(1, std::memory_order_relaxed);
+			g_BytesWritten.fetch_add((uint64_t)result, std::memory_order_relaxed);
+		}
+
+		// The callback job retains the counter before the request releases it, so it never drops to zero in between.
+		if (request.callback)
+			JobSystem::Submit([callback = std::move(request.callback), result] { callback(result); }, pending.counter);
+		if (pending.counter)
+			JobSystem::Release(*pending.counter);
+	}
+
+#ifndef _WIN32
+	/*
+	 * io_uring consists of two ring buffers shared with the kernel: we append submission queue entries (SQEs) to the submission queue
+	 * and tell the kernel about them with io_uring_enter(), the kernel appends a completion queue entry (CQE) for every finished request.
+	 * Each side only ever writes the tail of the ring it produces and the head of the ring it consumes, so the only synchronization needed
+	 * is an acquire load of the other side's index and a release store of our own.
+	 * The rings are set up with raw system calls, which keeps liburing out of the dependencies.
+	 */
+
+	/// <summary>
+	/// Maximum number of requests in flight. The completion queue is twice as large, so it can't overflow.
+	/// </summary>
+	static constexpr uint32_t QUEUE_DEPTH = 256;
+	/// <summary>
+	/// User data of the no-op that wakes the completion thread on shutdown.
+	/// </summary>
+	static constexpr uint64_t WAKE_UP = UINT64_MAX;
+
+	struct Ring {
+		int fd = -1;
+		void* rings = nullptr;
+		size_t ringsSize = 0;
+		io_uring_sqe* sqes = nullptr;
+		size_t sqesSize = 0;
+
+		uint32_t* sqHead;
+		uint32_t* sqTail;
+		uint32_t sqMask;
+		uint32_t* sqArray;
+		uint32_t* cqHead;
+		uint32_t* cqTail;
+		uint32_t cqMask;
+		io_uring_cqe* cqes;
+	};
+
+	static Ring g_Ring;
+	/// <summary>
+	/// Requests in flight, indexed by the user data of their SQE.
+	/// </summary>
+	static std::vector<Pending> g_Slots;
+	static std::vector<uint32_t> g_FreeSlots;
+
+	static int Enter(uint32_t toSubmit, uint32_t minComplete, uint32_t flags) {
+		return (int)syscall(__NR_io_uring_enter, g_Ring.fd, toSubmit, minComplete, flags, nullptr, 0);
+	}
+
+	/// <returns>True if the kernel supports every operation we submit. IORING_OP_READ and IORING_OP_WRITE only exist since Linux 5.6.</returns>
+	static bool SupportsOps(int fd) {
+		static constexpr uint8_t OPS[] = { IORING_OP_NOP, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED, IORING_OP_FSYNC };
+
+		// The probe itself was added in Linux 5.6 as well, so if it fails, the operations are missing too.
+		std::vector<std::byte> storage(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+		auto* probe = (io_uring_probe*)storage.data();
+		if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+			return false;
+		return std::all_of(std::begin(OPS), std::end(OPS), [probe](uint8_t op) {
+			return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+		});
+	}
+
+	static bool CreateRing() {
+		io_uring_params params{};
+		int fd = (int)syscall(__NR_io_uring_setup, QUEUE_DEPTH, &params);
+		if (fd < 0) {
+			Log::Warning("io_uring is not available (errno {}), using I/O threads", errno);
+			return false;
+		}
+		// Both rings share a single mapping since Linux 5.4. Every request would fail with EINVAL on a kernel lacking an operation.
+		if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !SupportsOps(fd)) {
+			Log::Warning("io_uring is too old, using I/O threads");
+			close(fd);
+			return false;
+		}
+
+		auto& ring = g_Ring;
+		ring.fd = fd;
+		ring.ringsSize = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(uint32_t), params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+		ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		auto* rings = mmap(nullptr, ring.ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		auto* sqes = mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+		if (rings == MAP_FAILED || sqes == MAP_FAILED) {
+			Log::Warning("Failed to map the io_uring queues (errno {}), using I/O threads", errno);
+			if (rings != MAP_FAILED)
+				munmap(rings, ring.ringsSize);
+			if (sqes != MAP_FAILED)
+				munmap(sqes, ring.sqesSize);
+			close(fd);
+			ring = {};
+			return false;
+		}
+
+		ring.rings = rings;
+		ring.sqes = (io_uring_sqe*)sqes;
+		auto* base = (std::byte*)rings;
+		ring.sqHead = (uint32_t*)(base + params.sq_off.head);
+		ring.sqTail = (uint32_t*)(base + params.sq_off.tail);
+		ring.sqMask = *(uint32_t*)(base + params.sq_off.ring_mask);
+		ring.sqArray = (uint32_t*)(base + params.sq_off.array);
+		ring.cqHead = (uint32_t*)(base + params.cq_off.head);
+		ring.cqTail = (uint32_t*)(base + params.cq_off.tail);
+		ring.cqMask = *(uint32_t*)(base + params.cq_off.ring_mask);
+		ring.cqes = (io_uring_cqe*)(base + params.cq_off.cqes);
+
+		g_Slots.resize(QUEUE_DEPTH);
+		g_FreeSlots.clear();
+		for (uint32_t i = QUEUE_DEPTH; i > 0; i--)
+			g_FreeSlots.push_back(i - 1);
+		return true;
+	}
+
+	static void DestroyRing() {
+		munmap(g_Ring.sqes, g_Ring.sqesSize);
+		munmap(g_Ring.rings, g_Ring.ringsSize);
+		close(g_Ring.fd);
+		g_Ring = {};
+		g_Slots.clear();
+		g_FreeSlots.clear();
+	}
+
+	/// <summary>
+	/// Registers the buffers with io_uring, so reads and writes into them skip pinning their pages.
+	/// </summary>
+	static void RegisterBuffers() {
+		if (!g_Buffers)
+			return;
+		std::vector<iovec> iov(BUFFER_COUNT);
+		for (uint32_t i = 0; i < BUFFER_COUNT; i++)
+			iov[i] = { g_Buffers + (size_t)i * BUFFER_SIZE, BUFFER_SIZE };
+		g_BuffersRegistered = syscall(__NR_io_uring_register, g_Ring.fd, IORING_REGISTER_BUFFERS, iov.data(), BUFFER_COUNT) == 0;
+		// Usually the locked memory limit (ulimit -l) is too small. The buffers still work, just without the benefit.
+		if (!g_BuffersRegistered)
+			Log::Warning("Failed to register I/O buffers (errno {})", errno);
+	}
+
+	/// <summary>
+	/// Takes the SQEs the kernel didn't consume off the submission queue again and fails their requests.
+	/// </summary>
+	///	<remarks>g_Mutex must be held.</remarks>
+	static void FailUnsubmitted(int error, std::vector<std::pair<Pending, int64_t>>& completed) {
+		auto& ring = g_Ring;
+		auto head = std::atomic_ref{ *ring.sqHead }.load(std::memory_order_acquire);
+		auto tail = std::atomic_ref{ *ring.sqTail }.load(std::memory_order_relaxed);
+		for (auto i = head; i != tail; i++) {
+			auto slot = ring.sqes[ring.sqArray[i & ring.sqMask]].user_data;
+			if (slot == WAKE_UP)
+				continue;
+			completed.emplace_back(std::move(g_Slots[slot]), -(int64_t)error);
+			g_FreeSlots.push_back((uint32_t)slot);
+			g_InFlight--;
+		}
+		// Only io_uring_enter() makes the kernel read the queue, and every call of it is made under g_Mutex, so the head can't move meanwhile.
+		std::atomic_ref{ *ring.sqTail }.store(head, std::memory_order_release);
+		if (g_InFlight == 0 && g_Pending.empty())
+			g_IdleCV.notify_all();
+	}
+
+	/// <summary>
+	/// Appends pending requests to the submission queue while there are free slots, and submits them with a single system call.
+	/// A chain is only started if it fits completely, since the kernel only links SQEs submitted together.
+	/// </summary>
+	/// <param name="completed">Receives the requests that could not be submitted, to be completed once g_Mutex was released</param>
+	///	<remarks>g_Mutex must be held.</remarks>
+	static void FlushRing(std::vector<std::pair<Pending, int64_t>>& completed) {
+		auto& ring = g_Ring;
+		auto tail = std::atomic_ref{ *ring.sqTail }.load(std::memory_order_relaxed);
+		uint32_t added = 0;
+		while (!g_Pending.empty()) {
+			size_t chain = 1;
+			while (chain < g_Pending.size() && g_Pending[chain - 1].request.linked)
+				chain++;
+			if (chain > g_FreeSlots.size())
+				break;
+
+			for (size_t i = 0; i < chain; i++) {
+				auto slot = g_FreeSlots.back();
+				g_FreeSlots.pop_back();
+				g_Slots[slot] = std::move(g_Pending.front());
+				g_Pending.pop_front();
+
+				const auto& r = g_Slots[slot].request;
+				auto fixed = r.buffer != NO_BUFFER && g_BuffersRegistered;
+				auto& sqe = ring.sqes[tail & ring.sqMask];
+				memset(&sqe, 0, sizeof(sqe));
+				sqe.fd = r.file;
+				if (r.op == Op::Sync) {
+					sqe.opcode = IORING_OP_FSYNC;
+					sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+				} else {
+					if (r.op == Op::Read)
+						sqe.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+					else
+						sqe.opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+					sqe.off = r.offset;
+					sqe.addr = (uint64_t)(uintptr_t)r.data;
+					sqe.len = r.size;
+					sqe.buf_index = fixed ? (uint16_t)r.buffer : 0;
+				}
+				sqe.flags = r.linked ? IOSQE_IO_LINK : 0;
+				sqe.user_data = slot;
+				ring.sqArray[tail & ring.sqMask] = tail & ring.sqMask;
+				tail++;
+				added++;
+			}
+		}
+		std::atomic_ref{ *ring.sqTail }.store(tail, std::memory_order_release);
+		g_InFlight += added;
+		// Submits everything the kernel didn't consume yet, including entries a failed call left behind.
+		auto toSubmit = tail - std::atomic_ref{ *ring.sqHead }.load(std::memory_order_acquire);
+		if (toSubmit == 0)
+			return;
+		int res;
+		do {
+			res = Enter(toSubmit, 0, 0);
+		} while (res < 0 && errno == EINTR);
+		// A call that submitted some of the entries returns their count instead of an error, the rest is treated as if the kernel was busy.
+		auto error = res < 0 ? errno : EAGAIN;
+		g_Submissions.fetch_add(1, std::memory_order_relaxed);
+
+		auto left = tail - std::atomic_ref{ *ring.sqHead }.load(std::memory_order_acquire);
+		if (left == 0)
+			return;
+		/*
+		 * Running out of kernel resources (EAGAIN, EBUSY) passes. As long as some requests are in the kernel, the completion thread
+		 * calls us again once one of them completes, which submits the rest. Otherwise nothing would ever complete, and waiting
+		 * for the requests would hang (e.g. Terminate()), so they fail instead, just like on any other error.
+		 */
+		if ((error == EAGAIN || error == EBUSY) && g_InFlight > left)
+			return;
+		Log::Error("Failed to submit {} I/O requests (errno {})", left, error);
+		FailUnsubmitted(error, completed);
+		// Failing them freed their slots, requests waiting for one can go now.
+		if (!g_Pending.empty())
+			FlushRing(completed);
+	}
+
+	/// <summary>
+	/// Gives up on io_uring after the completion thread failed to wait for completions, and hands every pending request to I/O threads.
+	/// </summary>
+	/// <param name="completed">Receives the requests that were in flight, to be completed once g_Mutex was released</param>
+	///	<remarks>g_Mutex must be held.</remarks>
+	static void FallBackToThreads(int error, std::vector<std::pair<Pending, int64_t>>& completed) {
+		Log::Error("Failed to wait for I/O completions (errno {}), switching to I/O threads", error);
+
+		/*
+		 * The completions of requests in the kernel can't be reaped anymore, so they fail. Destroying the ring cancels the ones
+		 * that haven't finished yet. Requests still waiting for a slot were never submitted and run on the I/O threads instead.
+		 */
+		std::vector<bool> isFree(QUEUE_DEPTH);
+		for (auto slot : g_FreeSlots)
+			isFree[slot] = true;
+		for (uint32_t slot = 0; slot < QUEUE_DEPTH; slot++) {
+			if (!isFree[slot])
+				completed.emplace_back(std::move(g_Slots[slot]), -(int64_t)error);
+		}
+		g_InFlight = 0;
+		DestroyRing();
+		g_BuffersRegistered = false;
+
+		// Once Terminate() stopped the service, nothing is left to execute.
+		if (g_Running)
+			StartIoThreads();
+		if (g_Pending.empty())
+			g_IdleCV.notify_all();
+	}
+
+	static void CompletionMain() {
+		Trace::SetThreadName("I/O Completion");
+		std::vector<std::pair<Pending, int64_t>> completed;
+		auto& ring = g_Ring;
+		bool stop = false;
+		while (!stop) {
+			if (Enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+				auto error = errno;
+				// The kernel may be short of resources for a moment, e.g. when the completion queue overflowed.
+				if (error == EAGAIN || error == EBUSY) {
+					std::this_thread::yield();
+				} else {
+					{
+						std::lock_guard lock{ g_Mutex };
+						FallBackToThreads(error, completed);
+					}
+					g_RequestCV.notify_all();
+					for (auto& [pending, result] : completed)
+						Complete(pending, result);
+					return;
+				}
+			}
+
+			{
+				std::lock_guard lock{ g_Mutex };
+				auto head = std::atomic_ref{ *ring.cqHead }.load(std::memory_order_relaxed);
+				auto tail = std::atomic_ref{ *ring.cqTail }.load(std::memory_order_acquire);
+				for (; head != tail; head++) {
+					const auto& cqe = ring.cqes[head & ring.cqMask];
+					if (cqe.user_data == WAKE_UP) {
+						stop = true;
+						continue;
+					}
+					auto slot = (uint32_t)cqe.user_data;
+					completed.emplace_back(std::move(g_Slots[slot]), cqe.res);
+					g_FreeSlots.push_back(slot);
+					g_InFlight--;
+				}
+				std::atomic_ref{ *ring.cqHead }.store(head, std::memory_order_release);
+
+				// Requests that had to wait for a free slot can go now, and those a failed submission left behind.
+				FlushRing(completed);
+				if (g_InFlight == 0 && g_Pending.empty())
+					g_IdleCV.notify_all();
+			}
+
+			for (auto& [pending, result] : completed)
+				Complete(pending, result);
+			completed.clear();
+		}
+	}
+
+	/// <summary>
+	/// Wakes the completion thread with a no-op, so it notices the shutdown.
+	/// </summary>
+	///	<remarks>g_Mutex must be held.</remarks>
+	static void WakeCompletionThread() {
+		auto tail = std::atomic_ref{ *g_Ring.sqTail }.load(std::memory_order_relaxed);
+		auto& sqe = g_Ring.sqes[tail & g_Ring.sqMask];
+		memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = IORING_OP_NOP;
+		sqe.user_data = WAKE_UP;
+		g_Ring.sqArray[tail & g_Ring.sqMask] = tail & g_Ring.sqMask;
+		std::atomic_ref{ *g_Ring.sqTail }.store(tail + 1, std::memory_order_release);
+		while (Enter(1, 0, 0) < 0 && errno == EINTR) {}
+	}
+#endif
+
+	/// <summary>
+	/// Executes a request on the calling thread, blocking until it completed.
+	/// </summary>
+	/// <returns>The bytes transferred or a negative error code, see Callback</returns>
+	static int64_t Execute(const Request& r) {
+		TRACE_ZONE("I/O Request");
+		if (r.op == Op::Sync) {
+#ifdef _WIN32
+			return FlushFileBuffers(r.file) ? 0 : -(int64_t)GetLastError();
+#else
+			int res;
+			do {
+				res = fdatasync(r.file);
+			} while (res < 0 && errno == EINTR);
+			return res < 0 ? -(int64_t)errno : 0;
+#endif
+		}
+
+		auto* bytes = (std::byte*)r.data;
+		uint32_t done = 0;
+		while (done < r.size) {
+#ifdef _WIN32
+			OVERLAPPED overlapped{};
+			overlapped.Offset = (DWORD)(r.offset + done);
+			overlapped.OffsetHigh = (DWORD)((r.offset + done) >> 32);
+			DWORD n = 0;
+			auto ok = r.op == Op::Read ? ::ReadFile(r.file, bytes + done, r.size - done, &n, &overlapped) : WriteFile(r.file, bytes + done, r.size - done, &n, &overlapped);
+			if (!ok) {
+				auto error = GetLastError();
+				if (error == ERROR_HANDLE_EOF)
+					break;
+				return -(int64_t)error;
+			}
+#else
+			auto n = r.op == Op::Read ? pread(r.file, bytes + done, r.size - done, (off_t)(r.offset + done)) : pwrite(r.file, bytes + done, r.size - done, (off_t)(r.offset + done));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n < 0)
+				return -(int64_t)errno;
+#endif
+			// The end of the file was reached.
+			if (n == 0)
+				break;
+			done += (uint32_t)n;
+		}
+		return done;
+	}
+
+	static void IoThreadMain(uint32_t index) {
+		Trace::SetThreadName(Log::format("I/O {}", index));
+		std::vector<Pending> chain;
+		while (true) {
+			{
+				std::unique_lock lock{ g_Mutex };
+				g_RequestCV.wait(lock, [] { return !g_Pending.empty() || !g_Running; });
+				if (g_Pending.empty())
+					return;
+				// A chain is executed by a single thread, which keeps its requests in order.
+				do {
+					chain.push_back(std::move(g_Pending.front()));
+					g_Pending.pop_front();
+				} while (chain.back().request.linked && !g_Pending.empty());
+				g_InFlight += (uint32_t)chain.size();
+			}
+
+			auto canceled = false;
+			for (auto& pending : chain) {
+				auto result = canceled ? -(int64_t)ECANCELED : Execute(pending.request);
+				if (pending.request.linked && result != pending.request.size)
+					canceled = true;
+				Complete(pending, result);
+			}
+
+			std::lock_guard lock{ g_Mutex };
+			g_InFlight -= (uint32_t)chain.size();
+			if (g_InFlight == 0 && g_Pending.empty())
+				g_IdleCV.notify_all();
+			chain.clear();
+		}
+	}
+
+	static void CreateBuffers() {
+		size_t size = (size_t)BUFFER_SIZE * BUFFER_COUNT;
+		auto* p = VirtualMemory::Reserve(size);
+		if (!p || !VirtualMemory::Commit(p, size, false)) {
+			Log::Warning("Failed to allocate I/O buffers");
+			if (p)
+				VirtualMemory::Release(p, size);
+			return;
+		}
+		g_Buffers = (std::byte*)p;
+		MemoryTracker::RecordAlloc(MemoryTag::General, MemoryDomain::Cpu, size);
+		g_FreeBuffers.clear();
+		for (uint32_t i = BUFFER_COUNT; i > 0; i--)
+			g_FreeBuffers.push_back(i - 1);
+	}
+
+	/// <summary>
+	/// Switches to the Threads backend and starts the I/O threads.
+	/// </summary>
+	static void StartIoThreads() {
+		g_Backend = Backend::Threads;
+		auto numThreads = (uint32_t)std::clamp<int64_t>(CommandLine::GetInt("--io-threads", DEFAULT_THREADS), 1, 64);
+		for (uint32_t i = 0; i < numThreads; i++)
+			g_Threads.emplace_back(IoThreadMain, i);
+		Log::Info("I/O service: {} I/O threads", numThreads);
+	}
+
+	void Initialize() {
+		auto backend = CommandLine::GetString("--io-backend");
+		CreateBuffers();
+		g_Running = true;
+
+#ifndef _WIN32
+		if (backend != "threads" && CreateRing()) {
+			g_Backend = Backend::IoUring;
+			RegisterBuffers();
+			g_Threads.emplace_back(CompletionMain);
+			Log::Info("I/O service: io_uring with {} requests in flight", QUEUE_DEPTH);
+			return;
+		}
+#endif
+
+		StartIoThreads();
+	}
+
+	void Terminate() {
+		{
+			std::unique_lock lock{ g_Mutex };
+			g_IdleCV.wait(lock, [] { return g_InFlight == 0 && g_Pending.empty(); });
+			g_Running = false;
+#ifndef _WIN32
+			if (g_Backend == Backend::IoUring)
+				WakeCompletionThread();
+#endif
+		}
+		g_RequestCV.notify_all();
+		for (auto& t : g_Threads)
+			t.join();
+		g_Threads.clear();
+
+#ifndef _WIN32
+		// Closing the ring also unregisters the buffers.
+		if (g_Backend == Backend::IoUring)
+			DestroyRing();
+#endif
+		g_BuffersRegistered = false;
+		if (g_Buffers) {
+			size_t size = (size_t)BUFFER_SIZE * BUFFER_COUNT;
+			VirtualMemory::Release(g_Buffers, size);
+			MemoryTracker::RecordFree(MemoryTag::General, MemoryDomain::Cpu, size);
+			g_Buffers = nullptr;
+		}
+		g_FreeBuffers.clear();
+	}
+
+	Backend GetBackend() {
+		return g_Backend;
+	}
+
+	void Submit(std::span<Request> requests, JobSystem::Counter* counter) {
+		if (requests.empty())
+			return;
+		// A chain can't continue into the next batch.
+		requests.back().linked = false;
+
+#ifndef _WIN32
+		std::vector<std::pair<Pending, int64_t>> failed;
+#endif
+		Backend backend;
+		{
+			std::lock_guard lock{ g_Mutex };
+			for (auto& r : requests) {
+				if (counter)
+					JobSystem::Retain(*counter);
+				g_Pending.push_back({ std::move(r), counter });
+			}
+			// Read under the lock, as the completion thread may fall back to I/O threads.
+			backend = g_Backend;
+#ifndef _WIN32
+			if (backend == Backend::IoUring) {
+				FlushRing(failed);
+				g_Deferred.fetch_add(std::min(g_Pending.size(), requests.size()), std::memory_order_relaxed);
+			}
+#endif
+		}
+#ifndef _WIN32
+		if (backend == Backend::IoUring) {
+			for (auto& [pending, result] : failed)
+				Complete(pending, result);
+			return;
+		}
+#endif
+		g_RequestCV.notify_all();
+	}
+
+	void Submit(Request request, JobSystem::Counter* counter) {
+		Submit(std::span{ &request, 1 }, counter);
+	}
+
+	Buffer AcquireBuffer() {
+		std::lock_guard lock{ g_BufferMutex };
+		if (g_FreeBuffers.empty())
+			return { nullptr, NO_BUFFER };
+		auto index = g_FreeBuffers.back();
+		g_FreeBuffers.pop_back();
+		return { g_Buffers + (size_t)index * BUFFER_SIZE, index };
+	}
+
+	void ReleaseBuffer(uint32_t index) {
+		std::lock_guard lock{ g_BufferMutex };
+		g_FreeBuffers.push_back(index);
+	}
+
+	bool ReadFile(const std::string& path, std::vector<char>& out) {
+		uint64_t size;
+#ifdef _WIN32
+		auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		size = (uint64_t)fileSize.QuadPart;
+#else
+		int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file < 0)
+			return false;
+		struct stat st;
+		fstat(file, &st);
+		size = (uint64_t)st.st_size;
+#endif
+
+		int64_t result = -1;
+		if (size <= UINT32_MAX) {
+			out.resize(size);
+			JobSystem::Counter counter;
+			Submit({ Op::Read, file, 0, out.data(), (uint32_t)size, NO_BUFFER, false, [&result](int64_t r) { result = r; } }, &counter);
+			JobSystem::Wait(counter);
+		}
+
+#ifdef _WIN32
+		CloseHandle(file);
+#else
+		close(file);
+#endif
+		return result == (int64_t)size;
+	}
+
+	Stats GetStats() {
+		return {
+			g_Reads.load(std::memory_order_relaxed),
+			g_Writes.load(std::memory_order_relaxed),
+			g_BytesRead.load(std::memory_order_relaxed),
+			g_BytesWritten.load(std::memory_order_relaxed),
+			g_Syncs.load(std::memory_order_relaxed),
+			g_Failed.load(std::memory_order_relaxed),
+			g_Submissions.load(std::memory_order_relaxed),
+			g_Deferred.load(std::memory_order_relaxed),
+		};
+	}
+
+	void PrintReport() {
+		auto s = GetStats();
+		Log::Info("I/O service ({}): {} reads ({:.1f} MiB), {} writes ({:.1f} MiB), {} syncs, {} failed, {} submissions, {} deferred",
+			g_Backend == Backend::IoUring ? "io_uring" : "threads", s.reads, (double)s.bytesRead / (1024.0 * 1024.0),
+			s.writes, (double)s.bytesWritten / (1024.0 * 1024.0), s.syncs, s.failed, s.submissions, s.deferred);
+	}
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+
+namespace Core::IoService {
+
+	/*
+	 * Reading or writing a file with read()/write() blocks the calling thread until the storage delivered. When worker threads
+	 * do that, every request in flight costs a worker, so throughput depends on the number of threads rather than on what the disk can do,
+	 * and the jobs queued behind them (e.g. terrain generation) stall meanwhile.
+	 *
+	 * The I/O service instead takes requests (read or write a range of a file) and calls back once they completed:
+	 * - On Linux it uses io_uring. Requests are written into a queue shared with the kernel and submitted in batches with a single system call,
+	 *   so hundreds of reads can be in flight without a single thread waiting for them. A completion thread reaps the results.
+	 * - Elsewhere, or if io_uring is unavailable (e.g. disabled by a container), a few dedicated I/O threads execute the requests with pread/pwrite.
+	 *   That still keeps the workers free, it just needs a thread per request in flight.
+	 * Either way, callbacks run as jobs on the job system, so they may do real work like decoding a chunk.
+	 *
+	 * Registered buffers are a fixed set of buffers that io_uring maps once, instead of pinning the pages of every request again.
+	 * Code that reads often (e.g. chunk loads) acquires one for each request and releases it in the callback.
+	 */
+
+	enum class Backend : uint8_t {
+		IoUring,
+		Threads,
+	};
+
+#ifdef _WIN32
+	using FileHandle = void*;
+#else
+	using FileHandle = int;
+#endif
+
+	enum class Op : uint8_t {
+		Read,
+		Write,
+		/// <summary>
+		/// Forces the data written to the file so far to the disk, like fdatasync(). data and size are ignored, the result is 0 on success.
+		/// Linked behind a write, it makes the write durable without a thread waiting for the disk.
+		/// </summary>
+		Sync,
+	};
+
+	/// <summary>
+	/// Index of a registered buffer, or NO_BUFFER for memory that isn't one.
+	/// </summary>
+	inline constexpr uint32_t NO_BUFFER = UINT32_MAX;
+	inline constexpr uint32_t BUFFER_SIZE = 128 * 1024;
+	inline constexpr uint32_t BUFFER_COUNT = 64;
+
+	/// <summary>
+	/// Called with the number of bytes transferred, or a negative error code (errno on Linux).
+	/// A read may transfer fewer bytes than requested at the end of the file.
+	/// </summary>
+	using Callback = std::function<void(int64_t result)>;
+
+	struct Request {
+		Op op;
+		FileHandle file;
+		uint64_t offset;
+		/// <summary>
+		/// Destination of a read or source of a write. Must stay valid until the request completed.
+		/// </summary>
+		void* data;
+		uint32_t size;
+		/// <summary>
+		/// The registered buffer containing data, or NO_BUFFER.
+		/// </summary>
+		uint32_t buffer = NO_BUFFER;
+		/// <summary>
+		/// The next request of the batch only starts once this one transferred every byte. If it doesn't, the rest of the chain fails with ECANCELED.
+		/// Used to write data before the index pointing at it.
+		/// </summary>
+		bool linked = false;
+		/// <summary>
+		/// Runs as a job once the request completed. May be empty.
+		/// </summary>
+		Callback callback;
+	};
+
+	struct Buffer {
+		std::byte* data;
+		uint32_t index;
+	};
+
+	/// <summary>
+	/// Chooses the backend ("--io-backend uring|threads", "--io-threads") and starts the completion or I/O threads.
+	/// </summary>
+	///	<remarks>Must be called after Core::JobSystem::Initialize()</remarks>
+	void Initialize();
+	/// <summary>
+	/// Waits for every request and stops the threads.
+	/// </summary>
+	///	<remarks>Must be called before Core::JobSystem::Terminate(), since callbacks run as jobs.</remarks>
+	void Terminate();
+
+	[[nodiscard]] Backend GetBackend();
+
+	/// <summary>
+	/// Submits a batch of requests. Never blocks on the I/O itself: if the queue is full, requests wait until earlier ones completed.
+	/// </summary>
+	/// <param name="counter">Optional counter that stays incremented for every request until its callback finished</param>
+	void Submit(std::span<Request> requests, JobSystem::Counter* counter = nullptr);
+	void Submit(Request request, JobSystem::Counter* counter = nullptr);
+
+	/// <summary>
+	/// Takes a registered buffer of BUFFER_SIZE bytes. Thread-safe.
+	/// </summary>
+	/// <returns>The buffer, or { nullptr, NO_BUFFER } if every one is in use</returns>
+	[[nodiscard]] Buffer AcquireBuffer();
+	void ReleaseBuffer(uint32_t index);
+
+	/// <summary>
+	/// Reads a whole file through the service, e.g. an asset. The calling thread executes jobs while waiting.
+	/// </summary>
+	/// <returns>False if the file could not be opened or read</returns>
+	bool ReadFile(const std::string& path, std::vector<char>& out);
+
+	struct Stats {
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t bytesRead;
+		uint64_t bytesWritten;
+		uint64_t syncs;
+		uint64_t failed;
+		/// <summary>
+		/// System calls submitting requests (io_uring only), fewer than requests when they are batched.
+		/// </summary>
+		uint64_t submissions;
+		/// <summary>
+		/// Requests that had to wait for room in the queue.
+		/// </summary>
+		uint64_t deferred;
+	};
+
+	[[nodiscard]] Stats GetStats();
+	/// <summary>
+	/// Prints the stats to the log.
+	/// </summary>
+	void PrintReport();
+
+}
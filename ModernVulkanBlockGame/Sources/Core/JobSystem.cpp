@@ -0,0 +1,153 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Trace.h"
+#include "Logging/Log.h"
+
+namespace Core::JobSystem {
+
+	struct Job {
+		std::function<void()> fn;
+		Counter* counter;
+	};
+
+	static std::vector<std::thread> g_Workers;
+	/// <summary>
+	/// Jobs waiting for execution. A single locked queue is plenty for the coarse jobs (startup steps, chunk generation etc.) we run.
+	/// </summary>
+	static std::deque<Job> g_Queue;
+	static std::mutex g_QueueMutex;
+	static std::condition_variable g_QueueCV;
+	static bool g_Running = false;
+
+	static thread_local uint32_t t_ThreadIndex = 0;
+
+	/// <summary>
+	/// Executes a job and signals its counter.
+	/// </summary>
+	static void Execute(Job& job) {
+		TRACE_ZONE("Job");
+		job.fn();
+		if (job.counter)
+			Release(*job.counter);
+	}
+
+	/// <summary>
+	/// Pops a job from the queue without blocking.
+	/// </summary>
+	/// <returns>True if a job was executed</returns>
+	static bool TryExecuteOne() {
+		Job job;
+		{
+			std::lock_guard lock{ g_QueueMutex };
+			if (g_Queue.empty())
+				return false;
+			job = std::move(g_Queue.front());
+			g_Queue.pop_front();
+		}
+		Execute(job);
+		return true;
+	}
+
+	static void WorkerMain(uint32_t index) {
+		t_ThreadIndex = index;
+		Trace::SetThreadName(Log::format("Worker {}", index));
+
+		while (true) {
+			Job job;
+			{
+				std::unique_lock lock{ g_QueueMutex };
+				g_QueueCV.wait(lock, [] { return !g_Queue.empty() || !g_Running; });
+				// Pending jobs are still finished on shutdown, so that nobody waits on a counter forever.
+				if (g_Queue.empty())
+					return;
+				job = std::move(g_Queue.front());
+				g_Queue.pop_front();
+			}
+			Execute(job);
+		}
+	}
+
+	void Initialize(uint32_t numWorkers) {
+		if (numWorkers == 0) {
+			auto hw = std::thread::hardware_concurrency();
+			numWorkers = hw > 1 ? hw - 1 : 1;
+		}
+
+		g_Running = true;
+		g_Workers.reserve(numWorkers);
+		for (uint32_t i = 0; i < numWorkers; i++)
+			g_Workers.emplace_back(WorkerMain, i + 1);
+	}
+
+	void Terminate() {
+		{
+			std::lock_guard lock{ g_QueueMutex };
+			g_Running = false;
+		}
+		g_QueueCV.notify_all();
+
+		for (auto& w : g_Workers)
+			w.join();
+		g_Workers.clear();
+	}
+
+	uint32_t GetWorkerCount() {
+		return (uint32_t)g_Workers.size();
+	}
+
+	uint32_t GetThreadIndex() {
+		return t_ThreadIndex;
+	}
+
+	void Submit(std::function<void()> job, Counter* counter) {
+		if (counter)
+			Retain(*counter);
+
+		{
+			std::lock_guard lock{ g_QueueMutex };
+			g_Queue.push_back({ std::move(job), counter });
+		}
+		g_QueueCV.notify_one();
+	}
+
+	void Retain(Counter& counter) {
+		counter.value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Release(Counter& counter) {
+		if (counter.value.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			counter.value.notify_all();
+	}
+
+	void Wait(Counter& counter) {
+		while (true) {
+			auto val = counter.value.load(std::memory_order_acquire);
+			if (val == 0)
+				return;
+
+			// Help out instead of idling, this also guarantees progress when there are no workers.
+			if (!TryExecuteOne())
+				counter.value.wait(val, std::memory_order_acquire);
+		}
+	}
+
+	void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& fn) {
+		if (batchSize == 0)
+			batchSize = 1;
+
+		Counter counter;
+		for (uint32_t begin = 0; begin < count; begin += batchSize) {
+			auto end = std::min(begin + batchSize, count);
+			Submit([&fn, begin, end] { fn(begin, end); }, &counter);
+		}
+		Wait(counter);
+	}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace Core::JobSystem {
+
+	/// <summary>
+	/// Counter that is incremented for every job submitted with it and decremented once that job finished.
+	/// Used to wait for a group of jobs.
+	/// </summary>
+	struct Counter {
+		std::atomic<uint32_t> value{ 0 };
+	};
+
+	/// <summary>
+	/// Starts the worker threads.
+	/// </summary>
+	/// <param name="numWorkers">Number of worker threads, 0 chooses one worker per hardware thread except the main thread</param>
+	///	<remarks>Must be called before any job is submitted.</remarks>
+	void Initialize(uint32_t numWorkers = 0);
+
+	/// <summary>
+	/// Finishes all pending jobs and joins the worker threads.
+	/// </summary>
+	void Terminate();
+
+	/// <returns>The number of worker threads, not including the main thread</returns>
+	[[nodiscard]] uint32_t GetWorkerCount();
+
+	/// <returns>Index of the calling thread, 0 for every thread that is not a worker, 1..GetWorkerCount() for workers</returns>
+	[[nodiscard]] uint32_t GetThreadIndex();
+
+	/// <summary>
+	/// Queues a job for execution on one of the worker threads.
+	/// </summary>
+	/// <param name="job">The function to execute</param>
+	/// <param name="counter">Optional counter that will be decremented once the job finished</param>
+	void Submit(std::function<void()> job, Counter* counter = nullptr);
+
+	/// <summary>
+	/// Increments a counter for work that doesn't run as a job, e.g. an I/O request, so waiting on the counter also waits for that work.
+	/// </summary>
+	void Retain(Counter& counter);
+	/// <summary>
+	/// Decrements a counter once the work it was retained for finished.
+	/// </summary>
+	void Release(Counter& counter);
+
+	/// <summary>
+	/// Blocks until the given counter reaches zero. The calling thread executes queued jobs while waiting.
+	/// </summary>
+	void Wait(Counter& counter);
+
+	/// <summary>
+	/// Splits the range [0, count) into batches and executes fn for every batch in parallel. Blocks until every batch finished.
+	/// </summary>
+	/// <param name="count">Number of elements</param>
+	/// <param name="batchSize">Number of elements per job</param>
+	/// <param name="fn">Function receiving the range [begin, end) it should process</param>
+	void ParallelFor(uint32_t count, uint32_t batchSize, const std::function<void(uint32_t begin, uint32_t end)>& fn);
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace Core::Json {
+
+	/// <summary>
+	/// Escapes the characters that may not appear in a JSON string, so the result can be written between quotes.
+	/// </summary>
+	inline std::string Escape(std::string_view str) {
+		std::string res;
+		res.reserve(str.size());
+		for (char c : str) {
+			switch (c) {
+			case '"': res += "\\\""; break;
+			case '\\': res += "\\\\"; break;
+			case '\n': res += "\\n"; break;
+			case '\r': res += "\\r"; break;
+			case '\t': res += "\\t"; break;
+			default:
+				if ((unsigned char)c < 0x20) {
+					char code[8];
+					std::snprintf(code, sizeof(code), "\\u%04x", (unsigned)c);
+					res += code;
+				}
+				else {
+					res += c;
+				}
+			}
+		}
+		return res;
+	}
+
+}
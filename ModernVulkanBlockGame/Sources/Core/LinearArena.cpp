@@ -0,0 +1,89 @@
+#include "LinearArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace Core {
+
+	/// <summary>
+	/// Size of the block header, rounded up so the data following it is aligned like operator new.
+	/// </summary>
+	static constexpr size_t HEADER_SIZE = (sizeof(void*) * 2 + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+	LinearArena::LinearArena(size_t initialSize, MemoryTag tag)
+		: m_InitialSize{initialSize}, m_Tag{tag}
+	{ }
+
+	LinearArena::~LinearArena() {
+		MemoryTracker::RecordOperations(m_Tag, MemoryDomain::Cpu, 0, m_Allocations);
+		FreeBlocks();
+	}
+
+	void LinearArena::FreeBlocks() {
+		while (m_Current) {
+			auto* prev = m_Current->prev;
+			MemoryTracker::RecordFree(m_Tag, MemoryDomain::Cpu, HEADER_SIZE + m_Current->size, 0);
+			::operator delete(m_Current);
+			m_Current = prev;
+		}
+		m_Ptr = m_End = nullptr;
+		m_UsedInPrevious = 0;
+	}
+
+	size_t LinearArena::GetUsed() const {
+		if (!m_Current)
+			return 0;
+		return m_UsedInPrevious + (size_t)(m_Ptr - ((std::byte*)m_Current + HEADER_SIZE));
+	}
+
+	void LinearArena::Grow(size_t required) {
+		if (m_Current)
+			m_UsedInPrevious += (size_t)(m_Ptr - ((std::byte*)m_Current + HEADER_SIZE));
+
+		auto size = std::max(m_Current ? m_Current->size * 2 : m_InitialSize, required);
+		auto* block = (Block*)::operator new(HEADER_SIZE + size);
+		MemoryTracker::RecordAlloc(m_Tag, MemoryDomain::Cpu, HEADER_SIZE + size, 0);
+		block->prev = m_Current;
+		block->size = size;
+		m_Current = block;
+		m_Ptr = (std::byte*)block + HEADER_SIZE;
+		m_End = m_Ptr + size;
+	}
+
+	void* LinearArena::do_allocate(size_t bytes, size_t alignment) {
+		auto aligned = ((uintptr_t)m_Ptr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		if (!m_Current || aligned + bytes > (uintptr_t)m_End) {
+			// The new block is only aligned like operator new, so we may need up to alignment - 1 bytes of padding.
+			Grow(bytes + alignment);
+			aligned = ((uintptr_t)m_Ptr + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		}
+		m_Ptr = (std::byte*)(aligned + bytes);
+		m_Allocations++;
+		return (void*)aligned;
+	}
+
+	void LinearArena::Reset() {
+		if (!m_Current)
+			return;
+
+		auto used = GetUsed();
+		m_Peak = std::max(m_Peak, used);
+		// Resetting frees every allocation at once.
+		MemoryTracker::RecordOperations(m_Tag, MemoryDomain::Cpu, m_Allocations, m_Allocations);
+		m_Allocations = 0;
+
+		if (m_Current->prev) {
+			// The last frame needed more than one block. Replace them by a single block that would have been large enough.
+			auto size = m_Current->size;
+			for (auto* b = m_Current->prev; b; b = b->prev)
+				size += b->size;
+			FreeBlocks();
+			Grow(size);
+			return;
+		}
+		m_Ptr = (std::byte*)m_Current + HEADER_SIZE;
+		m_UsedInPrevious = 0;
+	}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+#include "MemoryTracker.h"
+
+namespace Core {
+
+	/// <summary>
+	/// Allocates by bumping a pointer and frees everything at once in Reset(). Individual deallocations are ignored.
+	/// </summary>
+	/// <remarks>
+	/// When an allocation doesn't fit, a new block twice the size is chained. Reset() merges the chain into a single block large enough
+	/// for everything that was allocated since the previous reset, so after a few frames of warming up the arena never touches the heap again.
+	/// Not thread-safe, every thread needs its own arena.
+	/// </remarks>
+	class LinearArena : public std::pmr::memory_resource {
+	public:
+		/// <param name="initialSize">Size of the first block, which is only allocated once something is allocated from the arena</param>
+		/// <param name="tag">Subsystem the blocks are attributed to in the MemoryTracker</param>
+		explicit LinearArena(size_t initialSize = 64 * 1024, MemoryTag tag = MemoryTag::General);
+		~LinearArena() override;
+
+		LinearArena(const LinearArena&) = delete;
+		void operator=(const LinearArena&) = delete;
+
+		/// <summary>
+		/// Frees every allocation. Memory allocated from the arena before must not be used anymore.
+		/// </summary>
+		void Reset();
+
+		/// <returns>Bytes allocated since the last reset, including alignment padding</returns>
+		[[nodiscard]] size_t GetUsed() const;
+		/// <returns>The most bytes that were ever allocated between two resets</returns>
+		[[nodiscard]] size_t GetPeak() const { return m_Peak; }
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void*, size_t, size_t) override { }
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	private:
+		struct Block {
+			Block* prev;
+			size_t size;
+		};
+
+		/// <summary>
+		/// Chains a new block that can hold at least the given number of bytes.
+		/// </summary>
+		void Grow(size_t required);
+		void FreeBlocks();
+
+		size_t m_InitialSize;
+		MemoryTag m_Tag;
+		/// <summary>
+		/// The block allocations are currently taken from, its predecessors are full.
+		/// </summary>
+		Block* m_Current = nullptr;
+		std::byte* m_Ptr = nullptr;
+		std::byte* m_End = nullptr;
+		/// <summary>
+		/// Bytes used in the blocks before m_Current.
+		/// </summary>
+		size_t m_UsedInPrevious = 0;
+		size_t m_Peak = 0;
+		/// <summary>
+		/// Allocations since the last reset, reported to the MemoryTracker by Reset().
+		/// </summary>
+		uint64_t m_Allocations = 0;
+	};
+
+}
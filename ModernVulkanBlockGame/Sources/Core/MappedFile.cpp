@@ -0,0 +1,220 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Logging/Log.h"
+
+namespace Core {
+
+	/// <summary>
+	/// The file is grown by at least this much at a time, so appending doesn't resize (or on Windows remap) it every time.
+	/// </summary>
+	static constexpr uint64_t GROW_STEP = 4 * 1024 * 1024;
+
+	MappedFile& MappedFile::operator=(MappedFile&& r) noexcept {
+		if (this != &r) {
+			Close();
+#ifdef _WIN32
+			m_File = std::exchange(r.m_File, nullptr);
+			m_Mapping = std::exchange(r.m_Mapping, nullptr);
+#else
+			m_Fd = std::exchange(r.m_Fd, -1);
+			m_FileSize = std::exchange(r.m_FileSize, 0);
+#endif
+			m_Data = std::exchange(r.m_Data, nullptr);
+			m_Size = std::exchange(r.m_Size, 0);
+			m_MappedSize = std::exchange(r.m_MappedSize, 0);
+			m_MaxSize = std::exchange(r.m_MaxSize, 0);
+		}
+		return *this;
+	}
+
+	bool MappedFile::Open(const std::string& path, uint64_t maxSize) {
+		Close();
+		m_MaxSize = maxSize;
+#ifdef _WIN32
+		auto file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			Log::Error("Failed to open {}: error {}", path, (uint32_t)GetLastError());
+			return false;
+		}
+		m_File = file;
+		LARGE_INTEGER size;
+		GetFileSizeEx(file, &size);
+		m_Size = (uint64_t)size.QuadPart;
+		if (!Remap(std::min(std::max(m_Size, GROW_STEP), std::max(m_MaxSize, m_Size)))) {
+			Log::Error("Failed to map {}: error {}", path, (uint32_t)GetLastError());
+			Close();
+			return false;
+		}
+#else
+		m_Fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if (m_Fd < 0) {
+			Log::Error("Failed to open {}: errno {}", path, errno);
+			return false;
+		}
+		struct stat st;
+		fstat(m_Fd, &st);
+		m_Size = (uint64_t)st.st_size;
+		m_FileSize = m_Size;
+		// Mapping beyond the end of the file is fine, as long as nobody touches the pages there.
+		m_MappedSize = std::max(m_MaxSize, m_Size);
+		auto* p = mmap(nullptr, m_MappedSize, PROT_READ, MAP_SHARED, m_Fd, 0);
+		if (p == MAP_FAILED) {
+			Log::Error("Failed to map {}: errno {}", path, errno);
+			Close();
+			return false;
+		}
+		m_Data = (std::byte*)p;
+#endif
+		return true;
+	}
+
+	void MappedFile::Close() {
+#ifdef _WIN32
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle(m_Mapping);
+		if (m_File) {
+			// Growing the mapping grew the file, we cut off what was never written.
+			LARGE_INTEGER size;
+			size.QuadPart = (LONGLONG)m_Size;
+			SetFilePointerEx(m_File, size, nullptr, FILE_BEGIN);
+			SetEndOfFile(m_File);
+			CloseHandle(m_File);
+		}
+		m_Mapping = nullptr;
+		m_File = nullptr;
+#else
+		if (m_Data)
+			munmap(m_Data, m_MappedSize);
+		if (m_Fd >= 0) {
+			// Growing the file in steps left a part that was never written.
+			if (m_FileSize > m_Size && ftruncate(m_Fd, (off_t)m_Size) != 0)
+				Log::Warning("Failed to truncate a file: errno {}", errno);
+			close(m_Fd);
+		}
+		m_Fd = -1;
+		m_FileSize = 0;
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+		m_MappedSize = 0;
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Remap(uint64_t size) {
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_Mapping)
+			CloseHandle(m_Mapping);
+		m_Data = nullptr;
+		m_MappedSize = 0;
+
+		// A read-write mapping larger than the file extends it, the new part reads as zeros.
+		m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, nullptr);
+		if (!m_Mapping)
+			return false;
+		m_Data = (std::byte*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+		if (!m_Data)
+			return false;
+		m_MappedSize = size;
+		return true;
+	}
+#endif
+
+	bool MappedFile::Write(uint64_t offset, const void* data, size_t size) {
+		if (!m_Data || offset + size > std::max(m_MaxSize, m_Size))
+			return false;
+#ifdef _WIN32
+		if (offset + size > m_MappedSize && !Remap(std::min(std::max(offset + size, m_MappedSize + GROW_STEP), m_MaxSize)))
+			return false;
+		auto* bytes = (const std::byte*)data;
+		while (size > 0) {
+			OVERLAPPED overlapped{};
+			overlapped.Offset = (DWORD)offset;
+			overlapped.OffsetHigh = (DWORD)(offset >> 32);
+			DWORD written = 0;
+			if (!WriteFile(m_File, bytes, (DWORD)std::min<size_t>(size, 1u << 30), &written, &overlapped) || written == 0)
+				return false;
+			bytes += written;
+			offset += written;
+			size -= written;
+			m_Size = std::max(m_Size, offset);
+		}
+#else
+		auto* bytes = (const std::byte*)data;
+		while (size > 0) {
+			auto written = pwrite(m_Fd, bytes, size, (off_t)offset);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+				return false;
+			bytes += written;
+			offset += (uint64_t)written;
+			size -= (size_t)written;
+			m_Size = std::max(m_Size, offset);
+			m_FileSize = std::max(m_FileSize, offset);
+		}
+#endif
+		return true;
+	}
+
+	bool MappedFile::Grow(uint64_t size) {
+		if (!m_Data || size > std::max(m_MaxSize, m_Size))
+			return false;
+		if (size <= m_Size)
+			return true;
+#ifdef _WIN32
+		if (size > m_MappedSize && !Remap(std::min(std::max(size, m_MappedSize + GROW_STEP), m_MaxSize)))
+			return false;
+#else
+		if (size > m_FileSize) {
+			auto fileSize = std::min(std::max(size, m_FileSize + GROW_STEP), m_MaxSize);
+			if (ftruncate(m_Fd, (off_t)fileSize) != 0)
+				return false;
+			m_FileSize = fileSize;
+		}
+#endif
+		m_Size = size;
+		return true;
+	}
+
+	bool MappedFile::Sync() {
+#ifdef _WIN32
+		return m_File && FlushFileBuffers(m_File);
+#else
+		return m_Fd >= 0 && fdatasync(m_Fd) == 0;
+#endif
+	}
+
+	bool MappedFile::SyncDirectory(const std::string& path) {
+#ifdef _WIN32
+		// NTFS journals its metadata, so the entries are durable once the files are.
+		(void)path;
+		return true;
+#else
+		int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0)
+			return false;
+		auto ok = fsync(fd) == 0;
+		close(fd);
+		return ok;
+#endif
+	}
+
+}
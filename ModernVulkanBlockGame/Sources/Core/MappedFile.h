@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace Core {
+
+	/*
+	 * A file that is read through a memory mapping, but written with regular writes.
+	 * Reading then only touches the pages that are actually needed, without a system call or a copy into a buffer,
+	 * while writes never fault in pages just to overwrite them and can't corrupt the file through a stray pointer.
+	 *
+	 * On Linux, the mapping covers maxSize bytes from the start, so it never has to move while the file grows:
+	 * the page cache is shared, so data written with pwrite() shows up in the mapping right away.
+	 * Windows can't map beyond the end of a file, so the file is grown in steps and remapped when it outgrows the mapping.
+	 * Either way, pointers into the mapping may only be used while no other thread writes to the file.
+	 */
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		void operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& r) noexcept { *this = std::move(r); }
+		MappedFile& operator=(MappedFile&& r) noexcept;
+
+		/// <summary>
+		/// Opens a file for reading and writing, creating it if it doesn't exist, and maps it.
+		/// </summary>
+		/// <param name="maxSize">The size the file may grow to</param>
+		/// <returns>False if the file could not be opened or mapped</returns>
+		bool Open(const std::string& path, uint64_t maxSize);
+		void Close();
+
+		[[nodiscard]] bool IsOpen() const { return m_Data != nullptr; }
+		/// <returns>The contents of the file, valid up to GetSize()</returns>
+		[[nodiscard]] const std::byte* GetData() const { return m_Data; }
+		[[nodiscard]] uint64_t GetSize() const { return m_Size; }
+
+		/// <summary>
+		/// Writes data at an offset, growing the file if necessary. The mapping contains the data afterwards.
+		/// </summary>
+		/// <returns>False if the data could not be written completely, or would grow the file beyond maxSize</returns>
+		bool Write(uint64_t offset, const void* data, size_t size);
+		/// <summary>
+		/// Grows the file to at least size bytes, so it can be written by other means than Write(), e.g. asynchronously through the Core::IoService.
+		/// GetSize() includes the new bytes right away, they read as zeros until they are written.
+		/// </summary>
+		/// <returns>False if the file could not be grown, or would grow beyond maxSize</returns>
+		bool Grow(uint64_t size);
+		/// <summary>
+		/// Blocks until everything written so far is on disk.
+		/// </summary>
+		bool Sync();
+		/// <summary>
+		/// Blocks until the entries of a directory are on disk, so files created, renamed or deleted in it survive a crash.
+		/// Syncing a file doesn't cover its name.
+		/// </summary>
+		static bool SyncDirectory(const std::string& path);
+
+#ifdef _WIN32
+		[[nodiscard]] void* GetHandle() const { return m_File; }
+#else
+		[[nodiscard]] int GetHandle() const { return m_Fd; }
+#endif
+
+	private:
+#ifdef _WIN32
+		bool Remap(uint64_t size);
+
+		void* m_File = nullptr;
+		void* m_Mapping = nullptr;
+#else
+		int m_Fd = -1;
+		/// <summary>
+		/// Actual size of the file, which Grow() extends in steps ahead of m_Size.
+		/// </summary>
+		uint64_t m_FileSize = 0;
+#endif
+		std::byte* m_Data = nullptr;
+		/// <summary>
+		/// Size of the file as far as its user is concerned. The file is cut to this size when it is closed.
+		/// </summary>
+		uint64_t m_Size = 0;
+		/// <summary>
+		/// Bytes covered by the mapping.
+		/// </summary>
+		uint64_t m_MappedSize = 0;
+		uint64_t m_MaxSize = 0;
+	};
+
+}
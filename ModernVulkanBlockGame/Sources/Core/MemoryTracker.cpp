@@ -0,0 +1,81 @@
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <chrono>
+
+#include "Logging/Log.h"
+
+namespace Core::MemoryTracker {
+
+	/// <summary>
+	/// The counters of a tag, on their own cache line so subsystems don't slow each other down.
+	/// </summary>
+	struct alignas(64) Counters {
+		std::atomic<uint64_t> live;
+		std::atomic<uint64_t> peak;
+		std::atomic<uint64_t> allocations;
+		std::atomic<uint64_t> frees;
+	};
+
+	static std::array<std::array<Counters, (size_t)MemoryTag::Count>, (size_t)MemoryDomain::Count> g_Counters;
+	static const auto g_StartTime = std::chrono::steady_clock::now();
+
+	static Counters& Get(MemoryTag tag, MemoryDomain domain) {
+		return g_Counters[(size_t)domain][(size_t)tag];
+	}
+
+	void RecordAlloc(MemoryTag tag, MemoryDomain domain, uint64_t bytes, uint64_t allocations) {
+		auto& c = Get(tag, domain);
+		auto live = c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		auto peak = c.peak.load(std::memory_order_relaxed);
+		while (live > peak && !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+		if (allocations > 0)
+			c.allocations.fetch_add(allocations, std::memory_order_relaxed);
+	}
+
+	void RecordFree(MemoryTag tag, MemoryDomain domain, uint64_t bytes, uint64_t frees) {
+		auto& c = Get(tag, domain);
+		c.live.fetch_sub(bytes, std::memory_order_relaxed);
+		if (frees > 0)
+			c.frees.fetch_add(frees, std::memory_order_relaxed);
+	}
+
+	void RecordOperations(MemoryTag tag, MemoryDomain domain, uint64_t allocations, uint64_t frees) {
+		auto& c = Get(tag, domain);
+		if (allocations > 0)
+			c.allocations.fetch_add(allocations, std::memory_order_relaxed);
+		if (frees > 0)
+			c.frees.fetch_add(frees, std::memory_order_relaxed);
+	}
+
+	TagStats GetStats(MemoryTag tag, MemoryDomain domain) {
+		const auto& c = Get(tag, domain);
+		auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - g_StartTime).count();
+		auto allocations = c.allocations.load(std::memory_order_relaxed);
+		return {
+			c.live.load(std::memory_order_relaxed),
+			c.peak.load(std::memory_order_relaxed),
+			allocations,
+			c.frees.load(std::memory_order_relaxed),
+			seconds > 0.0 ? allocations / seconds : 0.0,
+		};
+	}
+
+	void PrintReport() {
+		constexpr const char* DOMAIN_NAMES[] = { "RAM ", "VRAM" };
+		constexpr double MIB = 1024.0 * 1024.0;
+
+		std::string report = "Memory by subsystem:";
+		for (size_t d = 0; d < (size_t)MemoryDomain::Count; d++) {
+			for (size_t t = 0; t < (size_t)MemoryTag::Count; t++) {
+				auto s = GetStats((MemoryTag)t, (MemoryDomain)d);
+				if (s.peakBytes == 0 && s.allocations == 0)
+					continue;
+				report += Log::format("\n    {} {:<16} live {:>9.2f} MiB, peak {:>9.2f} MiB, {:>9} allocations ({:.1f}/s on average), {:>9} frees",
+					DOMAIN_NAMES[d], MEMORY_TAG_NAMES[t], s.liveBytes / MIB, s.peakBytes / MIB, s.allocations, s.averageAllocationsPerSecond, s.frees);
+			}
+		}
+		Log::Info("{}", report);
+	}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Core {
+
+	/// <summary>
+	/// The subsystem memory is attributed to.
+	/// </summary>
+	enum class MemoryTag : uint8_t {
+		General,
+		/// <summary>
+		/// Chunk objects and their block and light arrays.
+		/// </summary>
+		Chunks,
+		/// <summary>
+		/// Vertex and index data.
+		/// </summary>
+		Meshes,
+		/// <summary>
+		/// Swapchain-sized images, e.g. depth buffers and offscreen targets.
+		/// </summary>
+		RenderTargets,
+		/// <summary>
+		/// Readback buffers of frame captures.
+		/// </summary>
+		Capture,
+		/// <summary>
+		/// Per-frame arenas, see Core::FrameArena.
+		/// </summary>
+		Transient,
+		Logging,
+		Count,
+	};
+
+	enum class MemoryDomain : uint8_t {
+		Cpu,
+		Gpu,
+		Count,
+	};
+
+	inline constexpr std::array<const char*, (size_t)MemoryTag::Count> MEMORY_TAG_NAMES{
+		"general", "chunks", "meshes", "render_targets", "capture", "transient", "logging",
+	};
+
+}
+
+namespace Core::MemoryTracker {
+
+	/*
+	 * Memory regressions are hard to pin down without knowing which subsystem the memory belongs to. Every allocator the engine owns
+	 * (slab pools, arenas, GPU buffers and images) attributes its memory to a MemoryTag. The tracker keeps live totals, peaks and
+	 * the number of allocations per tag, for RAM and VRAM separately.
+	 *
+	 * Allocators report the memory they take from the system, not every small allocation: a slab pool reports the slabs it committed,
+	 * an arena its blocks. That is the memory the process actually uses, and it keeps the counters off the hot paths.
+	 * Allocation counts are still exact, as pools and arenas count them locally and report them in batches.
+	 */
+
+	/// <summary>
+	/// Records that memory was taken from the system. May be called from any thread.
+	/// </summary>
+	/// <param name="allocations">Number of allocations the memory was handed out in, may be 0 if it only grows a pool</param>
+	void RecordAlloc(MemoryTag tag, MemoryDomain domain, uint64_t bytes, uint64_t allocations = 1);
+	/// <summary>
+	/// Records that memory was returned to the system.
+	/// </summary>
+	void RecordFree(MemoryTag tag, MemoryDomain domain, uint64_t bytes, uint64_t frees = 1);
+	/// <summary>
+	/// Counts allocations that were served from memory that was already recorded, e.g. blocks of a pool.
+	/// </summary>
+	void RecordOperations(MemoryTag tag, MemoryDomain domain, uint64_t allocations, uint64_t frees);
+
+	struct TagStats {
+		uint64_t liveBytes;
+		uint64_t peakBytes;
+		uint64_t allocations;
+		uint64_t frees;
+		/// <summary>
+		/// Allocations per second, averaged over the whole run since the program started. Bursts and the current rate don't show up here.
+		/// </summary>
+		double averageAllocationsPerSecond;
+	};
+
+	[[nodiscard]] TagStats GetStats(MemoryTag tag, MemoryDomain domain);
+
+	/// <summary>
+	/// Prints the statistics of every tag that was used to the log.
+	/// </summary>
+	void PrintReport();
+
+}
@@ -0,0 +1,124 @@
+#include "Png.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "Logging/Log.h"
+
+namespace Core::Png {
+
+	/*
+	 * A PNG file is a signature followed by chunks, each consisting of its length, a four character type, the data and a CRC.
+	 * The pixel data is stored zlib compressed in IDAT chunks, every row preceded by a filter type byte.
+	 * Since captures are written while the game runs, we don't compress at all and write "stored" deflate blocks instead,
+	 * which any PNG decoder reads. This keeps writing cheap at the cost of larger files.
+	 */
+
+	static constexpr std::array<uint32_t, 256> CRC_TABLE = [] {
+		std::array<uint32_t, 256> table{};
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		return table;
+	}();
+
+	static uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+		for (size_t i = 0; i < size; i++)
+			crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return crc;
+	}
+
+	static void PutBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+		out.push_back((uint8_t)(value >> 24));
+		out.push_back((uint8_t)(value >> 16));
+		out.push_back((uint8_t)(value >> 8));
+		out.push_back((uint8_t)value);
+	}
+
+	static void WriteChunk(FILE* file, const char type[4], const std::vector<uint8_t>& data) {
+		std::vector<uint8_t> header;
+		PutBigEndian(header, (uint32_t)data.size());
+		header.insert(header.end(), type, type + 4);
+
+		// The CRC covers the type and the data, but not the length.
+		auto crc = UpdateCrc(0xFFFFFFFFu, header.data() + 4, 4);
+		crc = UpdateCrc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+		std::vector<uint8_t> footer;
+		PutBigEndian(footer, crc);
+
+		fwrite(header.data(), 1, header.size(), file);
+		fwrite(data.data(), 1, data.size(), file);
+		fwrite(footer.data(), 1, footer.size(), file);
+	}
+
+	bool Write(const std::string& path, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels) {
+		std::unique_ptr<FILE, decltype(&fclose)> file{ fopen(path.c_str(), "wb"), &fclose };
+		if (!file) {
+			Log::Error("Failed to open {} for writing", path);
+			return false;
+		}
+
+		static constexpr uint8_t SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		fwrite(SIGNATURE, 1, sizeof(SIGNATURE), file.get());
+
+		std::vector<uint8_t> ihdr;
+		PutBigEndian(ihdr, width);
+		PutBigEndian(ihdr, height);
+		ihdr.push_back(8); // bit depth
+		ihdr.push_back(channels == 4 ? 6 : 2); // color type: RGBA or RGB
+		ihdr.push_back(0); // compression: deflate
+		ihdr.push_back(0); // filter method
+		ihdr.push_back(0); // no interlacing
+		WriteChunk(file.get(), "IHDR", ihdr);
+
+		// Every row starts with filter type 0 (none).
+		auto rowSize = (size_t)width * channels;
+		std::vector<uint8_t> raw;
+		raw.reserve((rowSize + 1) * height);
+		for (uint32_t y = 0; y < height; y++) {
+			raw.push_back(0);
+			raw.insert(raw.end(), pixels + y * rowSize, pixels + (y + 1) * rowSize);
+		}
+
+		// zlib stream: header, stored deflate blocks of at most 65535 bytes, Adler-32 checksum of the uncompressed data.
+		std::vector<uint8_t> idat;
+		idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+		idat.push_back(0x78);
+		idat.push_back(0x01);
+		uint32_t a = 1, b = 0;
+		size_t offset = 0;
+		do {
+			auto size = (uint16_t)std::min<size_t>(raw.size() - offset, 65535);
+			bool last = offset + size == raw.size();
+			idat.push_back(last ? 1 : 0);
+			idat.push_back((uint8_t)size);
+			idat.push_back((uint8_t)(size >> 8));
+			idat.push_back((uint8_t)~size);
+			idat.push_back((uint8_t)(~size >> 8));
+			idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + size);
+
+			for (size_t i = offset; i < offset + size; i++) {
+				a = (a + raw[i]) % 65521;
+				b = (b + a) % 65521;
+			}
+			offset += size;
+		} while (offset < raw.size());
+		PutBigEndian(idat, (b << 16) | a);
+		WriteChunk(file.get(), "IDAT", idat);
+
+		WriteChunk(file.get(), "IEND", {});
+
+		if (ferror(file.get())) {
+			Log::Error("Failed to write {}", path);
+			return false;
+		}
+		return true;
+	}
+
+}
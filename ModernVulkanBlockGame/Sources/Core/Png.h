@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Core::Png {
+
+	/// <summary>
+	/// Writes an 8 bit per channel image as PNG file.
+	/// </summary>
+	/// <param name="pixels">Rows of width * channels bytes each, from top to bottom</param>
+	/// <param name="channels">3 for RGB or 4 for RGBA</param>
+	/// <returns>False if the file could not be written</returns>
+	bool Write(const std::string& path, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* pixels);
+
+}
@@ -0,0 +1,244 @@
+#include "SlabPool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+
+#include "VirtualMemory.h"
+#include "Logging/Log.h"
+
+namespace Core {
+
+	/// <summary>
+	/// Maximum number of free blocks a thread keeps per pool.
+	/// </summary>
+	static constexpr uint32_t CACHE_CAPACITY = 32;
+	/// <summary>
+	/// Number of blocks moved between a thread cache and the shared free list at once.
+	/// Half the capacity, so a thread alternating between allocating and freeing doesn't move blocks back and forth every time.
+	/// </summary>
+	static constexpr uint32_t CACHE_BATCH = CACHE_CAPACITY / 2;
+
+	/// <summary>
+	/// Protects the registry and the lifetime of the pools in it.
+	/// </summary>
+	static std::mutex g_RegistryMutex;
+	static std::array<SlabPool*, SlabPool::MAX_POOLS> g_Pools;
+	/// <summary>
+	/// Generation of the last pool that used a slot, 0 means the slot was never used.
+	/// </summary>
+	static std::array<uint32_t, SlabPool::MAX_POOLS> g_Generations;
+	static std::atomic<bool> g_HugePages{ false };
+
+	struct SlabPool::ThreadCache {
+		struct Entry {
+			FreeBlock* head;
+			uint32_t count;
+			uint32_t generation;
+			/// <summary>
+			/// Operations since they were last reported to the MemoryTracker, which only happens when blocks move in a batch.
+			/// </summary>
+			uint32_t allocations;
+			uint32_t frees;
+		};
+		std::array<Entry, MAX_POOLS> entries{};
+
+		~ThreadCache() {
+			// Give the cached blocks back to pools that still exist, otherwise they would be lost until the pool is destroyed.
+			std::lock_guard lock{ g_RegistryMutex };
+			for (uint32_t i = 0; i < MAX_POOLS; i++) {
+				auto& e = entries[i];
+				if (!g_Pools[i] || g_Generations[i] != e.generation)
+					continue;
+				MemoryTracker::RecordOperations(g_Pools[i]->m_Tag, MemoryDomain::Cpu, e.allocations, e.frees);
+				if (!e.head)
+					continue;
+				auto* tail = e.head;
+				while (tail->next)
+					tail = tail->next;
+				g_Pools[i]->ReleaseBatch(e.head, tail, e.count);
+				e = {};
+			}
+		}
+	};
+
+	thread_local SlabPool::ThreadCache SlabPool::t_Cache;
+
+	SlabPool::SlabPool(std::string name, size_t blockSize, MemoryTag tag, size_t alignment, size_t maxBytes)
+		: m_Name{std::move(name)}, m_Tag{tag}
+	{
+		assert(alignment > 0 && (alignment & (alignment - 1)) == 0 && alignment <= VirtualMemory::GetPageSize());
+		// Every block must be able to hold the free list link, and the blocks following the first one must be aligned as well.
+		blockSize = std::max(blockSize, sizeof(FreeBlock));
+		m_BlockSize = (blockSize + alignment - 1) & ~(alignment - 1);
+
+		m_Reserved = (std::max(maxBytes, m_BlockSize) + SLAB_SIZE - 1) & ~(SLAB_SIZE - 1);
+		m_Base = (std::byte*)VirtualMemory::Reserve(m_Reserved);
+		if (!m_Base) {
+			Log::Error("Failed to reserve {} MiB of address space for pool {}", m_Reserved >> 20, m_Name);
+			m_Reserved = 0;
+		}
+
+		std::lock_guard lock{ g_RegistryMutex };
+		auto it = std::find(g_Pools.begin(), g_Pools.end(), nullptr);
+		if (it == g_Pools.end()) {
+			// Without a slot the pool can't have thread caches, so we can't hand out anything.
+			Log::Error("Too many pools, pool {} will be unable to allocate", m_Name);
+			m_Slot = MAX_POOLS;
+			m_Generation = 0;
+			return;
+		}
+		m_Slot = (uint32_t)(it - g_Pools.begin());
+		m_Generation = ++g_Generations[m_Slot];
+		*it = this;
+	}
+
+	SlabPool::~SlabPool() {
+		{
+			// Blocks still in other threads' caches now belong to an old generation and will be ignored.
+			std::lock_guard lock{ g_RegistryMutex };
+			if (m_Slot < MAX_POOLS)
+				g_Pools[m_Slot] = nullptr;
+		}
+		if (m_Base)
+			VirtualMemory::Release(m_Base, m_Reserved);
+		MemoryTracker::RecordFree(m_Tag, MemoryDomain::Cpu, m_Committed, 0);
+	}
+
+	uint32_t SlabPool::AcquireBatch(FreeBlock*& head, uint32_t count) {
+		std::lock_guard lock{ m_Mutex };
+
+		uint32_t acquired = 0;
+		while (acquired < count && m_FreeList) {
+			auto* block = m_FreeList;
+			m_FreeList = block->next;
+			block->next = head;
+			head = block;
+			acquired++;
+		}
+		m_FreeCount -= acquired;
+
+		while (acquired < count && m_Carved + m_BlockSize <= m_Reserved) {
+			while (m_Carved + m_BlockSize > m_Committed) {
+				auto size = std::min(SLAB_SIZE, m_Reserved - m_Committed);
+				if (!VirtualMemory::Commit(m_Base + m_Committed, size, g_HugePages.load(std::memory_order_relaxed))) {
+					Log::Error("Failed to commit a slab for pool {}", m_Name);
+					return acquired;
+				}
+				m_Committed += size;
+				MemoryTracker::RecordAlloc(m_Tag, MemoryDomain::Cpu, size, 0);
+			}
+			auto* block = (FreeBlock*)(m_Base + m_Carved);
+			m_Carved += m_BlockSize;
+			block->next = head;
+			head = block;
+			acquired++;
+		}
+		return acquired;
+	}
+
+	void SlabPool::ReleaseBatch(FreeBlock* head, FreeBlock* tail, uint32_t count) {
+		std::lock_guard lock{ m_Mutex };
+		tail->next = m_FreeList;
+		m_FreeList = head;
+		m_FreeCount += count;
+	}
+
+	void* SlabPool::Allocate() {
+		if (m_Slot >= MAX_POOLS)
+			return nullptr;
+
+		auto& cache = t_Cache.entries[m_Slot];
+		if (cache.generation != m_Generation) {
+			// Whatever is cached belongs to a destroyed pool, its memory is gone.
+			cache = { nullptr, 0, m_Generation, 0, 0 };
+		}
+		if (!cache.head) {
+			MemoryTracker::RecordOperations(m_Tag, MemoryDomain::Cpu, cache.allocations, cache.frees);
+			cache.allocations = cache.frees = 0;
+			cache.count = AcquireBatch(cache.head, CACHE_BATCH);
+			if (!cache.head) {
+				Log::Error("Pool {} is exhausted", m_Name);
+				return nullptr;
+			}
+		}
+
+		auto* block = cache.head;
+		cache.head = block->next;
+		cache.count--;
+		cache.allocations++;
+		return block;
+	}
+
+	void SlabPool::Free(void* p) {
+		if (!p)
+			return;
+		assert((std::byte*)p >= m_Base && (std::byte*)p < m_Base + m_Reserved && "Block does not belong to this pool");
+
+		auto& cache = t_Cache.entries[m_Slot];
+		if (cache.generation != m_Generation)
+			cache = { nullptr, 0, m_Generation, 0, 0 };
+
+		auto* block = (FreeBlock*)p;
+		block->next = cache.head;
+		cache.head = block;
+		cache.count++;
+		cache.frees++;
+
+		if (cache.count > CACHE_CAPACITY) {
+			// Keep the most recently freed blocks, they are the most likely to still be in the cache.
+			auto* last = cache.head;
+			for (uint32_t i = 1; i < CACHE_CAPACITY - CACHE_BATCH; i++)
+				last = last->next;
+			auto* head = last->next;
+			auto* tail = head;
+			auto count = cache.count - (CACHE_CAPACITY - CACHE_BATCH);
+			for (uint32_t i = 1; i < count; i++)
+				tail = tail->next;
+			last->next = nullptr;
+			cache.count -= count;
+			ReleaseBatch(head, tail, count);
+			MemoryTracker::RecordOperations(m_Tag, MemoryDomain::Cpu, cache.allocations, cache.frees);
+			cache.allocations = cache.frees = 0;
+		}
+	}
+
+	PoolStats SlabPool::GetStats() const {
+		std::lock_guard lock{ m_Mutex };
+		auto carved = m_BlockSize > 0 ? m_Carved / m_BlockSize : 0;
+		return {
+			m_Name, m_BlockSize,
+			carved - m_FreeCount, carved,
+			m_Committed / SLAB_SIZE, m_Committed,
+		};
+	}
+
+	std::vector<PoolStats> SlabPool::GetAllStats() {
+		std::vector<PoolStats> res;
+		std::lock_guard lock{ g_RegistryMutex };
+		for (const auto* pool : g_Pools) {
+			if (pool)
+				res.push_back(pool->GetStats());
+		}
+		return res;
+	}
+
+	void SlabPool::PrintReport() {
+		auto stats = GetAllStats();
+		if (stats.empty())
+			return;
+
+		std::string report = "Pool allocators:";
+		for (const auto& s : stats) {
+			report += Log::format("\n    {:<20} {:>6} B blocks, {:>8} in use, {:>8} carved, {:>4} slabs ({:.1f} MiB committed)",
+				s.name, s.blockSize, s.blocksInUse, s.blocksCarved, s.slabs, s.bytesCommitted / (1024.0 * 1024.0));
+		}
+		Log::Info("{}", report);
+	}
+
+	void SlabPool::SetHugePages(bool enabled) {
+		g_HugePages.store(enabled, std::memory_order_relaxed);
+	}
+
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MemoryTracker.h"
+
+namespace Core {
+
+	/*
+	 * Chunks and meshes are created and destroyed constantly while the player moves, always with the same few sizes.
+	 * A general purpose allocator handles this with size class lookups, locks shared by every size and memory that fragments over time.
+	 *
+	 * A SlabPool only hands out blocks of a single size. It reserves a large range of address space up front and commits it one slab
+	 * (2 MiB, the size of a huge page) at a time, carving blocks off the end of the last slab. Freed blocks go onto a free list and are reused first.
+	 * Every thread keeps a small cache of free blocks per pool, so allocating and freeing usually touches neither a lock nor another thread's cache line.
+	 * Blocks only move between a thread cache and the shared free list in batches, when the cache runs empty or overflows.
+	 * Memory is never returned to the OS while the pool exists, the working set of chunks stays roughly constant anyways.
+	 */
+
+	/// <summary>
+	/// Occupancy of a SlabPool.
+	/// </summary>
+	struct PoolStats {
+		std::string name;
+		size_t blockSize;
+		/// <summary>
+		/// Blocks that are not on the shared free list, i.e. allocated or sitting in the cache of a thread.
+		/// </summary>
+		size_t blocksInUse;
+		/// <summary>
+		/// Blocks that were carved from a slab so far. The pool can hand out this many blocks without committing more memory.
+		/// </summary>
+		size_t blocksCarved;
+		size_t slabs;
+		size_t bytesCommitted;
+	};
+
+	/// <summary>
+	/// Thread-safe allocator for blocks of a single size.
+	/// </summary>
+	class SlabPool {
+	public:
+		static constexpr size_t SLAB_SIZE = 2 * 1024 * 1024;
+		/// <summary>
+		/// Maximum number of pools that exist at the same time.
+		/// </summary>
+		static constexpr uint32_t MAX_POOLS = 32;
+
+		/// <param name="name">Shown in the statistics</param>
+		/// <param name="tag">Subsystem the committed memory is attributed to in the MemoryTracker</param>
+		/// <param name="alignment">Power of two, at most the page size</param>
+		/// <param name="maxBytes">Address space to reserve, the pool can never grow larger than this</param>
+		SlabPool(std::string name, size_t blockSize, MemoryTag tag = MemoryTag::General, size_t alignment = alignof(std::max_align_t), size_t maxBytes = 1ull << 30);
+		/// <summary>
+		/// Releases all memory of the pool, including blocks that were not freed.
+		/// </summary>
+		~SlabPool();
+
+		SlabPool(const SlabPool&) = delete;
+		void operator=(const SlabPool&) = delete;
+
+		/// <returns>An uninitialized block, or nullptr if the pool is exhausted</returns>
+		[[nodiscard]] void* Allocate();
+		/// <summary>
+		/// Returns a block to the pool. May be called from any thread, not only the one that allocated the block.
+		/// </summary>
+		void Free(void* p);
+
+		[[nodiscard]] size_t GetBlockSize() const { return m_BlockSize; }
+		[[nodiscard]] PoolStats GetStats() const;
+
+		/// <returns>The statistics of every pool that currently exists</returns>
+		[[nodiscard]] static std::vector<PoolStats> GetAllStats();
+		/// <summary>
+		/// Prints the statistics of every pool to the log.
+		/// </summary>
+		static void PrintReport();
+		/// <summary>
+		/// Whether slabs committed from now on should be backed by transparent huge pages. Off by default.
+		/// </summary>
+		static void SetHugePages(bool enabled);
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+		struct ThreadCache;
+		static thread_local ThreadCache t_Cache;
+
+		/// <summary>
+		/// Moves up to count blocks from the shared free list (or fresh ones from a slab) into a list.
+		/// </summary>
+		/// <returns>The number of blocks that were moved</returns>
+		uint32_t AcquireBatch(FreeBlock*& head, uint32_t count);
+		/// <summary>
+		/// Puts a list of blocks back onto the shared free list.
+		/// </summary>
+		void ReleaseBatch(FreeBlock* head, FreeBlock* tail, uint32_t count);
+
+		std::string m_Name;
+		size_t m_BlockSize;
+		MemoryTag m_Tag;
+		std::byte* m_Base;
+		size_t m_Reserved;
+		/// <summary>
+		/// Index of the pool in the registry and in every thread cache.
+		/// </summary>
+		uint32_t m_Slot;
+		/// <summary>
+		/// Distinguishes this pool from earlier pools in the same slot, whose blocks may still be in a thread cache.
+		/// </summary>
+		uint32_t m_Generation;
+
+		mutable std::mutex m_Mutex;
+		FreeBlock* m_FreeList = nullptr;
+		size_t m_FreeCount = 0;
+		/// <summary>
+		/// Bytes from m_Base that were handed out as blocks or committed.
+		/// </summary>
+		size_t m_Carved = 0;
+		size_t m_Committed = 0;
+	};
+
+	/// <summary>
+	/// A SlabPool for objects of type T.
+	/// </summary>
+	template<typename T>
+	class ObjectPool {
+	public:
+		explicit ObjectPool(std::string name, MemoryTag tag = MemoryTag::General, size_t alignment = alignof(T))
+			: m_Pool{ std::move(name), sizeof(T), tag, alignment }
+		{ }
+
+		/// <returns>A new object, or nullptr if the pool is exhausted</returns>
+		template<typename... Args>
+		[[nodiscard]] T* New(Args&&... args) {
+			auto* p = m_Pool.Allocate();
+			if (!p)
+				return nullptr;
+			return new (p) T(std::forward<Args>(args)...);
+		}
+		void Delete(T* obj) {
+			if (!obj)
+				return;
+			obj->~T();
+			m_Pool.Free(obj);
+		}
+
+		[[nodiscard]] PoolStats GetStats() const { return m_Pool.GetStats(); }
+
+	private:
+		SlabPool m_Pool;
+	};
+
+}
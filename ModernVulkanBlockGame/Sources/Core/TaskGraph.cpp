@@ -0,0 +1,181 @@
+#include "TaskGraph.h"
+
+#include <fstream>
+
+#include "JobSystem.h"
+#include "Json.h"
+#include "Logging/Log.h"
+
+namespace Core {
+
+	static const char* ToString(TaskGraph::Status status) {
+		switch (status) {
+		case TaskGraph::Status::Pending: return "pending";
+		case TaskGraph::Status::Succeeded: return "ok";
+		case TaskGraph::Status::Failed: return "failed";
+		case TaskGraph::Status::Skipped: return "skipped";
+		}
+		return "unknown";
+	}
+
+	TaskGraph::TaskId TaskGraph::Add(std::string name, std::function<bool()> fn, std::initializer_list<TaskId> deps, bool mainThread) {
+		auto id = (TaskId)m_Tasks.size();
+
+		auto task = std::make_unique<Task>();
+		task->name = std::move(name);
+		task->fn = std::move(fn);
+		task->numDeps = (uint32_t)deps.size();
+		task->mainThread = mainThread;
+		task->status = Status::Pending;
+		task->thread = 0;
+
+		// Dependencies always have a smaller id than the dependent task, so the graph can never contain a cycle.
+		for (auto d : deps)
+			m_Tasks[d]->dependents.push_back(id);
+
+		m_Tasks.push_back(std::move(task));
+		return id;
+	}
+
+	bool TaskGraph::Run() {
+		m_Start = Clock::now();
+		m_NumRemaining = (uint32_t)m_Tasks.size();
+
+		for (auto& t : m_Tasks) {
+			t->remainingDeps = t->numDeps;
+			t->depFailed = false;
+		}
+		for (TaskId i = 0; i < m_Tasks.size(); i++) {
+			if (m_Tasks[i]->numDeps == 0)
+				Schedule(i);
+		}
+
+		// The calling thread executes every task that is bound to it, until the whole graph has finished.
+		while (true) {
+			TaskId next;
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_CV.wait(lock, [this] { return !m_MainThreadQueue.empty() || m_NumRemaining == 0; });
+				if (m_MainThreadQueue.empty())
+					break;
+				next = m_MainThreadQueue.front();
+				m_MainThreadQueue.pop_front();
+			}
+			Execute(next);
+		}
+
+		m_End = Clock::now();
+
+		bool success = true;
+		for (const auto& t : m_Tasks)
+			success &= t->status == Status::Succeeded;
+		return success;
+	}
+
+	void TaskGraph::Schedule(TaskId id) {
+		if (m_Tasks[id]->mainThread) {
+			{
+				std::lock_guard lock{ m_Mutex };
+				m_MainThreadQueue.push_back(id);
+			}
+			m_CV.notify_all();
+		} else {
+			JobSystem::Submit([this, id] { Execute(id); });
+		}
+	}
+
+	void TaskGraph::Execute(TaskId id) {
+		auto& task = *m_Tasks[id];
+
+		if (task.depFailed) {
+			task.status = Status::Skipped;
+		} else {
+			task.thread = JobSystem::GetThreadIndex();
+			task.start = Clock::now();
+			bool ok;
+			try {
+				ok = task.fn();
+			} catch (const std::exception& e) {
+				// An exception must not escape into the JobSystem, so we treat it like a failed task.
+				Log::Error("Task {} threw an exception: {}", task.name, e.what());
+				ok = false;
+			}
+			task.end = Clock::now();
+			task.status = ok ? Status::Succeeded : Status::Failed;
+		}
+
+		for (auto d : task.dependents) {
+			auto& dep = *m_Tasks[d];
+			if (task.status != Status::Succeeded)
+				dep.depFailed = true;
+			if (dep.remainingDeps.fetch_sub(1) == 1)
+				Schedule(d);
+		}
+
+		// Notifying while holding the lock ensures that Run() cannot return (and destroy the graph) before we are done.
+		std::lock_guard lock{ m_Mutex };
+		m_NumRemaining--;
+		m_CV.notify_all();
+	}
+
+	void TaskGraph::AddMilestone(std::string name) {
+		m_Milestones.emplace_back(std::move(name), ToMs(Clock::now()));
+	}
+
+	std::vector<TaskGraph::TaskTiming> TaskGraph::GetTimings() const {
+		std::vector<TaskTiming> res;
+		res.reserve(m_Tasks.size());
+		for (const auto& t : m_Tasks) {
+			auto executed = t->status == Status::Succeeded || t->status == Status::Failed;
+			res.push_back({
+				t->name, t->status, t->thread,
+				executed ? ToMs(t->start) : 0.0,
+				executed ? ToMs(t->end) : 0.0,
+			});
+		}
+		return res;
+	}
+
+	void TaskGraph::PrintReport() const {
+		std::string report = Log::format("Startup took {:.2f} ms on {} threads:", ToMs(m_End), JobSystem::GetWorkerCount() + 1);
+		for (const auto& t : GetTimings()) {
+			report += Log::format("\n    {:<28} {:>8.2f} -> {:>8.2f} ms ({:>8.2f} ms) thread {} [{}]",
+				t.name, t.startMs, t.endMs, t.endMs - t.startMs, t.thread, ToString(t.status));
+		}
+		for (const auto& [name, ms] : m_Milestones)
+			report += Log::format("\n    {:<28} {:>8.2f} ms", name, ms);
+
+		Log::Info("{}", report);
+	}
+
+	bool TaskGraph::WriteJsonReport(const std::string& path) const {
+		std::ofstream out{ path };
+		if (!out) {
+			Log::Error("Failed to open {} for writing", path);
+			return false;
+		}
+
+		out << "{\n";
+		out << Log::format("  \"total_ms\": {:.3f},\n", ToMs(m_End));
+		out << Log::format("  \"threads\": {},\n", JobSystem::GetWorkerCount() + 1);
+		out << "  \"tasks\": [\n";
+		auto timings = GetTimings();
+		for (size_t i = 0; i < timings.size(); i++) {
+			const auto& t = timings[i];
+			out << Log::format("    {{ \"name\": \"{}\", \"status\": \"{}\", \"thread\": {}, \"start_ms\": {:.3f}, \"end_ms\": {:.3f}, \"duration_ms\": {:.3f} }}{}\n",
+				Json::Escape(t.name), ToString(t.status), t.thread, t.startMs, t.endMs, t.endMs - t.startMs, i + 1 < timings.size() ? "," : "");
+		}
+		out << "  ],\n";
+		out << "  \"milestones\": {";
+		for (size_t i = 0; i < m_Milestones.size(); i++)
+			out << Log::format("{} \"{}\": {:.3f}", i > 0 ? "," : "", Json::Escape(m_Milestones[i].first), m_Milestones[i].second);
+		out << " }\n";
+		out << "}\n";
+		return true;
+	}
+
+	double TaskGraph::ToMs(Clock::time_point t) const {
+		return std::chrono::duration<double, std::milli>(t - m_Start).count();
+	}
+
+}
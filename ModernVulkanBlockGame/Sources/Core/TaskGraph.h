@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Core {
+
+	/// <summary>
+	/// A set of tasks with dependencies between them. Tasks whose dependencies are finished run concurrently on the JobSystem,
+	/// which is used to overlap independent initialization steps. Every task is timed, so that a breakdown can be printed afterwards.
+	/// </summary>
+	class TaskGraph {
+	public:
+		using TaskId = uint32_t;
+
+		enum class Status {
+			Pending,
+			Succeeded,
+			Failed,
+			/// <summary>
+			/// The task was not executed since one of its dependencies failed.
+			/// </summary>
+			Skipped,
+		};
+
+		struct TaskTiming {
+			std::string name;
+			Status status;
+			/// <summary>
+			/// JobSystem thread index the task was executed on, 0 is the thread that called Run().
+			/// </summary>
+			uint32_t thread;
+			double startMs;
+			double endMs;
+		};
+
+		/// <summary>
+		/// Adds a task to the graph.
+		/// </summary>
+		/// <param name="name">Name of the task used in the timing report</param>
+		/// <param name="fn">The task function, returning false aborts every task depending on this one</param>
+		/// <param name="deps">Tasks that must be finished before this task may start</param>
+		/// <param name="mainThread">Run the task on the thread that calls Run(), required e.g. for most GLFW functions</param>
+		/// <returns>Id of the task, used to specify dependencies</returns>
+		TaskId Add(std::string name, std::function<bool()> fn, std::initializer_list<TaskId> deps = {}, bool mainThread = false);
+
+		/// <summary>
+		/// Executes every task and blocks until all of them are finished.
+		/// </summary>
+		/// <returns>True if every task succeeded</returns>
+		bool Run();
+
+		/// <summary>
+		/// Records the time since Run() was called under the given name, e.g. the time to the first rendered frame.
+		/// </summary>
+		void AddMilestone(std::string name);
+
+		/// <returns>The timings of every task, in the order they were added</returns>
+		[[nodiscard]] std::vector<TaskTiming> GetTimings() const;
+
+		/// <summary>
+		/// Prints a human readable timing breakdown to the log.
+		/// </summary>
+		void PrintReport() const;
+		/// <summary>
+		/// Writes the timing breakdown as JSON, so that it can be tracked by scripts.
+		/// </summary>
+		/// <returns>False if the file could not be written</returns>
+		bool WriteJsonReport(const std::string& path) const;
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Task {
+			std::string name;
+			std::function<bool()> fn;
+			std::vector<TaskId> dependents;
+			uint32_t numDeps;
+			bool mainThread;
+
+			std::atomic<uint32_t> remainingDeps;
+			std::atomic<bool> depFailed;
+			Status status;
+			uint32_t thread;
+			Clock::time_point start;
+			Clock::time_point end;
+		};
+
+		void Schedule(TaskId id);
+		void Execute(TaskId id);
+		[[nodiscard]] double ToMs(Clock::time_point t) const;
+
+		std::vector<std::unique_ptr<Task>> m_Tasks;
+		std::vector<std::pair<std::string, double>> m_Milestones;
+		Clock::time_point m_Start;
+		Clock::time_point m_End;
+
+		/// <summary>
+		/// Tasks that became ready but must be executed by the thread that called Run().
+		/// </summary>
+		std::deque<TaskId> m_MainThreadQueue;
+		uint32_t m_NumRemaining;
+		std::mutex m_Mutex;
+		std::condition_variable m_CV;
+	};
+
+}
@@ -0,0 +1,119 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Json.h"
+#include "Logging/Log.h"
+
+namespace Core::Trace {
+
+	/// <summary>
+	/// Number of zones each thread keeps. When a buffer is full, the oldest zones are overwritten.
+	/// </summary>
+	static constexpr size_t BUFFER_SIZE = 1 << 16;
+
+	struct Event {
+		const char* name;
+		uint64_t startNs;
+		uint64_t endNs;
+	};
+
+	struct ThreadBuffer {
+		uint32_t id;
+		std::string name;
+		std::array<Event, BUFFER_SIZE> events;
+		/// <summary>
+		/// Total number of events ever recorded, only written by the owning thread.
+		/// </summary>
+		std::atomic<uint64_t> count;
+	};
+
+	/// <summary>
+	/// Every buffer ever created. Buffers outlive their threads, so that zones of finished threads still end up in the trace.
+	/// </summary>
+	static std::vector<std::unique_ptr<ThreadBuffer>> g_Buffers;
+	static std::mutex g_BuffersMutex;
+
+	static thread_local ThreadBuffer* t_Buffer = nullptr;
+	/// <summary>
+	/// Name given to the calling thread before it recorded any zone, used once its buffer is created.
+	/// </summary>
+	static thread_local std::string t_Name;
+
+	/// <returns>The buffer of the calling thread, which is created on first use</returns>
+	static ThreadBuffer& GetBuffer() {
+		if (!t_Buffer) {
+			auto buffer = std::make_unique<ThreadBuffer>();
+			std::lock_guard lock{ g_BuffersMutex };
+			buffer->id = (uint32_t)g_Buffers.size();
+			buffer->name = t_Name.empty() ? Log::format("Thread {}", buffer->id) : std::move(t_Name);
+			buffer->count = 0;
+			t_Buffer = buffer.get();
+			g_Buffers.push_back(std::move(buffer));
+		}
+		return *t_Buffer;
+	}
+
+	void Record(const char* name, uint64_t startNs, uint64_t endNs) {
+		auto& buffer = GetBuffer();
+		auto count = buffer.count.load(std::memory_order_relaxed);
+		buffer.events[count % BUFFER_SIZE] = { name, startNs, endNs };
+		buffer.count.store(count + 1, std::memory_order_release);
+	}
+
+	void SetThreadName(std::string name) {
+		// Threads that never record a zone (e.g. every thread when tracing is compiled out) shouldn't get a buffer just for their name.
+		if (!t_Buffer) {
+			t_Name = std::move(name);
+			return;
+		}
+		std::lock_guard lock{ g_BuffersMutex };
+		t_Buffer->name = std::move(name);
+	}
+
+	bool WriteChromeTrace(const std::string& path) {
+		std::ofstream out{ path };
+		if (!out) {
+			Log::Error("Failed to open {} for writing", path);
+			return false;
+		}
+
+		std::lock_guard lock{ g_BuffersMutex };
+
+		// Chrome traces use microseconds, we make them relative to the earliest zone for readability.
+		uint64_t origin = UINT64_MAX;
+		for (const auto& b : g_Buffers) {
+			auto count = b->count.load(std::memory_order_acquire);
+			for (uint64_t i = count > BUFFER_SIZE ? count - BUFFER_SIZE : 0; i < count; i++)
+				origin = std::min(origin, b->events[i % BUFFER_SIZE].startNs);
+		}
+
+		size_t numEvents = 0;
+		out << "{\"traceEvents\":[\n";
+		bool first = true;
+		for (const auto& b : g_Buffers) {
+			out << Log::format("{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+				first ? "" : ",\n", b->id, Json::Escape(b->name));
+			first = false;
+
+			auto count = b->count.load(std::memory_order_acquire);
+			for (uint64_t i = count > BUFFER_SIZE ? count - BUFFER_SIZE : 0; i < count; i++) {
+				const auto& e = b->events[i % BUFFER_SIZE];
+				out << Log::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+					Json::Escape(e.name), b->id, (e.startNs - origin) / 1000.0, (e.endNs - e.startNs) / 1000.0);
+				numEvents++;
+			}
+		}
+		out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		Log::Info("Wrote {} trace zones of {} threads to {}", numEvents, g_Buffers.size(), path);
+		return true;
+	}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/*
+ * Tracing zones are compiled into Debug builds. In Release builds they compile to nothing, unless ENABLE_TRACING is defined
+ * (e.g. by building with "make config=Release tracing=1").
+ */
+#if !defined(NDEBUG) || defined(ENABLE_TRACING)
+#define TRACING_ENABLED 1
+#else
+#define TRACING_ENABLED 0
+#endif
+
+namespace Core::Trace {
+
+	/*
+	 * A zone measures the time between its construction and destruction on the current thread.
+	 * Every thread records its zones into its own ring buffer, so recording a zone never takes a lock.
+	 * The buffers can be written as a Chrome trace (JSON), which can be opened in chrome://tracing or https://ui.perfetto.dev.
+	 */
+
+	/// <summary>
+	/// Records a finished zone into the ring buffer of the calling thread.
+	/// </summary>
+	/// <param name="name">Name of the zone, must stay valid until the trace was written (e.g. a string literal)</param>
+	void Record(const char* name, uint64_t startNs, uint64_t endNs);
+
+	/// <summary>
+	/// Names the calling thread in the trace. Doesn't allocate the ring buffer, a thread only gets one once it records a zone.
+	/// </summary>
+	void SetThreadName(std::string name);
+
+	/// <summary>
+	/// Writes every recorded zone as Chrome trace JSON.
+	/// </summary>
+	/// <remarks>Zones that are recorded while writing may be missing or, if a ring buffer wrapped around, be corrupted. Best called on shutdown.</remarks>
+	/// <returns>False if the file could not be written</returns>
+	bool WriteChromeTrace(const std::string& path);
+
+	/// <returns>Nanoseconds since an arbitrary, fixed point in time</returns>
+	inline uint64_t Now() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/// <summary>
+	/// Records a zone spanning its lifetime. Use the TRACE_ZONE macro instead of this class directly.
+	/// </summary>
+	class Zone {
+	public:
+		explicit Zone(const char* name)
+			: m_Name{name}, m_Start{Now()}
+		{ }
+		~Zone() { Record(m_Name, m_Start, Now()); }
+
+		Zone(const Zone&) = delete;
+		void operator=(const Zone&) = delete;
+
+	private:
+		const char* m_Name;
+		uint64_t m_Start;
+	};
+
+}
+
+#if TRACING_ENABLED
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+/// <summary>
+/// Traces the rest of the enclosing scope under the given name, which must be a string literal.
+/// </summary>
+#define TRACE_ZONE(name) ::Core::Trace::Zone TRACE_CONCAT(traceZone, __LINE__){ name }
+#else
+#define TRACE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace Core {
+
+	/// <summary>
+	/// Passes values from one producer thread to one consumer thread. The producer can always write and the consumer always reads
+	/// the newest complete value, neither of them ever waits. Values the consumer didn't pick up in time are overwritten.
+	/// </summary>
+	/*
+	 * There are three slots: the producer writes into the back slot, the consumer reads the front slot.
+	 * Publishing swaps the back slot with the middle slot, latching swaps the front slot with the middle slot.
+	 * Both swaps are a single atomic exchange of the middle index, which also carries a flag telling whether it holds a new value.
+	 */
+	template<typename T>
+	class TripleBuffer {
+	public:
+		/// <summary>
+		/// Publishes a value, replacing the previously published one if the consumer didn't latch it yet.
+		/// </summary>
+		/// <remarks>Must only be called by the producer thread.</remarks>
+		void Publish(const T& value) {
+			m_Slots[m_Back] = value;
+			auto prev = m_Middle.exchange(m_Back | NEW_BIT, std::memory_order_acq_rel);
+			m_Back = prev & INDEX_MASK;
+		}
+
+		/// <summary>
+		/// Makes the newest published value available through Front().
+		/// </summary>
+		/// <remarks>Must only be called by the consumer thread.</remarks>
+		/// <returns>True if a value was published since the last call</returns>
+		bool Latch() {
+			if (!(m_Middle.load(std::memory_order_relaxed) & NEW_BIT))
+				return false;
+			auto prev = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+			m_Front = prev & INDEX_MASK;
+			return true;
+		}
+
+		/// <returns>The value latched last, or a default constructed value if nothing was latched yet</returns>
+		/// <remarks>Must only be called by the consumer thread.</remarks>
+		[[nodiscard]] const T& Front() const { return m_Slots[m_Front]; }
+
+	private:
+		static constexpr uint8_t NEW_BIT = 0x4;
+		static constexpr uint8_t INDEX_MASK = 0x3;
+
+		std::array<T, 3> m_Slots{};
+		alignas(64) uint8_t m_Back = 0;
+		alignas(64) std::atomic<uint8_t> m_Middle{ 1 };
+		alignas(64) uint8_t m_Front = 2;
+	};
+
+}
@@ -0,0 +1,82 @@
+#include "VirtualMemory.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Core::VirtualMemory {
+
+	size_t GetPageSize() {
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		return info.dwPageSize;
+#else
+		return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+	}
+
+	void* Reserve(size_t size) {
+#ifdef _WIN32
+		// Windows reservations are aligned to the allocation granularity (64 KiB), so we reserve more and release it to get huge page alignment.
+		auto* p = VirtualAlloc(nullptr, size + HUGE_PAGE_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+		if (!p)
+			return nullptr;
+		auto aligned = ((uintptr_t)p + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+		VirtualFree(p, 0, MEM_RELEASE);
+		// Another thread may have taken the range in between, in which case we fall back to the unaligned reservation.
+		if (auto* q = VirtualAlloc((void*)aligned, size, MEM_RESERVE, PAGE_NOACCESS))
+			return q;
+		return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+		// Over-reserve and unmap the unaligned head and tail. MAP_NORESERVE keeps the reservation from counting against the commit limit.
+		auto* p = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (p == MAP_FAILED)
+			return nullptr;
+		auto start = (uintptr_t)p;
+		auto aligned = (start + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+		if (aligned > start)
+			munmap(p, aligned - start);
+		auto tail = start + size + HUGE_PAGE_SIZE - (aligned + size);
+		if (tail > 0)
+			munmap((void*)(aligned + size), tail);
+		return (void*)aligned;
+#endif
+	}
+
+	bool Commit(void* p, size_t size, bool hugePages) {
+#ifdef _WIN32
+		// Large pages on Windows need a privilege and can't be committed inside a reservation, so the hint is ignored.
+		(void)hugePages;
+		return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+		if (mprotect(p, size, PROT_READ | PROT_WRITE) != 0)
+			return false;
+#ifdef MADV_HUGEPAGE
+		// Transparent huge pages don't need to be set up by the administrator like MAP_HUGETLB, the kernel uses them when it can.
+		if (hugePages)
+			madvise(p, size, MADV_HUGEPAGE);
+#else
+		(void)hugePages;
+#endif
+		return true;
+#endif
+	}
+
+	void Release(void* p, size_t size) {
+#ifdef _WIN32
+		(void)size;
+		VirtualFree(p, 0, MEM_RELEASE);
+#else
+		munmap(p, size);
+#endif
+	}
+
+}
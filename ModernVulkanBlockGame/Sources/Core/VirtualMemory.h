@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Core::VirtualMemory {
+
+	/*
+	 * Reserving address space and committing memory are separate steps: a reservation only claims a range of addresses,
+	 * memory is only used once a part of it is committed. This lets an allocator reserve a large contiguous range up front
+	 * and grow into it without ever moving anything.
+	 */
+
+	/// <summary>
+	/// Size of a transparent huge page on x86-64. Committing aligned ranges of this size allows the OS to back them with huge pages.
+	/// </summary>
+	inline constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+	[[nodiscard]] size_t GetPageSize();
+
+	/// <summary>
+	/// Reserves a range of address space without committing any memory.
+	/// </summary>
+	/// <param name="size">Size in bytes, a multiple of the page size</param>
+	/// <returns>The start of the range, aligned to HUGE_PAGE_SIZE, or nullptr on failure</returns>
+	[[nodiscard]] void* Reserve(size_t size);
+	/// <summary>
+	/// Commits a part of a reserved range. Committed memory is zeroed.
+	/// </summary>
+	/// <param name="hugePages">Ask the OS to back the range with huge pages, which reduces TLB misses. Only a hint, ignored on Windows.</param>
+	/// <returns>False if the memory could not be committed</returns>
+	bool Commit(void* p, size_t size, bool hugePages);
+	/// <summary>
+	/// Returns a whole reserved range to the OS.
+	/// </summary>
+	void Release(void* p, size_t size);
+
+}
@@ -0,0 +1,75 @@
+#include "Archetype.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace ECS {
+
+	static size_t AlignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	Archetype::Archetype(ComponentMask mask)
+		: m_Mask{mask}, m_Offsets{}, m_Capacity{0}, m_ChunkSize{CHUNK_SIZE}
+	{
+		for (auto bits = mask; bits != 0; bits &= bits - 1)
+			m_Components.push_back((ComponentId)std::countr_zero(bits));
+
+		// Start with the capacity ignoring padding and shrink it until every array (and the padding in front of it) fits.
+		size_t rowSize = sizeof(Entity);
+		for (auto id : m_Components)
+			rowSize += GetComponentInfo(id).size;
+		m_Capacity = std::max((uint32_t)(CHUNK_SIZE / rowSize), 1u);
+		while (m_Capacity > 1 && ComputeLayout(m_Capacity) > CHUNK_SIZE)
+			m_Capacity--;
+		// Only if a single entity doesn't fit, chunks are larger than CHUNK_SIZE.
+		m_ChunkSize = std::max(ComputeLayout(m_Capacity), CHUNK_SIZE);
+	}
+
+	size_t Archetype::ComputeLayout(uint32_t capacity) {
+		size_t offset = sizeof(Entity) * capacity;
+		for (auto id : m_Components) {
+			const auto& info = GetComponentInfo(id);
+			offset = AlignUp(offset, info.alignment);
+			m_Offsets[id] = (uint32_t)offset;
+			offset += (size_t)info.size * capacity;
+		}
+		return offset;
+	}
+
+	Archetype::Location Archetype::Allocate(Entity entity) {
+		if (m_Chunks.empty() || m_Chunks.back().count == m_Capacity) {
+			auto data = m_SpareChunk ? std::move(m_SpareChunk) : std::unique_ptr<std::byte, ChunkDeleter>{
+				(std::byte*)::operator new(m_ChunkSize, std::align_val_t{ CHUNK_ALIGNMENT })
+			};
+			m_Chunks.push_back({ std::move(data), 0 });
+		}
+
+		auto chunk = (uint32_t)m_Chunks.size() - 1;
+		auto row = m_Chunks[chunk].count++;
+		GetEntities(chunk)[row] = entity;
+		return { chunk, row };
+	}
+
+	Entity Archetype::Remove(Location location) {
+		auto lastChunk = (uint32_t)m_Chunks.size() - 1;
+		auto lastRow = m_Chunks[lastChunk].count - 1;
+
+		auto moved = NULL_ENTITY;
+		if (location.chunk != lastChunk || location.row != lastRow) {
+			for (auto id : m_Components) {
+				memcpy(GetComponent(location.chunk, location.row, id), GetComponent(lastChunk, lastRow, id), GetComponentInfo(id).size);
+			}
+			moved = GetEntities(lastChunk)[lastRow];
+			GetEntities(location.chunk)[location.row] = moved;
+		}
+
+		if (--m_Chunks[lastChunk].count == 0) {
+			m_SpareChunk = std::move(m_Chunks.back().data);
+			m_Chunks.pop_back();
+		}
+		return moved;
+	}
+
+}
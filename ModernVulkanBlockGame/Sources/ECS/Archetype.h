@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "Component.h"
+#include "Entity.h"
+
+namespace ECS {
+
+	/*
+	 * An archetype stores every entity that has exactly a certain set of components.
+	 * Its entities live in fixed size chunks. Within a chunk, every component type has its own array (structure of arrays),
+	 * so a query touching only positions streams through nothing but positions, and the loops can be vectorized.
+	 * Entities are kept dense: removing one moves the last entity of the archetype into the hole, so every chunk but the last is full.
+	 */
+
+	class Archetype {
+	public:
+		/// <summary>
+		/// Size of a chunk in bytes. Small enough to stay in L1/L2 while a system works on it, large enough to amortize the per-chunk overhead.
+		/// </summary>
+		static constexpr size_t CHUNK_SIZE = 16 * 1024;
+		static constexpr size_t CHUNK_ALIGNMENT = 64;
+
+		explicit Archetype(ComponentMask mask);
+
+		Archetype(const Archetype&) = delete;
+		void operator=(const Archetype&) = delete;
+
+		[[nodiscard]] ComponentMask GetMask() const { return m_Mask; }
+		[[nodiscard]] bool Has(ComponentId id) const { return (m_Mask >> id) & 1; }
+		[[nodiscard]] const std::vector<ComponentId>& GetComponents() const { return m_Components; }
+		/// <returns>The number of entities a chunk can hold</returns>
+		[[nodiscard]] uint32_t GetChunkCapacity() const { return m_Capacity; }
+		[[nodiscard]] uint32_t GetChunkCount() const { return (uint32_t)m_Chunks.size(); }
+		/// <returns>The number of entities in a chunk</returns>
+		[[nodiscard]] uint32_t GetEntityCount(uint32_t chunk) const { return m_Chunks[chunk].count; }
+
+		[[nodiscard]] Entity* GetEntities(uint32_t chunk) { return (Entity*)m_Chunks[chunk].data.get(); }
+		/// <returns>The array of a component in a chunk, the archetype must contain the component</returns>
+		[[nodiscard]] void* GetArray(uint32_t chunk, ComponentId id) { return m_Chunks[chunk].data.get() + m_Offsets[id]; }
+		template<Component T>
+		[[nodiscard]] T* GetArray(uint32_t chunk) { return (T*)GetArray(chunk, GetComponentId<T>()); }
+		[[nodiscard]] void* GetComponent(uint32_t chunk, uint32_t row, ComponentId id) {
+			return (std::byte*)GetArray(chunk, id) + (size_t)row * GetComponentInfo(id).size;
+		}
+
+		struct Location {
+			uint32_t chunk;
+			uint32_t row;
+		};
+
+		/// <summary>
+		/// Appends an entity. Its components are left uninitialized.
+		/// </summary>
+		Location Allocate(Entity entity);
+		/// <summary>
+		/// Removes the entity at the given location by moving the last entity of the archetype into its place.
+		/// </summary>
+		/// <returns>The entity that was moved to the given location, or NULL_ENTITY if the removed entity was the last one</returns>
+		Entity Remove(Location location);
+
+	private:
+		/// <summary>
+		/// Computes m_Offsets for the given number of entities per chunk.
+		/// </summary>
+		/// <returns>The number of bytes a chunk needs</returns>
+		size_t ComputeLayout(uint32_t capacity);
+
+		struct ChunkDeleter {
+			void operator()(std::byte* data) const { ::operator delete(data, std::align_val_t{ CHUNK_ALIGNMENT }); }
+		};
+		struct Chunk {
+			std::unique_ptr<std::byte, ChunkDeleter> data;
+			uint32_t count;
+		};
+
+		ComponentMask m_Mask;
+		std::vector<ComponentId> m_Components;
+		/// <summary>
+		/// Byte offset of the array of every component contained in this archetype within a chunk. The entity array is at offset 0.
+		/// </summary>
+		std::array<uint32_t, MAX_COMPONENTS> m_Offsets;
+		uint32_t m_Capacity;
+		size_t m_ChunkSize;
+		std::vector<Chunk> m_Chunks;
+		/// <summary>
+		/// A chunk that became empty is kept here instead of being freed, so an entity moving back and forth doesn't allocate every time.
+		/// </summary>
+		std::unique_ptr<std::byte, ChunkDeleter> m_SpareChunk;
+	};
+
+}
@@ -0,0 +1,69 @@
+#include "CommandBuffer.h"
+
+#include <array>
+#include <cstring>
+
+#include "World.h"
+
+namespace ECS {
+
+	void CommandBuffer::Append(const void* data, size_t size) {
+		auto offset = m_Data.size();
+		m_Data.resize(offset + size);
+		memcpy(m_Data.data() + offset, data, size);
+	}
+
+	void CommandBuffer::Playback(World& world) {
+		const auto* p = m_Data.data();
+		const auto* end = p + m_Data.size();
+
+		// Operands are copied out instead of dereferenced in place, since the stream doesn't keep them aligned.
+		auto read = [&p]<typename T>(T& value) {
+			memcpy(&value, p, sizeof(T));
+			p += sizeof(T);
+		};
+
+		std::array<ComponentId, MAX_COMPONENTS> ids;
+		std::array<const void*, MAX_COMPONENTS> data;
+		while (p < end) {
+			Op op;
+			read(op);
+			Entity entity;
+			ComponentId id;
+			switch (op) {
+			case Op::Create: {
+				uint32_t count;
+				read(count);
+				for (uint32_t i = 0; i < count; i++) {
+					read(ids[i]);
+					// World copies components with memcpy, so they may stay unaligned.
+					data[i] = p;
+					p += GetComponentInfo(ids[i]).size;
+				}
+				world.CreateRaw(count, ids.data(), data.data());
+				break;
+			}
+			case Op::Destroy:
+				read(entity);
+				if (world.IsAlive(entity))
+					world.Destroy(entity);
+				break;
+			case Op::Add:
+				read(entity);
+				read(id);
+				if (world.IsAlive(entity))
+					world.AddRaw(entity, id, p);
+				p += GetComponentInfo(id).size;
+				break;
+			case Op::Remove:
+				read(entity);
+				read(id);
+				if (world.IsAlive(entity))
+					world.RemoveRaw(entity, id);
+				break;
+			}
+		}
+		m_Data.clear();
+	}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Component.h"
+#include "Entity.h"
+
+namespace ECS {
+
+	class World;
+
+	/// <summary>
+	/// Records structural changes (creating and destroying entities, adding and removing components) to be applied later.
+	/// </summary>
+	/// <remarks>
+	/// Structural changes move entities between chunks, so they must not happen while a query iterates over them.
+	/// Systems record them instead, and World::FlushCommands() applies them once the iteration finished.
+	/// A CommandBuffer is not thread-safe, every thread records into its own, see World::GetCommandBuffer().
+	/// </remarks>
+	class CommandBuffer {
+	public:
+		/// <summary>
+		/// Creates an entity with the given components. Since the entity doesn't exist before the buffer is applied, no handle is returned.
+		/// </summary>
+		template<Component... Ts>
+		void Create(const Ts&... components) {
+			PutOp(Op::Create);
+			Put((uint32_t)sizeof...(Ts));
+			(PutComponent(GetComponentId<Ts>(), &components), ...);
+		}
+
+		void Destroy(Entity entity) {
+			PutOp(Op::Destroy);
+			Put(entity);
+		}
+
+		/// <summary>
+		/// Adds a component, or overwrites it if the entity already has it.
+		/// </summary>
+		template<Component T>
+		void Add(Entity entity, const T& component) {
+			PutOp(Op::Add);
+			Put(entity);
+			PutComponent(GetComponentId<T>(), &component);
+		}
+
+		template<Component T>
+		void Remove(Entity entity) {
+			PutOp(Op::Remove);
+			Put(entity);
+			Put(GetComponentId<T>());
+		}
+
+		[[nodiscard]] bool IsEmpty() const { return m_Data.empty(); }
+
+		/// <summary>
+		/// Applies every recorded command in order and clears the buffer. Commands referring to entities that were destroyed meanwhile are skipped.
+		/// </summary>
+		void Playback(World& world);
+
+	private:
+		/*
+		 * Commands are stored as a stream of bytes: the op followed by its operands, components as their id followed by their bytes.
+		 * Recording a command never allocates once the buffer has grown to its working size.
+		 */
+		enum class Op : uint8_t {
+			Create,
+			Destroy,
+			Add,
+			Remove,
+		};
+
+		void Append(const void* data, size_t size);
+		void PutOp(Op op) { Append(&op, sizeof(op)); }
+		template<typename T>
+		void Put(const T& value) { Append(&value, sizeof(T)); }
+		void PutComponent(ComponentId id, const void* data) {
+			Put(id);
+			Append(data, GetComponentInfo(id).size);
+		}
+
+		std::vector<std::byte> m_Data;
+	};
+
+}
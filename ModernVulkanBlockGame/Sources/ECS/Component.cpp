@@ -0,0 +1,33 @@
+#include "Component.h"
+
+#include <array>
+#include <cstdlib>
+#include <mutex>
+
+#include "Logging/Log.h"
+
+namespace ECS {
+
+	static std::mutex g_Mutex;
+	static std::array<ComponentInfo, MAX_COMPONENTS> g_Components;
+	static uint32_t g_NumComponents;
+
+	namespace Detail {
+		ComponentId RegisterComponent(const ComponentInfo& info) {
+			// Ids are assigned when a type is first used, which may happen on any thread.
+			std::lock_guard lock{ g_Mutex };
+			if (g_NumComponents == MAX_COMPONENTS) {
+				// The crash handler of the log writes the message before we go down.
+				Log::Error("Too many component types, {} can't be registered", info.name);
+				std::abort();
+			}
+			g_Components[g_NumComponents] = info;
+			return g_NumComponents++;
+		}
+	}
+
+	const ComponentInfo& GetComponentInfo(ComponentId id) {
+		return g_Components[id];
+	}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <typeinfo>
+
+namespace ECS {
+
+	/*
+	 * Components are plain data. Since they are moved between chunks with memcpy and chunks are freed without calling destructors,
+	 * they must be trivially copyable and destructible. Anything owning memory (strings, vectors) belongs into a system instead.
+	 */
+
+	template<typename T>
+	concept Component = std::is_trivially_copyable_v<std::remove_const_t<T>> && std::is_trivially_destructible_v<std::remove_const_t<T>>;
+
+	/// <summary>
+	/// Index of a component type, assigned in the order the types are first used.
+	/// </summary>
+	using ComponentId = uint32_t;
+	/// <summary>
+	/// Set of component types, bit i being set meaning that the component with id i is contained.
+	/// </summary>
+	using ComponentMask = uint64_t;
+
+	inline constexpr uint32_t MAX_COMPONENTS = 64;
+
+	struct ComponentInfo {
+		const char* name;
+		uint32_t size;
+		uint32_t alignment;
+	};
+
+	namespace Detail {
+		/// <summary>
+		/// Assigns the next free id to a component type.
+		/// </summary>
+		ComponentId RegisterComponent(const ComponentInfo& info);
+	}
+
+	/// <returns>The id of a component type. const is ignored, so T and const T have the same id.</returns>
+	template<Component T>
+	ComponentId GetComponentId() {
+		using D = std::remove_const_t<T>;
+		if constexpr (!std::is_same_v<T, D>) {
+			return GetComponentId<D>();
+		} else {
+			static const ComponentId id = Detail::RegisterComponent({ typeid(D).name(), (uint32_t)sizeof(D), (uint32_t)alignof(D) });
+			return id;
+		}
+	}
+
+	template<Component... Ts>
+	ComponentMask GetComponentMask() {
+		return ((ComponentMask{ 1 } << GetComponentId<Ts>()) | ... | 0);
+	}
+
+	[[nodiscard]] const ComponentInfo& GetComponentInfo(ComponentId id);
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ECS {
+
+	/// <summary>
+	/// Handle of an entity. The index of a destroyed entity is reused, the generation tells the old and the new entity apart.
+	/// </summary>
+	struct Entity {
+		uint32_t index;
+		uint32_t generation;
+
+		bool operator==(const Entity& r) const = default;
+	};
+
+	/// <summary>
+	/// Handle that never refers to an entity.
+	/// </summary>
+	inline constexpr Entity NULL_ENTITY{ UINT32_MAX, 0 };
+
+}
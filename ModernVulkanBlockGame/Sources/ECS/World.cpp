@@ -0,0 +1,139 @@
+#include "World.h"
+
+#include <cstring>
+
+namespace ECS {
+
+	World::World()
+		: m_NumEntities{0}, m_CommandBuffers(Core::JobSystem::GetWorkerCount() + 1)
+	{ }
+
+	Entity World::CreateRaw(uint32_t count, const ComponentId* ids, const void* const* data) {
+		ComponentMask mask = 0;
+		for (uint32_t i = 0; i < count; i++)
+			mask |= ComponentMask{ 1 } << ids[i];
+		auto& archetype = GetArchetype(mask);
+
+		Entity entity;
+		if (!m_FreeIndices.empty()) {
+			entity.index = m_FreeIndices.back();
+			m_FreeIndices.pop_back();
+		} else {
+			entity.index = (uint32_t)m_Records.size();
+			m_Records.push_back({ nullptr, 0, 0, 0 });
+		}
+		// The generation was already incremented when the previous entity with this index was destroyed.
+		entity.generation = m_Records[entity.index].generation;
+
+		auto loc = archetype.Allocate(entity);
+		for (uint32_t i = 0; i < count; i++)
+			memcpy(archetype.GetComponent(loc.chunk, loc.row, ids[i]), data[i], GetComponentInfo(ids[i]).size);
+
+		m_Records[entity.index] = { &archetype, loc.chunk, loc.row, entity.generation };
+		m_NumEntities++;
+		return entity;
+	}
+
+	void World::Destroy(Entity entity) {
+		// A stale handle may refer to an index that was reused by another entity by now.
+		if (!IsAlive(entity))
+			return;
+		auto& r = m_Records[entity.index];
+		auto moved = r.archetype->Remove({ r.chunk, r.row });
+		if (moved != NULL_ENTITY) {
+			m_Records[moved.index].chunk = r.chunk;
+			m_Records[moved.index].row = r.row;
+		}
+
+		r.archetype = nullptr;
+		// Every handle to the destroyed entity becomes invalid.
+		r.generation++;
+		m_FreeIndices.push_back(entity.index);
+		m_NumEntities--;
+	}
+
+	bool World::IsAlive(Entity entity) const {
+		return entity.index < m_Records.size()
+			&& m_Records[entity.index].archetype
+			&& m_Records[entity.index].generation == entity.generation;
+	}
+
+	void World::AddRaw(Entity entity, ComponentId id, const void* data) {
+		if (!IsAlive(entity))
+			return;
+		auto* archetype = m_Records[entity.index].archetype;
+		auto loc = Archetype::Location{ m_Records[entity.index].chunk, m_Records[entity.index].row };
+		if (!archetype->Has(id)) {
+			archetype = &GetArchetype(archetype->GetMask() | (ComponentMask{ 1 } << id));
+			loc = MoveEntity(entity, *archetype);
+		}
+		memcpy(archetype->GetComponent(loc.chunk, loc.row, id), data, GetComponentInfo(id).size);
+	}
+
+	void World::RemoveRaw(Entity entity, ComponentId id) {
+		if (!IsAlive(entity))
+			return;
+		auto* archetype = m_Records[entity.index].archetype;
+		if (archetype->Has(id))
+			MoveEntity(entity, GetArchetype(archetype->GetMask() & ~(ComponentMask{ 1 } << id)));
+	}
+
+	Archetype::Location World::MoveEntity(Entity entity, Archetype& target) {
+		auto& r = m_Records[entity.index];
+		auto& source = *r.archetype;
+
+		auto loc = target.Allocate(entity);
+		for (auto id : target.GetComponents()) {
+			if (source.Has(id))
+				memcpy(target.GetComponent(loc.chunk, loc.row, id), source.GetComponent(r.chunk, r.row, id), GetComponentInfo(id).size);
+		}
+
+		auto moved = source.Remove({ r.chunk, r.row });
+		if (moved != NULL_ENTITY) {
+			m_Records[moved.index].chunk = r.chunk;
+			m_Records[moved.index].row = r.row;
+		}
+
+		r.archetype = &target;
+		r.chunk = loc.chunk;
+		r.row = loc.row;
+		return loc;
+	}
+
+	void World::FlushCommands() {
+		for (auto& buffer : m_CommandBuffers) {
+			if (!buffer.IsEmpty())
+				buffer.Playback(*this);
+		}
+	}
+
+	Archetype& World::GetArchetype(ComponentMask mask) {
+		auto it = m_ArchetypesByMask.find(mask);
+		if (it != m_ArchetypesByMask.end())
+			return *it->second;
+
+		auto& archetype = *m_Archetypes.emplace_back(std::make_unique<Archetype>(mask));
+		m_ArchetypesByMask.emplace(mask, &archetype);
+		return archetype;
+	}
+
+	const std::vector<Archetype*>& World::Query(ComponentMask mask) {
+		auto& query = m_Queries[mask];
+		for (; query.checked < m_Archetypes.size(); query.checked++) {
+			auto* archetype = m_Archetypes[query.checked].get();
+			if ((archetype->GetMask() & mask) == mask)
+				query.archetypes.push_back(archetype);
+		}
+		return query.archetypes;
+	}
+
+	const std::vector<World::ChunkRef>& World::GatherChunks(ComponentMask mask) {
+		m_ChunkRefs.clear();
+		for (auto* a : Query(mask)) {
+			for (uint32_t c = 0; c < a->GetChunkCount(); c++)
+				m_ChunkRefs.push_back({ a, c });
+		}
+		return m_ChunkRefs;
+	}
+
+}
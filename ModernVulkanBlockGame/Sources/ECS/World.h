@@ -0,0 +1,188 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Archetype.h"
+#include "CommandBuffer.h"
+#include "Component.h"
+#include "Entity.h"
+#include "Core/JobSystem.h"
+
+namespace ECS {
+
+	/*
+	 * The World owns every entity and its components, grouped into archetypes by their set of components (see Archetype).
+	 * Systems are plain functions running queries: a query visits every archetype containing (at least) the requested components,
+	 * chunk by chunk, handing out the component arrays of the chunk. The archetypes matching a set of components are cached,
+	 * so a query costs one lookup plus the iteration itself.
+	 *
+	 * Structural changes (Create, Destroy, Add, Remove) move entities between chunks and must not happen during a query.
+	 * Within a query, they are recorded into a CommandBuffer and applied afterwards by FlushCommands().
+	 */
+
+	class World {
+	public:
+		/// <remarks>Must be created after Core::JobSystem::Initialize(), since every worker thread gets its own CommandBuffer.</remarks>
+		World();
+
+		World(const World&) = delete;
+		void operator=(const World&) = delete;
+
+		template<Component... Ts>
+		Entity Create(const Ts&... components) {
+			std::array<ComponentId, sizeof...(Ts)> ids{ GetComponentId<Ts>()... };
+			std::array<const void*, sizeof...(Ts)> data{ &components... };
+			return CreateRaw((uint32_t)sizeof...(Ts), ids.data(), data.data());
+		}
+		/// <summary>
+		/// Destroys an entity. Does nothing if it was already destroyed.
+		/// </summary>
+		void Destroy(Entity entity);
+
+		/// <returns>True if the entity was created and not destroyed yet</returns>
+		[[nodiscard]] bool IsAlive(Entity entity) const;
+		[[nodiscard]] uint32_t GetEntityCount() const { return m_NumEntities; }
+
+		/// <summary>
+		/// Adds a component, or overwrites it if the entity already has it. Does nothing if the entity was destroyed.
+		/// </summary>
+		template<Component T>
+		void Add(Entity entity, const T& component) { AddRaw(entity, GetComponentId<T>(), &component); }
+		/// <summary>
+		/// Removes a component. Does nothing if the entity doesn't have it or was destroyed.
+		/// </summary>
+		template<Component T>
+		void Remove(Entity entity) { RemoveRaw(entity, GetComponentId<T>()); }
+
+		/// <returns>False if the entity doesn't have the component or was destroyed</returns>
+		template<Component T>
+		[[nodiscard]] bool Has(Entity entity) const { return IsAlive(entity) && m_Records[entity.index].archetype->Has(GetComponentId<T>()); }
+		/// <returns>The component of an entity, or nullptr if it doesn't have it or was destroyed. Only valid until the next structural change.</returns>
+		template<Component T>
+		[[nodiscard]] T* Get(Entity entity) {
+			if (!IsAlive(entity))
+				return nullptr;
+			const auto& r = m_Records[entity.index];
+			auto id = GetComponentId<T>();
+			return r.archetype->Has(id) ? (T*)r.archetype->GetComponent(r.chunk, r.row, id) : nullptr;
+		}
+
+		/// <summary>
+		/// Calls fn(count, entities, arrays...) for every chunk containing the components Ts, with one array per component.
+		/// Declare components that are only read as const.
+		/// </summary>
+		template<Component... Ts, typename Fn>
+		void ForEachChunk(Fn&& fn) {
+			for (auto* a : Query(GetComponentMask<Ts...>())) {
+				for (uint32_t c = 0; c < a->GetChunkCount(); c++)
+					fn(a->GetEntityCount(c), (const Entity*)a->GetEntities(c), a->template GetArray<Ts>(c)...);
+			}
+		}
+		/// <summary>
+		/// Calls fn(components...) for every entity with the components Ts.
+		/// </summary>
+		template<Component... Ts, typename Fn>
+		void Each(Fn&& fn) {
+			ForEachChunk<Ts...>([&fn](uint32_t count, const Entity*, Ts*... arrays) {
+				for (uint32_t i = 0; i < count; i++)
+					fn(arrays[i]...);
+			});
+		}
+
+		/// <summary>
+		/// Like ForEachChunk(), but the chunks are distributed over the JobSystem. Blocks until every chunk was processed.
+		/// fn runs concurrently, so it may only write to the components of its own chunk, and structural changes go to GetCommandBuffer().
+		/// </summary>
+		/// <param name="chunksPerJob">Number of chunks a job processes, more chunks per job have less overhead but balance worse</param>
+		template<Component... Ts, typename Fn>
+		void ParallelForEachChunk(Fn&& fn, uint32_t chunksPerJob = 4) {
+			const auto& chunks = GatherChunks(GetComponentMask<Ts...>());
+			Core::JobSystem::ParallelFor((uint32_t)chunks.size(), chunksPerJob, [&chunks, &fn](uint32_t begin, uint32_t end) {
+				for (auto i = begin; i < end; i++) {
+					auto [a, c] = chunks[i];
+					fn(a->GetEntityCount(c), (const Entity*)a->GetEntities(c), a->template GetArray<Ts>(c)...);
+				}
+			});
+		}
+		/// <summary>
+		/// Like Each(), but the chunks are distributed over the JobSystem, see ParallelForEachChunk().
+		/// </summary>
+		template<Component... Ts, typename Fn>
+		void ParallelEach(Fn&& fn, uint32_t chunksPerJob = 4) {
+			ParallelForEachChunk<Ts...>([&fn](uint32_t count, const Entity*, Ts*... arrays) {
+				for (uint32_t i = 0; i < count; i++)
+					fn(arrays[i]...);
+			}, chunksPerJob);
+		}
+
+		/// <returns>The CommandBuffer of the calling thread</returns>
+		/// <remarks>Every thread that is not a worker of the JobSystem shares one buffer, so only one of them may use it.</remarks>
+		[[nodiscard]] CommandBuffer& GetCommandBuffer() { return m_CommandBuffers[Core::JobSystem::GetThreadIndex()]; }
+		/// <summary>
+		/// Applies the commands of every thread's CommandBuffer, in order of the thread index.
+		/// </summary>
+		void FlushCommands();
+
+		/// <summary>
+		/// Creates an entity with count components whose ids and data are given, used where the types are not known at compile time.
+		/// </summary>
+		Entity CreateRaw(uint32_t count, const ComponentId* ids, const void* const* data);
+		void AddRaw(Entity entity, ComponentId id, const void* data);
+		void RemoveRaw(Entity entity, ComponentId id);
+
+	private:
+		struct Record {
+			/// <summary>
+			/// nullptr if the entity was destroyed.
+			/// </summary>
+			Archetype* archetype;
+			uint32_t chunk;
+			uint32_t row;
+			uint32_t generation;
+		};
+
+		struct CachedQuery {
+			/// <summary>
+			/// Number of archetypes that were checked so far. Archetypes are never removed, so only newer ones have to be checked.
+			/// </summary>
+			size_t checked = 0;
+			std::vector<Archetype*> archetypes;
+		};
+
+		struct ChunkRef {
+			Archetype* archetype;
+			uint32_t chunk;
+		};
+
+		/// <returns>The archetype with exactly the given components, which is created if it doesn't exist yet</returns>
+		Archetype& GetArchetype(ComponentMask mask);
+		/// <returns>Every archetype containing at least the given components</returns>
+		const std::vector<Archetype*>& Query(ComponentMask mask);
+		/// <returns>Every chunk of every archetype containing at least the given components</returns>
+		const std::vector<ChunkRef>& GatherChunks(ComponentMask mask);
+		/// <summary>
+		/// Moves an entity to another archetype, copying every component both archetypes have in common.
+		/// </summary>
+		/// <returns>The new location of the entity</returns>
+		Archetype::Location MoveEntity(Entity entity, Archetype& target);
+
+		std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+		std::unordered_map<ComponentMask, Archetype*> m_ArchetypesByMask;
+		std::unordered_map<ComponentMask, CachedQuery> m_Queries;
+		std::vector<ChunkRef> m_ChunkRefs;
+
+		std::vector<Record> m_Records;
+		std::vector<uint32_t> m_FreeIndices;
+		uint32_t m_NumEntities;
+
+		/// <summary>
+		/// One buffer per JobSystem thread index.
+		/// </summary>
+		std::vector<CommandBuffer> m_CommandBuffers;
+	};
+
+}
@@ -0,0 +1,149 @@
+#include "Chunk.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "Core/SlabPool.h"
+
+namespace Game {
+
+	/*
+	 * Block arrays are aligned to a cache line, so the meshing and lighting passes never read a line shared with another chunk.
+	 * The pools are created during static initialization, before main() could create a chunk, and destroyed after the last chunk is gone.
+	 */
+	static Core::ObjectPool<Chunk> g_ChunkPool{ "Chunk", Core::MemoryTag::Chunks };
+	/// <summary>
+	/// The reference count is stored in front of the block array, padded to a cache line so the array stays aligned.
+	/// </summary>
+	static constexpr size_t BLOCK_HEADER_SIZE = 64;
+	static Core::SlabPool g_BlockPool{ "Chunk Blocks", BLOCK_HEADER_SIZE + Chunk::VOLUME * sizeof(BlockId), Core::MemoryTag::Chunks, 64 };
+	static Core::SlabPool g_LightPool{ "Chunk Light", Chunk::VOLUME * sizeof(uint8_t), Core::MemoryTag::Chunks, 64 };
+
+	static std::atomic<uint64_t> g_CopiesOnWrite;
+
+	static std::atomic<uint32_t>& GetRefCount(const BlockId* blocks) {
+		return *std::launder((std::atomic<uint32_t>*)((std::byte*)blocks - BLOCK_HEADER_SIZE));
+	}
+
+	/// <returns>A block array with a reference count of 1, uninitialized, or nullptr if the pool is exhausted</returns>
+	static BlockId* AllocateBlocks() {
+		auto* p = (std::byte*)g_BlockPool.Allocate();
+		if (!p)
+			return nullptr;
+		new (p) std::atomic<uint32_t>{ 1 };
+		return (BlockId*)(p + BLOCK_HEADER_SIZE);
+	}
+
+	static void RetainBlocks(const BlockId* blocks) {
+		if (blocks)
+			GetRefCount(blocks).fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Drops a reference, the last one frees the array.
+	/// </summary>
+	static void ReleaseBlocks(const BlockId* blocks) {
+		// Acquire-release, so the reads of a snapshot on another thread happen before the array is reused or written in place.
+		if (blocks && GetRefCount(blocks).fetch_sub(1, std::memory_order_acq_rel) == 1)
+			g_BlockPool.Free((std::byte*)blocks - BLOCK_HEADER_SIZE);
+	}
+
+	ChunkSnapshot::ChunkSnapshot(ivec3 position, const BlockId* blocks)
+		: m_Position{ position }, m_Blocks{ blocks }
+	{
+		RetainBlocks(m_Blocks);
+	}
+
+	ChunkSnapshot::~ChunkSnapshot() {
+		ReleaseBlocks(m_Blocks);
+	}
+
+	ChunkSnapshot::ChunkSnapshot(const ChunkSnapshot& r)
+		: ChunkSnapshot{ r.m_Position, r.m_Blocks }
+	{ }
+
+	ChunkSnapshot& ChunkSnapshot::operator=(const ChunkSnapshot& r) {
+		RetainBlocks(r.m_Blocks);
+		ReleaseBlocks(m_Blocks);
+		m_Position = r.m_Position;
+		m_Blocks = r.m_Blocks;
+		return *this;
+	}
+
+	ChunkSnapshot::ChunkSnapshot(ChunkSnapshot&& r) noexcept
+		: m_Position{ r.m_Position }, m_Blocks{ std::exchange(r.m_Blocks, nullptr) }
+	{ }
+
+	ChunkSnapshot& ChunkSnapshot::operator=(ChunkSnapshot&& r) noexcept {
+		if (this != &r) {
+			ReleaseBlocks(m_Blocks);
+			m_Position = r.m_Position;
+			m_Blocks = std::exchange(r.m_Blocks, nullptr);
+		}
+		return *this;
+	}
+
+	void ChunkDeleter::operator()(Chunk* chunk) const {
+		g_ChunkPool.Delete(chunk);
+	}
+
+	ChunkPtr Chunk::Create(ivec3 position) {
+		return ChunkPtr{ g_ChunkPool.New(position) };
+	}
+
+	Chunk::~Chunk() {
+		ReleaseBlocks(m_Blocks);
+		g_LightPool.Free(m_Light);
+	}
+
+	BlockId* Chunk::GetOrCreateBlocks() {
+		if (!m_Blocks) {
+			m_Blocks = AllocateBlocks();
+			if (m_Blocks)
+				std::fill_n(m_Blocks, VOLUME, AIR);
+		} else if (GetRefCount(m_Blocks).load(std::memory_order_acquire) > 1) {
+			// Only this thread takes snapshots, so the count can't grow meanwhile. If it drops, we merely copied for nothing.
+			auto* copy = AllocateBlocks();
+			if (!copy)
+				return nullptr;
+			memcpy(copy, m_Blocks, VOLUME * sizeof(BlockId));
+			ReleaseBlocks(m_Blocks);
+			m_Blocks = copy;
+			g_CopiesOnWrite.fetch_add(1, std::memory_order_relaxed);
+		}
+		return m_Blocks;
+	}
+
+	ChunkSnapshot Chunk::Snapshot() const {
+		return ChunkSnapshot{ m_Position, m_Blocks };
+	}
+
+	uint64_t Chunk::GetCopyOnWriteCount() {
+		return g_CopiesOnWrite.load(std::memory_order_relaxed);
+	}
+
+	bool Chunk::SetBlock(int32_t x, int32_t y, int32_t z, BlockId block) {
+		// Setting air in an empty chunk doesn't change anything, so there is no need to allocate.
+		if (!m_Blocks && block == AIR)
+			return true;
+		auto* blocks = GetOrCreateBlocks();
+		if (!blocks)
+			return false;
+		blocks[Index(x, y, z)] = block;
+		m_Modified = true;
+		return true;
+	}
+
+	uint8_t* Chunk::GetOrCreateLight() {
+		if (!m_Light) {
+			m_Light = (uint8_t*)g_LightPool.Allocate();
+			if (m_Light)
+				std::fill_n(m_Light, VOLUME, uint8_t{ 0 });
+		}
+		return m_Light;
+	}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include "Maths/ivec3.h"
+
+namespace Game {
+
+	/// <summary>
+	/// Type of a block, 0 is air.
+	/// </summary>
+	using BlockId = uint16_t;
+	inline constexpr BlockId AIR = 0;
+	inline constexpr BlockId STONE = 1;
+	inline constexpr BlockId DIRT = 2;
+	inline constexpr BlockId GRASS = 3;
+	inline constexpr BlockId SAND = 4;
+	inline constexpr BlockId WATER = 5;
+
+	/*
+	 * The world is divided into cubes of SIZE^3 blocks. Chunks are loaded and unloaded all the time while the player moves,
+	 * so the Chunk objects and their block and light arrays come from SlabPools instead of the general purpose allocator.
+	 * The arrays are only allocated once a chunk contains something, most chunks of a world are entirely air (or entirely dark).
+	 *
+	 * Block arrays are reference-counted, so a ChunkSnapshot can share the array of its chunk instead of copying it.
+	 * Writing to an array that is shared first copies it (copy-on-write): the snapshot keeps the blocks as they were when it was taken,
+	 * e.g. while a save job encodes them on a worker, and only the chunks that are actually edited meanwhile are duplicated.
+	 */
+
+	class Chunk;
+
+	/// <summary>
+	/// The blocks of a chunk at the time the snapshot was taken. Taking one only increments a reference count.
+	/// Snapshots may be copied and destroyed on any thread.
+	/// </summary>
+	class ChunkSnapshot {
+	public:
+		ChunkSnapshot() = default;
+		~ChunkSnapshot();
+		ChunkSnapshot(const ChunkSnapshot& r);
+		ChunkSnapshot& operator=(const ChunkSnapshot& r);
+		ChunkSnapshot(ChunkSnapshot&& r) noexcept;
+		ChunkSnapshot& operator=(ChunkSnapshot&& r) noexcept;
+
+		[[nodiscard]] ivec3 GetPosition() const { return m_Position; }
+		/// <returns>The block array, or nullptr if the chunk was entirely air</returns>
+		[[nodiscard]] const BlockId* GetBlocks() const { return m_Blocks; }
+
+	private:
+		friend class Chunk;
+		ChunkSnapshot(ivec3 position, const BlockId* blocks);
+
+		ivec3 m_Position{};
+		const BlockId* m_Blocks = nullptr;
+	};
+
+	struct ChunkDeleter {
+		void operator()(Chunk* chunk) const;
+	};
+	using ChunkPtr = std::unique_ptr<Chunk, ChunkDeleter>;
+
+	class Chunk {
+	public:
+		static constexpr int32_t SIZE = 16;
+		static constexpr int32_t VOLUME = SIZE * SIZE * SIZE;
+
+		/// <summary>
+		/// Creates an empty chunk.
+		/// </summary>
+		/// <param name="position">Chunk coordinate, i.e. the block coordinate of its minimum corner divided by SIZE</param>
+		/// <returns>The chunk, or nullptr if the pool is exhausted</returns>
+		[[nodiscard]] static ChunkPtr Create(ivec3 position);
+
+		explicit Chunk(ivec3 position)
+			: m_Position{position}
+		{ }
+		~Chunk();
+
+		Chunk(const Chunk&) = delete;
+		void operator=(const Chunk&) = delete;
+
+		/// <summary>
+		/// Index of a block in the arrays. y is the slowest changing coordinate, so a horizontal layer is contiguous.
+		/// </summary>
+		[[nodiscard]] static constexpr int32_t Index(int32_t x, int32_t y, int32_t z) {
+			return x + z * SIZE + y * SIZE * SIZE;
+		}
+
+		[[nodiscard]] ivec3 GetPosition() const { return m_Position; }
+		[[nodiscard]] bool IsEmpty() const { return !m_Blocks; }
+
+		/// <returns>Whether the blocks changed since the chunk was last loaded or saved</returns>
+		[[nodiscard]] bool IsModified() const { return m_Modified; }
+		/// <summary>
+		/// SetBlock() marks the chunk as modified, writing to the array directly (e.g. when generating it) doesn't.
+		/// </summary>
+		void SetModified(bool modified) { m_Modified = modified; }
+
+		/// <param name="x">Coordinate within the chunk, 0 to SIZE-1</param>
+		[[nodiscard]] BlockId GetBlock(int32_t x, int32_t y, int32_t z) const {
+			return m_Blocks ? m_Blocks[Index(x, y, z)] : AIR;
+		}
+		/// <returns>False if the block array could not be allocated</returns>
+		bool SetBlock(int32_t x, int32_t y, int32_t z, BlockId block);
+		/// <returns>The block array, or nullptr if the chunk is entirely air</returns>
+		[[nodiscard]] const BlockId* GetBlocks() const { return m_Blocks; }
+		/// <summary>
+		/// Allocates the block array if necessary, filled with air. If a snapshot shares the array, the chunk gets its own copy first.
+		/// </summary>
+		/// <returns>The block array, or nullptr if it could not be allocated</returns>
+		[[nodiscard]] BlockId* GetOrCreateBlocks();
+		/// <summary>
+		/// Shares the block array with a new snapshot. Must be called by the thread that modifies the chunk.
+		/// </summary>
+		[[nodiscard]] ChunkSnapshot Snapshot() const;
+		/// <returns>The number of block arrays copied because a snapshot shared them, over all chunks</returns>
+		[[nodiscard]] static uint64_t GetCopyOnWriteCount();
+
+		/// <returns>Light level (sky light in the high nibble, block light in the low one), 0 if the chunk has no light data</returns>
+		[[nodiscard]] uint8_t GetLight(int32_t x, int32_t y, int32_t z) const {
+			return m_Light ? m_Light[Index(x, y, z)] : 0;
+		}
+		/// <returns>The light array, or nullptr if it could not be allocated</returns>
+		[[nodiscard]] uint8_t* GetOrCreateLight();
+
+	private:
+		ivec3 m_Position;
+		BlockId* m_Blocks = nullptr;
+		uint8_t* m_Light = nullptr;
+		bool m_Modified = false;
+	};
+
+}
@@ -0,0 +1,127 @@
+#include "ChunkCodec.h"
+
+#include <algorithm>
+
+namespace Game::ChunkCodec {
+
+	/// <summary>
+	/// Distinct block ids a chunk can contain.
+	/// </summary>
+	static constexpr uint32_t MAX_PALETTE_SIZE = Chunk::VOLUME;
+
+	static void PutVarint(std::vector<uint8_t>& out, uint32_t v) {
+		while (v >= 0x80) {
+			out.push_back((uint8_t)(v | 0x80));
+			v >>= 7;
+		}
+		out.push_back((uint8_t)v);
+	}
+
+	/// <returns>False if the data ended or the number has more than 32 bits</returns>
+	static bool GetVarint(const uint8_t*& p, const uint8_t* end, uint32_t& v) {
+		v = 0;
+		for (uint32_t shift = 0; shift < 35; shift += 7) {
+			if (p == end)
+				return false;
+			auto byte = *p++;
+			v |= (uint32_t)(byte & 0x7F) << shift;
+			if (!(byte & 0x80))
+				return true;
+		}
+		return false;
+	}
+
+	void Encode(const BlockId* blocks, std::vector<uint8_t>& out) {
+		if (!blocks || std::all_of(blocks, blocks + Chunk::VOLUME, [](BlockId b) { return b == AIR; })) {
+			out.push_back((uint8_t)Format::Empty);
+			return;
+		}
+		out.push_back((uint8_t)Format::PaletteRle);
+
+		/*
+		 * The palette is built in order of first appearance. Lookups only happen once per run, and chunks rarely contain more
+		 * than a handful of distinct blocks, so a linear search beats a hash map here.
+		 */
+		std::vector<BlockId> palette;
+		std::vector<uint32_t> runs;
+		auto indexOf = [&palette](BlockId block) {
+			auto it = std::find(palette.begin(), palette.end(), block);
+			if (it != palette.end())
+				return (uint32_t)(it - palette.begin());
+			palette.push_back(block);
+			return (uint32_t)palette.size() - 1;
+		};
+
+		int32_t i = 0;
+		while (i < Chunk::VOLUME) {
+			auto block = blocks[i];
+			auto start = i;
+			while (i < Chunk::VOLUME && blocks[i] == block)
+				i++;
+			runs.push_back(indexOf(block));
+			runs.push_back((uint32_t)(i - start));
+		}
+
+		PutVarint(out, (uint32_t)palette.size());
+		for (auto block : palette)
+			PutVarint(out, block);
+		for (auto v : runs)
+			PutVarint(out, v);
+	}
+
+	bool Decode(const uint8_t* data, size_t size, Chunk& chunk) {
+		const auto* p = data;
+		const auto* end = data + size;
+		if (p == end)
+			return false;
+		auto format = (Format)*p++;
+		if (format == Format::Empty)
+			return p == end;
+		if (format != Format::PaletteRle)
+			return false;
+
+		uint32_t paletteSize;
+		if (!GetVarint(p, end, paletteSize) || paletteSize == 0 || paletteSize > MAX_PALETTE_SIZE)
+			return false;
+		std::vector<BlockId> palette(paletteSize);
+		for (auto& block : palette) {
+			uint32_t v;
+			if (!GetVarint(p, end, v) || v > UINT16_MAX)
+				return false;
+			block = (BlockId)v;
+		}
+
+		// The runs are validated before the block array is allocated, so corrupted data leaves the chunk untouched.
+		const auto* runs = p;
+		uint32_t i = 0;
+		while (i < (uint32_t)Chunk::VOLUME) {
+			uint32_t index, length;
+			if (!GetVarint(p, end, index) || !GetVarint(p, end, length) || index >= paletteSize || length == 0 || length > Chunk::VOLUME - i)
+				return false;
+			i += length;
+		}
+		if (p != end)
+			return false;
+
+		auto* blocks = chunk.GetOrCreateBlocks();
+		if (!blocks)
+			return false;
+		p = runs;
+		for (i = 0; i < (uint32_t)Chunk::VOLUME;) {
+			uint32_t index, length;
+			GetVarint(p, end, index);
+			GetVarint(p, end, length);
+			std::fill_n(blocks + i, length, palette[index]);
+			i += length;
+		}
+		return true;
+	}
+
+	uint32_t Checksum(const uint8_t* data, size_t size) {
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ data[i]) * 16777619u;
+		return hash;
+	}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Chunk.h"
+
+namespace Game::ChunkCodec {
+
+	/*
+	 * Chunks contain few distinct blocks, in long runs along the horizontal layers (e.g. a layer of stone, then dirt, then air).
+	 * The encoding makes use of both:
+	 * - The palette lists the distinct block ids of the chunk, so a block only needs a small index into it.
+	 * - The blocks are stored as runs of (palette index, length) in the order of Chunk::Index(), i.e. layer by layer.
+	 * - Every number is a varint (7 bits per byte, the top bit tells whether another byte follows), so small numbers take a single byte.
+	 * A typical terrain chunk shrinks from 8 KiB to a few dozen bytes, and decoding is a few fills per run.
+	 *
+	 * Layout: the Format byte, for PaletteRle followed by the palette size, the palette ids and the runs until Chunk::VOLUME blocks are covered.
+	 */
+
+	enum class Format : uint8_t {
+		/// <summary>
+		/// Entirely air, nothing follows.
+		/// </summary>
+		Empty,
+		PaletteRle,
+	};
+
+	/// <summary>
+	/// Appends the encoded blocks of a chunk to out.
+	/// </summary>
+	/// <param name="blocks">The block array of a chunk or snapshot, nullptr if it is entirely air</param>
+	void Encode(const BlockId* blocks, std::vector<uint8_t>& out);
+	/// <summary>
+	/// Fills an empty chunk with encoded blocks.
+	/// </summary>
+	/// <returns>False if the data is corrupted or the block array could not be allocated</returns>
+	bool Decode(const uint8_t* data, size_t size, Chunk& chunk);
+
+	/// <returns>A checksum (32 bit FNV-1a) of the data, to detect torn or corrupted writes</returns>
+	[[nodiscard]] uint32_t Checksum(const uint8_t* data, size_t size);
+
+}
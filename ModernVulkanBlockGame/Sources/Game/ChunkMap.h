@@ -0,0 +1,320 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define CHUNK_MAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "Maths/ivec3.h"
+#include "Maths/Morton.h"
+
+namespace Game {
+
+	/*
+	 * Maps chunk coordinates to chunks. The mesher and lighting look up all 26 neighbors of a chunk, so lookups must be fast
+	 * and must not chase pointers through individually allocated nodes like std::unordered_map does.
+	 *
+	 * This is an open-addressing hash table in the style of Abseil's SwissTable. Next to the slots there is an array of control bytes,
+	 * one per slot: EMPTY, DELETED, or the lowest 7 bits of the hash of the slot's key. A lookup compares 16 control bytes at once with SSE2
+	 * and only looks at slots whose control byte matches, so it usually touches exactly one slot. The table stays below 7/8 full.
+	 *
+	 * Keys are the Morton codes of the coordinates (see Maths/Morton.h). The values themselves are stored in a dense array,
+	 * the slots only store the key and the index into that array. Iteration walks the dense array, and SortZOrder() sorts it by key,
+	 * which puts chunks that are close in space close in memory.
+	 */
+
+	template<typename T>
+	class ChunkMap {
+	public:
+		/// <summary>
+		/// Index of the center in the array returned by GetNeighborhood(). The neighbor at offset (x, y, z) is at index (x + 1) + (y + 1) * 3 + (z + 1) * 9.
+		/// </summary>
+		static constexpr uint32_t NEIGHBORHOOD_CENTER = 13;
+
+		struct Entry {
+			uint64_t key;
+			T value;
+
+			[[nodiscard]] ivec3 GetPosition() const { return Morton::Decode(key); }
+		};
+
+		ChunkMap() = default;
+		ChunkMap(const ChunkMap&) = delete;
+		void operator=(const ChunkMap&) = delete;
+		ChunkMap(ChunkMap&&) noexcept = default;
+		ChunkMap& operator=(ChunkMap&&) noexcept = default;
+
+		[[nodiscard]] size_t Size() const { return m_Entries.size(); }
+		[[nodiscard]] bool IsEmpty() const { return m_Entries.empty(); }
+
+		/// <returns>The value at a position, or nullptr if there is none</returns>
+		[[nodiscard]] T* Find(const ivec3& pos) {
+			auto key = Morton::Encode(pos);
+			auto slot = FindSlot(key, Hash(key));
+			return slot == NOT_FOUND ? nullptr : &m_Entries[m_Slots[slot].index].value;
+		}
+		[[nodiscard]] const T* Find(const ivec3& pos) const { return const_cast<ChunkMap*>(this)->Find(pos); }
+		[[nodiscard]] bool Contains(const ivec3& pos) const { return Find(pos) != nullptr; }
+
+		/// <summary>
+		/// Inserts a value if there is none at the position yet.
+		/// </summary>
+		/// <returns>The value at the position, and whether it was inserted</returns>
+		template<typename... Args>
+		std::pair<T*, bool> TryEmplace(const ivec3& pos, Args&&... args) {
+			auto key = Morton::Encode(pos);
+			auto hash = Hash(key);
+			if (auto slot = FindSlot(key, hash); slot != NOT_FOUND)
+				return { &m_Entries[m_Slots[slot].index].value, false };
+
+			if ((m_Entries.size() + m_NumDeleted + 1) * 8 > m_Capacity * 7)
+				Rehash(std::max<size_t>(m_Entries.size() * 2 + 1, GROUP_SIZE));
+
+			auto slot = FindFreeSlot(hash);
+			if (m_Control[slot] == DELETED)
+				m_NumDeleted--;
+			m_Control[slot] = H2(hash);
+			m_Slots[slot] = { key, (uint32_t)m_Entries.size() };
+			m_Entries.push_back({ key, T(std::forward<Args>(args)...) });
+			return { &m_Entries.back().value, true };
+		}
+
+		/// <summary>
+		/// Inserts a value, replacing the one at the position if there is one.
+		/// </summary>
+		T& InsertOrAssign(const ivec3& pos, T value) {
+			auto [v, inserted] = TryEmplace(pos, std::move(value));
+			if (!inserted)
+				*v = std::move(value);
+			return *v;
+		}
+
+		/// <summary>
+		/// Removes the value at a position. The last entry of the dense array takes its place, so iteration order changes.
+		/// </summary>
+		/// <returns>False if there was no value at the position</returns>
+		bool Erase(const ivec3& pos) {
+			auto key = Morton::Encode(pos);
+			auto slot = FindSlot(key, Hash(key));
+			if (slot == NOT_FOUND)
+				return false;
+
+			auto index = m_Slots[slot].index;
+			if (index != m_Entries.size() - 1) {
+				m_Entries[index] = std::move(m_Entries.back());
+				m_Slots[FindSlot(m_Entries[index].key, Hash(m_Entries[index].key))].index = index;
+			}
+			m_Entries.pop_back();
+
+			/*
+			 * If the slot's group still has an empty slot, no lookup ever probed past this group, so the slot can become empty again.
+			 * Otherwise, lookups for other keys may continue past it, so it must be marked as deleted.
+			 */
+			auto group = slot & ~(size_t)(GROUP_SIZE - 1);
+			if (MatchEmpty(&m_Control[group]) != 0) {
+				m_Control[slot] = EMPTY;
+			} else {
+				m_Control[slot] = DELETED;
+				m_NumDeleted++;
+			}
+			return true;
+		}
+
+		void Clear() {
+			m_Entries.clear();
+			if (m_Capacity > 0)
+				memset(m_Control.get(), EMPTY, m_Capacity);
+			m_NumDeleted = 0;
+		}
+
+		/// <summary>
+		/// Makes room for the given number of values without rehashing.
+		/// </summary>
+		void Reserve(size_t count) {
+			m_Entries.reserve(count);
+			if (count * 8 > m_Capacity * 7)
+				Rehash(count);
+		}
+
+		/// <summary>
+		/// Looks up a position and all 26 positions around it.
+		/// </summary>
+		/// <param name="out">Receives the values, nullptr where there is none, see NEIGHBORHOOD_CENTER for the order</param>
+		void GetNeighborhood(const ivec3& center, std::array<T*, 27>& out) {
+			/*
+			 * The keys of the neighbors are computed from the center's key with Morton::Add(), instead of encoding 27 positions.
+			 * All 27 groups are prefetched before the first one is probed, so their cache misses overlap instead of being paid one after another.
+			 */
+			static const auto OFFSETS = [] {
+				std::array<uint64_t, 27> offsets;
+				for (int32_t i = 0; i < 27; i++)
+					offsets[i] = Morton::EncodeOffset(ivec3{ i % 3 - 1, i / 3 % 3 - 1, i / 9 - 1 });
+				return offsets;
+			}();
+
+			if (m_Capacity == 0) {
+				out.fill(nullptr);
+				return;
+			}
+
+			auto centerKey = Morton::Encode(center);
+			std::array<uint64_t, 27> keys;
+			std::array<uint64_t, 27> hashes;
+			for (uint32_t i = 0; i < 27; i++) {
+				keys[i] = Morton::Add(centerKey, OFFSETS[i]);
+				hashes[i] = Hash(keys[i]);
+				Prefetch(&m_Control[FirstGroup(hashes[i])]);
+			}
+			for (uint32_t i = 0; i < 27; i++) {
+				auto slot = FindSlot(keys[i], hashes[i]);
+				out[i] = slot == NOT_FOUND ? nullptr : &m_Entries[m_Slots[slot].index].value;
+			}
+		}
+
+		/// <summary>
+		/// Sorts the values by the Morton code of their position, so iteration walks space in Z-order and neighbors are close in memory.
+		/// </summary>
+		/// <remarks>Invalidates pointers to values. Cheap if the values are already mostly sorted.</remarks>
+		void SortZOrder() {
+			std::sort(m_Entries.begin(), m_Entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+			for (uint32_t i = 0; i < m_Entries.size(); i++)
+				m_Slots[FindSlot(m_Entries[i].key, Hash(m_Entries[i].key))].index = i;
+		}
+
+		/// <summary>
+		/// The entries in iteration order, Z-order after SortZOrder() until the next insertion or removal.
+		/// </summary>
+		[[nodiscard]] auto begin() { return m_Entries.begin(); }
+		[[nodiscard]] auto end() { return m_Entries.end(); }
+		[[nodiscard]] auto begin() const { return m_Entries.begin(); }
+		[[nodiscard]] auto end() const { return m_Entries.end(); }
+
+	private:
+		static constexpr uint32_t GROUP_SIZE = 16;
+		static constexpr int8_t EMPTY = (int8_t)0x80;
+		static constexpr int8_t DELETED = (int8_t)0xFE;
+		static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+		struct Slot {
+			uint64_t key;
+			uint32_t index;
+		};
+
+		static uint64_t Hash(uint64_t key) {
+			// Morton codes of nearby chunks only differ in their lowest bits, so they must be mixed before they can index the table.
+			auto h = key * 0x9E3779B97F4A7C15ull;
+			return h ^ (h >> 32);
+		}
+		/// <summary>
+		/// The 7 bits of the hash stored in the control byte, always a non-negative value.
+		/// </summary>
+		static int8_t H2(uint64_t hash) { return (int8_t)(hash & 0x7F); }
+		/// <returns>The index of the first slot of the group where probing starts</returns>
+		size_t FirstGroup(uint64_t hash) const { return (size_t)(hash >> 7) & (m_Capacity - 1) & ~(size_t)(GROUP_SIZE - 1); }
+
+		static void Prefetch(const void* p) {
+#if defined(__GNUC__)
+			__builtin_prefetch(p);
+#elif defined(CHUNK_MAP_SSE2)
+			_mm_prefetch((const char*)p, _MM_HINT_T0);
+#endif
+		}
+
+		/// <returns>A bit mask with bit i set if control byte i of the group equals value</returns>
+		static uint32_t Match(const int8_t* group, int8_t value) {
+#ifdef CHUNK_MAP_SSE2
+			auto ctrl = _mm_loadu_si128((const __m128i*)group);
+			return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(value)));
+#else
+			uint32_t mask = 0;
+			for (uint32_t i = 0; i < GROUP_SIZE; i++)
+				mask |= (uint32_t)(group[i] == value) << i;
+			return mask;
+#endif
+		}
+		static uint32_t MatchEmpty(const int8_t* group) { return Match(group, EMPTY); }
+		/// <returns>A bit mask with bit i set if slot i of the group is empty or deleted, which are exactly the control bytes with the sign bit set</returns>
+		static uint32_t MatchFree(const int8_t* group) {
+#ifdef CHUNK_MAP_SSE2
+			return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+			uint32_t mask = 0;
+			for (uint32_t i = 0; i < GROUP_SIZE; i++)
+				mask |= (uint32_t)(group[i] < 0) << i;
+			return mask;
+#endif
+		}
+
+		/*
+		 * Probing visits whole groups in a triangular sequence (+1, +2, +3, ... groups), which visits every group exactly once
+		 * since the number of groups is a power of two.
+		 */
+
+		/// <returns>The slot containing the key, or NOT_FOUND</returns>
+		size_t FindSlot(uint64_t key, uint64_t hash) const {
+			if (m_Capacity == 0)
+				return NOT_FOUND;
+
+			auto h2 = H2(hash);
+			auto group = FirstGroup(hash);
+			for (size_t step = GROUP_SIZE; ; step += GROUP_SIZE) {
+				for (auto match = Match(&m_Control[group], h2); match != 0; match &= match - 1) {
+					auto slot = group + (size_t)std::countr_zero(match);
+					if (m_Slots[slot].key == key)
+						return slot;
+				}
+				// An empty slot ends the probe sequence: the key would have been inserted there.
+				if (MatchEmpty(&m_Control[group]) != 0)
+					return NOT_FOUND;
+				group = (group + step) & (m_Capacity - 1);
+			}
+		}
+
+		/// <returns>The first empty or deleted slot in the probe sequence of the hash</returns>
+		size_t FindFreeSlot(uint64_t hash) const {
+			auto group = FirstGroup(hash);
+			for (size_t step = GROUP_SIZE; ; step += GROUP_SIZE) {
+				if (auto match = MatchFree(&m_Control[group]); match != 0)
+					return group + (size_t)std::countr_zero(match);
+				group = (group + step) & (m_Capacity - 1);
+			}
+		}
+
+		/// <summary>
+		/// Rebuilds the table with room for at least count values, which also drops every deleted slot.
+		/// </summary>
+		void Rehash(size_t count) {
+			m_Capacity = std::bit_ceil(std::max<size_t>(count * 8 / 7 + 1, GROUP_SIZE));
+			m_Control = std::make_unique<int8_t[]>(m_Capacity);
+			m_Slots = std::make_unique<Slot[]>(m_Capacity);
+			memset(m_Control.get(), EMPTY, m_Capacity);
+			m_NumDeleted = 0;
+
+			for (uint32_t i = 0; i < m_Entries.size(); i++) {
+				auto hash = Hash(m_Entries[i].key);
+				auto slot = FindFreeSlot(hash);
+				m_Control[slot] = H2(hash);
+				m_Slots[slot] = { m_Entries[i].key, i };
+			}
+		}
+
+		std::unique_ptr<int8_t[]> m_Control;
+		std::unique_ptr<Slot[]> m_Slots;
+		/// <summary>
+		/// Number of slots, a power of two and a multiple of GROUP_SIZE, or 0 before the first insertion.
+		/// </summary>
+		size_t m_Capacity = 0;
+		size_t m_NumDeleted = 0;
+		std::vector<Entry> m_Entries;
+	};
+
+}
@@ -0,0 +1,605 @@
+#include "ChunkStreaming.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ChunkMap.h"
+#include "Core/CommandLine.h"
+#include "Core/JobSystem.h"
+#include "Core/Trace.h"
+#include "Logging/Log.h"
+
+namespace Game::ChunkStreaming {
+
+	enum class State : uint8_t {
+		/// <summary>
+		/// Waiting in g_Queue for a job to be issued.
+		/// </summary>
+		Queued,
+		/// <summary>
+		/// A job is loading or generating the chunk, or it is waiting to be integrated.
+		/// </summary>
+		InFlight,
+		Ready,
+	};
+
+	struct Record {
+		/// <summary>
+		/// Same as the key in g_Chunks, stored to save decoding it in every scan.
+		/// </summary>
+		ivec3 position;
+		ChunkPtr chunk;
+		State state;
+		/// <summary>
+		/// Value of g_ScanCount when the chunk was last within range.
+		/// </summary>
+		uint32_t lastInRange;
+		/// <summary>
+		/// Whether the chunk is ready, but out of range, i.e. in the LRU cache.
+		/// </summary>
+		bool cached;
+		/// <summary>
+		/// Whether the chunk was loaded from disk, otherwise it is only saved if a saver is set.
+		/// </summary>
+		bool fromDisk;
+	};
+
+	/// <summary>
+	/// A chunk that left the range. Becomes stale if the chunk comes back into range, which lastInRange tells.
+	/// </summary>
+	struct LruEntry {
+		ivec3 position;
+		uint32_t lastInRange;
+	};
+
+	/// <summary>
+	/// A chunk produced by a job.
+	/// </summary>
+	struct Result {
+		ivec3 position;
+		/// <summary>
+		/// nullptr if the chunk could not be allocated.
+		/// </summary>
+		ChunkPtr chunk;
+		bool fromDisk;
+	};
+
+	/// <summary>
+	/// Cosine of the angle the viewer must turn by before the queue is prioritized again (about 25 degrees).
+	/// </summary>
+	static constexpr float TURN_THRESHOLD = 0.9f;
+
+	static Config g_Config;
+	static GenerateFn g_Generate;
+	static LoadFn g_Load;
+	static SaveFn g_Save;
+	static EditFn g_EditLog;
+	static DurableFn g_Durable;
+
+	/// <summary>
+	/// Every chunk that is queued, in flight or ready. Only accessed by the main thread.
+	/// </summary>
+	static ChunkMap<Record> g_Chunks;
+	/// <summary>
+	/// Queued chunks with their priority, sorted so the most important one is at the back.
+	/// Rebuilt by every scan, so it never contains chunks that are not queued anymore.
+	/// </summary>
+	static std::vector<std::pair<float, ivec3>> g_Queue;
+	/// <summary>
+	/// The view direction g_Queue was prioritized for.
+	/// </summary>
+	static vec3 g_PrioritizedDirection;
+	/// <summary>
+	/// Queued chunks that left the range during a scan, reused by every scan.
+	/// </summary>
+	static std::vector<ivec3> g_Dropped;
+	/// <summary>
+	/// Chunks in the order they left the range, the least recently used one in front.
+	/// May contain stale entries, which are dropped once they outnumber the cached chunks (see PruneLru()).
+	/// </summary>
+	static std::deque<LruEntry> g_Lru;
+
+	static ivec3 g_ViewChunk;
+	static bool g_HasViewChunk;
+	static uint32_t g_ScanCount;
+
+	static std::mutex g_ResultMutex;
+	/// <summary>
+	/// Chunks finished by jobs, protected by g_ResultMutex.
+	/// </summary>
+	static std::vector<Result> g_Results;
+	/// <summary>
+	/// Finished chunks taken from g_Results that didn't fit into the budget of an update yet.
+	/// </summary>
+	static std::vector<Result> g_Integrating;
+	static Core::JobSystem::Counter g_Jobs;
+
+	static uint32_t g_InFlight;
+	static uint32_t g_Cached;
+	static uint64_t g_Generated;
+	static uint64_t g_LoadedFromDisk;
+	static uint64_t g_Evicted;
+	static uint64_t g_Saved;
+	static uint64_t g_Discarded;
+
+	/// <summary>
+	/// The running autosave job, if any.
+	/// </summary>
+	static Core::JobSystem::Counter g_AutosaveJob;
+	static std::chrono::steady_clock::time_point g_LastAutosave;
+	static uint32_t g_Autosaves;
+	static uint64_t g_SnapshotNs;
+	static uint64_t g_MaxSnapshotNs;
+	static std::atomic<uint64_t> g_AutosavedChunks;
+	static std::atomic<uint64_t> g_AutosaveNs;
+	static std::mutex g_AutosaveMutex;
+	/// <summary>
+	/// Chunks the autosave job failed to save, protected by g_AutosaveMutex. Marked as modified again by RestoreFailedSaves().
+	/// </summary>
+	static std::vector<ivec3> g_FailedSaves;
+
+	/// <summary>
+	/// Terrain used while no generator is set: stone below y = 0, air above.
+	/// </summary>
+	static void GenerateFlat(Chunk& chunk) {
+		auto baseY = chunk.GetPosition().y * Chunk::SIZE;
+		if (baseY >= 0)
+			return;
+		auto* blocks = chunk.GetOrCreateBlocks();
+		if (blocks)
+			std::fill_n(blocks, Chunk::VOLUME, STONE);
+	}
+
+	static int32_t SqrDistance(const ivec3& a, const ivec3& b) {
+		auto d = a - b;
+		return d.x * d.x + d.y * d.y + d.z * d.z;
+	}
+
+	static bool IsInRange(const ivec3& position) {
+		auto keep = g_Config.viewDistance + g_Config.hysteresis;
+		return SqrDistance(position, g_ViewChunk) <= keep * keep;
+	}
+
+	/// <returns>True if the chunk of the entry was destroyed, or came back into range since it was added</returns>
+	static bool IsStale(const LruEntry& entry) {
+		auto* rec = g_Chunks.Find(entry.position);
+		return !rec || !rec->cached || rec->lastInRange != entry.lastInRange;
+	}
+
+	/// <summary>
+	/// Drops the stale entries of g_Lru. Moving back and forth within the cache size adds entries without ever evicting,
+	/// so without this the queue would grow with every scan.
+	/// </summary>
+	static void PruneLru() {
+		// Every cached chunk has exactly one live entry, so pruning at twice that amortizes to a constant cost per entry.
+		if (g_Lru.size() <= 2 * (size_t)g_Cached + 64)
+			return;
+		std::erase_if(g_Lru, IsStale);
+	}
+
+	/// <returns>True if chunks that count as saved may not be on disk, so they have to be saved again before they are destroyed</returns>
+	static bool SavesUnconfirmed() {
+		return g_Durable && !g_Durable();
+	}
+
+	/// <summary>
+	/// Saves a chunk that is about to be destroyed, unless it is already on disk unchanged.
+	/// </summary>
+	/// <param name="unconfirmed">See SavesUnconfirmed()</param>
+	static void SaveIfNeeded(const Record& rec, bool unconfirmed) {
+		if (!g_Save || !rec.chunk || (rec.fromDisk && !rec.chunk->IsModified() && !unconfirmed))
+			return;
+		if (g_Save(rec.chunk->Snapshot()))
+			g_Saved++;
+	}
+
+	/// <summary>
+	/// Marks the chunks a finished autosave failed to save as modified again, so they are saved by the next autosave or on eviction.
+	/// </summary>
+	/// <remarks>Must be called once the autosave job finished and before evicting, otherwise the chunks could be destroyed unsaved.</remarks>
+	static void RestoreFailedSaves() {
+		std::lock_guard lock{ g_AutosaveMutex };
+		for (const auto& position : g_FailedSaves) {
+			auto* rec = g_Chunks.Find(position);
+			if (rec && rec->chunk)
+				rec->chunk->SetModified(true);
+		}
+		g_FailedSaves.clear();
+	}
+
+	void Initialize() {
+		g_Config = {};
+		g_Config.viewDistance = (int32_t)std::clamp<int64_t>(Core::CommandLine::GetInt("--view-distance", g_Config.viewDistance), 1, 64);
+		g_Config.maxJobsInFlight = (uint32_t)std::max<int64_t>(Core::CommandLine::GetInt("--stream-jobs", g_Config.maxJobsInFlight), 1);
+		g_Config.integrateBudgetUs = (uint32_t)std::max<int64_t>(Core::CommandLine::GetInt("--stream-budget-us", g_Config.integrateBudgetUs), 0);
+		g_Config.autosaveIntervalMs = (uint32_t)std::clamp<int64_t>(Core::CommandLine::GetInt("--autosave", 0), 0, 24 * 3600) * 1000;
+		// The cache must at least hold the shell between the radius and the margin, otherwise moving back and forth evicts chunks right away.
+		auto keep = g_Config.viewDistance + g_Config.hysteresis;
+		g_Config.cacheSize = std::max<uint32_t>(g_Config.cacheSize, (uint32_t)(4 * keep * keep * keep - 4 * g_Config.viewDistance * g_Config.viewDistance * g_Config.viewDistance));
+
+		// Everything within the margin plus the cache, so the map never rehashes while streaming.
+		g_Chunks.Reserve(4 * keep * keep * keep + g_Config.cacheSize);
+
+		if (!g_Generate)
+			g_Generate = GenerateFlat;
+		g_HasViewChunk = false;
+		g_LastAutosave = std::chrono::steady_clock::now();
+	}
+
+	void Terminate() {
+		// Jobs must not push results after we cleared them, and the last saves must be queued after the ones of a running autosave.
+		Core::JobSystem::Wait(g_Jobs);
+		Core::JobSystem::Wait(g_AutosaveJob);
+		RestoreFailedSaves();
+		g_Results.clear();
+		g_Integrating.clear();
+		auto unconfirmed = SavesUnconfirmed();
+		for (const auto& e : g_Chunks)
+			SaveIfNeeded(e.value, unconfirmed);
+		g_Chunks.Clear();
+		g_Queue = {};
+		g_Dropped = {};
+		g_Lru.clear();
+		g_InFlight = 0;
+		g_Cached = 0;
+	}
+
+	const Config& GetConfig() {
+		return g_Config;
+	}
+
+	void SetGenerator(GenerateFn generate) {
+		g_Generate = generate ? std::move(generate) : GenerateFlat;
+	}
+
+	void SetLoader(LoadFn load) {
+		g_Load = std::move(load);
+	}
+
+	void SetSaver(SaveFn save) {
+		g_Save = std::move(save);
+	}
+
+	void SetEditLog(EditFn log) {
+		g_EditLog = std::move(log);
+	}
+
+	void SetDurabilityCheck(DurableFn durable) {
+		g_Durable = std::move(durable);
+	}
+
+	/// <summary>
+	/// Sorts g_Queue by priority for the given view direction.
+	/// </summary>
+	static void Prioritize(const vec3& viewDirection) {
+		TRACE_ZONE("Prioritize");
+		/*
+		 * The priority is the distance, scaled by up to 2 for chunks behind the viewer. Chunks in front therefore come first,
+		 * but chunks right behind the viewer still come before far away ones in front, since the viewer may turn around.
+		 */
+		for (auto& [priority, pos] : g_Queue) {
+			auto offset = (pos - g_ViewChunk).ToVec3();
+			auto dist = offset.Magnitude();
+			auto facing = dist > 0.0f ? viewDirection.Dot(offset) / dist : 1.0f;
+			priority = dist * (1.5f - 0.5f * facing);
+		}
+		std::sort(g_Queue.begin(), g_Queue.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+		g_PrioritizedDirection = viewDirection;
+	}
+
+	/// <summary>
+	/// Called when the viewer entered another chunk. Queues every missing chunk within the radius
+	/// and moves the chunks beyond the radius plus the margin into the LRU cache.
+	/// </summary>
+	/// <param name="previous">The chunk the viewer was in before, or nullptr</param>
+	static void Rescan(const ivec3* previous, const vec3& viewDirection) {
+		TRACE_ZONE("Rescan");
+		g_ScanCount++;
+		g_Queue.clear();
+
+		g_Dropped.clear();
+		for (auto& e : g_Chunks) {
+			auto& rec = e.value;
+			if (IsInRange(rec.position)) {
+				rec.lastInRange = g_ScanCount;
+				if (rec.cached) {
+					rec.cached = false;
+					g_Cached--;
+				}
+				if (rec.state == State::Queued)
+					g_Queue.emplace_back(0.0f, rec.position);
+				continue;
+			}
+			switch (rec.state) {
+			case State::Queued:
+				// Nothing was done for the chunk yet, so we simply forget about it.
+				g_Dropped.push_back(rec.position);
+				break;
+			case State::InFlight:
+				// Checked again once the job finished.
+				break;
+			case State::Ready:
+				if (!rec.cached) {
+					rec.cached = true;
+					g_Cached++;
+					g_Lru.push_back({ rec.position, rec.lastInRange });
+				}
+				break;
+			}
+		}
+		for (const auto& p : g_Dropped)
+			g_Chunks.Erase(p);
+		PruneLru();
+
+		/*
+		 * Chunks within the radius around the previous chunk are already known, since they were within the range when the viewer was there,
+		 * and chunks are only ever removed once they are out of range. So only the positions that are new in the sphere need a lookup,
+		 * which keeps moving by a single chunk cheap.
+		 */
+		auto r = g_Config.viewDistance;
+		for (int32_t y = -r; y <= r; y++) {
+			for (int32_t z = -r; z <= r; z++) {
+				for (int32_t x = -r; x <= r; x++) {
+					if (x * x + y * y + z * z > r * r)
+						continue;
+					auto pos = g_ViewChunk + ivec3{ x, y, z };
+					if (previous && SqrDistance(pos, *previous) <= r * r)
+						continue;
+					auto [rec, inserted] = g_Chunks.TryEmplace(pos, Record{ pos, nullptr, State::Queued, g_ScanCount, false, false });
+					if (inserted)
+						g_Queue.emplace_back(0.0f, pos);
+				}
+			}
+		}
+
+		Prioritize(viewDirection);
+	}
+
+	/// <summary>
+	/// Makes finished chunks available, until the time or upload budget is used up.
+	/// </summary>
+	static void Integrate() {
+		TRACE_ZONE("Integrate");
+		{
+			std::lock_guard lock{ g_ResultMutex };
+			for (auto& r : g_Results)
+				g_Integrating.push_back(std::move(r));
+			g_Results.clear();
+		}
+		if (g_Integrating.empty())
+			return;
+
+		auto start = std::chrono::steady_clock::now();
+		auto budget = std::chrono::microseconds{ g_Config.integrateBudgetUs };
+		uint64_t uploaded = 0;
+		size_t i = 0;
+		// At least one chunk is integrated per update, so a tiny budget can't stall streaming completely.
+		while (i < g_Integrating.size()) {
+			if (i > 0 && (uploaded >= g_Config.uploadBudgetBytes || std::chrono::steady_clock::now() - start >= budget))
+				break;
+
+			auto& result = g_Integrating[i++];
+			g_InFlight--;
+			auto* rec = g_Chunks.Find(result.position);
+			if (!IsInRange(result.position)) {
+				// The viewer moved away while the job was running. The chunk is requested again once it comes back into range.
+				g_Discarded++;
+				g_Chunks.Erase(result.position);
+				continue;
+			}
+			if (!result.chunk) {
+				/*
+				 * The pool is exhausted. The chunk is queued again, but behind every other chunk: retrying right away would fail again,
+				 * until evictions (or the next scan) free some memory. Its priority is fixed by the next Prioritize().
+				 */
+				rec->state = State::Queued;
+				g_Queue.insert(g_Queue.begin(), { g_Queue.empty() ? 0.0f : g_Queue.front().first, result.position });
+				continue;
+			}
+
+			if (result.chunk->GetBlocks())
+				uploaded += Chunk::VOLUME * sizeof(BlockId);
+			(result.fromDisk ? g_LoadedFromDisk : g_Generated)++;
+			rec->chunk = std::move(result.chunk);
+			rec->fromDisk = result.fromDisk;
+			rec->state = State::Ready;
+			rec->lastInRange = g_ScanCount;
+		}
+		g_Integrating.erase(g_Integrating.begin(), g_Integrating.begin() + (ptrdiff_t)i);
+	}
+
+	/// <summary>
+	/// Generates a chunk that could not be loaded and hands it to Integrate().
+	/// </summary>
+	static void Finish(Result& result, bool loaded) {
+		if (result.chunk) {
+			result.fromDisk = loaded;
+			if (!loaded)
+				g_Generate(*result.chunk);
+		}
+		std::lock_guard lock{ g_ResultMutex };
+		g_Results.push_back(std::move(result));
+	}
+
+	/// <summary>
+	/// Issues jobs for the queued chunks with the highest priority.
+	/// </summary>
+	static void Issue() {
+		TRACE_ZONE("Issue");
+		auto budget = std::min(g_Config.maxRequestsPerUpdate, g_Config.maxJobsInFlight - std::min(g_InFlight, g_Config.maxJobsInFlight));
+		for (uint32_t i = 0; i < budget && !g_Queue.empty(); i++) {
+			auto pos = g_Queue.back().second;
+			g_Queue.pop_back();
+			g_Chunks.Find(pos)->state = State::InFlight;
+			g_InFlight++;
+
+			Core::JobSystem::Submit([pos] {
+				TRACE_ZONE("Load Chunk");
+				auto result = std::make_shared<Result>(Result{ pos, Chunk::Create(pos), false });
+				if (!result->chunk || !g_Load) {
+					Finish(*result, false);
+					return;
+				}
+				// The load may complete later on another thread. Retaining the counter keeps Terminate() waiting for it.
+				Core::JobSystem::Retain(g_Jobs);
+				g_Load(*result->chunk, [result](bool loaded) {
+					Finish(*result, loaded);
+					Core::JobSystem::Release(g_Jobs);
+				});
+			}, &g_Jobs);
+		}
+	}
+
+	/// <summary>
+	/// Destroys the least recently used chunks while the cache is too large.
+	/// </summary>
+	static void Evict() {
+		TRACE_ZONE("Evict");
+		// Saving an evicted chunk must not overtake saving its snapshot in a running autosave, so chunks stay cached until the autosave queued its saves.
+		if (g_AutosaveJob.value.load(std::memory_order_acquire) != 0)
+			return;
+		RestoreFailedSaves();
+		/*
+		 * A save that failed after it was queued only shows up later, when syncing it fails. Until the owner confirmed the saves,
+		 * a chunk that counts as saved is saved again before it is destroyed, otherwise it would only exist in memory.
+		 */
+		auto unconfirmed = g_Cached > g_Config.cacheSize && SavesUnconfirmed();
+		uint32_t evicted = 0;
+		while (g_Cached > g_Config.cacheSize && evicted < g_Config.maxEvictionsPerUpdate && !g_Lru.empty()) {
+			auto entry = g_Lru.front();
+			g_Lru.pop_front();
+			auto* rec = g_Chunks.Find(entry.position);
+			if (!rec || !rec->cached || rec->lastInRange != entry.lastInRange)
+				continue;
+			SaveIfNeeded(*rec, unconfirmed);
+			g_Chunks.Erase(entry.position);
+			g_Cached--;
+			g_Evicted++;
+			evicted++;
+		}
+	}
+
+	void Update(const vec3& viewPosition, const vec3& viewDirection) {
+		TRACE_ZONE("ChunkStreaming::Update");
+
+		auto viewChunk = ivec3::Floor(viewPosition / (float)Chunk::SIZE);
+		if (!g_HasViewChunk || viewChunk != g_ViewChunk) {
+			auto previous = g_ViewChunk;
+			g_ViewChunk = viewChunk;
+			Rescan(g_HasViewChunk ? &previous : nullptr, viewDirection);
+			g_HasViewChunk = true;
+		} else if (viewDirection.Dot(g_PrioritizedDirection) < TURN_THRESHOLD) {
+			Prioritize(viewDirection);
+		}
+
+		// Integrating first frees up slots for new jobs.
+		Integrate();
+		Issue();
+		Evict();
+
+		auto now = std::chrono::steady_clock::now();
+		if (g_Config.autosaveIntervalMs > 0 && now - g_LastAutosave >= std::chrono::milliseconds{ g_Config.autosaveIntervalMs } && Autosave())
+			g_LastAutosave = now;
+	}
+
+	bool Autosave(std::function<void()> saved, bool all) {
+		if (!g_Save || g_AutosaveJob.value.load(std::memory_order_acquire) != 0)
+			return false;
+		TRACE_ZONE("Autosave");
+		RestoreFailedSaves();
+
+		/*
+		 * Taking the snapshots of every chunk at once gives a consistent view of the world, and costs a reference count increment per chunk.
+		 * The chunks count as saved from now on: edits made meanwhile mark them as modified again, so they are saved by the next autosave or on eviction.
+		 * Chunks whose save fails are handed back by the job and marked as modified again as well.
+		 */
+		auto start = std::chrono::steady_clock::now();
+		std::vector<ChunkSnapshot> snapshots;
+		for (auto& e : g_Chunks) {
+			auto& rec = e.value;
+			if (rec.state != State::Ready || (!all && rec.fromDisk && !rec.chunk->IsModified()))
+				continue;
+			snapshots.push_back(rec.chunk->Snapshot());
+			rec.chunk->SetModified(false);
+			rec.fromDisk = true;
+		}
+		auto snapshotNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		g_Autosaves++;
+		g_SnapshotNs += snapshotNs;
+		g_MaxSnapshotNs = std::max(g_MaxSnapshotNs, snapshotNs);
+		if (snapshots.empty()) {
+			if (saved)
+				saved();
+			return true;
+		}
+
+		Core::JobSystem::Submit([snapshots = std::move(snapshots), saved = std::move(saved)] {
+			TRACE_ZONE("Autosave Job");
+			auto start = std::chrono::steady_clock::now();
+			uint64_t numSaved = 0;
+			std::vector<ivec3> failed;
+			for (const auto& snapshot : snapshots) {
+				if (g_Save(snapshot))
+					numSaved++;
+				else
+					failed.push_back(snapshot.GetPosition());
+			}
+			if (!failed.empty()) {
+				std::lock_guard lock{ g_AutosaveMutex };
+				g_FailedSaves.insert(g_FailedSaves.end(), failed.begin(), failed.end());
+			}
+			g_AutosavedChunks.fetch_add(numSaved, std::memory_order_relaxed);
+			g_AutosaveNs.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+			if (saved)
+				saved();
+		}, &g_AutosaveJob);
+		return true;
+	}
+
+	const Chunk* GetChunk(const ivec3& position) {
+		auto* rec = g_Chunks.Find(position);
+		return rec && rec->state == State::Ready ? rec->chunk.get() : nullptr;
+	}
+
+	bool SetBlock(const ivec3& position, BlockId block) {
+		ivec3 chunkPosition{ position.x >> 4, position.y >> 4, position.z >> 4 };
+		auto* rec = g_Chunks.Find(chunkPosition);
+		if (!rec || rec->state != State::Ready)
+			return false;
+		auto x = position.x & (Chunk::SIZE - 1), y = position.y & (Chunk::SIZE - 1), z = position.z & (Chunk::SIZE - 1);
+		if (!rec->chunk->SetBlock(x, y, z, block))
+			return false;
+		if (g_EditLog)
+			g_EditLog(chunkPosition, (uint16_t)Chunk::Index(x, y, z), block);
+		return true;
+	}
+
+	Stats GetStats() {
+		uint32_t loaded = 0;
+		for (const auto& e : g_Chunks)
+			loaded += e.value.state == State::Ready;
+		return {
+			loaded, g_Cached, (uint32_t)(g_Chunks.Size() - loaded - g_InFlight), g_InFlight,
+			g_Generated, g_LoadedFromDisk, g_Evicted, g_Saved, g_Discarded,
+			g_Autosaves, g_AutosavedChunks.load(std::memory_order_relaxed), g_SnapshotNs, g_MaxSnapshotNs, g_AutosaveNs.load(std::memory_order_relaxed),
+			Chunk::GetCopyOnWriteCount(),
+		};
+	}
+
+	void PrintReport() {
+		auto s = GetStats();
+		Log::Info("Chunk streaming: {} loaded ({} cached), {} queued, {} in flight, {} generated, {} loaded from disk, {} evicted, {} saved, {} discarded",
+			s.loaded, s.cached, s.queued, s.inFlight, s.generated, s.loadedFromDisk, s.evicted, s.saved, s.discarded);
+		if (s.autosaves == 0)
+			return;
+		Log::Info("Autosave: {} autosaves saved {} chunks ({:.0f} chunks/s on the save job), snapshots took {:.1f} us per autosave on average and {:.1f} us at most, {} chunks copied on write",
+			s.autosaves, s.autosavedChunks, s.autosaveNs > 0 ? (double)s.autosavedChunks * 1e9 / (double)s.autosaveNs : 0.0,
+			(double)s.snapshotNs / 1000.0 / s.autosaves, (double)s.maxSnapshotNs / 1000.0, s.copiesOnWrite);
+	}
+
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "Chunk.h"
+#include "Maths/vec3.h"
+
+namespace Game::ChunkStreaming {
+
+	/*
+	 * Keeps the chunks within a radius around the viewer loaded while it moves through the world.
+	 *
+	 * Update() runs once per simulation step on the main thread and only ever does a bounded amount of work:
+	 * - When the viewer enters another chunk, every missing chunk within the radius is queued.
+	 * - Queued chunks are prioritized by distance, and chunks in the view direction come first. The best ones are handed to worker jobs,
+	 *   which load them from disk or generate them. Only a limited number of jobs is in flight, so a burst of requests can't starve other jobs.
+	 * - Finished chunks are made available within a time budget and an upload budget (the bytes of block data made available per update,
+	 *   which is what a mesher will have to process and upload).
+	 * - Chunks that end up further away than the radius plus a margin are not destroyed right away, since the viewer often turns back.
+	 *   They are kept in an LRU cache and destroyed in least recently used order once the cache is full, again only a few per update.
+	 * Moving faster than chunks can be produced therefore never causes a frame spike. Chunks just show up later.
+	 *
+	 * Autosaving takes a snapshot of every chunk that changed since it was saved, which only shares its block array (see ChunkSnapshot),
+	 * and a job encodes and saves the snapshots on a worker. The main thread keeps editing meanwhile: the first edit of a chunk
+	 * whose snapshot is still held copies its blocks, every other chunk is left alone.
+	 */
+
+	struct Config {
+		/// <summary>
+		/// Radius in chunks around the viewer's chunk that is kept loaded.
+		/// </summary>
+		int32_t viewDistance = 8;
+		/// <summary>
+		/// Chunks are only considered out of range beyond viewDistance + hysteresis, so moving back and forth across
+		/// a chunk border doesn't load and unload the same chunks over and over.
+		/// </summary>
+		int32_t hysteresis = 2;
+		/// <summary>
+		/// Number of out of range chunks that are kept loaded in case the viewer comes back.
+		/// </summary>
+		uint32_t cacheSize = 1024;
+		/// <summary>
+		/// Maximum number of chunk jobs queued or running on the JobSystem at the same time.
+		/// </summary>
+		uint32_t maxJobsInFlight = 32;
+		/// <summary>
+		/// Maximum number of jobs issued per update.
+		/// </summary>
+		uint32_t maxRequestsPerUpdate = 16;
+		/// <summary>
+		/// Main thread time per update for making finished chunks available, in microseconds.
+		/// </summary>
+		uint32_t integrateBudgetUs = 500;
+		/// <summary>
+		/// Bytes of block data made available per update.
+		/// </summary>
+		uint64_t uploadBudgetBytes = 2 * 1024 * 1024;
+		/// <summary>
+		/// Maximum number of chunks destroyed per update.
+		/// </summary>
+		uint32_t maxEvictionsPerUpdate = 64;
+		/// <summary>
+		/// Time between autosaves in milliseconds, 0 disables autosaving.
+		/// </summary>
+		uint32_t autosaveIntervalMs = 0;
+	};
+
+	/// <summary>
+	/// Fills a new chunk. Called on worker threads, possibly for several chunks at the same time.
+	/// </summary>
+	using GenerateFn = std::function<void(Chunk& chunk)>;
+	/// <summary>
+	/// Starts loading a chunk from disk. Called on worker threads.
+	/// Must call done exactly once, from any thread, with false if the chunk was never saved or could not be read, in which case it is generated.
+	/// The chunk stays alive until then.
+	/// </summary>
+	using LoadFn = std::function<void(Chunk& chunk, std::function<void(bool loaded)> done)>;
+	/// <summary>
+	/// Saves a chunk before it is destroyed (on the main thread) or during an autosave (on a worker thread).
+	/// </summary>
+	/// <returns>False if the chunk could not be saved</returns>
+	using SaveFn = std::function<bool(const ChunkSnapshot& snapshot)>;
+	/// <summary>
+	/// Records a block edit, e.g. in the journal. Called on the main thread.
+	/// </summary>
+	/// <param name="index">Index of the block within the chunk, see Chunk::Index()</param>
+	using EditFn = std::function<void(const ivec3& chunk, uint16_t index, BlockId block)>;
+	/// <summary>
+	/// Tells whether the chunks that count as saved are known to be on disk. Called on the main thread.
+	/// </summary>
+	using DurableFn = std::function<bool()>;
+
+	/// <summary>
+	/// Reads the configuration from the command line ("--view-distance", "--stream-jobs", "--stream-budget-us", "--autosave").
+	/// </summary>
+	///	<remarks>Must be called after Core::JobSystem::Initialize()</remarks>
+	void Initialize();
+	/// <summary>
+	/// Waits for every chunk job, saves the chunks that need it and destroys every chunk.
+	/// </summary>
+	void Terminate();
+
+	[[nodiscard]] const Config& GetConfig();
+	/// <summary>
+	/// Sets the function filling chunks that could not be loaded. The default fills everything below y = 0 with stone.
+	/// </summary>
+	/// <remarks>Must not be called while chunks are streamed in.</remarks>
+	void SetGenerator(GenerateFn generate);
+	/// <summary>
+	/// Sets the function loading chunks from disk. Without one, every chunk is generated.
+	/// </summary>
+	/// <remarks>Must not be called while chunks are streamed in.</remarks>
+	void SetLoader(LoadFn load);
+	/// <summary>
+	/// Sets the function saving chunks that are evicted (and every chunk on Terminate()) if they are modified or weren't loaded from disk.
+	/// Without one, chunks are simply destroyed.
+	/// </summary>
+	/// <remarks>Must not be called while chunks are streamed in.</remarks>
+	void SetSaver(SaveFn save);
+	/// <summary>
+	/// Sets the function recording every edit made with SetBlock(). Without one, edits are only saved with their chunk.
+	/// </summary>
+	void SetEditLog(EditFn log);
+	/// <summary>
+	/// Sets the function telling whether earlier saves reached the disk, e.g. Journal::AreSavesDurable(). While it returns false,
+	/// evicted chunks are saved even if they are unchanged, since their last save may be lost. Without one, every save counts as durable.
+	/// </summary>
+	/// <remarks>Must not be called while chunks are streamed in.</remarks>
+	void SetDurabilityCheck(DurableFn durable);
+
+	/// <summary>
+	/// Queues chunks around the viewer, issues jobs, makes finished chunks available and evicts chunks, all within the configured budgets.
+	/// </summary>
+	/// <param name="viewDirection">Normalized direction the viewer looks in</param>
+	void Update(const vec3& viewPosition, const vec3& viewDirection);
+
+	/// <summary>
+	/// Starts saving every chunk that changed since it was last saved. Called by Update() every autosave interval, and by journal checkpoints.
+	/// </summary>
+	/// <param name="saved">Called once every save was started, from the autosave job or right away if nothing changed</param>
+	/// <param name="all">Saves every loaded chunk, changed or not, e.g. when earlier saves may not have reached the disk</param>
+	/// <returns>False if no saver is set or the previous autosave is still running</returns>
+	bool Autosave(std::function<void()> saved = {}, bool all = false);
+
+	/// <returns>The chunk at a chunk coordinate, or nullptr if it is not loaded (yet)</returns>
+	[[nodiscard]] const Chunk* GetChunk(const ivec3& position);
+	/// <summary>
+	/// Changes a block of a loaded chunk and records the edit, see SetEditLog().
+	/// </summary>
+	/// <param name="position">Block coordinate</param>
+	/// <returns>False if the chunk is not loaded (yet) or its block array could not be allocated</returns>
+	bool SetBlock(const ivec3& position, BlockId block);
+
+	struct Stats {
+		/// <summary>
+		/// Chunks that are available, including the ones in the LRU cache.
+		/// </summary>
+		uint32_t loaded;
+		/// <summary>
+		/// Chunks that are out of range, but kept in the LRU cache.
+		/// </summary>
+		uint32_t cached;
+		/// <summary>
+		/// Chunks waiting for a job to be issued.
+		/// </summary>
+		uint32_t queued;
+		/// <summary>
+		/// Chunks whose job was issued but hasn't been integrated yet.
+		/// </summary>
+		uint32_t inFlight;
+		uint64_t generated;
+		uint64_t loadedFromDisk;
+		uint64_t evicted;
+		uint64_t saved;
+		/// <summary>
+		/// Chunks that were out of range by the time their job finished.
+		/// </summary>
+		uint64_t discarded;
+		uint32_t autosaves;
+		uint64_t autosavedChunks;
+		/// <summary>
+		/// Main thread time spent taking the snapshots of every autosave, and of the slowest one.
+		/// </summary>
+		uint64_t snapshotNs;
+		uint64_t maxSnapshotNs;
+		/// <summary>
+		/// Time the autosave jobs spent encoding and saving snapshots.
+		/// </summary>
+		uint64_t autosaveNs;
+		/// <summary>
+		/// Block arrays copied because a chunk was edited while a snapshot shared them, see Chunk::GetCopyOnWriteCount().
+		/// </summary>
+		uint64_t copiesOnWrite;
+	};
+
+	[[nodiscard]] Stats GetStats();
+	/// <summary>
+	/// Prints the stats to the log.
+	/// </summary>
+	void PrintReport();
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Maths/Transform.h"
+#include "Maths/vec3.h"
+
+/*
+ * Components of the simulation's entities. Every entity that is rendered has a Transform and a PreviousTransform.
+ * Transform itself is a component as well, see Maths/Transform.h.
+ */
+
+namespace Game {
+
+	/// <summary>
+	/// The Transform after the previous simulation tick, which the Renderer interpolates from.
+	/// </summary>
+	struct PreviousTransform {
+		Transform value;
+	};
+
+	/// <summary>
+	/// Rotates an entity at a constant speed.
+	/// </summary>
+	struct Spin {
+		vec3 axis;
+		/// <summary>
+		/// Radians per second.
+		/// </summary>
+		float speed;
+	};
+
+}
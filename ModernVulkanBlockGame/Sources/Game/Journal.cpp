@@ -0,0 +1,465 @@
+#include "Journal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "ChunkCodec.h"
+#include "ChunkMap.h"
+#include "RegionStore.h"
+#include "Core/CommandLine.h"
+#include "Core/IoService.h"
+#include "Core/JobSystem.h"
+#include "Core/MappedFile.h"
+#include "Core/Trace.h"
+#include "Logging/Log.h"
+
+namespace Game::Journal {
+
+	/// <summary>
+	/// The size a segment may grow to. Checkpoints start long before, a segment only gets this large if they keep failing.
+	/// </summary>
+	static constexpr uint64_t MAX_SEGMENT_SIZE = 256ull * 1024 * 1024;
+	static constexpr int64_t DEFAULT_SYNC_INTERVAL_MS = 100;
+	static constexpr int64_t DEFAULT_CHECKPOINT_KB = 4096;
+	/// <summary>
+	/// Chunks replayed at the same time, which bounds the chunks allocated from the pool.
+	/// </summary>
+	static constexpr uint32_t REPLAY_WAVE = 1024;
+
+	struct BatchHeader {
+		/// <summary>
+		/// Number of records following the header. 0 marks the end of the segment, since a segment is grown ahead of its batches.
+		/// </summary>
+		uint32_t count;
+		uint32_t checksum;
+	};
+
+	struct Edit {
+		int32_t x, y, z;
+		uint16_t index;
+		BlockId block;
+	};
+	static_assert(sizeof(Edit) == 16);
+
+	struct Segment {
+		uint32_t id;
+		Core::MappedFile file;
+		/// <summary>
+		/// Where the next batch is written.
+		/// </summary>
+		uint64_t end;
+	};
+
+	static std::string g_Directory;
+	static uint32_t g_SyncIntervalMs;
+	static uint64_t g_CheckpointSize;
+	static CheckpointFn g_Checkpoint;
+
+	/// <summary>
+	/// The segment batches are written to. Only accessed by the main thread.
+	/// </summary>
+	static std::shared_ptr<Segment> g_Segment;
+	/// <summary>
+	/// The segment the next checkpoint switches to, opened by a checkpoint that could not start yet.
+	/// </summary>
+	static std::shared_ptr<Segment> g_NextSegment;
+	/// <summary>
+	/// A checkpoint starts once the segment reaches this size.
+	/// </summary>
+	static uint64_t g_CheckpointAt;
+	static std::vector<Edit> g_Batch;
+	static std::chrono::steady_clock::time_point g_BatchStart;
+
+	/// <summary>
+	/// A batch is being written. There is only one at a time, so batches reach the segment in order, and the next one collects edits meanwhile.
+	/// </summary>
+	static std::atomic<bool> g_Writing;
+	static std::atomic<bool> g_Checkpointing;
+	/// <summary>
+	/// A batch failed, so the segment can't be replayed beyond it. The next update starts a checkpoint to make the edits durable.
+	/// </summary>
+	static std::atomic<bool> g_ForceCheckpoint;
+	/// <summary>
+	/// A checkpoint failed, so chunks that count as saved may be missing from the region files. Until a checkpoint saving every chunk
+	/// succeeded, no segment is deleted.
+	/// </summary>
+	static std::atomic<bool> g_FullCheckpoint;
+	/// <summary>
+	/// Batch writes and checkpoints in flight, until their callbacks finished.
+	/// </summary>
+	static Core::JobSystem::Counter g_Jobs;
+
+	static uint64_t g_Edits;
+	static std::atomic<uint64_t> g_Batches;
+	static std::atomic<uint64_t> g_BytesWritten;
+	static std::atomic<uint64_t> g_FailedBatches;
+	static std::atomic<uint64_t> g_Checkpoints;
+	static std::atomic<uint64_t> g_CheckpointNs;
+	static uint64_t g_ReplayedEdits;
+	static uint64_t g_ReplayedChunks;
+
+	static std::string GetSegmentPath(uint32_t id) {
+		return Log::format("{}/journal.{}.log", g_Directory, id);
+	}
+
+	/// <returns>The ids of the segments in the world directory, in ascending order</returns>
+	static std::vector<uint32_t> FindSegments() {
+		std::vector<uint32_t> ids;
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(g_Directory, ec)) {
+			auto name = entry.path().filename().string();
+			constexpr std::string_view prefix = "journal.", suffix = ".log";
+			if (name.size() <= prefix.size() + suffix.size() || !name.starts_with(prefix) || !name.ends_with(suffix))
+				continue;
+			uint32_t id;
+			auto* first = name.data() + prefix.size();
+			auto* last = name.data() + name.size() - suffix.size();
+			if (auto [p, err] = std::from_chars(first, last, id); err == std::errc{} && p == last)
+				ids.push_back(id);
+		}
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	}
+
+	/// <summary>
+	/// Deletes the segments before the given one, whose edits are in the region files.
+	/// </summary>
+	static void DeleteSegments(uint32_t firstKept) {
+		for (auto id : FindSegments()) {
+			if (id >= firstKept)
+				break;
+			std::error_code ec;
+			if (!std::filesystem::remove(GetSegmentPath(id), ec) && ec)
+				Log::Warning("Failed to delete journal segment {}: {}", GetSegmentPath(id), ec.message());
+		}
+	}
+
+	/// <summary>
+	/// Syncs the region files, executing jobs while waiting. Only used at startup and shutdown, a checkpoint doesn't wait.
+	/// </summary>
+	static bool SyncRegions() {
+		Core::JobSystem::Counter counter;
+		auto synced = false;
+		Core::JobSystem::Retain(counter);
+		RegionStore::Sync([&](bool ok) {
+			synced = ok;
+			Core::JobSystem::Release(counter);
+		});
+		Core::JobSystem::Wait(counter);
+		return synced;
+	}
+
+	static std::shared_ptr<Segment> OpenSegment(uint32_t id) {
+		auto segment = std::make_shared<Segment>();
+		segment->id = id;
+		segment->end = 0;
+		if (!segment->file.Open(GetSegmentPath(id), MAX_SEGMENT_SIZE))
+			return nullptr;
+		return segment;
+	}
+
+	/// <summary>
+	/// Reads the edits of a segment up to its end or the first damaged batch.
+	/// </summary>
+	/// <returns>False if the segment could not be opened</returns>
+	static bool ReadSegment(uint32_t id, ChunkMap<std::vector<Edit>>& edits) {
+		Core::MappedFile file;
+		if (!file.Open(GetSegmentPath(id), MAX_SEGMENT_SIZE))
+			return false;
+		const auto* data = (const uint8_t*)file.GetData();
+		auto size = file.GetSize();
+		uint64_t offset = 0;
+		while (size - offset >= sizeof(BatchHeader)) {
+			BatchHeader header;
+			memcpy(&header, data + offset, sizeof(header));
+			if (header.count == 0)
+				break;
+			auto bytes = (uint64_t)header.count * sizeof(Edit);
+			const auto* records = data + offset + sizeof(header);
+			if (bytes > size - offset - sizeof(header) || ChunkCodec::Checksum(records, bytes) != header.checksum) {
+				Log::Warning("Journal segment {} is damaged at offset {}, the edits after it are lost", GetSegmentPath(id), offset);
+				break;
+			}
+			for (uint32_t i = 0; i < header.count; i++) {
+				Edit edit;
+				memcpy(&edit, records + (size_t)i * sizeof(Edit), sizeof(Edit));
+				if (edit.index < Chunk::VOLUME)
+					edits.TryEmplace(ivec3{ edit.x, edit.y, edit.z }).first->push_back(edit);
+			}
+			g_ReplayedEdits += header.count;
+			offset += sizeof(header) + bytes;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Applies the edits of the segments to the region files, and syncs them.
+	/// </summary>
+	static bool Replay(const std::vector<uint32_t>& segments, const GenerateFn& generate) {
+		TRACE_ZONE("Replay Journal");
+		auto start = std::chrono::steady_clock::now();
+		ChunkMap<std::vector<Edit>> edits;
+		for (auto id : segments) {
+			if (!ReadSegment(id, edits))
+				return false;
+		}
+
+		/*
+		 * Every chunk is loaded asynchronously, and the callback applies the edits and saves it. Waiting inside a job instead
+		 * would make the waiting thread execute the next load, which waits as well, nesting as deep as there are chunks.
+		 */
+		std::atomic<bool> ok{ true };
+		Core::JobSystem::Counter counter;
+		uint32_t issued = 0;
+		for (auto& e : edits) {
+			std::shared_ptr<Chunk> chunk = Chunk::Create(e.GetPosition());
+			if (!chunk) {
+				ok.store(false, std::memory_order_relaxed);
+				break;
+			}
+			Core::JobSystem::Retain(counter);
+			RegionStore::Load(*chunk, [chunk, &records = e.value, &generate, &ok, &counter](RegionStore::LoadResult result) {
+				// Saving a generated chunk in place of one that can't be read would destroy it for good, the journal is kept instead.
+				if (result == RegionStore::LoadResult::Failed) {
+					ok.store(false, std::memory_order_relaxed);
+					Core::JobSystem::Release(counter);
+					return;
+				}
+				if (result == RegionStore::LoadResult::Absent)
+					generate(*chunk);
+				auto* blocks = chunk->GetOrCreateBlocks();
+				if (blocks) {
+					for (const auto& edit : records)
+						blocks[edit.index] = edit.block;
+				}
+				if (!blocks || !RegionStore::Save(chunk->Snapshot()))
+					ok.store(false, std::memory_order_relaxed);
+				Core::JobSystem::Release(counter);
+			});
+			if (++issued % REPLAY_WAVE == 0)
+				Core::JobSystem::Wait(counter);
+		}
+		Core::JobSystem::Wait(counter);
+		if (!ok.load(std::memory_order_relaxed) || !SyncRegions())
+			return false;
+
+		g_ReplayedChunks += edits.Size();
+		Log::Info("Replayed {} edits of {} chunks from the journal in {:.1f} ms", g_ReplayedEdits, edits.Size(),
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		return true;
+	}
+
+	bool Initialize(const std::string& directory, const GenerateFn& generate) {
+		g_Directory = directory;
+		g_SyncIntervalMs = (uint32_t)std::clamp<int64_t>(Core::CommandLine::GetInt("--journal-sync-ms", DEFAULT_SYNC_INTERVAL_MS), 0, 60 * 1000);
+		g_CheckpointSize = (uint64_t)std::clamp<int64_t>(Core::CommandLine::GetInt("--journal-checkpoint-kb", DEFAULT_CHECKPOINT_KB), 64, (int64_t)(MAX_SEGMENT_SIZE / 1024 / 2)) * 1024;
+
+		auto segments = FindSegments();
+		if (!segments.empty()) {
+			if (!Replay(segments, generate)) {
+				Log::Error("Failed to replay the journal in {}, it is kept for the next start", directory);
+				return false;
+			}
+			DeleteSegments(segments.back() + 1);
+		}
+
+		g_Segment = OpenSegment(segments.empty() ? 0 : segments.back() + 1);
+		if (!g_Segment)
+			return false;
+		// Syncing a batch doesn't cover the name of the segment.
+		if (!Core::MappedFile::SyncDirectory(directory))
+			Log::Warning("Failed to sync world directory {}", directory);
+		g_CheckpointAt = g_CheckpointSize;
+		g_FullCheckpoint.store(false, std::memory_order_relaxed);
+		return true;
+	}
+
+	/// <summary>
+	/// Writes the batch at the end of the segment, linked to a sync.
+	/// </summary>
+	static void WriteBatch() {
+		TRACE_ZONE("Write Journal Batch");
+		auto edits = (uint32_t)g_Batch.size();
+		auto bytes = (size_t)edits * sizeof(Edit);
+		auto data = std::make_shared<std::vector<uint8_t>>(sizeof(BatchHeader) + bytes);
+		BatchHeader header{ edits, ChunkCodec::Checksum((const uint8_t*)g_Batch.data(), bytes) };
+		memcpy(data->data(), &header, sizeof(header));
+		memcpy(data->data() + sizeof(header), g_Batch.data(), bytes);
+		g_Batch.clear();
+
+		auto& segment = *g_Segment;
+		if (!segment.file.Grow(segment.end + data->size())) {
+			Log::Error("Journal segment {} is full, {} edits are only durable after the next checkpoint", GetSegmentPath(segment.id), edits);
+			g_FailedBatches.fetch_add(1, std::memory_order_relaxed);
+			g_ForceCheckpoint.store(true, std::memory_order_relaxed);
+			return;
+		}
+		auto offset = segment.end;
+		segment.end += data->size();
+
+		auto handle = segment.file.GetHandle();
+		g_Writing.store(true, std::memory_order_relaxed);
+		Core::IoService::Request requests[2] = {
+			{ Core::IoService::Op::Write, handle, offset, data->data(), (uint32_t)data->size(), Core::IoService::NO_BUFFER, true, {} },
+			{ Core::IoService::Op::Sync, handle, 0, nullptr, 0, Core::IoService::NO_BUFFER, false,
+				[segment = g_Segment, data, edits](int64_t result) {
+					if (result == 0) {
+						g_Batches.fetch_add(1, std::memory_order_relaxed);
+						g_BytesWritten.fetch_add(data->size(), std::memory_order_relaxed);
+					} else {
+						Log::Error("Failed to write {} edits to journal segment {}: error {}", edits, GetSegmentPath(segment->id), -result);
+						g_FailedBatches.fetch_add(1, std::memory_order_relaxed);
+						g_ForceCheckpoint.store(true, std::memory_order_relaxed);
+					}
+					g_Writing.store(false, std::memory_order_release);
+				} },
+		};
+		Core::IoService::Submit(std::span{ requests }, &g_Jobs);
+	}
+
+	/// <summary>
+	/// Deletes the segments made obsolete by a checkpoint, once its saves are on disk.
+	/// </summary>
+	static void FinishCheckpoint(uint32_t firstKept, bool full, std::chrono::steady_clock::time_point start, bool synced) {
+		TRACE_ZONE("Finish Journal Checkpoint");
+		if (synced) {
+			// Only one checkpoint runs at a time, so the one after a failure is always full and clears the flag again.
+			if (full || !g_FullCheckpoint.load(std::memory_order_relaxed)) {
+				g_FullCheckpoint.store(false, std::memory_order_relaxed);
+				DeleteSegments(firstKept);
+			}
+			g_Checkpoints.fetch_add(1, std::memory_order_relaxed);
+			g_CheckpointNs.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+		} else {
+			/*
+			 * The segments are kept, so they can still be replayed. The chunks of the failed saves count as saved by now,
+			 * so the next checkpoint that only saves modified chunks would miss them: it saves every chunk instead.
+			 */
+			Log::Error("Journal checkpoint failed, the journal is kept until a checkpoint of every chunk succeeded");
+			g_FullCheckpoint.store(true, std::memory_order_relaxed);
+		}
+		g_Checkpointing.store(false, std::memory_order_release);
+	}
+
+	/// <summary>
+	/// Starts saving the modified chunks, and switches to a new segment for the edits made from now on.
+	/// </summary>
+	static void StartCheckpoint() {
+		TRACE_ZONE("Start Journal Checkpoint");
+		// The new segment is opened first, so the old one is never deleted while edits still go to it.
+		if (!g_NextSegment) {
+			g_NextSegment = OpenSegment(g_Segment->id + 1);
+			if (!g_NextSegment) {
+				g_CheckpointAt = g_Segment->end + g_CheckpointSize;
+				return;
+			}
+		}
+
+		auto firstKept = g_NextSegment->id;
+		auto full = g_FullCheckpoint.load(std::memory_order_relaxed);
+		auto start = std::chrono::steady_clock::now();
+		g_Checkpointing.store(true, std::memory_order_relaxed);
+		Core::JobSystem::Retain(g_Jobs);
+		auto started = g_Checkpoint([firstKept, full, start] {
+			RegionStore::Sync([firstKept, full, start](bool synced) {
+				FinishCheckpoint(firstKept, full, start, synced);
+				Core::JobSystem::Release(g_Jobs);
+			});
+		}, full);
+		if (!started) {
+			g_Checkpointing.store(false, std::memory_order_relaxed);
+			Core::JobSystem::Release(g_Jobs);
+			return;
+		}
+
+		/*
+		 * The snapshots contain every edit made so far. The edits still in g_Batch end up in the new segment,
+		 * where replaying them is redundant but harmless. No batch is in flight, so the old segment is closed right here.
+		 */
+		g_Segment = std::move(g_NextSegment);
+		g_CheckpointAt = g_CheckpointSize;
+		g_ForceCheckpoint.store(false, std::memory_order_relaxed);
+	}
+
+	void Terminate() {
+		if (!g_Segment)
+			return;
+		Core::JobSystem::Wait(g_Jobs);
+		if (!g_Batch.empty()) {
+			WriteBatch();
+			Core::JobSystem::Wait(g_Jobs);
+		}
+
+		// Every chunk was saved, so once the region files are synced, the journal is obsolete.
+		auto firstKept = (g_NextSegment ? g_NextSegment->id : g_Segment->id) + 1;
+		g_Segment.reset();
+		g_NextSegment.reset();
+		if (!SyncRegions())
+			Log::Error("Failed to sync the world, the journal is kept for replaying it");
+		else if (g_FullCheckpoint.load(std::memory_order_relaxed))
+			// Only the modified chunks were saved, which doesn't cover the saves lost by the failed checkpoint.
+			Log::Warning("A journal checkpoint failed, the journal is kept for replaying it");
+		else
+			DeleteSegments(firstKept);
+	}
+
+	void SetCheckpointer(CheckpointFn checkpoint) {
+		g_Checkpoint = std::move(checkpoint);
+	}
+
+	bool AreSavesDurable() {
+		// A failed checkpoint sets g_FullCheckpoint before it clears g_Checkpointing.
+		if (g_Checkpointing.load(std::memory_order_acquire))
+			return false;
+		return !g_FullCheckpoint.load(std::memory_order_relaxed);
+	}
+
+	void Record(const ivec3& chunk, uint16_t index, BlockId block) {
+		if (g_Batch.empty())
+			g_BatchStart = std::chrono::steady_clock::now();
+		g_Batch.push_back({ chunk.x, chunk.y, chunk.z, index, block });
+		g_Edits++;
+	}
+
+	void Update() {
+		if (!g_Segment)
+			return;
+		if (!g_Batch.empty() && !g_Writing.load(std::memory_order_acquire)
+			&& std::chrono::steady_clock::now() - g_BatchStart >= std::chrono::milliseconds{ g_SyncIntervalMs })
+			WriteBatch();
+
+		// A checkpoint waits for the batch in flight, which must reach the old segment before the switch.
+		if (g_Checkpoint && !g_Checkpointing.load(std::memory_order_acquire) && !g_Writing.load(std::memory_order_acquire)
+			&& (g_Segment->end >= g_CheckpointAt || g_ForceCheckpoint.load(std::memory_order_relaxed)))
+			StartCheckpoint();
+	}
+
+	Stats GetStats() {
+		return {
+			g_Edits,
+			g_Batches.load(std::memory_order_relaxed),
+			g_BytesWritten.load(std::memory_order_relaxed),
+			g_FailedBatches.load(std::memory_order_relaxed),
+			g_Checkpoints.load(std::memory_order_relaxed),
+			g_CheckpointNs.load(std::memory_order_relaxed),
+			g_ReplayedEdits,
+			g_ReplayedChunks,
+		};
+	}
+
+	void PrintReport() {
+		if (g_Directory.empty())
+			return;
+		auto s = GetStats();
+		Log::Info("Journal: {} edits in {} batches ({:.1f} KiB, {:.1f} edits per sync), {} failed, {} checkpoints ({:.1f} ms on average), {} edits of {} chunks replayed",
+			s.edits, s.batches, (double)s.bytesWritten / 1024.0, s.batches > 0 ? (double)s.edits / (double)s.batches : 0.0, s.failedBatches,
+			s.checkpoints, s.checkpoints > 0 ? (double)s.checkpointNs / 1e6 / (double)s.checkpoints : 0.0, s.replayedEdits, s.replayedChunks);
+	}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "Chunk.h"
+
+namespace Game::Journal {
+
+	/*
+	 * Saving a chunk for every edit would write a whole payload (at least a sector) plus its table entry to change a single block.
+	 * Instead, edits are appended to a journal, one 16 byte record per edit: the chunk coordinate, the index of the block within the chunk
+	 * and the new block. Records are collected for a short while and written as a batch, linked to a sync, so an edit is durable
+	 * within "--journal-sync-ms" without any thread waiting for the disk.
+	 *
+	 * The journal can't grow forever. Once it gets large, a checkpoint folds it into the region files:
+	 * 1. Every chunk changed since the last checkpoint is saved from a snapshot, in the background (ChunkStreaming::Autosave()).
+	 *    Edits made from then on go to a new journal segment.
+	 * 2. Once those saves are written, the region files are synced (RegionStore::Sync()).
+	 * 3. The older segments are deleted, everything they contain is in the region files now.
+	 * A chunk edited a thousand times since the last checkpoint is still saved only once.
+	 * If a checkpoint fails, some of its saves may not be on disk although the chunks count as saved. Every segment is kept then,
+	 * and the next checkpoint saves every loaded chunk. Segments are only deleted again once such a full checkpoint succeeded.
+	 * Chunks evicted while a checkpoint runs or after one failed are saved again (see AreSavesDurable()), so the full checkpoint covers them too.
+	 *
+	 * After a crash, Initialize() replays the segments that are left: the chunks they touch are loaded (or generated), the edits are applied
+	 * in order and the chunks saved. Records hold the new block rather than a change, so replaying is idempotent and it doesn't matter
+	 * whether some of the edits already made it into the region files. A batch that was only partially written fails its checksum,
+	 * and replaying the segment stops there.
+	 */
+
+	/// <summary>
+	/// Fills a chunk that was never saved, so edits can be replayed onto it. Called on worker threads.
+	/// </summary>
+	using GenerateFn = std::function<void(Chunk& chunk)>;
+	/// <summary>
+	/// Starts saving every chunk modified since the last checkpoint, or every chunk if all is set, see ChunkStreaming::Autosave().
+	/// </summary>
+	/// <returns>False if that is not possible right now, the checkpoint is tried again by the next update</returns>
+	using CheckpointFn = std::function<bool(std::function<void()> saved, bool all)>;
+
+	/// <summary>
+	/// Replays the journal left in the world directory, if any, and starts a new segment.
+	/// Reads the configuration from the command line ("--journal-sync-ms", "--journal-checkpoint-kb").
+	/// </summary>
+	/// <returns>False if the journal could not be replayed or the new segment could not be created. The old segments are kept then.</returns>
+	///	<remarks>Must be called after Game::RegionStore::Initialize(), on the same directory.</remarks>
+	bool Initialize(const std::string& directory, const GenerateFn& generate);
+	/// <summary>
+	/// Writes the remaining edits and waits for a running checkpoint. If the region files can be synced, the journal is deleted,
+	/// unless a checkpoint failed since the last full one: then it is kept and replayed by the next Initialize().
+	/// </summary>
+	///	<remarks>Must be called after every chunk was saved (see ChunkStreaming::Terminate()), and before Game::RegionStore::Terminate().</remarks>
+	void Terminate();
+
+	/// <summary>
+	/// Sets the function saving the modified chunks for a checkpoint. Without one, the journal only grows.
+	/// </summary>
+	void SetCheckpointer(CheckpointFn checkpoint);
+	/// <returns>False while chunks that count as saved may not be on disk: a checkpoint is running, or one failed and no full checkpoint
+	/// succeeded since. Chunks destroyed meanwhile must be saved again, see ChunkStreaming::SetDurabilityCheck().</returns>
+	[[nodiscard]] bool AreSavesDurable();
+
+	/// <summary>
+	/// Appends an edit to the next batch. Called on the main thread.
+	/// </summary>
+	void Record(const ivec3& chunk, uint16_t index, BlockId block);
+	/// <summary>
+	/// Writes the batch once the sync interval elapsed and starts a checkpoint once the segment is large enough. Called on the main thread.
+	/// </summary>
+	void Update();
+
+	struct Stats {
+		uint64_t edits;
+		uint64_t batches;
+		uint64_t bytesWritten;
+		/// <summary>
+		/// Batches that could not be written or synced. Their edits are only durable after the next checkpoint.
+		/// </summary>
+		uint64_t failedBatches;
+		uint64_t checkpoints;
+		/// <summary>
+		/// Time from starting a checkpoint until its segments were deleted, over every checkpoint.
+		/// </summary>
+		uint64_t checkpointNs;
+		uint64_t replayedEdits;
+		uint64_t replayedChunks;
+	};
+
+	[[nodiscard]] Stats GetStats();
+	/// <summary>
+	/// Prints the stats to the log.
+	/// </summary>
+	void PrintReport();
+
+}
@@ -0,0 +1,709 @@
+#include "RegionStore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ChunkCodec.h"
+#include "ChunkMap.h"
+#include "Core/IoService.h"
+#include "Core/JobSystem.h"
+#include "Core/MappedFile.h"
+#include "Core/Trace.h"
+#include "Logging/Log.h"
+
+namespace Game::RegionStore {
+
+	static constexpr uint32_t CHUNKS_PER_REGION = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+	static constexpr uint32_t TABLE_SECTORS = CHUNKS_PER_REGION * sizeof(uint32_t) / SECTOR_SIZE;
+	static constexpr uint32_t FIRST_PAYLOAD_SECTOR = 1 + TABLE_SECTORS;
+	/// <summary>
+	/// The size of the mapping of a region file, and therefore the size it may grow to.
+	/// </summary>
+	static constexpr uint64_t MAX_REGION_SIZE = 1024ull * 1024 * 1024;
+	/// <summary>
+	/// Region files kept open at the same time, the oldest one that is not in use is closed first.
+	/// </summary>
+	static constexpr uint32_t MAX_OPEN_REGIONS = 64;
+	/// <summary>
+	/// A region is compacted once it contains more garbage than live sectors, and at least this many garbage sectors.
+	/// </summary>
+	static constexpr uint32_t MIN_GARBAGE_SECTORS = 2048;
+
+	static constexpr char MAGIC[4] = { 'M', 'V', 'B', 'R' };
+	static constexpr uint32_t VERSION = 1;
+
+	/*
+	 * A table entry holds the first sector of the payload in the upper 24 bits and the number of sectors in the lower 8 bits.
+	 * 0 means the chunk was never saved. Chunks that are entirely air (most of the sky) get EMPTY_ENTRY instead of a payload,
+	 * which can't be confused with a real payload since sector 1 is part of the table.
+	 */
+	static constexpr uint32_t EMPTY_ENTRY = 1u << 8;
+	static constexpr uint32_t MAX_PAYLOAD_SECTORS = 0xFF;
+
+	struct FileHeader {
+		char magic[4];
+		uint32_t version;
+	};
+
+	struct PayloadHeader {
+		/// <summary>
+		/// Size of the encoded chunk following the header.
+		/// </summary>
+		uint32_t size;
+		uint32_t checksum;
+	};
+
+	/// <summary>
+	/// Size and checksum of the chunk, followed by the encoded chunk.
+	/// </summary>
+	using Payload = std::shared_ptr<const std::vector<uint8_t>>;
+
+	/// <summary>
+	/// The saves a call to Sync() waits for: every save started before it retains the sync point until it is written.
+	/// </summary>
+	struct SyncPoint {
+		/// <summary>
+		/// Saves that retained the sync point, plus one until Sync() takes it. Whoever releases the last one syncs the files.
+		/// </summary>
+		std::atomic<uint32_t> writes{ 1 };
+		std::atomic<bool> failed{ false };
+		SyncCallback done;
+	};
+
+	using SyncPoints = std::vector<std::shared_ptr<SyncPoint>>;
+
+	/// <summary>
+	/// A chunk whose save is being written.
+	/// </summary>
+	struct PendingSave {
+		Payload payload;
+		/// <summary>
+		/// The chunk was saved again while the payload was being written. Written once that finished, so the writes can't overtake each other.
+		/// </summary>
+		Payload next;
+		/// <summary>
+		/// The sync points of the saves next replaced. Since it contains their blocks, they wait for it instead.
+		/// </summary>
+		SyncPoints nextSyncPoints;
+	};
+
+	struct Region {
+		/// <summary>
+		/// Loads share the region, saves and compaction have it exclusively.
+		/// </summary>
+		std::shared_mutex mutex;
+		std::string path;
+		/// <summary>
+		/// Not open until the first chunk of the region is saved, if the file didn't exist yet.
+		/// </summary>
+		Core::MappedFile file;
+		/// <summary>
+		/// Copy of the offset table in the file.
+		/// </summary>
+		std::vector<uint32_t> table;
+		/// <summary>
+		/// Where the next payload is appended.
+		/// </summary>
+		uint32_t endSector;
+		uint32_t liveSectors;
+		bool compacting;
+		/// <summary>
+		/// Written since the file was last synced.
+		/// </summary>
+		std::atomic<bool> dirty{ false };
+		/// <summary>
+		/// Reads and writes submitted to the I/O service that didn't complete yet. The file may only be compacted while there are none.
+		/// </summary>
+		std::atomic<uint32_t> pendingIo{ 0 };
+		/// <summary>
+		/// Saves being written, by table index. The table doesn't point at them yet, so loads take the chunk from here.
+		/// </summary>
+		std::unordered_map<uint32_t, PendingSave> pendingSaves;
+	};
+
+	/// <summary>
+	/// A payload and the table entry pointing at it, kept alive until both are written.
+	/// </summary>
+	struct Write {
+		std::shared_ptr<Region> region;
+		uint32_t index;
+		uint32_t entry;
+		Payload payload;
+		SyncPoints syncPoints;
+	};
+
+	static std::string g_Directory;
+	static std::mutex g_RegionsMutex;
+	static ChunkMap<std::shared_ptr<Region>> g_Regions;
+	/// <summary>
+	/// The open regions in the order they were opened.
+	/// </summary>
+	static std::deque<ivec3> g_RegionOrder;
+	/// <summary>
+	/// Regions closed by GetRegion() while their files are still being synced. SyncFiles() covers them as well.
+	/// </summary>
+	static std::vector<std::shared_ptr<Region>> g_ClosingRegions;
+	/// <summary>
+	/// Syncing a region file failed when it was closed. The next call to SyncFiles() reports it.
+	/// </summary>
+	static std::atomic<bool> g_CloseFailed;
+	static Core::JobSystem::Counter g_CompactionJobs;
+	/// <summary>
+	/// Reads and writes in flight, until their callbacks finished.
+	/// </summary>
+	static Core::JobSystem::Counter g_IoJobs;
+	static std::mutex g_SyncMutex;
+	/// <summary>
+	/// Retained by the saves the next call to Sync() waits for.
+	/// </summary>
+	static std::shared_ptr<SyncPoint> g_SyncPoint;
+	/// <summary>
+	/// A region file was created or replaced since the directory was last synced.
+	/// </summary>
+	static std::atomic<bool> g_DirectoryDirty;
+
+	static std::atomic<uint64_t> g_Loaded;
+	static std::atomic<uint64_t> g_Saved;
+	static std::atomic<uint64_t> g_BytesWritten;
+	static std::atomic<uint64_t> g_Compactions;
+	static std::atomic<uint64_t> g_Syncs;
+	static std::atomic<uint64_t> g_Corrupted;
+
+	static ivec3 GetRegionPosition(const ivec3& chunk) {
+		return ivec3{ chunk.x >> 5, chunk.y >> 5, chunk.z >> 5 };
+	}
+
+	static uint32_t GetTableIndex(const ivec3& chunk) {
+		return (uint32_t)((chunk.x & (REGION_SIZE - 1)) + (chunk.z & (REGION_SIZE - 1)) * REGION_SIZE + (chunk.y & (REGION_SIZE - 1)) * REGION_SIZE * REGION_SIZE);
+	}
+
+	static uint64_t GetTableOffset(uint32_t index) {
+		return SECTOR_SIZE + (uint64_t)index * sizeof(uint32_t);
+	}
+
+	/// <summary>
+	/// Syncs the region files written since they were last synced, and the world directory if files were created or replaced.
+	/// </summary>
+	static bool SyncFiles() {
+		TRACE_ZONE("Sync Regions");
+		auto ok = true;
+		std::vector<std::shared_ptr<Region>> regions;
+		{
+			std::lock_guard lock{ g_RegionsMutex };
+			for (auto& e : g_Regions) {
+				if (e.value->dirty.load(std::memory_order_relaxed))
+					regions.push_back(e.value);
+			}
+			regions.insert(regions.end(), g_ClosingRegions.begin(), g_ClosingRegions.end());
+		}
+		if (g_CloseFailed.exchange(false, std::memory_order_relaxed))
+			ok = false;
+		for (auto& region : regions) {
+			// The shared lock keeps a compaction from replacing the file meanwhile.
+			std::shared_lock lock{ region->mutex };
+			if (!region->dirty.exchange(false, std::memory_order_relaxed) || !region->file.IsOpen())
+				continue;
+			if (!region->file.Sync()) {
+				Log::Error("Failed to sync {}", region->path);
+				region->dirty.store(true, std::memory_order_relaxed);
+				ok = false;
+			}
+		}
+		if (g_DirectoryDirty.exchange(false, std::memory_order_relaxed) && !Core::MappedFile::SyncDirectory(g_Directory)) {
+			Log::Error("Failed to sync world directory {}", g_Directory);
+			g_DirectoryDirty.store(true, std::memory_order_relaxed);
+			ok = false;
+		}
+		g_Syncs.fetch_add(1, std::memory_order_relaxed);
+		return ok;
+	}
+
+	static void ReleaseSyncPoint(const std::shared_ptr<SyncPoint>& syncPoint) {
+		if (syncPoint->writes.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		// fsync blocks until the disk is done, so it gets a job of its own instead of holding up an I/O callback.
+		Core::JobSystem::Submit([syncPoint] {
+			auto synced = SyncFiles();
+			syncPoint->done(synced && !syncPoint->failed.load(std::memory_order_relaxed));
+		}, &g_IoJobs);
+	}
+
+	/// <summary>
+	/// Called once the saves retaining the sync points were written, or failed to.
+	/// </summary>
+	static void ReleaseSyncPoints(SyncPoints& syncPoints, bool written) {
+		for (auto& syncPoint : syncPoints) {
+			if (!written)
+				syncPoint->failed.store(true, std::memory_order_relaxed);
+			ReleaseSyncPoint(syncPoint);
+		}
+		syncPoints.clear();
+	}
+
+	/// <summary>
+	/// Writes the header and an empty table into a new file.
+	/// </summary>
+	static bool WriteEmptyFile(Core::MappedFile& file, std::vector<uint32_t>& table) {
+		std::vector<std::byte> header(SECTOR_SIZE);
+		FileHeader fileHeader{};
+		memcpy(fileHeader.magic, MAGIC, sizeof(MAGIC));
+		fileHeader.version = VERSION;
+		memcpy(header.data(), &fileHeader, sizeof(fileHeader));
+		table.assign(CHUNKS_PER_REGION, 0);
+		return file.Write(0, header.data(), header.size()) && file.Write(SECTOR_SIZE, table.data(), table.size() * sizeof(uint32_t));
+	}
+
+	/// <summary>
+	/// Reads the table of an existing file and finds the end of the last payload.
+	/// </summary>
+	static bool ReadTable(Region& region) {
+		const auto& file = region.file;
+		FileHeader header;
+		if (file.GetSize() < (uint64_t)FIRST_PAYLOAD_SECTOR * SECTOR_SIZE)
+			return false;
+		memcpy(&header, file.GetData(), sizeof(header));
+		if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION)
+			return false;
+
+		region.table.resize(CHUNKS_PER_REGION);
+		memcpy(region.table.data(), file.GetData() + SECTOR_SIZE, CHUNKS_PER_REGION * sizeof(uint32_t));
+		region.endSector = FIRST_PAYLOAD_SECTOR;
+		region.liveSectors = 0;
+		for (auto& entry : region.table) {
+			auto first = entry >> 8, count = entry & MAX_PAYLOAD_SECTORS;
+			if (count == 0)
+				continue;
+			// The entry points past the end of the file, which was cut off. The chunk is treated as never saved.
+			if (first < FIRST_PAYLOAD_SECTOR || (uint64_t)first * SECTOR_SIZE + sizeof(PayloadHeader) > file.GetSize()) {
+				entry = 0;
+				continue;
+			}
+			region.endSector = std::max(region.endSector, first + count);
+			region.liveSectors += count;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Opens the file of a region if it exists, or creates it.
+	/// </summary>
+	static bool OpenFile(Region& region, bool create) {
+		if (!create && !std::filesystem::exists(region.path))
+			return false;
+		if (!region.file.Open(region.path, MAX_REGION_SIZE))
+			return false;
+		if (region.file.GetSize() == 0) {
+			if (!WriteEmptyFile(region.file, region.table)) {
+				Log::Error("Failed to initialize region file {}", region.path);
+				region.file.Close();
+				return false;
+			}
+			region.dirty.store(true, std::memory_order_relaxed);
+			g_DirectoryDirty.store(true, std::memory_order_relaxed);
+			region.endSector = FIRST_PAYLOAD_SECTOR;
+			region.liveSectors = 0;
+			return true;
+		}
+		if (!ReadTable(region)) {
+			// We don't touch the file, whatever it is. The chunks of the region are generated, but can't be saved.
+			Log::Error("{} is not a valid region file", region.path);
+			region.file.Close();
+			return false;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Syncs the file of a region that was closed by GetRegion(), on a job so that nobody waits for the disk meanwhile.
+	/// </summary>
+	static void SyncClosedRegion(std::shared_ptr<Region> region) {
+		TRACE_ZONE("Sync Closed Region");
+		{
+			// Locked exclusively, so a SyncFiles() that finds the region clean meanwhile only continues once the file is synced.
+			std::unique_lock lock{ region->mutex };
+			if (region->dirty.exchange(false, std::memory_order_relaxed) && !region->file.Sync()) {
+				Log::Error("Failed to sync {}", region->path);
+				g_CloseFailed.store(true, std::memory_order_relaxed);
+			}
+		}
+		std::lock_guard lock{ g_RegionsMutex };
+		std::erase(g_ClosingRegions, region);
+		// The file is closed once the last reference is gone, after the lock was released.
+	}
+
+	/// <returns>The region containing a chunk, opening its file if it exists</returns>
+	static std::shared_ptr<Region> GetRegion(const ivec3& chunk) {
+		auto position = GetRegionPosition(chunk);
+		std::lock_guard lock{ g_RegionsMutex };
+		if (auto* region = g_Regions.Find(position))
+			return *region;
+
+		/*
+		 * Regions whose file doesn't exist are kept as well, so loading the chunks of an unexplored area doesn't check for the file every time.
+		 * A region may only be closed once nobody else holds it, otherwise a second Region object for the same file
+		 * could be opened and both would append to it.
+		 */
+		auto region = std::make_shared<Region>();
+		region->path = Log::format("{}/r.{}.{}.{}.region", g_Directory, position.x, position.y, position.z);
+		region->compacting = false;
+		OpenFile(*region, false);
+		g_Regions.TryEmplace(position, region);
+		g_RegionOrder.push_back(position);
+
+		for (size_t i = 0; i < g_RegionOrder.size() && g_Regions.Size() > MAX_OPEN_REGIONS;) {
+			auto* r = g_Regions.Find(g_RegionOrder[i]);
+			if (r && r->use_count() > 1) {
+				i++;
+				continue;
+			}
+			// Sync() only knows the open regions and the ones being closed. fsync may take long, so it doesn't hold up every lookup.
+			if (r && (*r)->dirty.load(std::memory_order_relaxed)) {
+				g_ClosingRegions.push_back(*r);
+				Core::JobSystem::Submit([closed = *r] { SyncClosedRegion(closed); }, &g_IoJobs);
+			}
+			g_Regions.Erase(g_RegionOrder[i]);
+			g_RegionOrder.erase(g_RegionOrder.begin() + (ptrdiff_t)i);
+		}
+		return region;
+	}
+
+	/// <summary>
+	/// Copies every live payload into a new file, which then replaces the region file.
+	/// </summary>
+	static void Compact(Region& region) {
+		TRACE_ZONE("Compact Region");
+		std::unique_lock lock{ region.mutex };
+		// A load started since the compaction was issued. The last request to complete issues it again.
+		if (!region.file.IsOpen() || region.pendingIo.load(std::memory_order_relaxed) != 0)
+			return;
+
+		auto tmpPath = region.path + ".tmp";
+		std::error_code ec;
+		// Left over if we crashed while compacting. The region file itself is still intact in that case.
+		std::filesystem::remove(tmpPath, ec);
+
+		Core::MappedFile out;
+		std::vector<uint32_t> table;
+		auto ok = out.Open(tmpPath, MAX_REGION_SIZE) && WriteEmptyFile(out, table);
+		auto sector = FIRST_PAYLOAD_SECTOR;
+		for (uint32_t i = 0; ok && i < CHUNKS_PER_REGION; i++) {
+			auto entry = region.table[i];
+			auto count = entry & MAX_PAYLOAD_SECTORS;
+			if (count == 0) {
+				table[i] = entry;
+				continue;
+			}
+			const auto* payload = region.file.GetData() + (uint64_t)(entry >> 8) * SECTOR_SIZE;
+			auto size = std::min<uint64_t>((uint64_t)count * SECTOR_SIZE, region.file.GetSize() - (uint64_t)(entry >> 8) * SECTOR_SIZE);
+			ok = out.Write((uint64_t)sector * SECTOR_SIZE, payload, size);
+			table[i] = sector << 8 | count;
+			sector += count;
+		}
+		ok = ok && out.Write(SECTOR_SIZE, table.data(), table.size() * sizeof(uint32_t)) && out.Sync();
+		out.Close();
+		if (!ok) {
+			Log::Error("Failed to compact {}", region.path);
+			std::filesystem::remove(tmpPath, ec);
+			return;
+		}
+
+		// Windows can't replace a file that is still open.
+		auto oldSize = region.file.GetSize();
+		region.file.Close();
+		std::filesystem::rename(tmpPath, region.path, ec);
+		if (ec)
+			Log::Error("Failed to replace {} by its compacted version: {}", region.path, ec.message());
+		g_DirectoryDirty.store(true, std::memory_order_relaxed);
+		if (!OpenFile(region, false)) {
+			Log::Error("Failed to reopen {} after compacting it", region.path);
+			return;
+		}
+		g_Compactions.fetch_add(1, std::memory_order_relaxed);
+		Log::Info("Compacted {} from {} KiB to {} KiB", region.path, oldSize / 1024, region.file.GetSize() / 1024);
+	}
+
+	/// <summary>
+	/// Issues a compaction once the region contains more garbage than live sectors and no I/O is in flight.
+	/// </summary>
+	///	<remarks>The region must be locked exclusively.</remarks>
+	static void MaybeCompact(const std::shared_ptr<Region>& region) {
+		auto garbage = region->endSector - FIRST_PAYLOAD_SECTOR - region->liveSectors;
+		if (region->compacting || region->pendingIo.load(std::memory_order_relaxed) != 0 || garbage <= region->liveSectors || garbage < MIN_GARBAGE_SECTORS)
+			return;
+		region->compacting = true;
+		Core::JobSystem::Submit([region] {
+			Compact(*region);
+			std::lock_guard lock{ region->mutex };
+			region->compacting = false;
+		}, &g_CompactionJobs);
+	}
+
+	/// <summary>
+	/// Called once a read or write of the region completed.
+	/// </summary>
+	static void FinishIo(const std::shared_ptr<Region>& region) {
+		if (region->pendingIo.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			return;
+		std::lock_guard lock{ region->mutex };
+		MaybeCompact(region);
+	}
+
+	static void FinishWrite(Write& write, bool written);
+
+	/// <summary>
+	/// Appends a payload to the region file and points the table entry at it. The entry is only written once the payload is on the disk,
+	/// so it never points at data that isn't there yet, not even after a crash.
+	/// </summary>
+	///	<remarks>The region must be locked exclusively.</remarks>
+	/// <returns>False if the file could not be grown</returns>
+	static bool StartWrite(const std::shared_ptr<Region>& region, uint32_t index, Payload payload, SyncPoints syncPoints) {
+		auto write = std::make_shared<Write>(Write{ region, index, EMPTY_ENTRY, std::move(payload), std::move(syncPoints) });
+		const auto& data = *write->payload;
+		auto handle = region->file.GetHandle();
+		Core::IoService::Request requests[3];
+		uint32_t numRequests = 0;
+
+		if (data[sizeof(PayloadHeader)] != (uint8_t)ChunkCodec::Format::Empty) {
+			auto sectors = (uint32_t)((data.size() + SECTOR_SIZE - 1) / SECTOR_SIZE);
+			auto offset = (uint64_t)region->endSector * SECTOR_SIZE;
+			if (!region->file.Grow(offset + data.size())) {
+				Log::Error("Failed to grow {}", region->path);
+				ReleaseSyncPoints(write->syncPoints, false);
+				return false;
+			}
+			write->entry = region->endSector << 8 | sectors;
+			region->endSector += sectors;
+			requests[numRequests++] = { Core::IoService::Op::Write, handle, offset, (void*)data.data(), (uint32_t)data.size(), Core::IoService::NO_BUFFER, true, {} };
+			// Linking only orders the submission. Without the sync, the page cache could write the entry back to the disk before the payload.
+			requests[numRequests++] = { Core::IoService::Op::Sync, handle, 0, nullptr, 0, Core::IoService::NO_BUFFER, true, {} };
+		}
+		requests[numRequests++] = { Core::IoService::Op::Write, handle, GetTableOffset(index), &write->entry, sizeof(uint32_t), Core::IoService::NO_BUFFER, false,
+			[write](int64_t result) {
+				std::lock_guard lock{ write->region->mutex };
+				FinishWrite(*write, result == sizeof(uint32_t));
+			} };
+		region->pendingIo.fetch_add(1, std::memory_order_relaxed);
+		Core::IoService::Submit(std::span{ requests, numRequests }, &g_IoJobs);
+		return true;
+	}
+
+	/// <summary>
+	/// Points the table at a written payload and starts writing the next version of the chunk, if it was saved again meanwhile.
+	/// </summary>
+	///	<remarks>The region must be locked exclusively.</remarks>
+	static void FinishWrite(Write& write, bool written) {
+		auto& region = *write.region;
+		if (written) {
+			region.liveSectors += (write.entry & MAX_PAYLOAD_SECTORS);
+			region.liveSectors -= (region.table[write.index] & MAX_PAYLOAD_SECTORS);
+			region.table[write.index] = write.entry;
+			region.dirty.store(true, std::memory_order_relaxed);
+			g_Saved.fetch_add(1, std::memory_order_relaxed);
+			g_BytesWritten.fetch_add((write.entry == EMPTY_ENTRY ? 0 : write.payload->size()) + sizeof(uint32_t), std::memory_order_relaxed);
+		} else {
+			// The table still points at the previous version, if any. The sectors reserved for the payload are garbage now.
+			Log::Error("Failed to write a chunk to {}", region.path);
+		}
+		ReleaseSyncPoints(write.syncPoints, written);
+
+		auto it = region.pendingSaves.find(write.index);
+		if (it->second.next) {
+			it->second.payload = std::move(it->second.next);
+			if (!StartWrite(write.region, write.index, it->second.payload, std::move(it->second.nextSyncPoints)))
+				region.pendingSaves.erase(it);
+		} else {
+			region.pendingSaves.erase(it);
+		}
+		region.pendingIo.fetch_sub(1, std::memory_order_relaxed);
+		MaybeCompact(write.region);
+	}
+
+	/// <summary>
+	/// Checks a payload and decodes the chunk from it.
+	/// </summary>
+	static bool DecodePayload(const uint8_t* data, size_t size, Chunk& chunk, const Region& region) {
+		PayloadHeader header{};
+		if (size >= sizeof(header))
+			memcpy(&header, data, sizeof(header));
+		data += sizeof(header);
+		if (size < sizeof(header) || header.size > size - sizeof(header) || ChunkCodec::Checksum(data, header.size) != header.checksum
+			|| !ChunkCodec::Decode(data, header.size, chunk)) {
+			auto position = chunk.GetPosition();
+			g_Corrupted.fetch_add(1, std::memory_order_relaxed);
+			Log::Warning("Chunk ({}, {}, {}) in {} is corrupted", position.x, position.y, position.z, region.path);
+			return false;
+		}
+		chunk.SetModified(false);
+		g_Loaded.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool Initialize(const std::string& directory) {
+		std::error_code ec;
+		std::filesystem::create_directories(directory, ec);
+		if (ec) {
+			Log::Error("Failed to create world directory {}: {}", directory, ec.message());
+			return false;
+		}
+		g_Directory = directory;
+		g_SyncPoint = std::make_shared<SyncPoint>();
+		return true;
+	}
+
+	void Terminate() {
+		// Finished writes may still start the next version of a chunk, or a compaction.
+		Core::JobSystem::Wait(g_IoJobs);
+		Core::JobSystem::Wait(g_CompactionJobs);
+		std::lock_guard lock{ g_RegionsMutex };
+		for (auto& e : g_Regions) {
+			if (e.value->file.IsOpen())
+				e.value->file.Sync();
+		}
+		g_Regions.Clear();
+		g_RegionOrder.clear();
+	}
+
+	void Load(Chunk& chunk, LoadCallback done) {
+		TRACE_ZONE("Load Chunk From Region");
+		auto position = chunk.GetPosition();
+		auto region = GetRegion(position);
+		auto index = GetTableIndex(position);
+		Payload pending;
+		{
+			std::shared_lock lock{ region->mutex };
+			auto entry = region->file.IsOpen() ? region->table[index] : 0;
+			if (auto it = region->pendingSaves.find(index); it != region->pendingSaves.end()) {
+				pending = it->second.next ? it->second.next : it->second.payload;
+			} else if (entry == 0) {
+				lock.unlock();
+				done(LoadResult::Absent);
+				return;
+			} else if (entry != EMPTY_ENTRY) {
+				/*
+				 * The payload is read into a registered buffer, and decoded by the callback. No thread waits for the disk meanwhile.
+				 * The region stays locked until the read is submitted, so a compaction can't replace the file in between,
+				 * and pendingIo keeps it from starting before the read completed.
+				 */
+				auto size = (entry & MAX_PAYLOAD_SECTORS) * SECTOR_SIZE;
+				auto buffer = Core::IoService::AcquireBuffer();
+				std::shared_ptr<std::vector<uint8_t>> fallback;
+				if (!buffer.data)
+					fallback = std::make_shared<std::vector<uint8_t>>(size);
+				auto* data = buffer.data ? (void*)buffer.data : (void*)fallback->data();
+				region->pendingIo.fetch_add(1, std::memory_order_relaxed);
+				Core::IoService::Submit({ Core::IoService::Op::Read, region->file.GetHandle(), (uint64_t)(entry >> 8) * SECTOR_SIZE, data, size, buffer.index, false,
+					[region, &chunk, done, buffer, fallback, data](int64_t result) {
+						if (result < 0)
+							Log::Error("Failed to read a chunk from {}: error {}", region->path, -result);
+						auto loaded = result >= 0 && DecodePayload((const uint8_t*)data, (size_t)result, chunk, *region);
+						if (buffer.data)
+							Core::IoService::ReleaseBuffer(buffer.index);
+						FinishIo(region);
+						done(loaded ? LoadResult::Loaded : LoadResult::Failed);
+					} }, &g_IoJobs);
+				return;
+			}
+		}
+
+		if (pending) {
+			done(DecodePayload(pending->data(), pending->size(), chunk, *region) ? LoadResult::Loaded : LoadResult::Failed);
+			return;
+		}
+		// The chunk is entirely air, nothing to read.
+		chunk.SetModified(false);
+		g_Loaded.fetch_add(1, std::memory_order_relaxed);
+		done(LoadResult::Loaded);
+	}
+
+	bool Save(const ChunkSnapshot& snapshot) {
+		TRACE_ZONE("Save Chunk To Region");
+		std::shared_ptr<SyncPoint> syncPoint;
+		{
+			// Retained under the lock, otherwise Sync() could swap it and release the last reference before this save counts.
+			std::lock_guard lock{ g_SyncMutex };
+			syncPoint = g_SyncPoint;
+			syncPoint->writes.fetch_add(1, std::memory_order_relaxed);
+		}
+		auto fail = [&syncPoint] {
+			syncPoint->failed.store(true, std::memory_order_relaxed);
+			ReleaseSyncPoint(syncPoint);
+			return false;
+		};
+
+		// The payload is encoded before taking the lock, so loads of other chunks in the region don't wait for it.
+		auto payload = std::make_shared<std::vector<uint8_t>>(sizeof(PayloadHeader));
+		ChunkCodec::Encode(snapshot.GetBlocks(), *payload);
+		PayloadHeader header{ (uint32_t)(payload->size() - sizeof(PayloadHeader)), 0 };
+		header.checksum = ChunkCodec::Checksum(payload->data() + sizeof(PayloadHeader), header.size);
+		memcpy(payload->data(), &header, sizeof(header));
+		if ((payload->size() + SECTOR_SIZE - 1) / SECTOR_SIZE > MAX_PAYLOAD_SECTORS) {
+			Log::Error("Chunk is too large to be saved ({} bytes)", payload->size());
+			return fail();
+		}
+
+		auto position = snapshot.GetPosition();
+		auto region = GetRegion(position);
+		std::unique_lock lock{ region->mutex };
+		if (!region->file.IsOpen() && !OpenFile(*region, true))
+			return fail();
+
+		auto index = GetTableIndex(position);
+		auto [it, inserted] = region->pendingSaves.try_emplace(index, PendingSave{ payload, nullptr, {} });
+		if (!inserted) {
+			it->second.next = std::move(payload);
+			it->second.nextSyncPoints.push_back(std::move(syncPoint));
+			return true;
+		}
+		if (!StartWrite(region, index, std::move(payload), { std::move(syncPoint) })) {
+			region->pendingSaves.erase(index);
+			return false;
+		}
+		return true;
+	}
+
+	void Sync(SyncCallback done) {
+		std::shared_ptr<SyncPoint> syncPoint;
+		{
+			std::lock_guard lock{ g_SyncMutex };
+			// Saves started from now on retain the new sync point, so this doesn't wait forever while chunks keep being saved.
+			syncPoint = std::exchange(g_SyncPoint, std::make_shared<SyncPoint>());
+		}
+		syncPoint->done = std::move(done);
+		ReleaseSyncPoint(syncPoint);
+	}
+
+	Stats GetStats() {
+		uint32_t openRegions;
+		{
+			std::lock_guard lock{ g_RegionsMutex };
+			openRegions = (uint32_t)g_Regions.Size();
+		}
+		return {
+			g_Loaded.load(std::memory_order_relaxed),
+			g_Saved.load(std::memory_order_relaxed),
+			g_BytesWritten.load(std::memory_order_relaxed),
+			g_Compactions.load(std::memory_order_relaxed),
+			g_Syncs.load(std::memory_order_relaxed),
+			g_Corrupted.load(std::memory_order_relaxed),
+			openRegions,
+		};
+	}
+
+	void PrintReport() {
+		if (g_Directory.empty())
+			return;
+		auto s = GetStats();
+		Log::Info("Region store: {} chunks loaded, {} saved ({:.1f} MiB written), {} compactions, {} syncs, {} corrupted, {} regions open",
+			s.loaded, s.saved, (double)s.bytesWritten / (1024.0 * 1024.0), s.compactions, s.syncs, s.corrupted, s.openRegions);
+	}
+
+}
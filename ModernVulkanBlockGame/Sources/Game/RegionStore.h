@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "Chunk.h"
+
+namespace Game::RegionStore {
+
+	/*
+	 * Saved chunks are grouped into region files of REGION_SIZE^3 chunks, i.e. 32 x 32 columns, 32 chunks high.
+	 * Opening a file per chunk would cost more than decoding it, so region files stay open, and loading a chunk only reads the few sectors holding it.
+	 * The files are memory-mapped as well, for reading the offset table and copying payloads during compaction.
+	 *
+	 * A region file consists of
+	 * - a header sector with a magic number and the version,
+	 * - an offset table with an entry per chunk: the first sector of its payload and the number of sectors (0 if the chunk was never saved),
+	 * - the payloads, each starting at a sector boundary: size and checksum, followed by the chunk encoded with ChunkCodec.
+	 * Saving a chunk never overwrites its old payload. The new payload is appended and the table entry is pointed at it,
+	 * so a crash while writing leaves either the old or the new chunk, never a mix of both. The old payload becomes garbage,
+	 * and once a file consists mostly of garbage, a job compacts it by copying every live payload into a new file.
+	 *
+	 * Chunks are read and written through the Core::IoService, so loading or saving never blocks a thread on the disk:
+	 * a load reads the payload into a registered buffer and decodes it in the callback, a save appends the payload, forces it to the disk and then
+	 * writes the table entry, as a linked chain of requests. Until that completed, the chunk is served from memory, and saving it again waits
+	 * for the write in flight.
+	 *
+	 * Writes are not forced to the disk as they complete, that is what Sync() is for. The journal calls it to make a checkpoint durable.
+	 */
+
+	inline constexpr int32_t REGION_SIZE = 32;
+	inline constexpr uint32_t SECTOR_SIZE = 512;
+
+	/// <summary>
+	/// Opens the world in the given directory, creating it if necessary.
+	/// </summary>
+	/// <returns>False if the directory could not be created</returns>
+	///	<remarks>Must be called after Core::IoService::Initialize()</remarks>
+	bool Initialize(const std::string& directory);
+	/// <summary>
+	/// Waits for pending reads, writes and compactions and closes every region file.
+	/// </summary>
+	///	<remarks>No chunk may be loaded or saved anymore.</remarks>
+	void Terminate();
+
+	enum class LoadResult : uint8_t {
+		Loaded,
+		/// <summary>
+		/// The chunk was never saved.
+		/// </summary>
+		Absent,
+		/// <summary>
+		/// The chunk was saved, but could not be read or its data is corrupted.
+		/// </summary>
+		Failed,
+	};
+
+	using LoadCallback = std::function<void(LoadResult result)>;
+
+	/// <summary>
+	/// Starts filling an empty chunk with its saved blocks. Thread-safe.
+	/// </summary>
+	/// <param name="done">Called once the chunk is filled, right away if nothing has to be read, otherwise from a job</param>
+	///	<remarks>The chunk must stay alive until done was called.</remarks>
+	void Load(Chunk& chunk, LoadCallback done);
+	/// <summary>
+	/// Starts saving a chunk, replacing the previous version. Loads see the new version right away. Thread-safe.
+	/// Saves of the same chunk are written in the order this is called, so a later snapshot must not be saved before an earlier one.
+	/// </summary>
+	/// <returns>False if the region file could not be opened or grown</returns>
+	bool Save(const ChunkSnapshot& snapshot);
+
+	/// <summary>
+	/// Called with false if one of the saves or syncing a file failed.
+	/// </summary>
+	using SyncCallback = std::function<void(bool synced)>;
+
+	/// <summary>
+	/// Starts forcing every save started before the call to the disk: once they are written, a job syncs the region files and the world directory.
+	/// Nothing waits meanwhile, saves started later are not held up either. Thread-safe.
+	/// </summary>
+	/// <param name="done">Called from that job</param>
+	void Sync(SyncCallback done);
+
+	struct Stats {
+		uint64_t loaded;
+		uint64_t saved;
+		uint64_t bytesWritten;
+		uint64_t compactions;
+		uint64_t syncs;
+		/// <summary>
+		/// Chunks whose payload failed the checksum or could not be decoded.
+		/// </summary>
+		uint64_t corrupted;
+		/// <summary>
+		/// Regions kept open, including the ones without a file yet.
+		/// </summary>
+		uint32_t openRegions;
+	};
+
+	[[nodiscard]] Stats GetStats();
+	/// <summary>
+	/// Prints the stats to the log.
+	/// </summary>
+	void PrintReport();
+
+}
@@ -0,0 +1,141 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+
+#include "ChunkStreaming.h"
+#include "Components.h"
+#include "Core/CommandLine.h"
+#include "Maths/Maths.h"
+
+namespace Game::Simulation {
+
+	static std::unique_ptr<ECS::World> g_World;
+	static std::vector<Transform> g_Previous;
+	static std::vector<Transform> g_Current;
+
+	/// <summary>
+	/// Where the viewer is and looks at. The renderer doesn't follow it yet, it only drives chunk streaming.
+	/// </summary>
+	static vec3 g_ViewPosition;
+	static vec3 g_ViewDirection;
+	/// <summary>
+	/// Blocks per second the viewer flies along its view direction, set by "--fly-speed" to stress test streaming.
+	/// </summary>
+	static float g_FlySpeed;
+	/// <summary>
+	/// Random blocks changed around the viewer every tick, set by "--debug-edits" to exercise the edit journal and autosaves.
+	/// </summary>
+	static uint32_t g_DebugEdits;
+	static std::minstd_rand g_DebugEditRandom;
+
+	/// <summary>
+	/// Copies the transforms of every rendered entity into g_Previous and g_Current, in the same order.
+	/// </summary>
+	static void GatherTransforms() {
+		g_Previous.clear();
+		g_Current.clear();
+		g_World->ForEachChunk<const Transform, const PreviousTransform>([](uint32_t count, const ECS::Entity*, const Transform* current, const PreviousTransform* previous) {
+			g_Current.insert(g_Current.end(), current, current + count);
+			for (uint32_t i = 0; i < count; i++)
+				g_Previous.push_back(previous[i].value);
+		});
+	}
+
+	/// <summary>
+	/// Digs out or fills random blocks within two chunks of the viewer, through the same path as player edits.
+	/// </summary>
+	static void MakeDebugEdits() {
+		constexpr int32_t RANGE = 2 * Chunk::SIZE;
+		std::uniform_int_distribution<int32_t> offset{ -RANGE, RANGE - 1 };
+		auto center = ivec3::Floor(g_ViewPosition);
+		for (uint32_t i = 0; i < g_DebugEdits; i++) {
+			auto position = center + ivec3{ offset(g_DebugEditRandom), offset(g_DebugEditRandom), offset(g_DebugEditRandom) };
+			// Edits of chunks that are not loaded yet are simply dropped.
+			ChunkStreaming::SetBlock(position, g_DebugEditRandom() % 2 ? STONE : AIR);
+		}
+	}
+
+	/// <summary>
+	/// Creates an entity that is rendered at the given transform.
+	/// </summary>
+	static void CreateSpinningQuad(const Transform& transform, const Spin& spin) {
+		g_World->Create(transform, PreviousTransform{ transform }, spin);
+	}
+
+	void Initialize() {
+		g_World = std::make_unique<ECS::World>();
+		g_ViewPosition = vec3{ 0, 0, 0 };
+		g_ViewDirection = vec3{ 0, 0, 1 };
+		g_FlySpeed = (float)Core::CommandLine::GetInt("--fly-speed", 0);
+		g_DebugEdits = (uint32_t)std::clamp<int64_t>(Core::CommandLine::GetInt("--debug-edits", 0), 0, 100'000);
+		g_DebugEditRandom.seed(1);
+
+		// The test quad in front of the camera, doing half a turn per second.
+		CreateSpinningQuad(Transform{ vec3{0, 0, 5.0f}, Quaternion{}, vec3{1, 1, 1} }, Spin{ vec3{0, 0, 1}, ToRadians(180.0f) });
+
+		// Stress test: a wall of quads behind the test quad, each spinning around its own axis.
+		auto count = Core::CommandLine::GetInt("--spawn-entities", 0);
+		auto side = (int64_t)std::ceil(std::sqrt((double)count));
+		for (int64_t i = 0; i < count; i++) {
+			auto x = (float)(i % side) - (float)side * 0.5f;
+			auto y = (float)(i / side) - (float)side * 0.5f;
+			CreateSpinningQuad(
+				Transform{ vec3{x * 2.5f, y * 2.5f, 10.0f + (float)side * 2.0f}, Quaternion{}, vec3{1, 1, 1} },
+				Spin{ vec3{(float)(i % 7) - 3.0f, (float)(i % 5) - 2.0f, 1.0f}, ToRadians(45.0f + (float)(i % 90)) });
+		}
+
+		GatherTransforms();
+	}
+
+	void Terminate() {
+		g_World.reset();
+		g_Previous = {};
+		g_Current = {};
+	}
+
+	void Tick(float dt) {
+		// Every entity remembers where it was, then the systems move it on.
+		g_World->ParallelForEachChunk<const Transform, PreviousTransform>([](uint32_t count, const ECS::Entity*, const Transform* current, PreviousTransform* previous) {
+			for (uint32_t i = 0; i < count; i++)
+				previous[i].value = current[i];
+		});
+
+		g_World->ParallelEach<Transform, const Spin>([dt](Transform& t, const Spin& spin) {
+			// Normalizing after every step keeps rounding errors from accumulating into a scale over thousands of ticks.
+			t.rotation = (Quaternion{ spin.axis, spin.speed * dt } * t.rotation).Normalize();
+		});
+
+		// Entities created or destroyed by the systems above.
+		g_World->FlushCommands();
+
+		g_ViewPosition += g_ViewDirection * (g_FlySpeed * dt);
+		if (g_DebugEdits > 0)
+			MakeDebugEdits();
+
+		GatherTransforms();
+	}
+
+	ECS::World& GetWorld() {
+		return *g_World;
+	}
+
+	const std::vector<Transform>& GetPreviousTransforms() {
+		return g_Previous;
+	}
+
+	const std::vector<Transform>& GetCurrentTransforms() {
+		return g_Current;
+	}
+
+	vec3 GetViewPosition() {
+		return g_ViewPosition;
+	}
+
+	vec3 GetViewDirection() {
+		return g_ViewDirection;
+	}
+
+}
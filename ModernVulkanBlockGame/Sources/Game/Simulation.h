@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+
+#include "ECS/World.h"
+#include "Maths/Transform.h"
+
+namespace Game::Simulation {
+
+	/*
+	 * The simulation only ever advances in fixed ticks, see Core::FixedTimestep. Its entities live in an ECS::World,
+	 * every tick runs the systems over them. Afterwards the transforms of every rendered entity after the latest and after the previous tick
+	 * are copied out for the renderer to interpolate between. Both arrays always have the same size and order, so entity i is at index i in both.
+	 */
+
+	/// <summary>
+	/// Creates the world and the initial entities. "--spawn-entities N" adds N more for stress testing.
+	/// </summary>
+	///	<remarks>Must be called after Core::JobSystem::Initialize()</remarks>
+	void Initialize();
+	void Terminate();
+
+	/// <summary>
+	/// Advances the simulation by a single tick.
+	/// </summary>
+	/// <param name="dt">Duration of a tick in seconds</param>
+	void Tick(float dt);
+
+	/// <returns>The world containing every entity of the simulation</returns>
+	[[nodiscard]] ECS::World& GetWorld();
+
+	/// <returns>The transform of every entity after the previous tick</returns>
+	[[nodiscard]] const std::vector<Transform>& GetPreviousTransforms();
+	/// <returns>The transform of every entity after the latest tick</returns>
+	[[nodiscard]] const std::vector<Transform>& GetCurrentTransforms();
+
+	/// <returns>The position of the viewer after the latest tick</returns>
+	[[nodiscard]] vec3 GetViewPosition();
+	/// <returns>The normalized direction the viewer looks in</returns>
+	[[nodiscard]] vec3 GetViewDirection();
+
+}
@@ -0,0 +1,289 @@
+#include "TerrainGenerator.h"
+
+// Keeps the compiler from fusing multiplies and adds, see Noise.h. GCC takes -ffp-contract=off instead.
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "ChunkMap.h"
+#include "Core/CommandLine.h"
+#include "Core/JobSystem.h"
+#include "Core/MemoryTracker.h"
+#include "Core/Trace.h"
+#include "Logging/Log.h"
+#include "Maths/Noise.h"
+
+namespace Game::TerrainGenerator {
+
+	/*
+	 * The height is the sea level plus large scale continents, with smaller hills on top. Where the mountain noise is high,
+	 * the hills are scaled up a lot. The biome follows from the height, the mountain noise and a moisture noise.
+	 * Every noise uses its own seed, derived from the world seed.
+	 */
+	static constexpr Noise::Fractal CONTINENTS{ 4, 1.0f / 512.0f, 2.0f, 0.5f };
+	static constexpr Noise::Fractal HILLS{ 5, 1.0f / 96.0f, 2.0f, 0.5f };
+	static constexpr Noise::Fractal MOUNTAINS{ 3, 1.0f / 384.0f, 2.0f, 0.5f };
+	static constexpr Noise::Fractal MOISTURE{ 2, 1.0f / 320.0f, 2.0f, 0.5f };
+	/// <summary>
+	/// Blocks below the surface where this noise is above CAVE_THRESHOLD are hollowed out.
+	/// </summary>
+	static constexpr Noise::Fractal CAVES{ 2, 1.0f / 40.0f, 2.0f, 0.5f };
+	static constexpr float CAVE_THRESHOLD = 0.3f;
+	/// <summary>
+	/// Thickness of the dirt or sand layer below the surface block.
+	/// </summary>
+	static constexpr int32_t SOIL_DEPTH = 3;
+
+	static constexpr int32_t COLUMN_AREA = Chunk::SIZE * Chunk::SIZE;
+
+	/// <summary>
+	/// The horizontal data of a column of chunks, indexed by x + z * Chunk::SIZE.
+	/// </summary>
+	struct Column {
+		int16_t height[COLUMN_AREA];
+		Biome biome[COLUMN_AREA];
+		int32_t maxHeight;
+	};
+
+	/*
+	 * Columns are requested by every worker at the same time, so the cache is split into shards with a lock each.
+	 * Neighboring columns land in different shards, so the workers generating them don't wait for each other.
+	 * Columns are shared_ptrs, a column that is evicted while a worker still uses it is destroyed once the worker is done.
+	 */
+	static constexpr uint32_t NUM_SHARDS = 16;
+
+	struct Shard {
+		std::mutex mutex;
+		/// <summary>
+		/// Keyed by the chunk coordinate of the column with y = 0.
+		/// </summary>
+		ChunkMap<std::shared_ptr<const Column>> columns;
+		/// <summary>
+		/// The columns in the order they were added, the oldest one is evicted first.
+		/// </summary>
+		std::deque<ivec3> order;
+	};
+
+	static Config g_Config;
+	static Shard g_Shards[NUM_SHARDS];
+
+	static std::atomic<uint64_t> g_Chunks;
+	static std::atomic<uint64_t> g_EmptyChunks;
+	static std::atomic<uint64_t> g_GenerateNs;
+	static std::atomic<uint64_t> g_ColumnHits;
+	static std::atomic<uint64_t> g_ColumnMisses;
+
+	void Initialize() {
+		g_Config = {};
+		g_Config.seed = (uint32_t)Core::CommandLine::GetInt("--seed", g_Config.seed);
+	}
+
+	void Terminate() {
+		for (auto& shard : g_Shards) {
+			Core::MemoryTracker::RecordFree(Core::MemoryTag::Chunks, Core::MemoryDomain::Cpu, shard.order.size() * sizeof(Column), shard.order.size());
+			shard.columns.Clear();
+			shard.order.clear();
+		}
+	}
+
+	const Config& GetConfig() {
+		return g_Config;
+	}
+
+	static std::shared_ptr<const Column> ComputeColumn(int32_t cx, int32_t cz) {
+		TRACE_ZONE("Compute Column");
+		auto column = std::make_shared<Column>();
+		column->maxHeight = INT32_MIN;
+
+		float x[Noise::WIDTH], z[Noise::WIDTH];
+		float continents[Noise::WIDTH], hills[Noise::WIDTH], mountains[Noise::WIDTH], moisture[Noise::WIDTH];
+		for (int32_t lz = 0; lz < Chunk::SIZE; lz++) {
+			for (int32_t lx = 0; lx < Chunk::SIZE; lx += Noise::WIDTH) {
+				for (uint32_t i = 0; i < Noise::WIDTH; i++) {
+					x[i] = (float)(cx * Chunk::SIZE + lx + (int32_t)i);
+					z[i] = (float)(cz * Chunk::SIZE + lz);
+				}
+				Noise::Evaluate2D(g_Config.seed, CONTINENTS, x, z, continents);
+				Noise::Evaluate2D(g_Config.seed + 1, HILLS, x, z, hills);
+				Noise::Evaluate2D(g_Config.seed + 2, MOUNTAINS, x, z, mountains);
+				Noise::Evaluate2D(g_Config.seed + 3, MOISTURE, x, z, moisture);
+
+				for (uint32_t i = 0; i < Noise::WIDTH; i++) {
+					auto mountain = std::clamp((mountains[i] - 0.1f) * 2.5f, 0.0f, 1.0f);
+					auto height = (int32_t)std::floor((float)g_Config.seaLevel + continents[i] * 48.0f + hills[i] * (6.0f + 60.0f * mountain));
+					Biome biome = Biome::Plains;
+					if (height < g_Config.seaLevel)
+						biome = Biome::Ocean;
+					else if (mountain > 0.5f)
+						biome = Biome::Mountains;
+					else if (moisture[i] < -0.15f)
+						biome = Biome::Desert;
+
+					auto index = lx + (int32_t)i + lz * Chunk::SIZE;
+					column->height[index] = (int16_t)std::clamp(height, (int32_t)INT16_MIN, (int32_t)INT16_MAX);
+					column->biome[index] = biome;
+					column->maxHeight = std::max(column->maxHeight, (int32_t)column->height[index]);
+				}
+			}
+		}
+		return column;
+	}
+
+	/// <returns>The column with the given chunk coordinates, from the cache if possible</returns>
+	static std::shared_ptr<const Column> GetColumn(int32_t cx, int32_t cz) {
+		auto& shard = g_Shards[(cx & 3) | (cz & 3) << 2];
+		ivec3 key{ cx, 0, cz };
+		{
+			std::lock_guard lock{ shard.mutex };
+			if (auto* column = shard.columns.Find(key)) {
+				g_ColumnHits.fetch_add(1, std::memory_order_relaxed);
+				return *column;
+			}
+		}
+
+		// Computed without holding the lock. If two workers need the same column at once, both compute it and the first one is kept.
+		g_ColumnMisses.fetch_add(1, std::memory_order_relaxed);
+		auto computed = ComputeColumn(cx, cz);
+
+		std::lock_guard lock{ shard.mutex };
+		auto [column, inserted] = shard.columns.TryEmplace(key, std::move(computed));
+		if (inserted) {
+			shard.order.push_back(key);
+			Core::MemoryTracker::RecordAlloc(Core::MemoryTag::Chunks, Core::MemoryDomain::Cpu, sizeof(Column));
+			while (shard.order.size() > std::max(g_Config.columnCacheSize / NUM_SHARDS, 1u)) {
+				shard.columns.Erase(shard.order.front());
+				shard.order.pop_front();
+				Core::MemoryTracker::RecordFree(Core::MemoryTag::Chunks, Core::MemoryDomain::Cpu, sizeof(Column));
+			}
+			// Erasing may move entries in the map, so we look the column up again.
+			column = shard.columns.Find(key);
+		}
+		return *column;
+	}
+
+	void Generate(Chunk& chunk) {
+		TRACE_ZONE("Generate Terrain");
+		auto start = std::chrono::steady_clock::now();
+		auto pos = chunk.GetPosition();
+		auto column = GetColumn(pos.x, pos.z);
+
+		auto minY = pos.y * Chunk::SIZE;
+		auto* blocks = minY <= std::max(column->maxHeight, g_Config.seaLevel) ? chunk.GetOrCreateBlocks() : nullptr;
+		if (!blocks) {
+			// Entirely above the terrain and the sea, or the pool is exhausted.
+			g_EmptyChunks.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			float x[Noise::WIDTH], y[Noise::WIDTH], z[Noise::WIDTH], caves[Noise::WIDTH];
+			for (int32_t ly = 0; ly < Chunk::SIZE; ly++) {
+				auto wy = minY + ly;
+				for (int32_t lz = 0; lz < Chunk::SIZE; lz++) {
+					for (int32_t lx = 0; lx < Chunk::SIZE; lx += Noise::WIDTH) {
+						auto index = lx + lz * Chunk::SIZE;
+						const auto* height = &column->height[index];
+						const auto* biome = &column->biome[index];
+
+						// Cave noise is only needed if one of the blocks is below the surface.
+						if (wy < *std::max_element(height, height + Noise::WIDTH)) {
+							for (uint32_t i = 0; i < Noise::WIDTH; i++) {
+								x[i] = (float)(pos.x * Chunk::SIZE + lx + (int32_t)i);
+								// Caves are twice as wide as they are high.
+								y[i] = (float)wy * 2.0f;
+								z[i] = (float)(pos.z * Chunk::SIZE + lz);
+							}
+							Noise::Evaluate3D(g_Config.seed + 4, CAVES, x, y, z, caves);
+						}
+
+						auto* out = &blocks[Chunk::Index(lx, ly, lz)];
+						for (uint32_t i = 0; i < Noise::WIDTH; i++) {
+							auto h = (int32_t)height[i];
+							BlockId block;
+							if (wy > h)
+								block = wy <= g_Config.seaLevel ? WATER : AIR;
+							else if (wy < h && caves[i] > CAVE_THRESHOLD)
+								block = AIR;
+							else if (biome[i] == Biome::Mountains || wy < h - SOIL_DEPTH)
+								block = STONE;
+							else if (biome[i] == Biome::Desert || biome[i] == Biome::Ocean)
+								block = SAND;
+							else
+								block = wy == h ? GRASS : DIRT;
+							out[i] = block;
+						}
+					}
+				}
+			}
+		}
+
+		g_Chunks.fetch_add(1, std::memory_order_relaxed);
+		g_GenerateNs.fetch_add((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+	}
+
+	int32_t GetHeight(int32_t x, int32_t z) {
+		return GetColumn(x >> 4, z >> 4)->height[(x & (Chunk::SIZE - 1)) + (z & (Chunk::SIZE - 1)) * Chunk::SIZE];
+	}
+
+	Biome GetBiome(int32_t x, int32_t z) {
+		return GetColumn(x >> 4, z >> 4)->biome[(x & (Chunk::SIZE - 1)) + (z & (Chunk::SIZE - 1)) * Chunk::SIZE];
+	}
+
+	void RunBenchmark(uint32_t numChunks) {
+		TRACE_ZONE("Terrain Benchmark");
+		// Chunks from 96 blocks below to 96 blocks above the sea, which covers the terrain almost everywhere.
+		constexpr int32_t LAYERS = 12;
+		auto side = std::max((int32_t)std::ceil(std::sqrt((double)numChunks / LAYERS)), 1);
+		auto count = (uint32_t)(side * side * LAYERS);
+		auto baseY = g_Config.seaLevel / Chunk::SIZE - LAYERS / 2;
+
+		Log::Info("Generating {} chunks ({} x {} columns of {}) with {} noise", count, side, side, LAYERS, Noise::IMPLEMENTATION);
+		auto before = GetStats();
+		auto start = std::chrono::steady_clock::now();
+		// A job generates a whole column bottom to top, like streaming mostly does.
+		Core::JobSystem::ParallelFor(count, LAYERS, [side, baseY](uint32_t begin, uint32_t end) {
+			for (auto i = begin; i < end; i++) {
+				auto columnIndex = (int32_t)(i / LAYERS);
+				auto chunk = Chunk::Create(ivec3{ columnIndex % side, baseY + (int32_t)(i % LAYERS), columnIndex / side });
+				if (chunk)
+					Generate(*chunk);
+			}
+		});
+		auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		auto after = GetStats();
+		auto chunks = after.chunks - before.chunks;
+		auto coreSeconds = (double)(after.generateNs - before.generateNs) / 1e9;
+		Log::Info("Terrain benchmark: {} chunks ({} empty) in {:.1f} ms on {} threads, {:.0f} chunks/s, {:.0f} chunks/s per core, {:.1f} us per chunk",
+			chunks, after.emptyChunks - before.emptyChunks, seconds * 1e3, Core::JobSystem::GetWorkerCount() + 1,
+			(double)chunks / seconds, (double)chunks / coreSeconds, coreSeconds * 1e6 / (double)std::max<uint64_t>(chunks, 1));
+	}
+
+	Stats GetStats() {
+		return {
+			g_Chunks.load(std::memory_order_relaxed),
+			g_EmptyChunks.load(std::memory_order_relaxed),
+			g_GenerateNs.load(std::memory_order_relaxed),
+			g_ColumnHits.load(std::memory_order_relaxed),
+			g_ColumnMisses.load(std::memory_order_relaxed),
+		};
+	}
+
+	void PrintReport() {
+		auto s = GetStats();
+		if (s.chunks == 0)
+			return;
+		auto lookups = s.columnHits + s.columnMisses;
+		Log::Info("Terrain generator ({} noise, seed {}): {} chunks ({} empty), {:.0f} chunks/s per core, {:.1f} us per chunk, column cache hit rate {:.1f}%",
+			Noise::IMPLEMENTATION, g_Config.seed, s.chunks, s.emptyChunks, (double)s.chunks / ((double)s.generateNs / 1e9),
+			(double)s.generateNs / 1e3 / (double)s.chunks, lookups > 0 ? 100.0 * (double)s.columnHits / (double)lookups : 0.0);
+	}
+
+}
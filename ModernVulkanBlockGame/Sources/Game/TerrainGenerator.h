@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Chunk.h"
+
+namespace Game::TerrainGenerator {
+
+	/*
+	 * Generates the world from the seed alone, so the same chunk always gets the same blocks, regardless of the order
+	 * or the thread it is generated on.
+	 *
+	 * Everything that only depends on the horizontal position (terrain height and biome) is computed once per column of chunks
+	 * and cached, since the chunks stacked on top of each other are usually requested at about the same time.
+	 * Only caves need 3D noise per block, and only below the surface, chunks entirely above it are never allocated.
+	 * Generate() is called by the chunk streaming jobs, so chunks are generated on every worker thread in parallel.
+	 */
+
+	struct Config {
+		uint32_t seed = 1337;
+		/// <summary>
+		/// Terrain below this height is flooded with water.
+		/// </summary>
+		int32_t seaLevel = 0;
+		/// <summary>
+		/// Number of columns whose height and biome are kept.
+		/// </summary>
+		uint32_t columnCacheSize = 2048;
+	};
+
+	enum class Biome : uint8_t {
+		Ocean,
+		Plains,
+		Desert,
+		Mountains,
+	};
+
+	/// <summary>
+	/// Reads the configuration from the command line ("--seed").
+	/// </summary>
+	void Initialize();
+	/// <summary>
+	/// Drops the column cache.
+	/// </summary>
+	///	<remarks>No chunk may be generated anymore.</remarks>
+	void Terminate();
+
+	[[nodiscard]] const Config& GetConfig();
+
+	/// <summary>
+	/// Fills a chunk with terrain. Thread-safe.
+	/// </summary>
+	void Generate(Chunk& chunk);
+
+	/// <returns>The terrain height (the y coordinate of the topmost solid block) at a block column</returns>
+	[[nodiscard]] int32_t GetHeight(int32_t x, int32_t z);
+	[[nodiscard]] Biome GetBiome(int32_t x, int32_t z);
+
+	/// <summary>
+	/// Generates a square of columns, each 12 chunks high around the sea level, on every worker thread and logs the throughput.
+	/// The chunks are destroyed right after generating them.
+	/// </summary>
+	/// <param name="numChunks">Approximate number of chunks to generate</param>
+	void RunBenchmark(uint32_t numChunks);
+
+	struct Stats {
+		uint64_t chunks;
+		/// <summary>
+		/// Chunks that are entirely air and didn't need a block array.
+		/// </summary>
+		uint64_t emptyChunks;
+		/// <summary>
+		/// Time spent in Generate(), summed over every thread.
+		/// </summary>
+		uint64_t generateNs;
+		uint64_t columnHits;
+		uint64_t columnMisses;
+	};
+
+	[[nodiscard]] Stats GetStats();
+	/// <summary>
+	/// Prints the stats, including chunks per second per core, to the log.
+	/// </summary>
+	void PrintReport();
+
+}
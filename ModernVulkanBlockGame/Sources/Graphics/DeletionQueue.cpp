@@ -0,0 +1,65 @@
+#include "DeletionQueue.h"
+
+#include <deque>
+#include <mutex>
+
+namespace Graphics::DeletionQueue {
+
+	struct Entry {
+		/// <summary>
+		/// The last frame that may use the objects destroyed by deleter.
+		/// </summary>
+		uint64_t frame;
+		std::function<void()> deleter;
+	};
+
+	/// <summary>
+	/// Pending entries. Since the frame number only grows, the entries are sorted by frame.
+	/// </summary>
+	static std::deque<Entry> g_Entries;
+	static uint64_t g_CurrentFrame;
+	static std::mutex g_Mutex;
+
+	void Push(std::function<void()> deleter) {
+		std::lock_guard lock{ g_Mutex };
+		g_Entries.push_back({ g_CurrentFrame, std::move(deleter) });
+	}
+
+	void BeginFrame(uint64_t frame, uint64_t completedFrames) {
+		std::deque<Entry> finished;
+		{
+			std::lock_guard lock{ g_Mutex };
+			g_CurrentFrame = frame;
+			while (!g_Entries.empty() && g_Entries.front().frame < completedFrames) {
+				finished.push_back(std::move(g_Entries.front()));
+				g_Entries.pop_front();
+			}
+		}
+
+		// The deleters are called without holding the lock, so that they may push further entries.
+		for (auto& e : finished)
+			e.deleter();
+	}
+
+	void Flush() {
+		// Deleters may push further entries, so we repeat until the queue stays empty.
+		while (true) {
+			std::deque<Entry> entries;
+			{
+				std::lock_guard lock{ g_Mutex };
+				entries.swap(g_Entries);
+			}
+			if (entries.empty())
+				break;
+
+			for (auto& e : entries)
+				e.deleter();
+		}
+	}
+
+	size_t GetPendingCount() {
+		std::lock_guard lock{ g_Mutex };
+		return g_Entries.size();
+	}
+
+}
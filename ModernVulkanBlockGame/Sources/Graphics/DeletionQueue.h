@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace Graphics::DeletionQueue {
+
+	/*
+	 * Vulkan objects must not be destroyed while a frame that is still executing on the GPU uses them.
+	 * Instead of waiting for the whole device to become idle, objects that are no longer needed (e.g. the old swapchain after a resize)
+	 * are pushed into this queue, tagged with the number of the frame currently being recorded.
+	 * Once the Renderer knows that this frame has finished executing, the objects are destroyed.
+	 */
+
+	/// <summary>
+	/// Schedules a function destroying one or more objects, which is called once every frame that may use them has finished executing.
+	/// </summary>
+	/// <remarks>May be called from any thread.</remarks>
+	void Push(std::function<void()> deleter);
+
+	/// <summary>
+	/// Destroys every object whose frames have finished and starts tagging new entries with the given frame.
+	/// Called by the Renderer at the start of every frame.
+	/// </summary>
+	/// <param name="frame">Number of the frame that is about to be recorded</param>
+	/// <param name="completedFrames">Every frame with a number smaller than this has finished executing on the GPU</param>
+	void BeginFrame(uint64_t frame, uint64_t completedFrames);
+
+	/// <summary>
+	/// Destroys every object in the queue, regardless of its frame.
+	/// </summary>
+	///	<remarks>The GPU must be idle, e.g. after Manager::WaitIdle().</remarks>
+	void Flush();
+
+	/// <returns>The number of objects waiting to be destroyed</returns>
+	[[nodiscard]] size_t GetPendingCount();
+
+}
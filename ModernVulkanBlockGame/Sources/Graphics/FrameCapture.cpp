@@ -0,0 +1,248 @@
+#include "FrameCapture.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Manager.h"
+#include "Core/JobSystem.h"
+#include "Core/Png.h"
+#include "Core/Trace.h"
+#include "Logging/Log.h"
+
+namespace Graphics::FrameCapture {
+
+	enum class BufferState : uint8_t {
+		Free,
+		/// <summary>
+		/// A copy into the buffer was recorded, the frame may still be executing.
+		/// </summary>
+		InFlight,
+		/// <summary>
+		/// A worker thread is encoding and writing the contents.
+		/// </summary>
+		Writing,
+	};
+
+	struct ReadbackBuffer {
+		Manager::BufferInfo buffer;
+		void* mapped;
+		uint64_t size;
+		/// <summary>
+		/// Only changed by the render thread, except for Writing -> Free, which is done by the worker.
+		/// </summary>
+		std::atomic<BufferState> state;
+
+		// Describes the capture while InFlight or Writing.
+		uint64_t frame;
+		std::string path;
+		Format format;
+		vk::Format imageFormat;
+		vk::Extent2D extent;
+	};
+
+	static std::vector<std::unique_ptr<ReadbackBuffer>> g_Buffers;
+	/// <summary>
+	/// Counts the buffers being written by worker threads.
+	/// </summary>
+	static Core::JobSystem::Counter g_Writing;
+
+	/// <summary>
+	/// Protects the capture requests, which may be changed from any thread.
+	/// </summary>
+	static std::mutex g_RequestMutex;
+	static std::string g_ScreenshotPath;
+	static Format g_ScreenshotFormat;
+	static bool g_Recording;
+	static std::string g_RecordDirectory;
+	static Format g_RecordFormat;
+	static uint64_t g_RecordIndex;
+	static std::atomic<uint64_t> g_Dropped;
+
+	void Initialize(uint32_t bufferCount) {
+		g_Buffers.resize(bufferCount);
+		for (auto& b : g_Buffers) {
+			b = std::make_unique<ReadbackBuffer>();
+			b->state = BufferState::Free;
+		}
+	}
+
+	static void DestroyBuffer(ReadbackBuffer& b) {
+		if (!b.mapped)
+			return;
+		Manager::UnmapAllocation(b.buffer.allocation);
+		Manager::DestroyBuffer(b.buffer);
+		b.mapped = nullptr;
+		b.size = 0;
+	}
+
+	void Terminate() {
+		// Every frame has finished, so every pending capture can be written.
+		BeginFrame(UINT64_MAX);
+		Core::JobSystem::Wait(g_Writing);
+
+		for (auto& b : g_Buffers)
+			DestroyBuffer(*b);
+		g_Buffers.clear();
+
+		if (g_Dropped > 0)
+			Log::Warning("{} captured frames were skipped since no readback buffer was available", g_Dropped.load());
+	}
+
+	void RequestScreenshot(std::string path, Format format) {
+		std::lock_guard lock{ g_RequestMutex };
+		g_ScreenshotPath = std::move(path);
+		g_ScreenshotFormat = format;
+	}
+
+	void StartRecording(std::string directory, Format format) {
+		std::lock_guard lock{ g_RequestMutex };
+		g_Recording = true;
+		g_RecordDirectory = std::move(directory);
+		g_RecordFormat = format;
+		g_RecordIndex = 0;
+	}
+
+	void StopRecording() {
+		std::lock_guard lock{ g_RequestMutex };
+		g_Recording = false;
+	}
+
+	bool IsPending() {
+		std::lock_guard lock{ g_RequestMutex };
+		return !g_ScreenshotPath.empty() || g_Recording;
+	}
+
+	uint64_t GetDroppedCount() {
+		return g_Dropped.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// Encodes the contents of a buffer and writes them to its file. Runs on a worker thread.
+	/// </summary>
+	static void WriteCapture(ReadbackBuffer& b) {
+		TRACE_ZONE("Write Capture");
+
+		// The memory may not be host coherent, in which case the CPU caches could still hold old contents.
+		Manager::InvalidateAllocation(b.buffer.allocation);
+		const auto* pixels = (const uint8_t*)b.mapped;
+		auto numPixels = (size_t)b.extent.width * b.extent.height;
+
+		if (b.format == Format::Raw) {
+			if (auto file = fopen(b.path.c_str(), "wb")) {
+				fwrite(pixels, 4, numPixels, file);
+				fclose(file);
+			} else {
+				Log::Error("Failed to open {} for writing", b.path);
+			}
+		} else {
+			// PNG stores RGB, so BGRA images need to be swizzled. Alpha is dropped, as the backbuffer is always opaque.
+			bool bgra = b.imageFormat == vk::Format::eB8G8R8A8Srgb || b.imageFormat == vk::Format::eB8G8R8A8Unorm;
+			std::vector<uint8_t> rgb(numPixels * 3);
+			for (size_t i = 0; i < numPixels; i++) {
+				rgb[i * 3 + 0] = pixels[i * 4 + (bgra ? 2 : 0)];
+				rgb[i * 3 + 1] = pixels[i * 4 + 1];
+				rgb[i * 3 + 2] = pixels[i * 4 + (bgra ? 0 : 2)];
+			}
+			Core::Png::Write(b.path, b.extent.width, b.extent.height, 3, rgb.data());
+		}
+
+		b.state.store(BufferState::Free, std::memory_order_release);
+	}
+
+	void BeginFrame(uint64_t completedFrames) {
+		for (auto& b : g_Buffers) {
+			if (b->state.load(std::memory_order_relaxed) != BufferState::InFlight || b->frame >= completedFrames)
+				continue;
+
+			b->state.store(BufferState::Writing, std::memory_order_relaxed);
+			auto* buffer = b.get();
+			Core::JobSystem::Submit([buffer] { WriteCapture(*buffer); }, &g_Writing);
+		}
+	}
+
+	/// <returns>A buffer that is neither used by the GPU nor a worker thread, or nullptr</returns>
+	static ReadbackBuffer* FindFreeBuffer() {
+		for (auto& b : g_Buffers) {
+			if (b->state.load(std::memory_order_acquire) == BufferState::Free)
+				return b.get();
+		}
+		return nullptr;
+	}
+
+	void RecordCopy(vk::CommandBuffer cmd, vk::Image image, vk::Format format, vk::Extent2D extent, uint64_t frame) {
+		std::string path;
+		Format fileFormat;
+		{
+			std::lock_guard lock{ g_RequestMutex };
+			if (g_ScreenshotPath.empty() && !g_Recording)
+				return;
+
+			// Only formats with 4 bytes per pixel in RGBA or BGRA order can be encoded.
+			switch (format) {
+			case vk::Format::eB8G8R8A8Srgb:
+			case vk::Format::eB8G8R8A8Unorm:
+			case vk::Format::eR8G8B8A8Srgb:
+			case vk::Format::eR8G8B8A8Unorm:
+				break;
+			default:
+				Log::Error("Can't capture images with format {}", vk::to_string(format));
+				g_ScreenshotPath.clear();
+				g_Recording = false;
+				return;
+			}
+
+			if (!FindFreeBuffer()) {
+				// A screenshot stays requested and is taken as soon as a buffer is available, a recording skips the frame.
+				if (g_ScreenshotPath.empty())
+					g_Dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			if (!g_ScreenshotPath.empty()) {
+				path = std::move(g_ScreenshotPath);
+				fileFormat = g_ScreenshotFormat;
+				g_ScreenshotPath.clear();
+			} else {
+				fileFormat = g_RecordFormat;
+				path = Log::format("{}/frame_{:06}.{}", g_RecordDirectory, g_RecordIndex++, fileFormat == Format::Png ? "png" : "raw");
+			}
+		}
+
+		// Only the render thread takes buffers out of the ring, so the buffer found above is still free.
+		auto& b = *FindFreeBuffer();
+		auto size = (uint64_t)extent.width * extent.height * 4;
+		if (b.size < size) {
+			// The buffer is not in use by the GPU or a worker, so it can be replaced immediately.
+			DestroyBuffer(b);
+			b.buffer = Manager::CreateBuffer(size, vk::BufferUsageFlagBits::eTransferDst, Manager::BufferType::Readback, Core::MemoryTag::Capture);
+			b.mapped = Manager::MapAllocation(b.buffer.allocation);
+			b.size = size;
+		}
+
+		b.frame = frame;
+		b.path = std::move(path);
+		b.format = fileFormat;
+		b.imageFormat = format;
+		b.extent = extent;
+		b.state.store(BufferState::InFlight, std::memory_order_relaxed);
+
+		cmd.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, b.buffer.buffer, vk::BufferImageCopy{
+			0, 0, 0,
+			vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+			vk::Offset3D{ 0, 0, 0 },
+			vk::Extent3D{ extent.width, extent.height, 1 }
+		});
+
+		// Waiting for the fence alone does not make the copied data visible to the host, this barrier does.
+		vk::BufferMemoryBarrier barrier{
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead,
+			VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+			b.buffer.buffer, 0, VK_WHOLE_SIZE
+		};
+		cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, {}, barrier, {});
+	}
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Graphics::FrameCapture {
+
+	/*
+	 * Reading a rendered image back the naive way (copy, wait for the GPU, encode, write) stalls the render loop for tens of milliseconds.
+	 * Instead, a pass of the frame graph copies the image into one of a ring of host visible readback buffers.
+	 * Once the frame's fence has been waited on anyways, the buffer is handed to a worker thread, which encodes and writes it
+	 * and then returns the buffer to the ring. If every buffer is busy, the capture of that frame is skipped instead of waiting.
+	 */
+
+	enum class Format {
+		Png,
+		/// <summary>
+		/// The pixels exactly as the GPU stores them (e.g. BGRA, 8 bit per channel), rows from top to bottom without padding.
+		/// Cheapest to write, meant for recording every frame.
+		/// </summary>
+		Raw,
+	};
+
+	/// <summary>
+	/// Sets up the ring of readback buffers. The buffers themselves are allocated on first use.
+	/// </summary>
+	/// <param name="bufferCount">Should be larger than the number of frames in flight, so buffers are available while others are being written</param>
+	///	<remarks>Must be called after Manager::Initialize()</remarks>
+	void Initialize(uint32_t bufferCount);
+	/// <summary>
+	/// Writes every pending capture and destroys the readback buffers.
+	/// </summary>
+	///	<remarks>The GPU must be idle. Must be called before JobSystem::Terminate().</remarks>
+	void Terminate();
+
+	/// <summary>
+	/// Captures the next frame into the given file. If no readback buffer is available, the capture is retried the frame after.
+	/// </summary>
+	/// <remarks>May be called from any thread.</remarks>
+	void RequestScreenshot(std::string path, Format format = Format::Png);
+	/// <summary>
+	/// Captures every frame into the given directory, as frame_000000.png/.raw, frame_000001.png/.raw etc.
+	/// </summary>
+	/// <remarks>May be called from any thread.</remarks>
+	void StartRecording(std::string directory, Format format = Format::Raw);
+	void StopRecording();
+	/// <returns>True if a screenshot was requested but not taken yet, or a recording is running</returns>
+	[[nodiscard]] bool IsPending();
+	/// <returns>Number of recorded frames that were skipped since every readback buffer was busy</returns>
+	[[nodiscard]] uint64_t GetDroppedCount();
+
+	/// <summary>
+	/// Hands every readback buffer whose frame has finished executing to a worker thread.
+	/// Called by the Renderer at the start of every frame, after waiting for the frame's fence.
+	/// </summary>
+	/// <param name="completedFrames">Every frame with a number smaller than this has finished executing on the GPU</param>
+	void BeginFrame(uint64_t completedFrames);
+	/// <summary>
+	/// Records a copy of the image into a free readback buffer, if a capture was requested. Called by the capture pass of the frame graph.
+	/// </summary>
+	/// <param name="image">Must be in TransferSrcOptimal layout</param>
+	/// <param name="frame">Number of the frame being recorded</param>
+	void RecordCopy(vk::CommandBuffer cmd, vk::Image image, vk::Format format, vk::Extent2D extent, uint64_t frame);
+
+}
@@ -0,0 +1,93 @@
+#include "FramePacing.h"
+
+#include <algorithm>
+
+#include "Core/CommandLine.h"
+#include "Logging/Log.h"
+
+namespace Graphics::FramePacing {
+
+	/// <summary>
+	/// More frames in flight than this only add latency and memory, the GPU is busy long before.
+	/// </summary>
+	static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 8;
+
+	static Config g_Config = GetProfile(Profile::MaxThroughput);
+
+	Config GetProfile(Profile profile) {
+		switch (profile) {
+		case Profile::LowLatency:
+			return { profile, { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate }, 3, 1, 0.0, 1 };
+		case Profile::PowerSaving:
+			return { profile, { vk::PresentModeKHR::eFifo }, 2, 2, 0.0, 0 };
+		case Profile::MaxThroughput:
+		default:
+			return { profile, { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate }, 3, 3, 0.0, 0 };
+		}
+	}
+
+	static const char* ToString(Profile profile) {
+		switch (profile) {
+		case Profile::LowLatency: return "low-latency";
+		case Profile::PowerSaving: return "power-saving";
+		case Profile::MaxThroughput: return "max-throughput";
+		}
+		return "unknown";
+	}
+
+	void Initialize() {
+		auto profileName = Core::CommandLine::GetString("--pacing", "max-throughput");
+		auto profile = Profile::MaxThroughput;
+		if (profileName == "low-latency") {
+			profile = Profile::LowLatency;
+		} else if (profileName == "power-saving") {
+			profile = Profile::PowerSaving;
+		} else if (profileName != "max-throughput") {
+			Log::Warning("Unknown pacing profile {}, using max-throughput", profileName);
+		}
+		g_Config = GetProfile(profile);
+
+		auto presentMode = Core::CommandLine::GetString("--present-mode");
+		if (presentMode == "fifo") {
+			g_Config.presentModes = { vk::PresentModeKHR::eFifo };
+		} else if (presentMode == "fifo-relaxed") {
+			g_Config.presentModes = { vk::PresentModeKHR::eFifoRelaxed };
+		} else if (presentMode == "mailbox") {
+			g_Config.presentModes = { vk::PresentModeKHR::eMailbox };
+		} else if (presentMode == "immediate") {
+			g_Config.presentModes = { vk::PresentModeKHR::eImmediate };
+		} else if (!presentMode.empty()) {
+			Log::Warning("Unknown present mode {}", presentMode);
+		}
+
+		g_Config.swapchainImages = (uint32_t)std::max<int64_t>(Core::CommandLine::GetInt("--swapchain-images", g_Config.swapchainImages), 1);
+		g_Config.framesInFlight = (uint32_t)std::clamp<int64_t>(Core::CommandLine::GetInt("--frames-in-flight", g_Config.framesInFlight), 1, MAX_FRAMES_IN_FLIGHT);
+		g_Config.fpsLimit = (double)std::max<int64_t>(Core::CommandLine::GetInt("--fps-limit", (int64_t)g_Config.fpsLimit), 0);
+		g_Config.maxQueuedPresents = (uint32_t)std::max<int64_t>(Core::CommandLine::GetInt("--max-queued-presents", g_Config.maxQueuedPresents), 0);
+
+		Log::Info("Frame pacing: {} profile, {} swapchain images, {} frames in flight, fps limit {}, max queued presents {}",
+			ToString(g_Config.profile), g_Config.swapchainImages, g_Config.framesInFlight, g_Config.fpsLimit, g_Config.maxQueuedPresents);
+	}
+
+	const Config& GetConfig() {
+		return g_Config;
+	}
+
+	vk::PresentModeKHR ChoosePresentMode(std::span<const vk::PresentModeKHR> supported) {
+		for (auto mode : g_Config.presentModes) {
+			if (std::find(supported.begin(), supported.end(), mode) != supported.end())
+				return mode;
+		}
+		// FIFO must always be supported.
+		return vk::PresentModeKHR::eFifo;
+	}
+
+	uint32_t ChooseImageCount(const vk::SurfaceCapabilitiesKHR& caps) {
+		auto imageCount = std::max(g_Config.swapchainImages, caps.minImageCount);
+		// maxImageCount may be zero when there is no max image count, so we need an extra check.
+		if (caps.maxImageCount > 0)
+			imageCount = std::min(imageCount, caps.maxImageCount);
+		return imageCount;
+	}
+
+}
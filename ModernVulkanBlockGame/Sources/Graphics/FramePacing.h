@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Graphics::FramePacing {
+
+	/*
+	 * How frames are paced is a trade-off between latency, smoothness, throughput and power usage, e.g.:
+	 * - More frames in flight and swapchain images let the CPU and GPU work in parallel, but every queued frame adds latency.
+	 * - Mailbox and Immediate render as fast as possible, FIFO waits for vertical sync and saves power.
+	 * Instead of hard-coding one choice, a profile bundles the settings, and every setting can be overridden on the command line.
+	 */
+
+	enum class Profile {
+		/// <summary>
+		/// One frame in flight, and the CPU waits until the previous frame was displayed before sampling input (if VK_KHR_present_wait is supported).
+		/// </summary>
+		LowLatency,
+		/// <summary>
+		/// FIFO (vertical sync) with two swapchain images and two frames in flight.
+		/// </summary>
+		PowerSaving,
+		/// <summary>
+		/// Renders as fast as possible with three frames in flight.
+		/// </summary>
+		MaxThroughput,
+	};
+
+	struct Config {
+		Profile profile;
+		/// <summary>
+		/// Present modes in order of preference. FIFO is always supported, so it is used if none of them is.
+		/// </summary>
+		std::vector<vk::PresentModeKHR> presentModes;
+		/// <summary>
+		/// Requested number of swapchain images, clamped to what the surface supports.
+		/// </summary>
+		uint32_t swapchainImages;
+		/// <summary>
+		/// The maximum number of frames the CPU may be ahead of the GPU.
+		/// </summary>
+		uint32_t framesInFlight;
+		/// <summary>
+		/// Frames per second the render loop is limited to, 0 for no limit.
+		/// </summary>
+		double fpsLimit;
+		/// <summary>
+		/// Before sampling the input of a frame, wait until at most this many presented frames are still waiting to be displayed.
+		/// 0 disables waiting. Requires VK_KHR_present_wait.
+		/// </summary>
+		uint32_t maxQueuedPresents;
+	};
+
+	/// <returns>The default settings of a profile</returns>
+	[[nodiscard]] Config GetProfile(Profile profile);
+
+	/// <summary>
+	/// Chooses the profile given by "--pacing" and applies the overrides given on the command line.
+	/// </summary>
+	///	<remarks>Must be called before the Renderer and the Window are initialized.</remarks>
+	void Initialize();
+
+	[[nodiscard]] const Config& GetConfig();
+
+	/// <returns>The first of the configured present modes that is contained in supported, or FIFO</returns>
+	[[nodiscard]] vk::PresentModeKHR ChoosePresentMode(std::span<const vk::PresentModeKHR> supported);
+	/// <returns>The configured number of swapchain images, clamped to the surface capabilities</returns>
+	[[nodiscard]] uint32_t ChooseImageCount(const vk::SurfaceCapabilitiesKHR& caps);
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "Maths/Transform.h"
+
+namespace Graphics {
+
+	/// <summary>
+	/// Everything the Renderer needs to know about the simulation to render a frame.
+	/// Produced by the main thread, which handles input, and consumed by the render thread right before it records a frame.
+	/// </summary>
+	/// <remarks>Packets are copied into the slots of a Core::TripleBuffer, reusing the memory of their vectors.</remarks>
+	struct FramePacket {
+		/// <summary>
+		/// Incremented for every packet the main thread produces.
+		/// </summary>
+		uint64_t sequence;
+		/// <summary>
+		/// Simulation time in seconds the scene is rendered at.
+		/// </summary>
+		double time;
+		/// <summary>
+		/// Transforms of every entity after the previous and the latest simulation tick, see Game::Simulation.
+		/// </summary>
+		std::vector<Transform> previousTransforms;
+		std::vector<Transform> currentTransforms;
+		/// <summary>
+		/// How far time is between the two ticks, from 0 to 1. The Renderer interpolates the transforms by it.
+		/// </summary>
+		float alpha;
+		/// <summary>
+		/// When the input this packet is based on was polled, used to measure input latency.
+		/// </summary>
+		std::chrono::steady_clock::time_point inputTime;
+	};
+
+}
@@ -0,0 +1,278 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <array>
+
+#include "Manager.h"
+#include "Logging/Log.h"
+
+namespace Graphics::GpuProfiler {
+
+	/// <summary>
+	/// Maximum number of scopes per frame. Every scope uses two timestamp queries.
+	/// </summary>
+	static constexpr uint32_t MAX_SCOPES = 64;
+	/// <summary>
+	/// Number of frames the rolling statistics are computed over.
+	/// </summary>
+	static constexpr uint32_t HISTORY_SIZE = 256;
+	/// <summary>
+	/// Marks a scope that could not be recorded, e.g. since the profiler is not supported.
+	/// </summary>
+	static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+	/*
+	 * A pipeline statistics query writes one counter for every enabled statistic, ordered by their bit value.
+	 * We only count vertex and fragment shader invocations, which tell how much work the geometry causes (e.g. how much overdraw there is).
+	 */
+	static constexpr vk::QueryPipelineStatisticFlags STATISTICS =
+		vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations | vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+	static constexpr uint32_t NUM_STATISTICS = 2;
+
+	struct ScopeRecord {
+		std::string name;
+		/// <summary>
+		/// Index of the first of the two timestamp queries.
+		/// </summary>
+		uint32_t timestampQuery;
+		/// <summary>
+		/// Index of the pipeline statistics query or INVALID_SCOPE.
+		/// </summary>
+		uint32_t statisticsQuery;
+	};
+
+	/// <summary>
+	/// The queries of a single frame in flight.
+	/// </summary>
+	struct FrameQueries {
+		vk::QueryPool timestamps;
+		vk::QueryPool statistics;
+		std::vector<ScopeRecord> scopes;
+		uint32_t numStatistics;
+	};
+
+	struct Sample {
+		float ms;
+		uint64_t vertexInvocations;
+		uint64_t fragmentInvocations;
+	};
+
+	/// <summary>
+	/// Ring buffer of the last HISTORY_SIZE samples of a scope.
+	/// </summary>
+	struct History {
+		std::string name;
+		std::array<Sample, HISTORY_SIZE> samples;
+		uint32_t count;
+		uint32_t next;
+		bool hasStatistics;
+	};
+
+	static std::vector<FrameQueries> g_Frames;
+	static FrameQueries* g_CurrentFrame;
+	/// <summary>
+	/// Whether a scope counting pipeline statistics is currently open. Only one query of a type may be active at a time.
+	/// </summary>
+	static bool g_StatisticsActive;
+
+	static bool g_Enabled;
+	static bool g_StatisticsEnabled;
+	/// <summary>
+	/// Nanoseconds per timestamp tick.
+	/// </summary>
+	static double g_TimestampPeriod;
+	static uint64_t g_TimestampMask;
+
+	static std::vector<History> g_History;
+
+	void Initialize(uint32_t framesInFlight) {
+		const auto& physDev = Manager::GetPhysicalDevice();
+		const auto& dev = Manager::GetDevice();
+
+		// A queue family with zero valid timestamp bits does not support timestamps at all.
+		auto validBits = physDev.getQueueFamilyProperties()[Manager::GetGraphicsQueueFamily()].timestampValidBits;
+		g_Enabled = validBits > 0;
+		if (!g_Enabled) {
+			Log::Warning("Graphics queue does not support timestamps, GPU profiling is disabled");
+			return;
+		}
+		g_TimestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+		g_TimestampPeriod = physDev.getProperties().limits.timestampPeriod;
+		g_StatisticsEnabled = Manager::GetEnabledFeatures().pipelineStatisticsQuery;
+
+		g_Frames.resize(framesInFlight);
+		for (auto& f : g_Frames) {
+			f.timestamps = dev.createQueryPool({
+				{}, vk::QueryType::eTimestamp, MAX_SCOPES * 2
+			});
+			if (g_StatisticsEnabled) {
+				f.statistics = dev.createQueryPool({
+					{}, vk::QueryType::ePipelineStatistics, MAX_SCOPES, STATISTICS
+				});
+			}
+		}
+	}
+
+	void Terminate() {
+		const auto& dev = Manager::GetDevice();
+		for (const auto& f : g_Frames) {
+			dev.destroyQueryPool(f.timestamps);
+			if (f.statistics)
+				dev.destroyQueryPool(f.statistics);
+		}
+		g_Frames.clear();
+		g_CurrentFrame = nullptr;
+	}
+
+	/// <summary>
+	/// Adds a sample to the history of the scope with the given name.
+	/// </summary>
+	static void AddSample(const std::string& name, const Sample& sample, bool hasStatistics) {
+		auto it = std::find_if(g_History.begin(), g_History.end(), [&name](const History& h) { return h.name == name; });
+		if (it == g_History.end()) {
+			g_History.push_back({ name, {}, 0, 0, false });
+			it = g_History.end() - 1;
+		}
+
+		it->samples[it->next] = sample;
+		it->next = (it->next + 1) % HISTORY_SIZE;
+		it->count = std::min(it->count + 1, HISTORY_SIZE);
+		it->hasStatistics |= hasStatistics;
+	}
+
+	/// <summary>
+	/// Reads the results of the scopes the given frame recorded last time.
+	/// </summary>
+	static void ReadBack(FrameQueries& frame) {
+		if (frame.scopes.empty())
+			return;
+
+		const auto& dev = Manager::GetDevice();
+
+		std::array<uint64_t, MAX_SCOPES * 2> timestamps;
+		auto numTimestamps = (uint32_t)frame.scopes.size() * 2;
+		// The frame's fence has been waited on, so every result is available and we don't pass eWait.
+		auto res = dev.getQueryPoolResults(frame.timestamps, 0, numTimestamps,
+			numTimestamps * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+		if (res != vk::Result::eSuccess)
+			return;
+
+		std::array<uint64_t, MAX_SCOPES * NUM_STATISTICS> statistics{};
+		if (frame.numStatistics > 0) {
+			res = dev.getQueryPoolResults(frame.statistics, 0, frame.numStatistics,
+				frame.numStatistics * NUM_STATISTICS * sizeof(uint64_t), statistics.data(), NUM_STATISTICS * sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+			if (res != vk::Result::eSuccess)
+				statistics.fill(0);
+		}
+
+		for (const auto& s : frame.scopes) {
+			auto begin = timestamps[s.timestampQuery] & g_TimestampMask;
+			auto end = timestamps[s.timestampQuery + 1] & g_TimestampMask;
+			// Timestamps may wrap around if the queue has less than 64 valid bits.
+			auto ticks = (end - begin) & g_TimestampMask;
+
+			Sample sample{ (float)(ticks * g_TimestampPeriod / 1e6), 0, 0 };
+			bool hasStatistics = s.statisticsQuery != INVALID_SCOPE;
+			if (hasStatistics) {
+				sample.vertexInvocations = statistics[s.statisticsQuery * NUM_STATISTICS];
+				sample.fragmentInvocations = statistics[s.statisticsQuery * NUM_STATISTICS + 1];
+			}
+			AddSample(s.name, sample, hasStatistics);
+		}
+	}
+
+	void BeginFrame(vk::CommandBuffer cmd, uint32_t frameIndex) {
+		if (!g_Enabled)
+			return;
+
+		auto& frame = g_Frames[frameIndex];
+		ReadBack(frame);
+
+		frame.scopes.clear();
+		frame.numStatistics = 0;
+		g_CurrentFrame = &frame;
+
+		// Queries must be reset before they can be written again. This must happen outside of a RenderPass, so we do it at the start of the frame.
+		cmd.resetQueryPool(frame.timestamps, 0, MAX_SCOPES * 2);
+		if (frame.statistics)
+			cmd.resetQueryPool(frame.statistics, 0, MAX_SCOPES);
+	}
+
+	uint32_t BeginScope(vk::CommandBuffer cmd, std::string_view name, bool pipelineStatistics) {
+		if (!g_CurrentFrame || g_CurrentFrame->scopes.size() >= MAX_SCOPES)
+			return INVALID_SCOPE;
+
+		auto& frame = *g_CurrentFrame;
+		auto scope = (uint32_t)frame.scopes.size();
+
+		ScopeRecord record{ std::string{name}, scope * 2, INVALID_SCOPE };
+		// The top of pipe stage is reached as soon as the GPU starts processing the following commands.
+		cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.timestamps, record.timestampQuery);
+
+		if (pipelineStatistics && g_StatisticsEnabled && !g_StatisticsActive) {
+			record.statisticsQuery = frame.numStatistics++;
+			cmd.beginQuery(frame.statistics, record.statisticsQuery, {});
+			g_StatisticsActive = true;
+		}
+
+		frame.scopes.push_back(std::move(record));
+		return scope;
+	}
+
+	void EndScope(vk::CommandBuffer cmd, uint32_t scope) {
+		if (scope == INVALID_SCOPE || !g_CurrentFrame)
+			return;
+
+		const auto& record = g_CurrentFrame->scopes[scope];
+		if (record.statisticsQuery != INVALID_SCOPE) {
+			cmd.endQuery(g_CurrentFrame->statistics, record.statisticsQuery);
+			g_StatisticsActive = false;
+		}
+		// The bottom of pipe stage is reached once every previous command has finished executing.
+		cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, g_CurrentFrame->timestamps, record.timestampQuery + 1);
+	}
+
+	std::vector<ScopeStats> GetStats() {
+		std::vector<ScopeStats> res;
+		res.reserve(g_History.size());
+
+		for (const auto& h : g_History) {
+			std::vector<float> ms(h.count);
+			double sumMs = 0.0, sumVertices = 0.0, sumFragments = 0.0;
+			for (uint32_t i = 0; i < h.count; i++) {
+				ms[i] = h.samples[i].ms;
+				sumMs += h.samples[i].ms;
+				sumVertices += (double)h.samples[i].vertexInvocations;
+				sumFragments += (double)h.samples[i].fragmentInvocations;
+			}
+			std::sort(ms.begin(), ms.end());
+
+			auto percentile = [&ms](double p) {
+				return (double)ms[std::min((size_t)(p * ms.size()), ms.size() - 1)];
+			};
+			res.push_back({
+				h.name, h.count,
+				sumMs / h.count,
+				percentile(0.5), percentile(0.95), percentile(0.99), ms.back(),
+				h.hasStatistics ? sumVertices / h.count : 0.0,
+				h.hasStatistics ? sumFragments / h.count : 0.0,
+			});
+		}
+		return res;
+	}
+
+	void PrintReport() {
+		if (!g_Enabled)
+			return;
+
+		std::string report = Log::format("GPU timings over the last {} frames:", HISTORY_SIZE);
+		for (const auto& s : GetStats()) {
+			report += Log::format("\n    {:<20} avg {:>7.3f} ms, p50 {:>7.3f} ms, p95 {:>7.3f} ms, p99 {:>7.3f} ms, max {:>7.3f} ms",
+				s.name, s.avgMs, s.p50Ms, s.p95Ms, s.p99Ms, s.maxMs);
+			if (s.vertexInvocations > 0 || s.fragmentInvocations > 0)
+				report += Log::format(", {:.0f} vertex / {:.0f} fragment invocations", s.vertexInvocations, s.fragmentInvocations);
+		}
+		Log::Info("{}", report);
+	}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Graphics::GpuProfiler {
+
+	/*
+	 * The GPU executes a CommandBuffer long after it was recorded, so CPU timers can't tell how long the GPU spends on a pass.
+	 * Instead, we let the GPU itself write timestamps into a QueryPool at the start and end of every named scope.
+	 * Every frame in flight has its own QueryPools. Their results are read back when the frame's fence has been waited on,
+	 * i.e. framesInFlight frames later, at which point they are guaranteed to be available and reading them never stalls.
+	 */
+
+	/// <summary>
+	/// Creates the QueryPools for every frame in flight.
+	/// </summary>
+	///	<remarks>Must be called after Manager::Initialize()</remarks>
+	void Initialize(uint32_t framesInFlight);
+	void Terminate();
+
+	/// <summary>
+	/// Reads back the results of the last frame that used the given per-frame resources and resets its queries.
+	/// Must be recorded at the start of every frame, after the frame's fence was waited on.
+	/// </summary>
+	void BeginFrame(vk::CommandBuffer cmd, uint32_t frameIndex);
+
+	/// <summary>
+	/// Writes a timestamp marking the start of a named scope. Scopes may be nested.
+	/// </summary>
+	/// <param name="pipelineStatistics">Also count vertex and fragment shader invocations. Ignored if an enclosing scope already counts them.</param>
+	/// <returns>Handle for EndScope()</returns>
+	uint32_t BeginScope(vk::CommandBuffer cmd, std::string_view name, bool pipelineStatistics = false);
+	void EndScope(vk::CommandBuffer cmd, uint32_t scope);
+
+	/// <summary>
+	/// Measures the GPU time of every command recorded during its lifetime.
+	/// </summary>
+	class Scope {
+	public:
+		Scope(vk::CommandBuffer cmd, std::string_view name, bool pipelineStatistics = false)
+			: m_Cmd{cmd}, m_Scope{BeginScope(cmd, name, pipelineStatistics)}
+		{ }
+		~Scope() { EndScope(m_Cmd, m_Scope); }
+
+		Scope(const Scope&) = delete;
+		void operator=(const Scope&) = delete;
+
+	private:
+		vk::CommandBuffer m_Cmd;
+		uint32_t m_Scope;
+	};
+
+	/// <summary>
+	/// Statistics of a scope over the last frames.
+	/// </summary>
+	struct ScopeStats {
+		std::string name;
+		uint32_t samples;
+		double avgMs;
+		double p50Ms;
+		double p95Ms;
+		double p99Ms;
+		double maxMs;
+		/// <summary>
+		/// Average number of shader invocations per frame, 0 if the scope does not count pipeline statistics.
+		/// </summary>
+		double vertexInvocations;
+		double fragmentInvocations;
+	};
+
+	/// <returns>Rolling statistics of every scope that was recorded so far</returns>
+	[[nodiscard]] std::vector<ScopeStats> GetStats();
+	/// <summary>
+	/// Prints the statistics of every scope to the log.
+	/// </summary>
+	void PrintReport();
+
+}
@@ -1,6 +1,7 @@
 #include "Manager.h"
 
 #include <GLFW/glfw3.h>
+#include <memory>
 
 #include "Logging/Log.h"
 
@@ -21,6 +22,37 @@ namespace Graphics::Manager {
 
 	static VmaAllocator g_Allocator;
 
+	static bool g_Headless;
+	/// <summary>
+	/// Loads the Vulkan library in headless mode, where GLFW is not initialized and can't do that for us.
+	/// </summary>
+	static std::unique_ptr<vk::DynamicLoader> g_Loader;
+
+	/// <summary>
+	/// The optional Vulkan 1.0 features that are enabled on g_Device.
+	/// </summary>
+	static vk::PhysicalDeviceFeatures g_EnabledFeatures;
+	/// <summary>
+	/// Whether VK_KHR_present_id and VK_KHR_present_wait are enabled on g_Device.
+	/// </summary>
+	static bool g_PresentWaitSupported;
+	/// <summary>
+	/// Whether VK_EXT_surface_maintenance1 (and VK_KHR_get_surface_capabilities2, which it requires) are enabled on g_Instance.
+	/// </summary>
+	static bool g_SurfaceMaintenanceEnabled;
+	/// <summary>
+	/// Whether VK_EXT_swapchain_maintenance1 is enabled on g_Device, see IsSwapchainMaintenanceSupported().
+	/// </summary>
+	static bool g_SwapchainMaintenanceSupported;
+	/// <summary>
+	/// Whether VK_EXT_memory_budget is enabled on g_Device, which lets VMA query how much memory we may use.
+	/// </summary>
+	static bool g_MemoryBudgetSupported;
+	/// <summary>
+	/// Passed to vmaSetCurrentFrameIndex(), which makes VMA fetch the current budget.
+	/// </summary>
+	static uint32_t g_BudgetQueryIndex;
+
 	/// <summary>
 	/// Contains the device extensions that are absolutely required.
 	/// </summary>
@@ -28,6 +60,11 @@ namespace Graphics::Manager {
 		VK_KHR_SWAPCHAIN_EXTENSION_NAME
 	};
 
+	/// <returns>The device extensions that are absolutely required, none in headless mode since nothing is presented</returns>
+	static std::vector<const char*> GetRequiredDeviceExtensions() {
+		return g_Headless ? std::vector<const char*>{} : g_RequiredDeviceExtensions;
+	}
+
 	/// <summary>
 	/// Chooses a suitable Physical Device
 	/// </summary>
@@ -41,17 +78,30 @@ namespace Graphics::Manager {
 	/// <returns>Vector containing all instance extensions that should be enabled</returns>
 	static std::vector<const char*> ChooseInstanceExtensions();
 
-	bool Initialize() {
-		// We need to initialize GLFW here in order to call glfwGetRequiredInstanceExtensions.
-		if(glfwInit() != GLFW_TRUE) {
-			const char* msg;
-			glfwGetError(&msg);
-			Log::Error("Failed to initialize GLFW: {}", msg);
-			return false;
-		}
+	bool Initialize(bool headless) {
+		g_Headless = headless;
 
-		// This will load all functions needed for creating a vk::Instance.
-		VULKAN_HPP_DEFAULT_DISPATCHER.init(glfwGetInstanceProcAddress);
+		if (g_Headless) {
+			// Without a window, there is no need for GLFW, which would fail to initialize on a machine without a display anyways.
+			try {
+				g_Loader = std::make_unique<vk::DynamicLoader>();
+			} catch (const std::exception& e) {
+				Log::Error("Failed to load the Vulkan library: {}", e.what());
+				return false;
+			}
+			VULKAN_HPP_DEFAULT_DISPATCHER.init(g_Loader->getProcAddress<PFN_vkGetInstanceProcAddr>("vkGetInstanceProcAddr"));
+		} else {
+			// We need to initialize GLFW here in order to call glfwGetRequiredInstanceExtensions.
+			if(glfwInit() != GLFW_TRUE) {
+				const char* msg;
+				glfwGetError(&msg);
+				Log::Error("Failed to initialize GLFW: {}", msg);
+				return false;
+			}
+
+			// This will load all functions needed for creating a vk::Instance.
+			VULKAN_HPP_DEFAULT_DISPATCHER.init(glfwGetInstanceProcAddress);
+		}
 
 		// Choose the instance extensions we want to use.
 		auto exts = ChooseInstanceExtensions();
@@ -103,21 +153,78 @@ namespace Graphics::Manager {
 		 * This array contains an entry for every queue family we want to use. For an explanation of queue families, see IsPhysicalDeviceSuitable().
 		 * For every queue family, we specify how many of its queues we want to use and with which priority they should be scheduled.
 		 * I have never seen anyone use a priority different from 1.0f, as the impact of the priorities is pretty vaguely described in the spec.
+		 * A queue family may only be listed once, so without a dedicated transfer queue family, transfers share the graphics queue.
 		 */
-		std::array queueInfos {
+		std::vector queueInfos {
 			vk::DeviceQueueCreateInfo { {}, g_GraphicsQueueFamily, 1, &dummy },
-			vk::DeviceQueueCreateInfo { {}, g_TransferQueueFamily, 1, &dummy },
 		};
+		if (g_TransferQueueFamily != g_GraphicsQueueFamily)
+			queueInfos.push_back(vk::DeviceQueueCreateInfo { {}, g_TransferQueueFamily, 1, &dummy });
+		auto deviceExtensions = GetRequiredDeviceExtensions();
+		vk::PhysicalDeviceVulkan12Features vk12Features;
+		vk12Features.imagelessFramebuffer = true; // We want to use imageless framebuffers, so we need to enable that feature.
+
+		/*
+		 * VK_KHR_present_wait lets us wait until a present was actually displayed, which limits how many frames queue up in front of the display.
+		 * It is only used for frame pacing, so we enable it if available, but don't require it.
+		 */
+		vk::PhysicalDevicePresentIdFeaturesKHR presentIdFeatures;
+		vk::PhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures;
+		vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT swapchainMaintenanceFeatures;
+		g_PresentWaitSupported = false;
+		g_SwapchainMaintenanceSupported = false;
+		g_MemoryBudgetSupported = false;
+		bool hasPresentId = false, hasPresentWait = false, hasSwapchainMaintenance = false;
+		for (const auto& ext : g_PhysicalDevice.enumerateDeviceExtensionProperties()) {
+			hasPresentId |= strcmp(ext.extensionName, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0;
+			hasPresentWait |= strcmp(ext.extensionName, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0;
+			hasSwapchainMaintenance |= strcmp(ext.extensionName, VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME) == 0;
+			g_MemoryBudgetSupported |= strcmp(ext.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+		}
+		if (!g_Headless && hasPresentId && hasPresentWait) {
+			auto featureChain = g_PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDevicePresentIdFeaturesKHR, vk::PhysicalDevicePresentWaitFeaturesKHR>();
+			g_PresentWaitSupported = featureChain.get<vk::PhysicalDevicePresentIdFeaturesKHR>().presentId
+				&& featureChain.get<vk::PhysicalDevicePresentWaitFeaturesKHR>().presentWait;
+		}
+		if (g_PresentWaitSupported) {
+			deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+			presentIdFeatures.presentId = true;
+			presentWaitFeatures.presentWait = true;
+			presentIdFeatures.pNext = &presentWaitFeatures;
+			vk12Features.pNext = &presentIdFeatures;
+		}
+
+		/*
+		 * VK_EXT_swapchain_maintenance1 lets a present signal a fence once the presentation engine is done with it.
+		 * Only with it do we know when a retired swapchain may be destroyed, see Window::Recreate(). Without it, we fall back to a heuristic.
+		 */
+		if (!g_Headless && g_SurfaceMaintenanceEnabled && hasSwapchainMaintenance) {
+			auto featureChain = g_PhysicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>();
+			g_SwapchainMaintenanceSupported = featureChain.get<vk::PhysicalDeviceSwapchainMaintenance1FeaturesEXT>().swapchainMaintenance1;
+		}
+		if (g_SwapchainMaintenanceSupported) {
+			deviceExtensions.push_back(VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME);
+			swapchainMaintenanceFeatures.swapchainMaintenance1 = true;
+			swapchainMaintenanceFeatures.pNext = vk12Features.pNext;
+			vk12Features.pNext = &swapchainMaintenanceFeatures;
+		}
+		// Without the memory budget, VMA can only report what it allocated itself, not what the driver allows us to use.
+		if (g_MemoryBudgetSupported)
+			deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
 		vk::DeviceCreateInfo devInfo{
 			{},
 			queueInfos,
 			{},
-			g_RequiredDeviceExtensions
+			deviceExtensions
 		};
-		vk::PhysicalDeviceVulkan12Features vk12Features;
-		vk12Features.imagelessFramebuffer = true; // We want to use imageless framebuffers, so we need to enable that feature.
 		devInfo.pNext = &vk12Features;
 
+		// Pipeline statistics are only used for profiling, so we enable them if available, but don't require them.
+		g_EnabledFeatures.pipelineStatisticsQuery = g_PhysicalDevice.getFeatures().pipelineStatisticsQuery;
+		devInfo.pEnabledFeatures = &g_EnabledFeatures;
+
 		try {
 			g_Device = g_PhysicalDevice.createDevice(devInfo);
 		} catch(const vk::Error& e) {
@@ -137,6 +244,10 @@ namespace Graphics::Manager {
 		allocatorInfo.instance = g_Instance;
 		allocatorInfo.physicalDevice = g_PhysicalDevice;
 		allocatorInfo.device = g_Device;
+		// The memory budget is queried with vkGetPhysicalDeviceMemoryProperties2, which is core since Vulkan 1.1.
+		allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_2;
+		if (g_MemoryBudgetSupported)
+			allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 		auto err = vmaCreateAllocator(&allocatorInfo, &g_Allocator);
 		if(err != VK_SUCCESS) {
 			Log::Error("Failed to initialize Vulkan Memory Allocator");
@@ -151,6 +262,7 @@ namespace Graphics::Manager {
 
 		g_Device.destroy();
 		g_Instance.destroy();
+		g_Loader.reset();
 	}
 
 	vk::Instance GetInstance() {
@@ -169,11 +281,58 @@ namespace Graphics::Manager {
 		return g_GraphicsQueue;
 	}
 
+	uint32_t GetTransferQueueFamily() {
+		return g_TransferQueueFamily;
+	}
+
+	vk::Queue GetTransferQueue() {
+		return g_TransferQueue;
+	}
+
+	bool IsHeadless() {
+		return g_Headless;
+	}
+
+	bool IsPresentWaitSupported() {
+		return g_PresentWaitSupported;
+	}
+
+	bool IsSwapchainMaintenanceSupported() {
+		return g_SwapchainMaintenanceSupported;
+	}
+
 	vk::Device GetDevice() {
 		return g_Device;
 	}
 
-	BufferInfo CreateBuffer(uint64_t size, vk::BufferUsageFlags usage, BufferType type) {
+	const vk::PhysicalDeviceFeatures& GetEnabledFeatures() {
+		return g_EnabledFeatures;
+	}
+
+	/// <returns>Whether the memory of an allocation counts as VRAM or RAM</returns>
+	static Core::MemoryDomain GetDomain(const VmaAllocationInfo& info) {
+		const VkPhysicalDeviceMemoryProperties* props;
+		vmaGetMemoryProperties(g_Allocator, &props);
+		auto heap = props->memoryTypes[info.memoryType].heapIndex;
+		return (props->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? Core::MemoryDomain::Gpu : Core::MemoryDomain::Cpu;
+	}
+
+	static void TrackAllocation(const VmaAllocationInfo& info, Core::MemoryTag tag) {
+		Core::MemoryTracker::RecordAlloc(tag, GetDomain(info), info.size);
+	}
+
+	/// <summary>
+	/// Must be called before an allocation is freed. The tag is taken from the allocation's user data.
+	/// </summary>
+	static void UntrackAllocation(VmaAllocation alloc) {
+		if (!alloc)
+			return;
+		VmaAllocationInfo info;
+		vmaGetAllocationInfo(g_Allocator, alloc, &info);
+		Core::MemoryTracker::RecordFree((Core::MemoryTag)(uintptr_t)info.pUserData, GetDomain(info), info.size);
+	}
+
+	BufferInfo CreateBuffer(uint64_t size, vk::BufferUsageFlags usage, BufferType type, Core::MemoryTag tag) {
 		vk::BufferCreateInfo bufferInfo{
 			{}, size,
 			usage,
@@ -183,19 +342,64 @@ namespace Graphics::Manager {
 		switch (type) {
 		case BufferType::Gpu: allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY; break;
 		case BufferType::Staging: allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY; break;
+		case BufferType::Readback: allocInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU; break;
 		}
+		allocInfo.pUserData = (void*)(uintptr_t)tag;
 
 		VkBuffer buffer;
 		VmaAllocation alloc;
-		vmaCreateBuffer(g_Allocator, &static_cast<VkBufferCreateInfo&>(bufferInfo), &allocInfo, &buffer, &alloc, nullptr);
+		VmaAllocationInfo info;
+		vmaCreateBuffer(g_Allocator, &static_cast<VkBufferCreateInfo&>(bufferInfo), &allocInfo, &buffer, &alloc, &info);
+		TrackAllocation(info, tag);
 
 		return { alloc, buffer };
 	}
 
 	void DestroyBuffer(const BufferInfo& info) {
+		UntrackAllocation(info.allocation);
 		vmaDestroyBuffer(g_Allocator, info.buffer, info.allocation);
 	}
 
+	ImageInfo CreateImage(const vk::ImageCreateInfo& info, Core::MemoryTag tag) {
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+		allocInfo.pUserData = (void*)(uintptr_t)tag;
+
+		VkImage image;
+		VmaAllocation alloc;
+		VmaAllocationInfo allocationInfo;
+		vmaCreateImage(g_Allocator, &static_cast<const VkImageCreateInfo&>(info), &allocInfo, &image, &alloc, &allocationInfo);
+		TrackAllocation(allocationInfo, tag);
+
+		return { alloc, image };
+	}
+
+	void DestroyImage(const ImageInfo& info) {
+		UntrackAllocation(info.allocation);
+		vmaDestroyImage(g_Allocator, info.image, info.allocation);
+	}
+
+	VmaAllocation AllocateMemory(const vk::MemoryRequirements& requirements, Core::MemoryTag tag) {
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+		allocInfo.pUserData = (void*)(uintptr_t)tag;
+
+		VmaAllocation alloc;
+		VmaAllocationInfo info;
+		vmaAllocateMemory(g_Allocator, &static_cast<const VkMemoryRequirements&>(requirements), &allocInfo, &alloc, &info);
+		TrackAllocation(info, tag);
+		return alloc;
+	}
+
+	void BindImageMemory(const VmaAllocation& alloc, vk::Image image) {
+		vmaBindImageMemory(g_Allocator, alloc, image);
+	}
+
+	void FreeMemory(const VmaAllocation& alloc) {
+		UntrackAllocation(alloc);
+		vmaFreeMemory(g_Allocator, alloc);
+	}
+
 	void* MapAllocation(const VmaAllocation& alloc) {
 		void* res;
 		vmaMapMemory(g_Allocator, alloc, &res);
@@ -204,12 +408,50 @@ namespace Graphics::Manager {
 	void UnmapAllocation(const VmaAllocation& alloc) {
 		vmaUnmapMemory(g_Allocator, alloc);
 	}
+	void InvalidateAllocation(const VmaAllocation& alloc) {
+		vmaInvalidateAllocation(g_Allocator, alloc, 0, VK_WHOLE_SIZE);
+	}
+
+	std::vector<HeapBudget> GetMemoryBudgets() {
+		// VMA only fetches the budget from the driver when the frame index changes (or after many allocations).
+		vmaSetCurrentFrameIndex(g_Allocator, ++g_BudgetQueryIndex);
+
+		const VkPhysicalDeviceMemoryProperties* props;
+		vmaGetMemoryProperties(g_Allocator, &props);
+		std::vector<VmaBudget> budgets(props->memoryHeapCount);
+		vmaGetHeapBudgets(g_Allocator, budgets.data());
+
+		std::vector<HeapBudget> res;
+		res.reserve(budgets.size());
+		for (uint32_t i = 0; i < props->memoryHeapCount; i++) {
+			res.push_back({
+				(props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+				budgets[i].usage, budgets[i].budget,
+			});
+		}
+		return res;
+	}
+
+	void PrintMemoryBudgets() {
+		std::string report = Log::format("Memory heaps{}:", g_MemoryBudgetSupported ? "" : " (estimated, VK_EXT_memory_budget is not supported)");
+		auto budgets = GetMemoryBudgets();
+		for (size_t i = 0; i < budgets.size(); i++) {
+			const auto& b = budgets[i];
+			report += Log::format("\n    Heap {} ({}): {:.1f} of {:.1f} MiB used", i, b.deviceLocal ? "device local" : "host",
+				b.usage / (1024.0 * 1024.0), b.budget / (1024.0 * 1024.0));
+		}
+		Log::Info("{}", report);
+	}
 
 	void WaitIdle() {
 		g_Device.waitIdle();
 	}
 
 	static std::vector<const char*> ChooseInstanceExtensions() {
+		// Without a window there is no surface, so we don't need any extension.
+		if (g_Headless)
+			return {};
+
 		// First, query all extensions required by GLFW.
 		uint32_t numGlfwExts;
 		auto glfwExts = glfwGetRequiredInstanceExtensions(&numGlfwExts);
@@ -222,12 +464,22 @@ namespace Graphics::Manager {
 
 		// retrieve information about all the extensions our instance supports.
 		auto props = vk::enumerateInstanceExtensionProperties();
+		bool hasSurfaceCaps2 = false, hasSurfaceMaintenance = false;
 		for(const auto& p : props) {
 			// If the swapchain_color_space extension is supported, we want to enable it.
 			if(strcmp(p.extensionName, VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME) == 0) {
 				exts.push_back(VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME);
 				Log::Info("Instance supports HDR");
 			}
+			hasSurfaceCaps2 |= strcmp(p.extensionName, VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME) == 0;
+			hasSurfaceMaintenance |= strcmp(p.extensionName, VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME) == 0;
+		}
+
+		// The device extension VK_EXT_swapchain_maintenance1 requires these, see Initialize().
+		g_SurfaceMaintenanceEnabled = hasSurfaceCaps2 && hasSurfaceMaintenance;
+		if (g_SurfaceMaintenanceEnabled) {
+			exts.push_back(VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME);
+			exts.push_back(VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME);
 		}
 
 		return exts;
@@ -242,18 +494,13 @@ namespace Graphics::Manager {
 		if (props.apiVersion < VK_API_VERSION_1_2)
 			return false;
 
-		// Device must be a discrete GPU. Just a simple hack to not use my integrated GPU as it sucks.
-		// Normally, a user should be able to select from a list of suitable GPUs.
-		if (props.deviceType != vk::PhysicalDeviceType::eDiscreteGpu)
-			return false;
-
 		// Device must support imageless framebuffers. Any GPU I know of supports this.
 		if (!vk12Features.imagelessFramebuffer)
 			return false;
 
 		// Device must support every extension contained in g_RequiredDeviceExtensions.
 		auto extensions = physDev.enumerateDeviceExtensionProperties();
-		for(auto reqExt : g_RequiredDeviceExtensions) {
+		for(auto reqExt : GetRequiredDeviceExtensions()) {
 			bool found = false;
 			for(const auto& ext : extensions) {
 				if(strcmp(ext.extensionName, reqExt) == 0) {
@@ -277,7 +524,8 @@ namespace Graphics::Manager {
 		 *
 		 * Below we search for a queue family that supports graphics commands as well as presenting images to a swapchain. This will be called our graphics queue.
 		 * Additionally, we search for a queue that only supports transfer commands (e.g. buffer copy commands), since such a queue is very good for background loading
-		 * on desktop hardware.
+		 * on desktop hardware. Integrated GPUs and CPU implementations often don't have one, in which case transfers use the graphics queue.
+		 * In headless mode nothing is presented, so the graphics queue doesn't need to support presenting.
 		 */
 		
 		auto qFamilies = physDev.getQueueFamilyProperties();
@@ -288,7 +536,7 @@ namespace Graphics::Manager {
 			const auto& qf = qFamilies[i];
 
 			// If a queue family supports Graphics and presenting images to swapchains, we can use it as our graphics queue.
-			if(gfxQueueFamily == -1 && qf.queueFlags & vk::QueueFlagBits::eGraphics && glfwGetPhysicalDevicePresentationSupport(g_Instance, physDev, i)) {
+			if(gfxQueueFamily == -1 && qf.queueFlags & vk::QueueFlagBits::eGraphics && (g_Headless || glfwGetPhysicalDevicePresentationSupport(g_Instance, physDev, i))) {
 				gfxQueueFamily = i;
 				continue;
 			}
@@ -300,9 +548,11 @@ namespace Graphics::Manager {
 			}
 		}
 
-		// If we haven't found a graphics or transfer queue, this device is not suitable.
-		if (gfxQueueFamily == -1 || transferQueueFamily == -1)
+		// If we haven't found a graphics queue, this device is not suitable.
+		if (gfxQueueFamily == -1)
 			return false;
+		if (transferQueueFamily == -1)
+			transferQueueFamily = gfxQueueFamily;
 
 		outGfxQf = gfxQueueFamily;
 		outTransferQf = transferQueueFamily;
@@ -310,15 +560,42 @@ namespace Graphics::Manager {
 		return true;
 	}
 
+	/// <returns>How much we prefer a type of device, higher is better</returns>
+	static int RankDeviceType(vk::PhysicalDeviceType type) {
+		switch (type) {
+		case vk::PhysicalDeviceType::eDiscreteGpu: return 4;
+		case vk::PhysicalDeviceType::eIntegratedGpu: return 3;
+		case vk::PhysicalDeviceType::eVirtualGpu: return 2;
+		case vk::PhysicalDeviceType::eCpu: return 1;
+		default: return 0;
+		}
+	}
+
 	static vk::PhysicalDevice ChoosePhysicalDevice(uint32_t& outGfxQf, uint32_t& outTransferQf) {
+		/*
+		 * We prefer discrete GPUs, as integrated GPUs are usually a lot slower. Normally, a user should be able to select from a list of suitable GPUs.
+		 * Other devices are still accepted, so the game runs e.g. on laptops and on build machines without a GPU, using a CPU implementation like lavapipe.
+		 */
+		vk::PhysicalDevice best = nullptr;
+		int bestRank = -1;
+
 		// retrieve information about every physical device our instance knows of.
 		auto devs = g_Instance.enumeratePhysicalDevices();
 		for(const auto& dev : devs) {
-			if (IsPhysicalDeviceSuitable(dev, outGfxQf, outTransferQf))
-				return dev;
+			uint32_t gfxQf, transferQf;
+			if (!IsPhysicalDeviceSuitable(dev, gfxQf, transferQf))
+				continue;
+
+			auto rank = RankDeviceType(dev.getProperties().deviceType);
+			if (rank > bestRank) {
+				best = dev;
+				bestRank = rank;
+				outGfxQf = gfxQf;
+				outTransferQf = transferQf;
+			}
 		}
 
-		return nullptr;
+		return best;
 	}
 
 }
@@ -1,15 +1,23 @@
 #pragma once
 
+#include <vector>
+
 #include <vulkan/vulkan.hpp>
 #include <vk_mem_alloc.h>
 
+#include "Core/MemoryTracker.h"
+
 namespace Graphics::Manager {
 
 	/// <summary>
 	/// Initializes the basic Graphics system.
 	/// </summary>
+	/// <param name="headless">
+	/// Don't initialize GLFW and don't require presentation support, so rendering works on machines without a display.
+	/// Also accepts integrated GPUs and CPU implementations (e.g. lavapipe).
+	/// </param>
 	///	<remarks>Must be called before creating a window.</remarks>
-	bool Initialize();
+	bool Initialize(bool headless = false);
 
 	/// <summary>
 	/// Deinitializes the basic Graphics system.
@@ -27,9 +35,29 @@ namespace Graphics::Manager {
 	[[nodiscard]] uint32_t GetGraphicsQueueFamily();
 	[[nodiscard]] vk::Queue GetGraphicsQueue();
 
+	/// <returns>The Queue Family Index of the Transfer Queue, which is the graphics queue family if the device has no dedicated transfer queue</returns>
+	[[nodiscard]] uint32_t GetTransferQueueFamily();
+	[[nodiscard]] vk::Queue GetTransferQueue();
+
+	/// <returns>True if Initialize() was called in headless mode</returns>
+	[[nodiscard]] bool IsHeadless();
+	/// <returns>True if VK_KHR_present_id and VK_KHR_present_wait are enabled</returns>
+	[[nodiscard]] bool IsPresentWaitSupported();
+	/// <returns>True if VK_EXT_swapchain_maintenance1 is enabled, which allows presents to signal a fence</returns>
+	[[nodiscard]] bool IsSwapchainMaintenanceSupported();
+
 	/// <returns>The Vulkan Device in use</returns>
 	[[nodiscard]] vk::Device GetDevice();
 
+	/// <returns>The optional device features that were enabled, e.g. pipelineStatisticsQuery</returns>
+	[[nodiscard]] const vk::PhysicalDeviceFeatures& GetEnabledFeatures();
+
+	/*
+	 * Every allocation stores its MemoryTag as VMA user data, so it is attributed to the same subsystem when it is freed.
+	 * Allocations in device local heaps count as VRAM, all others (e.g. staging buffers) as RAM.
+	 */
+
+
 	struct BufferInfo {
 		VmaAllocation allocation;
 		vk::Buffer buffer;
@@ -37,15 +65,58 @@ namespace Graphics::Manager {
 	enum class BufferType {
 		Gpu,
 		Staging,
+		/// <summary>
+		/// Host visible memory the GPU writes to and the CPU reads from, preferably cached.
+		/// </summary>
+		Readback,
 	};
-	[[nodiscard]] BufferInfo CreateBuffer(uint64_t size, vk::BufferUsageFlags usage, BufferType type);
+	[[nodiscard]] BufferInfo CreateBuffer(uint64_t size, vk::BufferUsageFlags usage, BufferType type, Core::MemoryTag tag = Core::MemoryTag::General);
 	void DestroyBuffer(const BufferInfo& info);
 
+	struct ImageInfo {
+		VmaAllocation allocation;
+		vk::Image image;
+	};
+	/// <summary>
+	/// Creates an Image in device local memory, e.g. for use as depth buffer.
+	/// </summary>
+	[[nodiscard]] ImageInfo CreateImage(const vk::ImageCreateInfo& info, Core::MemoryTag tag = Core::MemoryTag::General);
+	void DestroyImage(const ImageInfo& info);
+
+	/// <summary>
+	/// Allocates device local memory that is not bound to any resource yet. Used to let several resources share the same memory.
+	/// </summary>
+	[[nodiscard]] VmaAllocation AllocateMemory(const vk::MemoryRequirements& requirements, Core::MemoryTag tag = Core::MemoryTag::General);
+	void BindImageMemory(const VmaAllocation& alloc, vk::Image image);
+	void FreeMemory(const VmaAllocation& alloc);
+
 	void* MapAllocation(const VmaAllocation& alloc);
 	void UnmapAllocation(const VmaAllocation& alloc);
+	/// <summary>
+	/// Makes writes of the GPU visible to the CPU. Required before reading mapped memory that may not be host coherent.
+	/// </summary>
+	void InvalidateAllocation(const VmaAllocation& alloc);
+
+	struct HeapBudget {
+		bool deviceLocal;
+		/// <summary>
+		/// Bytes the whole process uses in the heap, including memory not allocated through VMA.
+		/// </summary>
+		uint64_t usage;
+		/// <summary>
+		/// Bytes the process can use before allocations may fail or the system starts swapping, e.g. since other applications need VRAM as well.
+		/// </summary>
+		uint64_t budget;
+	};
+	/// <returns>The usage and budget of every memory heap. Estimated from the allocations of VMA if VK_EXT_memory_budget is not supported.</returns>
+	[[nodiscard]] std::vector<HeapBudget> GetMemoryBudgets();
+	/// <summary>
+	/// Prints the usage and budget of every memory heap to the log.
+	/// </summary>
+	void PrintMemoryBudgets();
 
 	/// <summary>
-	/// Blocks until the Vulkan Device is idling, must be called before destroying e.g. a swapchain.
+	/// Blocks until the Vulkan Device is idling. Only needed on shutdown, objects that are destroyed while rendering go through the DeletionQueue.
 	/// </summary>
 	void WaitIdle();
 
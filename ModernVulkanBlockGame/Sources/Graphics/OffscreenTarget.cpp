@@ -0,0 +1,93 @@
+#include "OffscreenTarget.h"
+
+namespace Graphics {
+
+	OffscreenTarget::OffscreenTarget()
+		: m_Extent{}, m_Format{vk::Format::eUndefined}, m_NextImage{0}
+	{ }
+
+	OffscreenTarget::OffscreenTarget(vk::Extent2D extent, vk::Format format, uint32_t imageCount)
+		: m_Extent{extent}, m_Format{format}, m_NextImage{0}
+	{
+		const auto& dev = Manager::GetDevice();
+
+		// The images can be copied from, e.g. to compare them against reference images.
+		vk::ImageCreateInfo imageInfo{
+			{}, vk::ImageType::e2D, m_Format,
+			vk::Extent3D{ m_Extent.width, m_Extent.height, 1 },
+			1, 1, vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+			vk::SharingMode::eExclusive, {},
+			vk::ImageLayout::eUndefined
+		};
+		vk::ImageViewCreateInfo viewInfo{
+			{}, nullptr, vk::ImageViewType::e2D,
+			m_Format, {},
+			vk::ImageSubresourceRange {
+				vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1
+			}
+		};
+
+		m_Allocations.reserve(imageCount);
+		m_Images.reserve(imageCount);
+		m_ImageViews.reserve(imageCount);
+		for (uint32_t i = 0; i < imageCount; i++) {
+			auto img = Manager::CreateImage(imageInfo, Core::MemoryTag::RenderTargets);
+			m_Allocations.push_back(img);
+			m_Images.push_back(img.image);
+
+			viewInfo.image = img.image;
+			m_ImageViews.push_back(dev.createImageView(viewInfo));
+		}
+	}
+
+	OffscreenTarget::OffscreenTarget(OffscreenTarget&& r) noexcept
+		: m_Extent{r.m_Extent},
+		  m_Format{r.m_Format},
+		  m_Allocations{std::move(r.m_Allocations)},
+		  m_Images{std::move(r.m_Images)},
+		  m_ImageViews{std::move(r.m_ImageViews)},
+		  m_NextImage{r.m_NextImage}
+	{
+		r.m_Allocations.clear();
+		r.m_Images.clear();
+		r.m_ImageViews.clear();
+	}
+
+	OffscreenTarget& OffscreenTarget::operator=(OffscreenTarget&& r) noexcept {
+		std::swap(m_Allocations, r.m_Allocations);
+		std::swap(m_Images, r.m_Images);
+		std::swap(m_ImageViews, r.m_ImageViews);
+		m_Extent = r.m_Extent;
+		m_Format = r.m_Format;
+		m_NextImage = r.m_NextImage;
+		return *this;
+	}
+
+	OffscreenTarget::~OffscreenTarget() {
+		Destroy();
+	}
+
+	void OffscreenTarget::Destroy() {
+		for (const auto& v : m_ImageViews)
+			Manager::GetDevice().destroyImageView(v);
+		for (const auto& a : m_Allocations)
+			Manager::DestroyImage(a);
+
+		m_ImageViews.clear();
+		m_Images.clear();
+		m_Allocations.clear();
+	}
+
+	std::optional<uint32_t> OffscreenTarget::Acquire(vk::Semaphore) {
+		// There is no presentation engine holding on to images, so the next image is always ready.
+		auto image = m_NextImage;
+		m_NextImage = (m_NextImage + 1) % (uint32_t)m_Images.size();
+		return image;
+	}
+
+	bool OffscreenTarget::Present(uint32_t, vk::Semaphore) {
+		return true;
+	}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Manager.h"
+#include "RenderTarget.h"
+
+namespace Graphics {
+
+	/// <summary>
+	/// Images in device memory that frames are rendered to without a window, e.g. for benchmarks and tests on machines without a display.
+	/// </summary>
+	class OffscreenTarget : public RenderTarget {
+	public:
+		/// <summary>
+		/// Creates an empty object that does not own any images.
+		/// </summary>
+		OffscreenTarget();
+
+		/// <summary>
+		/// Creates the images. They are used round-robin, so an image is only rendered to again after imageCount frames.
+		/// </summary>
+		/// <param name="imageCount">Should be at least the number of frames in flight, otherwise a frame could render to an image that is still in use</param>
+		OffscreenTarget(vk::Extent2D extent, vk::Format format, uint32_t imageCount);
+
+		OffscreenTarget(const OffscreenTarget&) = delete;
+		void operator=(const OffscreenTarget&) = delete;
+
+		OffscreenTarget(OffscreenTarget&& r) noexcept;
+		OffscreenTarget& operator=(OffscreenTarget&& r) noexcept;
+
+		~OffscreenTarget() override;
+		/// <summary>
+		/// Destroys the images, if any.
+		/// </summary>
+		void Destroy();
+
+		[[nodiscard]] std::optional<uint32_t> Acquire(vk::Semaphore imageReady) override;
+		bool Present(uint32_t image, vk::Semaphore renderFinished) override;
+		/// <summary>
+		/// Does nothing, offscreen images never go out of date.
+		/// </summary>
+		void Recreate() override { }
+
+		[[nodiscard]] bool UsesSemaphores() const override { return false; }
+		[[nodiscard]] vk::Format GetFormat() const override { return m_Format; }
+		[[nodiscard]] vk::Extent2D GetExtent() const override { return m_Extent; }
+		[[nodiscard]] const std::vector<vk::Image>& GetImages() const override { return m_Images; }
+		[[nodiscard]] const std::vector<vk::ImageView>& GetImageViews() const override { return m_ImageViews; }
+
+	private:
+		vk::Extent2D m_Extent;
+		vk::Format m_Format;
+		std::vector<Manager::ImageInfo> m_Allocations;
+		std::vector<vk::Image> m_Images;
+		std::vector<vk::ImageView> m_ImageViews;
+		uint32_t m_NextImage;
+	};
+
+}
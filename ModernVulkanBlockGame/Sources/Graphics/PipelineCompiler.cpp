@@ -2,27 +2,32 @@
 
 #include "Manager.h"
 #include "Vertex.h"
+#include "Core/IoService.h"
+#include "Logging/Log.h"
 
-#include <filesystem>
-#include <fstream>
+#include <mutex>
+#include <unordered_map>
 
 namespace Graphics::PipelineCompiler {
 
+    /// <summary>
+    /// SPIR-V code loaded by Preload(), indexed by file path.
+    /// </summary>
+    static std::unordered_map<std::string, std::vector<char>> g_CodeCache;
+    static std::mutex g_CodeCacheMutex;
+
     /// <summary>
     /// Read all bytes in a file
     /// </summary>
     /// <param name="path">Path to the file</param>
-    /// <returns>std::vector<char> containing all bytes in the file</returns>
+    /// <returns>std::vector<char> containing all bytes in the file, empty if it could not be read</returns>
     static std::vector<char> ReadFile(const std::string& path) {
-        auto size = std::filesystem::file_size(path);
-
+        // Read through the I/O service, so the worker loading shaders runs other jobs instead of waiting for the disk.
         std::vector<char> buffer;
-        buffer.resize(size);
-
-        std::ifstream in{path, std::ifstream::in | std::ifstream::binary};
-        in.read(buffer.data(), size);
-        in.close();
-
+        if (!Core::IoService::ReadFile(path, buffer)) {
+            Log::Error("Failed to read {}", path);
+            buffer.clear();
+        }
         return buffer;
     }
 
@@ -32,24 +37,46 @@ namespace Graphics::PipelineCompiler {
     /// <param name="path">Path to the SPIR-V file</param>
     /// <returns>vk::ShaderModule with the given SPIR-V code</returns>
     static vk::ShaderModule CreateModule(const std::string& path) {
-        auto code = ReadFile(path);
+        std::vector<char> code;
+        {
+            // The code stays cached, since a shader may be compiled into several Pipeline variants (e.g. for a depth pre-pass).
+            std::lock_guard lock{ g_CodeCacheMutex };
+            auto it = g_CodeCache.find(path);
+            if (it != g_CodeCache.end())
+                code = it->second;
+        }
+        if (code.empty())
+            code = ReadFile(path);
 
         return Manager::GetDevice().createShaderModule({
             {}, code.size(), reinterpret_cast<uint32_t*>(code.data())
         });
     }
 
-    vk::Pipeline Compile(const std::string& shaderName, vk::PipelineLayout layout, vk::RenderPass renderpass, uint32_t subpass) {
+    void Preload(const std::string& shaderName) {
+        for (const auto& path : { shaderName + ".vert.spv", shaderName + ".frag.spv" }) {
+            auto code = ReadFile(path);
+
+            std::lock_guard lock{ g_CodeCacheMutex };
+            g_CodeCache[path] = std::move(code);
+        }
+    }
+
+    vk::Pipeline Compile(const std::string& shaderName, vk::PipelineLayout layout, vk::RenderPass renderpass, uint32_t subpass, DepthMode depthMode) {
+        // A depth pre-pass only needs the vertex positions, the depth test is done without any fragment shader.
+        bool depthOnly = depthMode == DepthMode::PrePass;
+
     	// load vertex and fragment shader modules
         auto vShaderMod = CreateModule(shaderName + ".vert.spv");
-        auto fShaderMod = CreateModule(shaderName + ".frag.spv");
+        auto fShaderMod = depthOnly ? vk::ShaderModule{} : CreateModule(shaderName + ".frag.spv");
 
-    	// This array specifies every programmable shader stage the pipeline will use.
+    	// This vector specifies every programmable shader stage the pipeline will use.
     	// We could e.g. specify further shaders like a geometry shader. For now we only use Vertex and Fragment shader.
-        std::array stages {
+        std::vector stages {
             vk::PipelineShaderStageCreateInfo{ {}, vk::ShaderStageFlagBits::eVertex, vShaderMod, "vert" }, // "vert" is the name of the shaders main function.
-            vk::PipelineShaderStageCreateInfo{ {}, vk::ShaderStageFlagBits::eFragment, fShaderMod, "frag" },
         };
+        if (!depthOnly)
+            stages.push_back(vk::PipelineShaderStageCreateInfo{ {}, vk::ShaderStageFlagBits::eFragment, fShaderMod, "frag" });
 
     	/*
     	 * Here we specify Vertex Attributes and Bindings that the Vertex Shader will receive.
@@ -139,6 +166,26 @@ namespace Graphics::PipelineCompiler {
             {}, false, {},
             blendAttachments
         };
+        // The pre-pass subpass has no color attachments at all.
+        if (depthOnly)
+            colorBlend.attachmentCount = 0;
+
+    	/*
+    	 * This struct specifies whether and how fragments are tested against the depth attachment.
+    	 * Our projection maps the near plane to 0 and the far plane to 1, so a fragment is visible when its depth is less than the stored value.
+    	 *
+    	 * With a depth pre-pass, the depth buffer already contains the depth of the closest fragment of every pixel when the main subpass starts.
+    	 * Testing with eEqual then lets exactly one fragment per pixel through to the expensive fragment shader. Writing depth again is unnecessary.
+    	 * This only works because both Pipelines use the same vertex shader, which computes bit-identical positions (see "precise" in the shader).
+    	 */
+        vk::PipelineDepthStencilStateCreateInfo depthStencil {
+            {},
+            depthMode != DepthMode::None, // depthTestEnable
+            depthMode == DepthMode::TestAndWrite || depthMode == DepthMode::PrePass, // depthWriteEnable
+            depthMode == DepthMode::Equal ? vk::CompareOp::eEqual : vk::CompareOp::eLess,
+            false, // depthBoundsTestEnable
+            false, // stencilTestEnable
+        };
 
     	/*
     	 * Here we specify that we want to use a dynamically sized viewport and scissor, see above.
@@ -160,7 +207,7 @@ namespace Graphics::PipelineCompiler {
             &viewport,
             &rasterization,
             &multisample,
-            nullptr, // depthStencilState is only needed when we use a depth/stencil attachment in the RenderPass.
+            depthMode != DepthMode::None ? &depthStencil : nullptr, // depthStencilState is only needed when we use a depth/stencil attachment in the RenderPass.
             &colorBlend,
             &dynamic,
             layout, renderpass, subpass
@@ -174,7 +221,8 @@ namespace Graphics::PipelineCompiler {
 
     	// After the pipeline is created, the shader modules are not needed anymore.
         Manager::GetDevice().destroyShaderModule(vShaderMod);
-        Manager::GetDevice().destroyShaderModule(fShaderMod);
+        if (fShaderMod)
+            Manager::GetDevice().destroyShaderModule(fShaderMod);
 
         return res;
     }
@@ -4,6 +4,35 @@
 
 namespace Graphics::PipelineCompiler {
 
+    /// <summary>
+    /// Reads the SPIR-V code of a shader into a cache, so that a later call to Compile() does not have to touch the disk.
+    /// Can be called from any thread, which allows loading shaders while the Vulkan device is still being created.
+    /// </summary>
+    /// <param name="shaderName">Path to a shader without the .hlsl extension</param>
+    void Preload(const std::string& shaderName);
+
+    /// <summary>
+    /// Describes how a Pipeline uses the depth attachment of its subpass.
+    /// </summary>
+    enum class DepthMode {
+        /// <summary>
+        /// The subpass has no depth attachment.
+        /// </summary>
+        None,
+        /// <summary>
+        /// Fragments closer than the stored depth pass and overwrite it.
+        /// </summary>
+        TestAndWrite,
+        /// <summary>
+        /// Depth-only Pipeline for a depth pre-pass. Only uses the vertex shader and writes no color.
+        /// </summary>
+        PrePass,
+        /// <summary>
+        /// Only fragments exactly matching the depth written by a pre-pass are shaded. Does not write depth.
+        /// </summary>
+        Equal,
+    };
+
     /// <summary>
     /// Compiles a very basic vk::GraphicsPipeline. Mainly used to improve code readability, since
     /// creating a vk::Pipeline involves ~60 lines of code.
@@ -12,7 +41,8 @@ namespace Graphics::PipelineCompiler {
     /// <param name="layout">A compatible vk::PipelineLayout</param>
     /// <param name="renderpass">A compatible vk::RenderPass</param>
     /// <param name="subpass">Which subpass the Pipeline will be used in</param>
+    /// <param name="depthMode">How the Pipeline uses the depth attachment of the subpass</param>
     /// <returns>The compiled vk::Pipeline</returns>
-    vk::Pipeline Compile(const std::string& shaderName, vk::PipelineLayout layout, vk::RenderPass renderpass, uint32_t subpass);
+    vk::Pipeline Compile(const std::string& shaderName, vk::PipelineLayout layout, vk::RenderPass renderpass, uint32_t subpass, DepthMode depthMode = DepthMode::None);
 
 }
@@ -0,0 +1,753 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "DeletionQueue.h"
+#include "GpuProfiler.h"
+#include "Manager.h"
+#include "Logging/Log.h"
+
+namespace Graphics {
+
+	/// <summary>
+	/// Every access flag that writes memory. Only writes have to be made available to later accesses, reads never need a memory dependency.
+	/// </summary>
+	static constexpr vk::AccessFlags WRITE_ACCESS =
+		vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite |
+		vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eMemoryWrite;
+
+	static bool IsWrite(vk::AccessFlags access) {
+		return (bool)(access & WRITE_ACCESS);
+	}
+
+	/// <returns>True if an access in state "next" has to wait for the accesses in state "prev"</returns>
+	static bool NeedsDependency(vk::ImageLayout prevLayout, vk::AccessFlags prevAccess, vk::ImageLayout nextLayout, vk::AccessFlags nextAccess) {
+		/*
+		 * Two accesses only have to be synchronized if at least one of them writes (read-after-write, write-after-read, write-after-write).
+		 * A layout transition counts as a write, as it may rewrite the whole image.
+		 * Two reads of an image in the same layout never need a barrier, which is exactly the case a manually synchronized renderer
+		 * tends to over-synchronize.
+		 */
+		return IsWrite(prevAccess) || IsWrite(nextAccess) || prevLayout != nextLayout;
+	}
+
+	static vk::ImageUsageFlags UsageForLayout(vk::ImageLayout layout) {
+		switch (layout) {
+		case vk::ImageLayout::eColorAttachmentOptimal: return vk::ImageUsageFlagBits::eColorAttachment;
+		case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+		case vk::ImageLayout::eDepthStencilReadOnlyOptimal: return vk::ImageUsageFlagBits::eDepthStencilAttachment;
+		case vk::ImageLayout::eShaderReadOnlyOptimal: return vk::ImageUsageFlagBits::eSampled;
+		case vk::ImageLayout::eTransferSrcOptimal: return vk::ImageUsageFlagBits::eTransferSrc;
+		case vk::ImageLayout::eTransferDstOptimal: return vk::ImageUsageFlagBits::eTransferDst;
+		default: return {};
+		}
+	}
+
+	RenderGraph::ResourceId RenderGraph::ImportImage(std::string name, vk::Format format, vk::ImageUsageFlags usage, vk::ImageLayout finalLayout, vk::PipelineStageFlags initialStage) {
+		Resource res{};
+		res.name = std::move(name);
+		res.format = format;
+		res.aspect = vk::ImageAspectFlagBits::eColor;
+		res.usage = usage;
+		res.imported = true;
+		res.finalLayout = finalLayout;
+		res.initialStage = initialStage;
+		m_Resources.push_back(std::move(res));
+		return (ResourceId)m_Resources.size() - 1;
+	}
+
+	RenderGraph::ResourceId RenderGraph::CreateImage(std::string name, vk::Format format, vk::ImageAspectFlags aspect) {
+		Resource res{};
+		res.name = std::move(name);
+		res.format = format;
+		res.aspect = aspect;
+		res.imported = false;
+		m_Resources.push_back(std::move(res));
+		return (ResourceId)m_Resources.size() - 1;
+	}
+
+	RenderGraph::PassId RenderGraph::AddRasterPass(std::string name, std::vector<Attachment> attachments, std::vector<Subpass> subpasses, std::vector<Use> uses) {
+		Pass pass{};
+		pass.name = std::move(name);
+		pass.attachments = std::move(attachments);
+		pass.subpasses = std::move(subpasses);
+		pass.uses = std::move(uses);
+		pass.raster = true;
+		pass.enabled = true;
+		m_Passes.push_back(std::move(pass));
+		return (PassId)m_Passes.size() - 1;
+	}
+
+	RenderGraph::PassId RenderGraph::AddPass(std::string name, std::vector<Use> uses, ExecuteFn execute, bool sideEffects) {
+		Pass pass{};
+		pass.name = std::move(name);
+		pass.uses = std::move(uses);
+		pass.execute = std::move(execute);
+		pass.raster = false;
+		pass.sideEffects = sideEffects;
+		pass.enabled = true;
+		m_Passes.push_back(std::move(pass));
+		return (PassId)m_Passes.size() - 1;
+	}
+
+	void RenderGraph::SetPassEnabled(PassId pass, bool enabled) {
+		m_Passes[pass].enabled = enabled;
+	}
+
+	std::vector<RenderGraph::UseInfo> RenderGraph::CollectUses(const Pass& pass) const {
+		std::vector<UseInfo> res;
+
+		for (uint32_t a = 0; a < pass.attachments.size(); a++) {
+			UseInfo info{ pass.attachments[a].resource, (int32_t)a };
+			bool found = false;
+
+			for (uint32_t s = 0; s < pass.subpasses.size(); s++) {
+				const auto& sub = pass.subpasses[s];
+
+				vk::ImageLayout layout;
+				if (std::find(sub.colors.begin(), sub.colors.end(), a) != sub.colors.end()) {
+					layout = vk::ImageLayout::eColorAttachmentOptimal;
+					info.stages |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+					info.access |= vk::AccessFlagBits::eColorAttachmentWrite;
+				} else if (sub.depth == (int32_t)a) {
+					layout = sub.depthReadOnly ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eDepthStencilAttachmentOptimal;
+					info.stages |= vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+					info.access |= vk::AccessFlagBits::eDepthStencilAttachmentRead;
+					if (!sub.depthReadOnly)
+						info.access |= vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+				} else {
+					continue;
+				}
+
+				if (!found) {
+					info.firstSubpass = s;
+					info.firstLayout = layout;
+					found = true;
+				}
+				info.lastLayout = layout;
+			}
+
+			// Every attachment must be referenced by a subpass, otherwise it would not be part of the RenderPass.
+			if (found)
+				res.push_back(info);
+			else
+				Log::Error("Attachment {} of pass {} is not used by any subpass", m_Resources[info.resource].name, pass.name);
+		}
+
+		for (const auto& use : pass.uses) {
+			UseInfo info{ use.resource, -1, 0 };
+			switch (use.access) {
+			case Access::ShaderRead:
+				info.firstLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+				info.stages = vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+				info.access = vk::AccessFlagBits::eShaderRead;
+				break;
+			case Access::TransferSrc:
+				info.firstLayout = vk::ImageLayout::eTransferSrcOptimal;
+				info.stages = vk::PipelineStageFlagBits::eTransfer;
+				info.access = vk::AccessFlagBits::eTransferRead;
+				break;
+			case Access::TransferDst:
+				info.firstLayout = vk::ImageLayout::eTransferDstOptimal;
+				info.stages = vk::PipelineStageFlagBits::eTransfer;
+				info.access = vk::AccessFlagBits::eTransferWrite;
+				break;
+			}
+			info.lastLayout = info.firstLayout;
+			res.push_back(info);
+		}
+
+		return res;
+	}
+
+	void RenderGraph::Build() {
+		// On a rebuild, frames in flight may still use the previous RenderPasses, framebuffers and images.
+		// The memory slots are recomputed below, so their allocations have to be released first.
+		auto release = ReleaseSizeDependent();
+		std::vector<vk::RenderPass> renderPasses;
+		for (auto& pass : m_Passes) {
+			if (pass.renderPass)
+				renderPasses.push_back(std::exchange(pass.renderPass, nullptr));
+		}
+		if (!renderPasses.empty()) {
+			DeletionQueue::Push([release = std::move(release), renderPasses = std::move(renderPasses)] {
+				release();
+				for (auto rp : renderPasses)
+					Manager::GetDevice().destroyRenderPass(rp);
+			});
+		}
+
+		/*
+		 * Step 1: Culling.
+		 * Imported images (e.g. the swapchain image) are the outputs of the graph. Walking the passes backwards, a pass is needed if it writes
+		 * something that is needed later on. Everything a needed pass reads becomes needed as well.
+		 * Attachments are treated as read as well, since a pass may load the previous contents of an attachment.
+		 */
+		std::vector<bool> needed(m_Resources.size());
+		for (size_t r = 0; r < m_Resources.size(); r++)
+			needed[r] = m_Resources[r].imported;
+
+		for (size_t p = m_Passes.size(); p-- > 0;) {
+			auto& pass = m_Passes[p];
+
+			bool alive = pass.sideEffects;
+			for (const auto& a : pass.attachments)
+				alive |= needed[a.resource];
+			for (const auto& u : pass.uses)
+				alive |= u.access == Access::TransferDst && needed[u.resource];
+
+			alive &= pass.enabled;
+			pass.culled = !alive;
+			if (!alive)
+				continue;
+
+			for (const auto& a : pass.attachments)
+				needed[a.resource] = true;
+			for (const auto& u : pass.uses) {
+				if (u.access != Access::TransferDst)
+					needed[u.resource] = true;
+			}
+		}
+
+		// Passes are declared in the order they should execute in, so that order is always valid.
+		m_Order.clear();
+		for (PassId p = 0; p < m_Passes.size(); p++) {
+			if (m_Passes[p].culled && m_Passes[p].enabled)
+				Log::Info("Frame graph culled unused pass {}", m_Passes[p].name);
+			else if (!m_Passes[p].culled)
+				m_Order.push_back(p);
+		}
+
+		/*
+		 * Step 2: Lifetimes.
+		 * For every image we determine the first and the last pass using it, as well as all the usage flags a transient image needs.
+		 */
+		for (auto& r : m_Resources) {
+			r.firstUse = UINT32_MAX;
+			r.lastUse = 0;
+			if (!r.imported)
+				r.usage = {};
+		}
+		std::vector<std::vector<UseInfo>> passUses(m_Order.size());
+		for (uint32_t i = 0; i < m_Order.size(); i++) {
+			passUses[i] = CollectUses(m_Passes[m_Order[i]]);
+			for (const auto& u : passUses[i]) {
+				auto& r = m_Resources[u.resource];
+				r.firstUse = std::min(r.firstUse, i);
+				r.lastUse = i;
+				if (!r.imported)
+					r.usage |= UsageForLayout(u.firstLayout) | UsageForLayout(u.lastLayout);
+			}
+		}
+
+		/*
+		 * Step 3: Memory aliasing.
+		 * Transient images whose lifetimes don't overlap can use the same memory. We greedily put every image into the first memory slot
+		 * that is free at the time the image is first used. The slot sizes are only known once the images are created in Resize().
+		 */
+		std::vector<ResourceId> transients;
+		for (ResourceId r = 0; r < m_Resources.size(); r++) {
+			if (!m_Resources[r].imported && m_Resources[r].firstUse != UINT32_MAX)
+				transients.push_back(r);
+		}
+		std::sort(transients.begin(), transients.end(), [this](ResourceId a, ResourceId b) {
+			return m_Resources[a].firstUse < m_Resources[b].firstUse;
+		});
+
+		m_MemorySlots.clear();
+		for (auto r : transients) {
+			auto& res = m_Resources[r];
+
+			auto slot = std::find_if(m_MemorySlots.begin(), m_MemorySlots.end(), [this, &res](const MemorySlot& s) {
+				return m_Resources[s.occupants.back()].lastUse < res.firstUse;
+			});
+			if (slot == m_MemorySlots.end()) {
+				m_MemorySlots.push_back({});
+				slot = m_MemorySlots.end() - 1;
+			}
+			res.memorySlot = (uint32_t)(slot - m_MemorySlots.begin());
+			slot->occupants.push_back(r);
+		}
+
+		/*
+		 * Step 4: Synchronization.
+		 * We simulate a frame, tracking the state of every image. Whenever a pass uses an image in a way that conflicts with its
+		 * current state, we record a barrier (or a subpass dependency for attachments) from the old to the new state.
+		 *
+		 * The state at the start of a frame is:
+		 * - for imported images: undefined contents, available after the stage given on import (e.g. after the acquire semaphore was waited on)
+		 * - for transient images: undefined contents, but the previous user of the same memory (possibly in the previous frame, which may still be executing)
+		 *   must be finished. This is what allows every frame in flight to share a single set of transient images.
+		 */
+		auto endState = [&](ResourceId r) {
+			const auto& res = m_Resources[r];
+			for (const auto& u : passUses[res.lastUse]) {
+				if (u.resource == r)
+					return State{ u.lastLayout, u.stages, u.access };
+			}
+			return State{};
+		};
+
+		std::vector<State> states(m_Resources.size());
+		for (ResourceId r = 0; r < m_Resources.size(); r++) {
+			const auto& res = m_Resources[r];
+			if (res.firstUse == UINT32_MAX)
+				continue;
+
+			if (res.imported) {
+				states[r] = { vk::ImageLayout::eUndefined, res.initialStage, {} };
+			} else {
+				const auto& occupants = m_MemorySlots[res.memorySlot].occupants;
+				auto it = std::find(occupants.begin(), occupants.end(), r);
+				auto prev = it == occupants.begin() ? occupants.back() : *(it - 1);
+				auto prevState = endState(prev);
+				states[r] = { vk::ImageLayout::eUndefined, prevState.stages, prevState.access };
+			}
+		}
+
+		m_NumDependencies = 0;
+		m_Barriers.assign(m_Order.size() + 1, {});
+		for (uint32_t i = 0; i < m_Order.size(); i++) {
+			auto& pass = m_Passes[m_Order[i]];
+			auto& batch = m_Barriers[i];
+
+			// Images used outside of RenderPass attachments are synchronized with pipeline barriers in front of the pass.
+			for (const auto& u : passUses[i]) {
+				if (u.attachment != -1)
+					continue;
+
+				auto& prev = states[u.resource];
+				if (NeedsDependency(prev.layout, prev.access, u.firstLayout, u.access)) {
+					batch.srcStages |= prev.stages ? prev.stages : vk::PipelineStageFlagBits::eTopOfPipe;
+					batch.dstStages |= u.stages;
+
+					// A write-after-read hazard without layout transition only needs an execution dependency, no image barrier.
+					if (IsWrite(prev.access) || prev.layout != u.firstLayout) {
+						batch.barriers.push_back({
+							u.resource, prev.layout, u.firstLayout,
+							prev.access & WRITE_ACCESS, u.access
+						});
+					}
+				}
+				prev = { u.lastLayout, u.stages, u.access };
+			}
+			if (batch.srcStages)
+				m_NumDependencies++;
+
+			if (pass.raster)
+				CreateRenderPass(pass, i, passUses[i], states);
+		}
+
+		// At the end of the frame, imported images have to be transitioned into the layout their owner expects (e.g. ePresentSrcKHR).
+		auto& finalBatch = m_Barriers.back();
+		for (ResourceId r = 0; r < m_Resources.size(); r++) {
+			const auto& res = m_Resources[r];
+			if (!res.imported || res.firstUse == UINT32_MAX || states[r].layout == res.finalLayout)
+				continue;
+
+			finalBatch.srcStages |= states[r].stages;
+			finalBatch.dstStages |= vk::PipelineStageFlagBits::eBottomOfPipe;
+			finalBatch.barriers.push_back({
+				r, states[r].layout, res.finalLayout,
+				states[r].access & WRITE_ACCESS, {}
+			});
+		}
+		if (finalBatch.srcStages)
+			m_NumDependencies++;
+
+		Log::Info("Frame graph: {} of {} passes active, {} barriers/subpass dependencies, {} transient images in {} memory slots",
+			m_Order.size(), m_Passes.size(), m_NumDependencies, transients.size(), m_MemorySlots.size());
+
+		if (m_Extent.width != 0 && m_Extent.height != 0)
+			Resize(m_Extent);
+	}
+
+	void RenderGraph::CreateRenderPass(Pass& pass, uint32_t order, const std::vector<UseInfo>& uses, std::vector<State>& states) {
+		/*
+		 * Each AttachmentDescription2 describes a single attachment used by the RenderPass.
+		 *
+		 * The loadOp/storeOp and stencilLoadOp/stencilStoreOp pairs describe what happens to the data stored in the attachment at certain points in the pipeline.
+		 * loadOp specifies what happens with data already stored in the attachment before any rendering begins. This will probably be the pixels of the previous frame.
+		 * By using eClear, we discard the previous frame's pixels and set them to a color specified later in a beginRenderPass() command.
+		 * storeOp specifies what happens to the pixels in the attachment after the entire RenderPass has finished executing.
+		 * For a temporary attachment that is not needed after rendering, you could specify eDontCare, but since we need the pixels for presenting them to the screen, we
+		 * specify eStore.
+		 * The same applies to stencilLoadOp and stencilStoreOp.
+		 *
+		 * The initialLayout and finalLayout pair functions in a similar fashion to the above pairs.
+		 * initialLayout specifies in what ImageLayout the given attachment will be in, before any rendering starts.
+		 * finalLayout specifies what layout the Image should be in after any rendering has finished. The transition to this layout will
+		 * automatically be handled.
+		 *
+		 * Since the graph knows every pass using an attachment, it can choose all of these automatically:
+		 * - The first pass writing an image this frame clears it (or doesn't care about its contents), every later pass loads it.
+		 * - Only images that are read by a later pass (or are imported, like the swapchain image) are stored, depth buffers are usually not.
+		 * - The initial layout is the layout the previous pass left the image in, eUndefined for the first use, which discards the old contents.
+		 * - The final layout is the layout of the last subpass using the image, or the layout expected by the owner of an imported image.
+		 */
+		std::vector<vk::AttachmentDescription2> descs;
+		pass.clearValues.clear();
+
+		/*
+		 * Here we can describe what subpasses depend on each other. E.g. a subpass rendering the scene using a shadow map depends
+		 * on the results of the subpass rendering the shadow map.
+		 * Dependencies on VK_SUBPASS_EXTERNAL describe what the RenderPass has to wait for before it may touch an attachment,
+		 * e.g. that the automatic layout transition of a swapchain image happens *after* presenting the previous frame has finished.
+		 */
+		std::vector<vk::SubpassDependency2> deps;
+		auto addDependency = [&deps](uint32_t src, uint32_t dst, vk::PipelineStageFlags srcStages, vk::PipelineStageFlags dstStages, vk::AccessFlags srcAccess, vk::AccessFlags dstAccess) {
+			// Dependencies between the same pair of subpasses are merged into a single one.
+			auto it = std::find_if(deps.begin(), deps.end(), [&](const vk::SubpassDependency2& d) { return d.srcSubpass == src && d.dstSubpass == dst; });
+			if (it == deps.end()) {
+				deps.push_back(vk::SubpassDependency2{
+					src, dst, {}, {}, {}, {},
+					src == VK_SUBPASS_EXTERNAL ? vk::DependencyFlags{} : vk::DependencyFlags{ vk::DependencyFlagBits::eByRegion },
+					0
+				});
+				it = deps.end() - 1;
+			}
+			it->srcStageMask |= srcStages ? srcStages : vk::PipelineStageFlagBits::eTopOfPipe;
+			it->dstStageMask |= dstStages;
+			it->srcAccessMask |= srcAccess;
+			it->dstAccessMask |= dstAccess;
+		};
+
+		for (const auto& u : uses) {
+			if (u.attachment == -1)
+				continue;
+
+			const auto& att = pass.attachments[u.attachment];
+			const auto& res = m_Resources[u.resource];
+			auto& prev = states[u.resource];
+			bool first = res.firstUse == order;
+
+			auto loadOp = first ? (att.clear ? vk::AttachmentLoadOp::eClear : vk::AttachmentLoadOp::eDontCare) : vk::AttachmentLoadOp::eLoad;
+			auto storeOp = (res.imported || res.lastUse > order) ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+			auto initialLayout = first ? vk::ImageLayout::eUndefined : prev.layout;
+			auto finalLayout = (res.imported && res.lastUse == order) ? res.finalLayout : u.lastLayout;
+
+			descs.push_back(vk::AttachmentDescription2{
+				{}, res.format,
+				vk::SampleCountFlagBits::e1,
+				loadOp, storeOp,
+				vk::AttachmentLoadOp::eDontCare, vk::AttachmentStoreOp::eDontCare,
+				initialLayout, finalLayout
+			});
+			pass.clearValues.push_back(att.clear.value_or(vk::ClearValue{}));
+
+			if (NeedsDependency(initialLayout, prev.access, u.firstLayout, u.access))
+				addDependency(VK_SUBPASS_EXTERNAL, u.firstSubpass, prev.stages, u.stages, prev.access & WRITE_ACCESS, u.access);
+
+			prev = { finalLayout, u.stages, u.access };
+		}
+
+		/*
+		 * Here we describe the SubPasses that the RenderPass will contain. A SubPass is a "step" in our rendering pipeline.
+		 * Every subpass references the attachments it renders to. Between two subpasses using the same attachment in conflicting ways,
+		 * a dependency is added, e.g. between a depth pre-pass writing depth and the main subpass testing against it.
+		 */
+		std::vector<std::vector<vk::AttachmentReference2>> colorRefs(pass.subpasses.size());
+		std::vector<vk::AttachmentReference2> depthRefs(pass.subpasses.size());
+		std::vector<vk::SubpassDescription2> subpasses;
+		for (uint32_t s = 0; s < pass.subpasses.size(); s++) {
+			const auto& sub = pass.subpasses[s];
+
+			for (auto c : sub.colors)
+				colorRefs[s].push_back({ c, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageAspectFlagBits::eColor });
+			if (sub.depth != -1) {
+				depthRefs[s] = {
+					(uint32_t)sub.depth,
+					sub.depthReadOnly ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eDepthStencilAttachmentOptimal,
+					vk::ImageAspectFlagBits::eDepth
+				};
+			}
+
+			subpasses.push_back(vk::SubpassDescription2{
+				{}, vk::PipelineBindPoint::eGraphics, 0,
+				{},
+				colorRefs[s],
+				{},
+				sub.depth != -1 ? &depthRefs[s] : nullptr,
+				{},
+			});
+		}
+
+		for (uint32_t a = 0; a < pass.attachments.size(); a++) {
+			int32_t prevSub = -1;
+			vk::PipelineStageFlags prevStages;
+			vk::AccessFlags prevAccess;
+			vk::ImageLayout prevLayout;
+
+			for (uint32_t s = 0; s < pass.subpasses.size(); s++) {
+				const auto& sub = pass.subpasses[s];
+
+				vk::PipelineStageFlags stages;
+				vk::AccessFlags access;
+				vk::ImageLayout layout;
+				if (std::find(sub.colors.begin(), sub.colors.end(), a) != sub.colors.end()) {
+					stages = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+					access = vk::AccessFlagBits::eColorAttachmentWrite;
+					layout = vk::ImageLayout::eColorAttachmentOptimal;
+				} else if (sub.depth == (int32_t)a) {
+					stages = vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+					access = sub.depthReadOnly ? vk::AccessFlagBits::eDepthStencilAttachmentRead : vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+					layout = sub.depthReadOnly ? vk::ImageLayout::eDepthStencilReadOnlyOptimal : vk::ImageLayout::eDepthStencilAttachmentOptimal;
+				} else {
+					continue;
+				}
+
+				if (prevSub != -1 && NeedsDependency(prevLayout, prevAccess, layout, access))
+					addDependency((uint32_t)prevSub, s, prevStages, stages, prevAccess & WRITE_ACCESS, access);
+
+				prevSub = (int32_t)s;
+				prevStages = stages;
+				prevAccess = access;
+				prevLayout = layout;
+			}
+		}
+
+		m_NumDependencies += (uint32_t)deps.size();
+
+		vk::RenderPassCreateInfo2 passInfo{
+			{},
+			descs,
+			subpasses,
+			deps,
+			{},
+		};
+		pass.renderPass = Manager::GetDevice().createRenderPass2(passInfo);
+	}
+
+	void RenderGraph::Resize(const vk::Extent2D& extent) {
+		const auto& dev = Manager::GetDevice();
+
+		// Frames in flight may still use the old images and framebuffers, so they are destroyed once those frames are finished.
+		DeletionQueue::Push(ReleaseSizeDependent());
+		m_Extent = extent;
+
+		// Create every transient image without memory first, so that we know how much memory each slot needs.
+		uint64_t requestedBytes = 0;
+		std::vector<vk::MemoryRequirements> slotReqs(m_MemorySlots.size());
+		std::vector<bool> slotValid(m_MemorySlots.size(), false);
+		std::vector<std::pair<ResourceId, vk::MemoryRequirements>> ownAllocations;
+		for (uint32_t s = 0; s < m_MemorySlots.size(); s++) {
+			for (auto r : m_MemorySlots[s].occupants) {
+				auto& res = m_Resources[r];
+
+				vk::ImageCreateInfo imageInfo{
+					{}, vk::ImageType::e2D, res.format,
+					vk::Extent3D{ extent.width, extent.height, 1 },
+					1, 1, vk::SampleCountFlagBits::e1,
+					vk::ImageTiling::eOptimal,
+					res.usage,
+					vk::SharingMode::eExclusive, {},
+					vk::ImageLayout::eUndefined
+				};
+				res.image = dev.createImage(imageInfo);
+
+				auto reqs = dev.getImageMemoryRequirements(res.image);
+				requestedBytes += reqs.size;
+
+				auto& slot = slotReqs[s];
+				if (!slotValid[s]) {
+					slot = reqs;
+					slotValid[s] = true;
+				} else if (slot.memoryTypeBits & reqs.memoryTypeBits) {
+					slot.size = std::max(slot.size, reqs.size);
+					slot.alignment = std::max(slot.alignment, reqs.alignment);
+					slot.memoryTypeBits &= reqs.memoryTypeBits;
+				} else {
+					// The image can't live in the same memory type as the other occupants, so it gets its own memory.
+					// The barriers derived for the shared slot are still correct, just slightly more than needed.
+					ownAllocations.emplace_back(r, reqs);
+				}
+			}
+		}
+
+		uint64_t allocatedBytes = 0;
+		for (uint32_t s = 0; s < m_MemorySlots.size(); s++) {
+			auto& slot = m_MemorySlots[s];
+			slot.allocation = Manager::AllocateMemory(slotReqs[s], Core::MemoryTag::RenderTargets);
+			allocatedBytes += slotReqs[s].size;
+
+			for (auto r : slot.occupants) {
+				auto& res = m_Resources[r];
+				auto own = std::find_if(ownAllocations.begin(), ownAllocations.end(), [r](const auto& o) { return o.first == r; });
+				if (own != ownAllocations.end()) {
+					res.ownMemory = Manager::AllocateMemory(own->second, Core::MemoryTag::RenderTargets);
+					allocatedBytes += own->second.size;
+					Manager::BindImageMemory(res.ownMemory, res.image);
+				} else {
+					Manager::BindImageMemory(slot.allocation, res.image);
+				}
+
+				res.view = dev.createImageView({
+					{}, res.image, vk::ImageViewType::e2D,
+					res.format, {},
+					vk::ImageSubresourceRange{
+						res.aspect, 0, 1, 0, 1
+					}
+				});
+			}
+		}
+
+		/*
+		 * Every raster pass gets an imageless framebuffer. For imageless framebuffers, we need to specify the format and usage flags of the ImageViews
+		 * that will be used later, the actual views are only passed when the RenderPass begins.
+		 * This allows us to use the same framebuffer for every swapchain image.
+		 */
+		for (auto p : m_Order) {
+			auto& pass = m_Passes[p];
+			if (!pass.raster)
+				continue;
+
+			std::vector<vk::FramebufferAttachmentImageInfo> atInfos;
+			for (const auto& a : pass.attachments) {
+				const auto& res = m_Resources[a.resource];
+				atInfos.push_back(vk::FramebufferAttachmentImageInfo{
+					{}, res.usage,
+					extent.width, extent.height, 1, res.format
+				});
+			}
+			vk::FramebufferAttachmentsCreateInfo atInfo{
+				atInfos
+			};
+
+			vk::FramebufferCreateInfo fbInfo{
+				vk::FramebufferCreateFlagBits::eImageless, pass.renderPass,
+				(uint32_t)atInfos.size(), nullptr,
+				extent.width, extent.height, 1
+			};
+			fbInfo.pNext = &atInfo;
+
+			pass.framebuffer = dev.createFramebuffer(fbInfo);
+		}
+
+		Log::Info("Frame graph resized to {}x{}, transient images use {:.2f} MiB ({:.2f} MiB without aliasing)",
+			extent.width, extent.height, allocatedBytes / (1024.0 * 1024.0), requestedBytes / (1024.0 * 1024.0));
+	}
+
+	std::function<void()> RenderGraph::ReleaseSizeDependent() {
+		std::vector<vk::Framebuffer> framebuffers;
+		std::vector<vk::ImageView> views;
+		std::vector<vk::Image> images;
+		std::vector<VmaAllocation> allocations;
+
+		for (auto& pass : m_Passes) {
+			if (pass.framebuffer)
+				framebuffers.push_back(std::exchange(pass.framebuffer, nullptr));
+		}
+
+		for (auto& res : m_Resources) {
+			if (res.imported)
+				continue;
+
+			if (res.view)
+				views.push_back(std::exchange(res.view, nullptr));
+			if (res.image)
+				images.push_back(std::exchange(res.image, nullptr));
+			if (res.ownMemory)
+				allocations.push_back(std::exchange(res.ownMemory, nullptr));
+		}
+
+		for (auto& slot : m_MemorySlots) {
+			if (slot.allocation)
+				allocations.push_back(std::exchange(slot.allocation, nullptr));
+		}
+
+		return [framebuffers = std::move(framebuffers), views = std::move(views), images = std::move(images), allocations = std::move(allocations)] {
+			const auto& dev = Manager::GetDevice();
+			for (auto fb : framebuffers)
+				dev.destroyFramebuffer(fb);
+			for (auto v : views)
+				dev.destroyImageView(v);
+			for (auto img : images)
+				dev.destroyImage(img);
+			for (const auto& a : allocations)
+				Manager::FreeMemory(a);
+		};
+	}
+
+	void RenderGraph::Destroy() {
+		ReleaseSizeDependent()();
+
+		for (auto& pass : m_Passes) {
+			if (pass.renderPass)
+				Manager::GetDevice().destroyRenderPass(pass.renderPass);
+			pass.renderPass = nullptr;
+		}
+	}
+
+	vk::RenderPass RenderGraph::GetRenderPass(PassId pass) const {
+		return m_Passes[pass].renderPass;
+	}
+
+	void RenderGraph::SetImportedImage(ResourceId resource, vk::Image image, vk::ImageView view) {
+		auto& res = m_Resources[resource];
+		res.image = image;
+		res.view = view;
+	}
+
+	void RenderGraph::RecordBarriers(vk::CommandBuffer cmd, const BarrierBatch& batch) const {
+		if (!batch.srcStages)
+			return;
+
+		std::vector<vk::ImageMemoryBarrier> barriers;
+		barriers.reserve(batch.barriers.size());
+		for (const auto& b : batch.barriers) {
+			const auto& res = m_Resources[b.resource];
+			barriers.push_back(vk::ImageMemoryBarrier{
+				b.srcAccess, b.dstAccess,
+				b.oldLayout, b.newLayout,
+				VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+				res.image,
+				vk::ImageSubresourceRange{ res.aspect, 0, 1, 0, 1 }
+			});
+		}
+
+		cmd.pipelineBarrier(batch.srcStages, batch.dstStages, {}, {}, {}, barriers);
+	}
+
+	void RenderGraph::Execute(vk::CommandBuffer cmd) {
+		PassContext ctx{ cmd, m_Extent };
+
+		for (uint32_t i = 0; i < m_Order.size(); i++) {
+			const auto& pass = m_Passes[m_Order[i]];
+			// Every pass is profiled, RenderPasses additionally count their shader invocations.
+			GpuProfiler::Scope scope{ cmd, pass.name, pass.raster };
+
+			RecordBarriers(cmd, m_Barriers[i]);
+
+			if (!pass.raster) {
+				pass.execute(ctx);
+				continue;
+			}
+
+			vk::RenderPassBeginInfo rpInfo{
+				pass.renderPass, pass.framebuffer, vk::Rect2D{{0, 0}, m_Extent},
+				pass.clearValues
+			};
+			// Since we are using an imageless framebuffer, we need to pass a vk::RenderPassAttachmentBeginInfo, containing the actual ImageViews we want to render to.
+			std::vector<vk::ImageView> views;
+			views.reserve(pass.attachments.size());
+			for (const auto& a : pass.attachments)
+				views.push_back(m_Resources[a.resource].view);
+			vk::RenderPassAttachmentBeginInfo atInfo{
+				views
+			};
+			rpInfo.pNext = &atInfo;
+
+			cmd.beginRenderPass(rpInfo, vk::SubpassContents::eInline);
+			for (uint32_t s = 0; s < pass.subpasses.size(); s++) {
+				if (s > 0)
+					cmd.nextSubpass(vk::SubpassContents::eInline);
+				pass.subpasses[s].execute(ctx);
+			}
+			cmd.endRenderPass();
+		}
+
+		RecordBarriers(cmd, m_Barriers.back());
+	}
+
+}
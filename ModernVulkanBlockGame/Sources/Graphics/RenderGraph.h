@@ -0,0 +1,259 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+#include <vk_mem_alloc.h>
+
+namespace Graphics {
+
+	/// <summary>
+	/// Describes the passes of a frame and the images they read and write. From that description, the graph
+	/// - creates the RenderPasses including load/store ops, layouts and subpass dependencies,
+	/// - derives the pipeline barriers needed between passes, omitting every barrier that is not required,
+	/// - culls passes whose results are never used,
+	/// - allocates transient images and lets images whose lifetimes don't overlap share the same memory.
+	/// </summary>
+	class RenderGraph {
+	public:
+		using ResourceId = uint32_t;
+		using PassId = uint32_t;
+
+		/// <summary>
+		/// How a pass uses an image outside of its RenderPass attachments.
+		/// </summary>
+		enum class Access {
+			ShaderRead,
+			TransferSrc,
+			TransferDst,
+		};
+
+		/// <summary>
+		/// Data passed to the recording functions of a pass.
+		/// </summary>
+		struct PassContext {
+			vk::CommandBuffer cmd;
+			vk::Extent2D extent;
+		};
+		using ExecuteFn = std::function<void(const PassContext&)>;
+
+		struct Attachment {
+			ResourceId resource;
+			/// <summary>
+			/// The value the attachment is cleared to when the pass is the first one writing it this frame.
+			/// Without a clear value, the previous contents are undefined in that case.
+			/// </summary>
+			std::optional<vk::ClearValue> clear;
+		};
+
+		struct Subpass {
+			/// <summary>
+			/// Indices into the attachments of the pass that are used as color attachments.
+			/// </summary>
+			std::vector<uint32_t> colors;
+			/// <summary>
+			/// Index into the attachments of the pass that is used as depth attachment, or -1.
+			/// </summary>
+			int32_t depth = -1;
+			/// <summary>
+			/// The depth attachment is only tested against, not written.
+			/// </summary>
+			bool depthReadOnly = false;
+			ExecuteFn execute;
+		};
+
+		struct Use {
+			ResourceId resource;
+			Access access;
+		};
+
+		/// <summary>
+		/// Registers an image that is owned outside of the graph, e.g. a swapchain image. Imported images count as outputs of the graph.
+		/// </summary>
+		/// <param name="usage">The usage flags the image was created with</param>
+		/// <param name="finalLayout">The layout the image has to be in at the end of the frame</param>
+		/// <param name="initialStage">The pipeline stage after which the image is available, e.g. the wait stage of the acquire semaphore</param>
+		ResourceId ImportImage(std::string name, vk::Format format, vk::ImageUsageFlags usage, vk::ImageLayout finalLayout, vk::PipelineStageFlags initialStage);
+		/// <summary>
+		/// Declares an image owned by the graph, with the size of the graph. Its contents don't survive the frame.
+		/// </summary>
+		ResourceId CreateImage(std::string name, vk::Format format, vk::ImageAspectFlags aspect);
+
+		/// <summary>
+		/// Adds a pass rendering into the given attachments. The graph creates a RenderPass with one subpass for every entry in subpasses.
+		/// </summary>
+		/// <param name="uses">Images used outside of the attachments, e.g. sampled textures</param>
+		PassId AddRasterPass(std::string name, std::vector<Attachment> attachments, std::vector<Subpass> subpasses, std::vector<Use> uses = {});
+		/// <summary>
+		/// Adds a pass that does not render, e.g. a copy or compute pass.
+		/// </summary>
+		/// <param name="sideEffects">The pass writes something outside of the graph (e.g. a readback buffer) and must never be culled</param>
+		PassId AddPass(std::string name, std::vector<Use> uses, ExecuteFn execute, bool sideEffects = false);
+
+		/// <summary>
+		/// Disabled passes are culled like unused passes. Only takes effect on the next call to Build().
+		/// </summary>
+		void SetPassEnabled(PassId pass, bool enabled);
+		[[nodiscard]] bool IsPassEnabled(PassId pass) const { return m_Passes[pass].enabled; }
+
+		/// <summary>
+		/// Culls unused passes, orders the rest and creates their RenderPasses and barriers.
+		/// Must be called after every pass was added and before any Pipeline using GetRenderPass() is compiled.
+		/// May be called again, e.g. after enabling a pass. If the graph was already resized, its images and framebuffers are recreated,
+		/// the previous objects are destroyed through the DeletionQueue. Pipelines compiled for the previous RenderPasses stay valid as long as
+		/// the new ones only differ in layouts and load/store ops, e.g. when toggling a pass that runs after every RenderPass.
+		/// </summary>
+		void Build();
+		/// <summary>
+		/// (Re-)creates every transient image and framebuffer with the given size.
+		/// The old images and framebuffers are destroyed through the DeletionQueue, once no frame in flight uses them anymore.
+		/// </summary>
+		void Resize(const vk::Extent2D& extent);
+		/// <summary>
+		/// Destroys every Vulkan object owned by the graph.
+		/// </summary>
+		///	<remarks>The GPU must be idle.</remarks>
+		void Destroy();
+
+		/// <returns>The RenderPass created for a raster pass</returns>
+		[[nodiscard]] vk::RenderPass GetRenderPass(PassId pass) const;
+		/// <returns>The size of the graph's images, as given to Resize()</returns>
+		[[nodiscard]] vk::Extent2D GetExtent() const { return m_Extent; }
+		/// <returns>The image a resource refers to in the current frame, e.g. for copying from it in a pass</returns>
+		[[nodiscard]] vk::Image GetImage(ResourceId resource) const { return m_Resources[resource].image; }
+
+		/// <summary>
+		/// Sets the image an imported resource refers to in the next frame.
+		/// </summary>
+		void SetImportedImage(ResourceId resource, vk::Image image, vk::ImageView view);
+
+		/// <summary>
+		/// Records every pass that was not culled, including all barriers.
+		/// </summary>
+		void Execute(vk::CommandBuffer cmd);
+
+	private:
+		/// <summary>
+		/// Synchronization state of an image: in which layout it is and which stages/accesses touched it.
+		/// </summary>
+		struct State {
+			vk::ImageLayout layout;
+			vk::PipelineStageFlags stages;
+			vk::AccessFlags access;
+		};
+
+		struct Resource {
+			std::string name;
+			vk::Format format;
+			vk::ImageAspectFlags aspect;
+			vk::ImageUsageFlags usage;
+			bool imported;
+			vk::ImageLayout finalLayout;
+			vk::PipelineStageFlags initialStage;
+
+			// Filled in by Build() and Resize().
+			uint32_t firstUse;
+			uint32_t lastUse;
+			uint32_t memorySlot;
+			vk::Image image;
+			vk::ImageView view;
+			/// <summary>
+			/// Only set if the image could not share the memory of its slot, since their memory types are incompatible.
+			/// </summary>
+			VmaAllocation ownMemory;
+		};
+
+		struct Pass {
+			std::string name;
+			std::vector<Attachment> attachments;
+			std::vector<Subpass> subpasses;
+			std::vector<Use> uses;
+			ExecuteFn execute;
+			bool raster;
+			bool sideEffects;
+			bool enabled;
+
+			// Filled in by Build() and Resize().
+			bool culled;
+			vk::RenderPass renderPass;
+			vk::Framebuffer framebuffer;
+			std::vector<vk::ClearValue> clearValues;
+		};
+
+		/// <summary>
+		/// A single image barrier that is recorded in front of a pass. The actual vk::Image is only known when executing.
+		/// </summary>
+		struct Barrier {
+			ResourceId resource;
+			vk::ImageLayout oldLayout;
+			vk::ImageLayout newLayout;
+			vk::AccessFlags srcAccess;
+			vk::AccessFlags dstAccess;
+		};
+		struct BarrierBatch {
+			vk::PipelineStageFlags srcStages;
+			vk::PipelineStageFlags dstStages;
+			std::vector<Barrier> barriers;
+		};
+
+		/// <summary>
+		/// A block of memory shared by transient images whose lifetimes don't overlap.
+		/// </summary>
+		struct MemorySlot {
+			/// <summary>
+			/// Images using this slot, in the order they are used during a frame.
+			/// </summary>
+			std::vector<ResourceId> occupants;
+			VmaAllocation allocation;
+		};
+
+		/// <summary>
+		/// Summary of how a pass uses a single resource.
+		/// </summary>
+		struct UseInfo {
+			ResourceId resource;
+			/// <summary>
+			/// Index into the attachments of the pass or -1 if the resource is not used as an attachment.
+			/// </summary>
+			int32_t attachment;
+			uint32_t firstSubpass;
+			vk::ImageLayout firstLayout;
+			vk::ImageLayout lastLayout;
+			/// <summary>
+			/// All stages and accesses of the pass (in every subpass) touching the resource.
+			/// </summary>
+			vk::PipelineStageFlags stages;
+			vk::AccessFlags access;
+		};
+
+		[[nodiscard]] std::vector<UseInfo> CollectUses(const Pass& pass) const;
+		void CreateRenderPass(Pass& pass, uint32_t order, const std::vector<UseInfo>& uses, std::vector<State>& states);
+		void RecordBarriers(vk::CommandBuffer cmd, const BarrierBatch& batch) const;
+		/// <summary>
+		/// Removes every image, view, framebuffer and memory allocation depending on the size of the graph.
+		/// </summary>
+		/// <returns>A function destroying the removed objects</returns>
+		[[nodiscard]] std::function<void()> ReleaseSizeDependent();
+
+		std::vector<Resource> m_Resources;
+		std::vector<Pass> m_Passes;
+		/// <summary>
+		/// Passes that survived culling, in execution order.
+		/// </summary>
+		std::vector<PassId> m_Order;
+		/// <summary>
+		/// Barriers recorded before each pass in m_Order, and one extra batch after the last pass.
+		/// </summary>
+		std::vector<BarrierBatch> m_Barriers;
+		std::vector<MemorySlot> m_MemorySlots;
+		vk::Extent2D m_Extent;
+		/// <summary>
+		/// Number of pipeline barriers and subpass dependencies derived by Build(), for statistics only.
+		/// </summary>
+		uint32_t m_NumDependencies = 0;
+	};
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+namespace Graphics {
+
+	/// <summary>
+	/// A set of images the Renderer renders frames to, e.g. the swapchain of a window or offscreen images.
+	/// </summary>
+	class RenderTarget {
+	public:
+		virtual ~RenderTarget() = default;
+
+		/// <summary>
+		/// Acquires the image the next frame renders to.
+		/// </summary>
+		/// <param name="imageReady">Signaled once the image may be rendered to, only used if UsesSemaphores() returns true</param>
+		/// <returns>The index of the image, or std::nullopt if the target is out of date and must be recreated</returns>
+		[[nodiscard]] virtual std::optional<uint32_t> Acquire(vk::Semaphore imageReady) = 0;
+		/// <summary>
+		/// Hands a rendered image back to the target, e.g. to show it on the screen.
+		/// </summary>
+		/// <param name="renderFinished">Signaled once rendering to the image finished, only used if UsesSemaphores() returns true</param>
+		/// <returns>False if the target is out of date and must be recreated</returns>
+		virtual bool Present(uint32_t image, vk::Semaphore renderFinished) = 0;
+		/// <summary>
+		/// Recreates the images, e.g. with the current size of a window.
+		/// </summary>
+		virtual void Recreate() = 0;
+
+		/// <returns>
+		/// True if Acquire() and Present() synchronize with the GPU through semaphores. If false, the images are ready immediately,
+		/// and rendering neither waits for nor signals a semaphore.
+		/// </returns>
+		[[nodiscard]] virtual bool UsesSemaphores() const = 0;
+		/// <summary>
+		/// Blocks until at most maxQueued presented images wait to be displayed. Targets that can't tell return immediately.
+		/// </summary>
+		virtual void WaitForPresentQueue(uint32_t maxQueued) { }
+
+		[[nodiscard]] virtual vk::Format GetFormat() const = 0;
+		[[nodiscard]] virtual vk::Extent2D GetExtent() const = 0;
+		[[nodiscard]] virtual const std::vector<vk::Image>& GetImages() const = 0;
+		[[nodiscard]] virtual const std::vector<vk::ImageView>& GetImageViews() const = 0;
+	};
+
+}
@@ -1,11 +1,24 @@
 #include "Renderer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <span>
+
+#include "DeletionQueue.h"
+#include "FrameCapture.h"
+#include "FramePacing.h"
+#include "GpuProfiler.h"
 #include "Manager.h"
-#include "Renderpasses.h"
+#include "RenderGraph.h"
 #include "PipelineCompiler.h"
 #include "Vertex.h"
-#include "GLFW/glfw3.h"
 #include "Maths/Maths.h"
+#include "Core/CommandLine.h"
+#include "Core/FrameArena.h"
+#include "Core/FrameLimiter.h"
+#include "Core/FrameStats.h"
+#include "Core/Trace.h"
+#include "Core/TripleBuffer.h"
 
 namespace Graphics::Renderer {
 
@@ -31,15 +44,62 @@ namespace Graphics::Renderer {
 	/// </summary>
 	static std::vector<vk::CommandBuffer> g_CommandBuffers;
 
+	/// <summary>
+	/// The maximum number of frames the CPU may be ahead of the GPU, i.e. the number of sets of per-frame resources. See FramePacing::Config.
+	/// </summary>
+	static uint32_t g_FramesInFlight;
 	/// <summary>
 	/// Counter used to index the next set of per-frame resources.
 	/// </summary>
 	static uint32_t g_FrameCounter;
+	/// <summary>
+	/// Number of frames submitted so far. g_FrameCounter is always g_FrameNumber % g_FramesInFlight.
+	/// </summary>
+	static uint64_t g_FrameNumber;
+
+	/// <summary>
+	/// Describes every pass of a frame. The graph owns the RenderPasses, framebuffers and transient images like the depth buffer.
+	/// </summary>
+	static RenderGraph g_FrameGraph;
+	/// <summary>
+	/// The swapchain image rendered to, imported into g_FrameGraph.
+	/// </summary>
+	static RenderGraph::ResourceId g_Backbuffer;
+	/// <summary>
+	/// Depth buffer, only needed while rendering a frame, so it is a transient image of the graph.
+	/// </summary>
+	static RenderGraph::ResourceId g_Depth;
+	/// <summary>
+	/// The pass rendering the 3D scene.
+	/// </summary>
+	static RenderGraph::PassId g_ScenePass;
+	/// <summary>
+	/// The pass copying the backbuffer for FrameCapture. Only enabled while a capture is pending, see RenderFrame().
+	/// </summary>
+	static RenderGraph::PassId g_CapturePass;
+	/// <summary>
+	/// Format of the images g_Backbuffer refers to. A RenderTarget keeps its format when its images are recreated.
+	/// </summary>
+	static vk::Format g_BackbufferFormat;
+
+	/// <summary>
+	/// Whether frames are rendered to an OffscreenTarget instead of a window, see InitializePipelines().
+	/// </summary>
+	static bool g_Headless;
 
 	/// <summary>
-	/// Imageless framebuffer compatible with the 3D RenderPass.
+	/// Packets submitted by the main thread. The render thread latches the newest one right before recording a frame.
+	/// </summary>
+	static Core::TripleBuffer<FramePacket> g_Packets;
+	/// <summary>
+	/// Entity transforms of the latched packet, interpolated between its two simulation ticks. Allocated from the frame arena.
 	/// </summary>
-	static vk::Framebuffer g_3DFramebuffer;
+	static std::span<const Transform> g_Transforms;
+
+	/// <summary>
+	/// Sleeps at the start of a frame if "--fps-limit" is set.
+	/// </summary>
+	static Core::FrameLimiter g_FrameLimiter;
 
 	/// <summary>
 	/// Every Vulkan Pipeline needs a PipelineLayout that describes the layout of
@@ -52,27 +112,37 @@ namespace Graphics::Renderer {
 	/// A vk::Pipeline is roughly equivalent to a glProgram in OpenGL.
 	/// </summary>
 	static vk::Pipeline g_TestPipe;
+	/// <summary>
+	/// Depth-only variant of g_TestPipe, used in the depth pre-pass.
+	/// </summary>
+	static vk::Pipeline g_TestDepthPipe;
 
 	/// <summary>
 	/// Information about our VertexBuffer.
 	/// </summary>
 	static Manager::BufferInfo g_VertexBuffer;
 
-	void Initialize() {
-		Renderpasses::Initialize();
+	void Initialize(vk::Format backbufferFormat) {
+		InitializeFrameResources();
+		InitializePipelines(backbufferFormat);
+		InitializeGeometry();
+	}
 
+	void InitializeFrameResources() {
 		const auto& dev = Manager::GetDevice();
+		g_FramesInFlight = FramePacing::GetConfig().framesInFlight;
+		g_FrameLimiter.SetMaxFps(FramePacing::GetConfig().fpsLimit);
 
-		g_FrameResourceFences.reserve(MAX_FRAMES_IN_FLIGHT);
-		for(auto i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		g_FrameResourceFences.reserve(g_FramesInFlight);
+		for(uint32_t i = 0; i < g_FramesInFlight; i++) {
 			// Fences must be signaled on creation to avoid a dead lock on the first call to RenderFrame().
 			vk::FenceCreateInfo fInfo{ vk::FenceCreateFlagBits::eSignaled };
 			g_FrameResourceFences.push_back(dev.createFence(fInfo));
 		}
 
-		g_RenderStartSemaphores.reserve(MAX_FRAMES_IN_FLIGHT);
-		g_RenderFinishedSemaphores.reserve(MAX_FRAMES_IN_FLIGHT);
-		for (auto i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		g_RenderStartSemaphores.reserve(g_FramesInFlight);
+		g_RenderFinishedSemaphores.reserve(g_FramesInFlight);
+		for (uint32_t i = 0; i < g_FramesInFlight; i++) {
 			vk::SemaphoreCreateInfo sInfo{};
 			g_RenderStartSemaphores.push_back(dev.createSemaphore(sInfo));
 			g_RenderFinishedSemaphores.push_back(dev.createSemaphore(sInfo));
@@ -84,10 +154,126 @@ namespace Graphics::Renderer {
 		g_CommandPool = dev.createCommandPool(poolInfo);
 
 		vk::CommandBufferAllocateInfo cbInfo{
-				g_CommandPool, vk::CommandBufferLevel::ePrimary, (uint32_t)MAX_FRAMES_IN_FLIGHT
+				g_CommandPool, vk::CommandBufferLevel::ePrimary, g_FramesInFlight
 		};
 		g_CommandBuffers = dev.allocateCommandBuffers(cbInfo);
 
+		GpuProfiler::Initialize(g_FramesInFlight);
+		Core::FrameArena::Initialize(g_FramesInFlight);
+		// Twice as many readback buffers as frames in flight, so frames can be captured while earlier captures are still being written.
+		FrameCapture::Initialize(g_FramesInFlight * 2);
+	}
+
+	/// <summary>
+	/// Chooses a depth format that can be used as a depth attachment on the current physical device.
+	/// </summary>
+	static vk::Format ChooseDepthFormat() {
+		// The spec guarantees that at least one of eX8D24UnormPack32 and eD32Sfloat as well as eD16Unorm are supported.
+		// Since we don't need a stencil buffer, we prefer the format with the highest precision.
+		for (auto fmt : { vk::Format::eD32Sfloat, vk::Format::eX8D24UnormPack32, vk::Format::eD16Unorm }) {
+			auto props = Manager::GetPhysicalDevice().getFormatProperties(fmt);
+			if (props.optimalTilingFeatures & vk::FormatFeatureFlagBits::eDepthStencilAttachment)
+				return fmt;
+		}
+		return vk::Format::eD16Unorm;
+	}
+
+	/// <summary>
+	/// Records the draw commands of the scene. Used by both the depth pre-pass and the main subpass.
+	/// </summary>
+	static void DrawScene(const RenderGraph::PassContext& ctx, vk::Pipeline pipeline) {
+		auto& cmd = ctx.cmd;
+		auto extent = ctx.extent;
+
+		// Since we created our Pipelines with dynamic Viewport and Scissor sizes, we need to specify
+		// those dimensions before we draw anything.
+		cmd.setViewport(0, vk::Viewport{
+			0.0f, (float)extent.height, (float)extent.width, -(float)extent.height, 0.0f, 1.0f
+		});
+		cmd.setScissor(0, vk::Rect2D {
+			vk::Offset2D{0, 0},
+			extent
+		});
+
+		// Since our shader expects a VertexBuffer containing data at binding 0, we need to tell Vulkan which buffer to use.
+		cmd.bindVertexBuffers(0, g_VertexBuffer.buffer, { 0 });
+
+		// This is the equivalent to glUseProgram. Every draw command after this will use the given Pipeline.
+		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+
+		// Every entity is drawn as a quad with its own model matrix.
+		std::array constants{
+			mat4{},
+			mat4::Perspective(ToRadians(60.0f), 0.01f, 100.0f, (float)extent.width / (float)extent.height),
+		};
+		for (const auto& t : g_Transforms) {
+			constants[0] = t.LocalToWorld();
+			cmd.pushConstants(g_TestPipeLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(constants), constants.data());
+
+			// Roughly equivalent to glDrawArraysInstanced.
+			// The vertex data is located in our vertex buffer.
+			cmd.draw(6, 1, 0, 0);
+		}
+	}
+
+	/// <summary>
+	/// Declares the passes of a frame and builds g_FrameGraph.
+	/// </summary>
+	static void BuildFrameGraph(vk::Format backbufferFormat, bool depthPrePass) {
+		g_BackbufferFormat = backbufferFormat;
+		g_Backbuffer = g_FrameGraph.ImportImage("Backbuffer", backbufferFormat,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+			// After rendering finished, we want to present the image to the screen. Offscreen images are only ever copied from.
+			g_Headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR,
+			// Rendering waits for the acquire semaphore in this stage, see RenderFrame().
+			vk::PipelineStageFlagBits::eColorAttachmentOutput);
+		g_Depth = g_FrameGraph.CreateImage("Depth", ChooseDepthFormat(), vk::ImageAspectFlagBits::eDepth);
+
+		/*
+		 * Optionally, we render a depth pre-pass: The scene is first rendered without any fragment shader, only filling the depth buffer.
+		 * The main subpass then only shades fragments whose depth is *equal* to the stored depth, meaning every pixel is shaded exactly once,
+		 * no matter how much overdraw the scene has. This trades a second vertex processing pass for potentially a lot of fragment shading.
+		 */
+		std::vector<RenderGraph::Subpass> subpasses;
+		if (depthPrePass) {
+			RenderGraph::Subpass prePass{};
+			prePass.depth = 1;
+			prePass.execute = [](const RenderGraph::PassContext& ctx) { DrawScene(ctx, g_TestDepthPipe); };
+			subpasses.push_back(std::move(prePass));
+		}
+		RenderGraph::Subpass mainPass{};
+		mainPass.colors = { 0 };
+		mainPass.depth = 1;
+		// After a depth pre-pass, the main subpass only tests against the depth buffer.
+		mainPass.depthReadOnly = depthPrePass;
+		mainPass.execute = [](const RenderGraph::PassContext& ctx) { DrawScene(ctx, g_TestPipe); };
+		subpasses.push_back(std::move(mainPass));
+
+		// The color attachment is cleared to grey, the depth buffer to the far plane.
+		g_ScenePass = g_FrameGraph.AddRasterPass("Scene", {
+			{ g_Backbuffer, vk::ClearValue{ vk::ClearColorValue{std::array{0.2f, 0.2f, 0.2f, 1.0f}} } },
+			{ g_Depth, vk::ClearValue{ vk::ClearDepthStencilValue{1.0f, 0} } },
+		}, std::move(subpasses));
+
+		// Copies the finished image into a readback buffer when a screenshot or recording was requested, see FrameCapture.
+		// The copy writes outside of the graph, so the pass must not be culled while it is enabled.
+		g_CapturePass = g_FrameGraph.AddPass("Capture", {
+			{ g_Backbuffer, RenderGraph::Access::TransferSrc },
+		}, [](const RenderGraph::PassContext& ctx) {
+			FrameCapture::RecordCopy(ctx.cmd, g_FrameGraph.GetImage(g_Backbuffer), g_BackbufferFormat, ctx.extent, g_FrameNumber);
+		}, true);
+		// Without a capture, the pass would only transition the backbuffer to TransferSrc and back every frame.
+		g_FrameGraph.SetPassEnabled(g_CapturePass, false);
+
+		g_FrameGraph.Build();
+	}
+
+	void InitializePipelines(vk::Format backbufferFormat) {
+		bool depthPrePass = Core::CommandLine::HasOption("--depth-prepass");
+		// The final layout of the backbuffer depends on the kind of RenderTarget.
+		g_Headless = Core::CommandLine::HasOption("--headless");
+		BuildFrameGraph(backbufferFormat, depthPrePass);
+
 		std::array pushConstants{
 			vk::PushConstantRange {
 				vk::ShaderStageFlagBits::eVertex, 0, sizeof(mat4) * 2
@@ -96,10 +282,18 @@ namespace Graphics::Renderer {
 		g_TestPipeLayout = Manager::GetDevice().createPipelineLayout({
 			{}, {}, pushConstants
 		});
-		g_TestPipe = PipelineCompiler::Compile("Assets/Shaders/triangle", g_TestPipeLayout, Renderpasses::Get3DPass(), 0);
+		auto scenePass = g_FrameGraph.GetRenderPass(g_ScenePass);
+		if (depthPrePass) {
+			g_TestDepthPipe = PipelineCompiler::Compile("Assets/Shaders/triangle", g_TestPipeLayout, scenePass, 0, PipelineCompiler::DepthMode::PrePass);
+			g_TestPipe = PipelineCompiler::Compile("Assets/Shaders/triangle", g_TestPipeLayout, scenePass, 1, PipelineCompiler::DepthMode::Equal);
+		} else {
+			g_TestPipe = PipelineCompiler::Compile("Assets/Shaders/triangle", g_TestPipeLayout, scenePass, 0, PipelineCompiler::DepthMode::TestAndWrite);
+		}
+	}
 
+	void InitializeGeometry() {
 		// Create a VertexBuffer to hold our three vertices.
-		g_VertexBuffer = Manager::CreateBuffer(sizeof(Vertex) * 6, vk::BufferUsageFlagBits::eVertexBuffer, Manager::BufferType::Staging);
+		g_VertexBuffer = Manager::CreateBuffer(sizeof(Vertex) * 6, vk::BufferUsageFlagBits::eVertexBuffer, Manager::BufferType::Staging, Core::MemoryTag::Meshes);
 		// Map the buffer into application-visible memory, so we can copy data to the buffer.
 		auto buffer = Manager::MapAllocation(g_VertexBuffer.allocation);
 
@@ -125,9 +319,16 @@ namespace Graphics::Renderer {
 		Manager::DestroyBuffer(g_VertexBuffer);
 
 		dev.destroyPipeline(g_TestPipe);
+		if (g_TestDepthPipe)
+			dev.destroyPipeline(g_TestDepthPipe);
 		dev.destroyPipelineLayout(g_TestPipeLayout);
 
-		dev.destroyFramebuffer(g_3DFramebuffer);
+		g_FrameGraph.Destroy();
+		DeletionQueue::Flush();
+		FrameCapture::Terminate();
+		GpuProfiler::Terminate();
+		g_Transforms = {};
+		Core::FrameArena::Terminate();
 		// destroying the CommandPool automatically destroys all allocated CommandBuffers.
 		dev.destroyCommandPool(g_CommandPool);
 
@@ -137,45 +338,39 @@ namespace Graphics::Renderer {
 			dev.destroySemaphore(s);
 		for (const auto& f : g_FrameResourceFences)
 			dev.destroyFence(f);
-
-		Renderpasses::Terminate();
 	}
 
 	/// <summary>
-	/// Recreates the framebuffers. Must be called when a window changed size.
+	/// Recreates the images of a RenderTarget (e.g. the swapchain of a window) and every framebuffer depending on their size.
 	/// </summary>
-	/// <param name="size">New size of the framebuffers</param>
-	static void RecreateFramebuffers(const vk::Extent2D& size) {
-		// Destroy the old framebuffer.
-		if (g_3DFramebuffer)
-			Manager::GetDevice().destroyFramebuffer(g_3DFramebuffer);
-
-		vk::FramebufferCreateInfo fbInfo{
-			vk::FramebufferCreateFlagBits::eImageless, Renderpasses::Get3DPass(),
-			1, nullptr,
-			size.width, size.height, 1
-		};
-		// TODO: use correct format
-		auto fmt = vk::Format::eB8G8R8A8Srgb;
-		// for imageless framebuffers, we need to specify the format and usage flags of the ImageViews that will be used later.
-		std::array atInfos{
-			vk::FramebufferAttachmentImageInfo {
-				{}, vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
-				size.width, size.height, 1, fmt
-			},
-		};
-		vk::FramebufferAttachmentsCreateInfo atInfo{
-			atInfos
-		};
-		fbInfo.pNext = &atInfo;
+	static void RecreateTarget(RenderTarget& target) {
+		TRACE_ZONE("Recreate Swapchain");
 
-		g_3DFramebuffer = Manager::GetDevice().createFramebuffer(fbInfo);
+		/*
+		 * Frames that are still in flight may use the old framebuffers and depth buffers. Instead of waiting for the device
+		 * to become idle, they are pushed into the DeletionQueue and destroyed once the last frame using them has finished.
+		 * The old swapchain is kept until no present uses it anymore, see Window::Recreate().
+		 */
+		target.Recreate();
+		// Since the swapchain size changed, we also need new framebuffers and depth buffers. (Don't ask me why an imageless framebuffer needs to specify a size)
+		g_FrameGraph.Resize(target.GetExtent());
 	}
 
-	void RenderFrame(Window& wnd) {
-		// If we haven't created a framebuffer yet, do that now. Should only happen on the first frame.
-		if (!g_3DFramebuffer)
-			RecreateFramebuffers(wnd.GetExtent());
+	void SubmitPacket(const FramePacket& packet) {
+		g_Packets.Publish(packet);
+	}
+
+	void RenderFrame(RenderTarget& target) {
+		TRACE_ZONE("RenderFrame");
+
+		if (g_FrameLimiter.IsEnabled()) {
+			TRACE_ZONE("Frame Limiter");
+			g_FrameLimiter.Wait();
+		}
+
+		// If we haven't created the graph's framebuffers yet, do that now. Should only happen on the first frame.
+		if (g_FrameGraph.GetExtent() != target.GetExtent())
+			g_FrameGraph.Resize(target.GetExtent());
 
 		const auto& dev = Manager::GetDevice();
 
@@ -187,76 +382,93 @@ namespace Graphics::Renderer {
 		 * - Present the image (presentKHR).
 		 */
 
-		// waitForFences should always return Success, compiler will complain anyways if we don't use the result.
-		auto ignore = dev.waitForFences(g_FrameResourceFences[g_FrameCounter], true, UINT64_MAX) == vk::Result::eSuccess;
-		dev.resetFences(g_FrameResourceFences[g_FrameCounter]);
+		{
+			// Time spent here is time the CPU is ahead of the GPU by g_FramesInFlight frames, which is the first thing to check when frames are slow.
+			TRACE_ZONE("Wait For Fence");
+			auto waitStart = std::chrono::steady_clock::now();
+			// waitForFences should always return Success, compiler will complain anyways if we don't use the result.
+			auto ignore = dev.waitForFences(g_FrameResourceFences[g_FrameCounter], true, UINT64_MAX) == vk::Result::eSuccess;
+			Core::FrameStats::Record(Core::FrameStats::Metric::FenceWait,
+				(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart).count());
+		}
 
-		uint32_t imageIndex;
-		try {
+		// The frame that used these per-frame resources before has finished, and since frames finish in submission order, so has every frame before it.
+		// Objects that were only used by those frames can be destroyed now.
+		auto completedFrames = g_FrameNumber >= g_FramesInFlight ? g_FrameNumber - g_FramesInFlight + 1 : 0;
+		DeletionQueue::BeginFrame(g_FrameNumber, completedFrames);
+		// Captures of those frames can be written now, without waiting for the GPU.
+		FrameCapture::BeginFrame(completedFrames);
+		// Transient CPU data of the frame that used these resources before isn't referenced anymore either.
+		Core::FrameArena::BeginFrame(g_FrameCounter);
+
+		std::optional<uint32_t> acquired;
+		{
+			TRACE_ZONE("Acquire");
 			// g_RenderStartSemaphores[g_FrameCounter] will be signaled when the acquired image is ready to be rendered to.
-			imageIndex = dev.acquireNextImageKHR(wnd.GetSwapchain(), UINT64_MAX, g_RenderStartSemaphores[g_FrameCounter], nullptr).value;
-		} catch(const vk::OutOfDateKHRError&) {
-			// When a window is resized, the swapchain might not be compatible with that window anymore, in which case the above error will be thrown.
-			// We then have to create an entirely new swapchain with the new size in order to continue rendering.
-
-			// Since we cannot destroy a swapchain that is currently being rendered to, we just wait for the device to become idle.
-			Manager::GetDevice().waitIdle();
-			wnd.ResizeSwapchain();
-			// Since the swapchain size changed, we also need a new framebuffer. (Don't ask me why an imageless framebuffer needs to specify a size)
-			RecreateFramebuffers(wnd.GetExtent());
+			acquired = target.Acquire(g_RenderStartSemaphores[g_FrameCounter]);
+		}
+		if (!acquired) {
+			// The target is out of date, e.g. since the window was resized. See Window::Acquire().
+			// Nothing was submitted for this frame, so the fence is still signaled and the same per-frame resources are used in the next attempt.
+			RecreateTarget(target);
 			return;
 		}
+		auto imageIndex = *acquired;
 
-		auto& cmd = g_CommandBuffers[g_FrameCounter];
+		// Only reset the fence once we know that we will submit work signaling it again.
+		dev.resetFences(g_FrameResourceFences[g_FrameCounter]);
 
-		vk::CommandBufferBeginInfo cmdInfo{
-			vk::CommandBufferUsageFlagBits::eOneTimeSubmit // This CommandBuffer will only be submitted once before it will be recorded again.
-		};
-		cmd.begin(cmdInfo);
+		/*
+		 * Waiting for the fence and acquiring an image may block for a long time. The main thread keeps handling input meanwhile,
+		 * so we only now take the newest packet, right before recording. This way the frame shows the latest input possible.
+		 * With a limit on queued presents, we first wait until the display caught up, so the packet isn't sampled only to sit in the present queue.
+		 */
+		if (auto maxQueued = FramePacing::GetConfig().maxQueuedPresents; maxQueued > 0) {
+			TRACE_ZONE("Wait For Present");
+			target.WaitForPresentQueue(maxQueued);
+		}
+		g_Packets.Latch();
+		const auto& packet = g_Packets.Front();
+
+		// The simulation runs at a fixed rate, independent of the frame rate. Interpolating between its last two ticks
+		// gives smooth motion at any frame rate, at the cost of showing the simulation up to one tick late.
+		{
+			TRACE_ZONE("Interpolate");
+			auto count = std::min(packet.previousTransforms.size(), packet.currentTransforms.size());
+			auto* transforms = (Transform*)Core::FrameArena::GetResource()->allocate(count * sizeof(Transform), alignof(Transform));
+			Transform::Interpolate(packet.previousTransforms.data(), packet.currentTransforms.data(), packet.alpha, transforms, count);
+			g_Transforms = { transforms, count };
+		}
 
-		// Here we specify which color the color attachment should be cleared to.
-		vk::ClearValue clearColor{ vk::ClearColorValue{std::array{0.2f, 0.2f, 0.2f, 1.0f}} };
-		vk::RenderPassBeginInfo rpInfo{
-			Renderpasses::Get3DPass(), g_3DFramebuffer, vk::Rect2D{{0, 0}, wnd.GetExtent()},
-			clearColor
-		};
-		// Since we are using an imageless framebuffer, we need to pass a vk::RenderPassAttachmentBeginInfo, containing the actual ImageViews we want to render to.
-		vk::RenderPassAttachmentBeginInfo atInfo{
-			wnd.GetImageViews()[imageIndex]
-		};
-		rpInfo.pNext = &atInfo;
-		cmd.beginRenderPass(rpInfo, vk::SubpassContents::eInline);
+		// Captures are rare, so the capture pass is only part of the graph while one is pending. Rebuilding recreates the RenderPasses, framebuffers
+		// and transient images, the old ones are destroyed through the DeletionQueue. Pipelines stay valid, as the RenderPasses remain compatible.
+		if (bool capture = FrameCapture::IsPending(); capture != g_FrameGraph.IsPassEnabled(g_CapturePass)) {
+			TRACE_ZONE("Rebuild Frame Graph");
+			g_FrameGraph.SetPassEnabled(g_CapturePass, capture);
+			g_FrameGraph.Build();
+		}
 
-		// This is the equivalent to glUseProgram. Every draw command after this will use the given Pipeline.
-		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, g_TestPipe);
+		auto& cmd = g_CommandBuffers[g_FrameCounter];
+		{
+			TRACE_ZONE("Record");
 
-		// Since we created our Pipeline with dynamic Viewport and Scissor sizes, we need to specify
-		// those dimensions before we draw anything.
-		auto extent = wnd.GetExtent();
-		cmd.setViewport(0, vk::Viewport{
-			0.0f, (float)extent.height, (float)extent.width, -(float)extent.height, 0.0f, 1.0f
-		});
-		cmd.setScissor(0, vk::Rect2D {
-			vk::Offset2D{0, 0},
-			extent
-		});
+			vk::CommandBufferBeginInfo cmdInfo{
+				vk::CommandBufferUsageFlagBits::eOneTimeSubmit // This CommandBuffer will only be submitted once before it will be recorded again.
+			};
+			cmd.begin(cmdInfo);
 
-		float time = glfwGetTime();
-		std::array constants{
-			mat4::LocalToWorld(vec3{0, 0, 5.0f}, Quaternion{vec3{0, 0, 1}, ToRadians(180.0f * time)}, vec3{1, 1, 1}),
-			mat4::Perspective(ToRadians(60.0f), 0.01f, 100.0f, (float)extent.width / (float)extent.height),
-		};
-		cmd.pushConstants(g_TestPipeLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(constants), constants.data());
-		
-		// Since our shader expects a VertexBuffer containing data at binding 0, we need to tell Vulkan which buffer to use.
-		cmd.bindVertexBuffers(0, g_VertexBuffer.buffer, { 0 });
+			// The GPU timings of the frame that used this CommandBuffer before are available now.
+			GpuProfiler::BeginFrame(cmd, g_FrameCounter);
 
-		// Roughly equivalent to glDrawArraysInstanced.
-		// The vertex data is located in our vertex buffer.
-		cmd.draw(6, 1, 0, 0);
+			// The graph records the RenderPass of the scene including every barrier, it only needs to know which swapchain image to render to.
+			g_FrameGraph.SetImportedImage(g_Backbuffer, target.GetImages()[imageIndex], target.GetImageViews()[imageIndex]);
+			{
+				GpuProfiler::Scope frameScope{ cmd, "Frame" };
+				g_FrameGraph.Execute(cmd);
+			}
 
-		cmd.endRenderPass();
-		cmd.end();
+			cmd.end();
+		}
 
 		// The commands recorded above may start executing before the swapchain image is ready to be rendered to.
 		// To prevent that, we specify that the given CommandBuffer should not execute anything in the ColorAttachmentOutput stage
@@ -269,29 +481,41 @@ namespace Graphics::Renderer {
 			cmd,
 			g_RenderFinishedSemaphores[g_FrameCounter],
 		};
-		Manager::GetGraphicsQueue().submit(submitInfo, g_FrameResourceFences[g_FrameCounter]);
+		// Offscreen images don't signal or wait for anything. A semaphore that is signaled but never waited on could not be signaled again.
+		if (!target.UsesSemaphores()) {
+			submitInfo.setWaitSemaphores({});
+			submitInfo.setWaitDstStageMask({});
+			submitInfo.setSignalSemaphores({});
+		}
+		{
+			TRACE_ZONE("Submit");
+			Manager::GetGraphicsQueue().submit(submitInfo, g_FrameResourceFences[g_FrameCounter]);
+		}
 
 		// We need to wait for rendering to be finished before we can present a swapchain image, as otherwise a
 		// half-finished image might be presented. Thus, we specify g_RenderFinishedSemaphore[g_FrameCounter], which will be signalled by the
 		// submit() call above, once all commands are finished.
-		auto sc = wnd.GetSwapchain();
-		vk::PresentInfoKHR presentInfo{
-			g_RenderFinishedSemaphores[g_FrameCounter],
-			sc,
-			imageIndex
-		};
-		try {
-			auto err = Manager::GetGraphicsQueue().presentKHR(presentInfo);
-		} catch(const vk::OutOfDateKHRError&) {
-			// See the try/catch block of acquireNextImageKHR for explanation.
-			Manager::GetDevice().waitIdle();
-			wnd.ResizeSwapchain();
-			RecreateFramebuffers(wnd.GetExtent());
-			return;
+		bool presented;
+		{
+			TRACE_ZONE("Present");
+			presented = target.Present(imageIndex, g_RenderFinishedSemaphores[g_FrameCounter]);
+		}
+		if (presented) {
+			Core::FrameStats::RecordPresent();
+			// The time from polling the input until the frame showing it was handed to the presentation engine.
+			// The display adds its own latency on top, which can't be measured from here.
+			if (packet.sequence > 0)
+				Core::FrameStats::Record(Core::FrameStats::Metric::InputLatency,
+					(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - packet.inputTime).count());
+		} else {
+			// See the handling of a failed Acquire() above.
+			// The frame was submitted anyways, so we still advance to the next set of per-frame resources.
+			RecreateTarget(target);
 		}
 
+		g_FrameNumber++;
 		g_FrameCounter++;
-		g_FrameCounter %= MAX_FRAMES_IN_FLIGHT;
+		g_FrameCounter %= g_FramesInFlight;
 	}
 
 }
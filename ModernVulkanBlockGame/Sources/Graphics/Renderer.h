@@ -1,14 +1,38 @@
 #pragma once
 
-#include "Window.h"
+#include "FramePacket.h"
+#include "RenderTarget.h"
 
 namespace Graphics::Renderer {
 
 	/// <summary>
-	/// Initializes the Renderer
+	/// Initializes the Renderer by calling InitializeFrameResources(), InitializePipelines() and InitializeGeometry().
 	/// </summary>
+	/// <param name="backbufferFormat">Format of the images of the RenderTarget frames are rendered to</param>
 	///	<remarks>Must be called after Manager::Initialize()</remarks>
-	void Initialize();
+	void Initialize(vk::Format backbufferFormat);
+
+	/*
+	 * The following functions are the individual steps of Initialize(). They do not depend on each other,
+	 * so they may be executed concurrently on different threads during startup.
+	 */
+
+	/// <summary>
+	/// Creates the per-frame synchronization objects and CommandBuffers.
+	/// </summary>
+	///	<remarks>Must be called after Manager::Initialize()</remarks>
+	void InitializeFrameResources();
+	/// <summary>
+	/// Creates the RenderPasses and compiles every Pipeline.
+	/// </summary>
+	/// <param name="backbufferFormat">Format of the images of the RenderTarget frames are rendered to, see RenderTarget::GetFormat()</param>
+	///	<remarks>Must be called after Manager::Initialize()</remarks>
+	void InitializePipelines(vk::Format backbufferFormat);
+	/// <summary>
+	/// Creates and fills the vertex buffers.
+	/// </summary>
+	///	<remarks>Must be called after Manager::Initialize()</remarks>
+	void InitializeGeometry();
 	/// <summary>
 	/// Deinitializes the Renderer
 	/// </summary>
@@ -16,14 +40,16 @@ namespace Graphics::Renderer {
 	void Terminate();
 
 	/// <summary>
-	/// Renders a single frame to a given window.
+	/// Hands the newest state of the simulation to the Renderer. Frames are always rendered with the newest packet submitted before
+	/// their commands are recorded, packets submitted in between are skipped.
 	/// </summary>
-	/// <param name="wnd">The window to render to</param>
-	void RenderFrame(Window& wnd);
+	/// <remarks>May be called from a different thread than RenderFrame(), but only from one thread.</remarks>
+	void SubmitPacket(const FramePacket& packet);
 
 	/// <summary>
-	/// The maximum number of frames the CPU may be ahead of the GPU.
+	/// Renders a single frame to a given target.
 	/// </summary>
-	inline constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+	/// <param name="target">The window or offscreen images to render to, must be an OffscreenTarget if and only if "--headless" was passed</param>
+	void RenderFrame(RenderTarget& target);
 
 }
@@ -4,16 +4,19 @@
 #include <algorithm>
 
 #include "Logging/Log.h"
+#include "Core/FrameArena.h"
+#include "DeletionQueue.h"
+#include "FramePacing.h"
 #include "Manager.h"
 
 namespace Graphics {
 
 	Window::Window()
-		: m_Window{nullptr}, m_Surface{nullptr}, m_Swapchain{nullptr}
+		: m_Window{nullptr}, m_Surface{nullptr}, m_Swapchain{nullptr}, m_PresentId{0}
 	{ }
 
 	Window::Window(int w, int h, const char* title)
-		: m_Window{nullptr}, m_Surface{nullptr}
+		: m_Window{nullptr}, m_Surface{nullptr}, m_PresentId{0}
 	{
 		if(glfwInit() != GLFW_TRUE) {
 			const char* msg;
@@ -73,26 +76,10 @@ namespace Graphics {
 		// On windows and X11, currentExtent will never be (UINT32_MAX, UINT32_MAX).
 		m_SwapchainExtent = caps.currentExtent;
 
-		// Select apropriate swapchain image count
-		uint32_t imageCount = 3;
-		if (imageCount < caps.minImageCount)
-			imageCount = caps.minImageCount;
-		// maxImageCount may be zero when there is no max image count, so we need an extra check.
-		if (caps.maxImageCount > 0 && imageCount > caps.maxImageCount)
-			imageCount = caps.maxImageCount;
-
-		// Fifo must always be supported, so we use this as default.
-		vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;
-		for(const auto& mode : modes) {
-			// Mailbox is our most preferred mode, if supported we just break.
-			if(mode == vk::PresentModeKHR::eMailbox) {
-				presentMode = mode;
-				break;
-			}
-			if(mode == vk::PresentModeKHR::eImmediate) {
-				presentMode = mode;
-			}
-		}
+		// The image count and present mode depend on the frame pacing profile, e.g. FIFO to save power or Mailbox for low latency.
+		auto imageCount = FramePacing::ChooseImageCount(caps);
+		auto presentMode = FramePacing::ChoosePresentMode(modes);
+		Log::Info("Using present mode {} with {} swapchain images", vk::to_string(presentMode), imageCount);
 
 		vk::SwapchainCreateInfoKHR swapchainInfo{
 			{}, m_Surface, imageCount,
@@ -131,7 +118,11 @@ namespace Graphics {
 		  m_Format{r.m_Format},
 		  m_SwapchainExtent{r.m_SwapchainExtent},
 	      m_SwapchainImages{std::move(r.m_SwapchainImages)},
-	      m_SwapchainImageViews{std::move(r.m_SwapchainImageViews)}
+	      m_SwapchainImageViews{std::move(r.m_SwapchainImageViews)},
+	      m_PresentId{r.m_PresentId},
+	      m_PresentFences{std::move(r.m_PresentFences)},
+	      m_FreePresentFences{std::move(r.m_FreePresentFences)},
+	      m_Retired{std::move(r.m_Retired)}
 	{ }
 
 	Window& Window::operator=(Window&& r) noexcept {
@@ -142,6 +133,10 @@ namespace Graphics {
 		m_SwapchainImageViews = std::move(r.m_SwapchainImageViews);
 		m_Format = r.m_Format;
 		m_SwapchainExtent = r.m_SwapchainExtent;
+		m_PresentId = r.m_PresentId;
+		std::swap(m_PresentFences, r.m_PresentFences);
+		std::swap(m_FreePresentFences, r.m_FreePresentFences);
+		std::swap(m_Retired, r.m_Retired);
 		return *this;
 	}
 
@@ -151,6 +146,24 @@ namespace Graphics {
 
 	void Window::Destroy() {
 		if(IsValid()) {
+			const auto& dev = Manager::GetDevice();
+			// The device is idle, but the presentation engine may still use the swapchains. Not waiting forever in case a present never completes.
+			std::vector<vk::Fence> fences = m_PresentFences;
+			for (const auto& r : m_Retired)
+				fences.insert(fences.end(), r.presentFences.begin(), r.presentFences.end());
+			if (!fences.empty())
+				auto ignore = dev.waitForFences(fences, true, 1'000'000'000);
+
+			for (const auto& r : m_Retired)
+				DestroyRetired(r);
+			m_Retired.clear();
+			for (auto f : fences)
+				dev.destroyFence(f);
+			for (auto f : m_FreePresentFences)
+				dev.destroyFence(f);
+			m_PresentFences.clear();
+			m_FreePresentFences.clear();
+
 			for (const auto& v : m_SwapchainImageViews)
 				Manager::GetDevice().destroyImageView(v);
 
@@ -174,46 +187,155 @@ namespace Graphics {
 		return glfwWindowShouldClose(m_Window);
 	}
 
-	void Window::ResizeSwapchain() {
-		// Destroy old ImageViews
-		for (const auto& v : m_SwapchainImageViews)
+	std::optional<uint32_t> Window::Acquire(vk::Semaphore imageReady) {
+		try {
+			return Manager::GetDevice().acquireNextImageKHR(m_Swapchain, UINT64_MAX, imageReady, nullptr).value;
+		} catch (const vk::OutOfDateKHRError&) {
+			// When a window is resized, the swapchain might not be compatible with that window anymore, in which case the above error will be thrown.
+			// We then have to create an entirely new swapchain with the new size in order to continue rendering.
+			return std::nullopt;
+		}
+	}
+
+	bool Window::Present(uint32_t image, vk::Semaphore renderFinished) {
+		vk::PresentInfoKHR presentInfo{
+			renderFinished,
+			m_Swapchain,
+			image
+		};
+		// With VK_KHR_present_id every present gets an increasing id, which WaitForPresentQueue() can wait for.
+		auto id = m_PresentId + 1;
+		vk::PresentIdKHR presentId{ 1, &id };
+		if (Manager::IsPresentWaitSupported())
+			presentInfo.pNext = &presentId;
+
+		// With VK_EXT_swapchain_maintenance1 every present signals a fence, which tells us when a retired swapchain may be destroyed.
+		vk::Fence fence;
+		vk::SwapchainPresentFenceInfoEXT fenceInfo{ 1, &fence };
+		if (Manager::IsSwapchainMaintenanceSupported()) {
+			if (m_FreePresentFences.empty()) {
+				fence = Manager::GetDevice().createFence({});
+			} else {
+				fence = m_FreePresentFences.back();
+				m_FreePresentFences.pop_back();
+			}
+			// Even a present failing with OutOfDate counts as queued, so the fence is signaled in any case.
+			m_PresentFences.push_back(fence);
+			fenceInfo.pNext = presentInfo.pNext;
+			presentInfo.pNext = &fenceInfo;
+		}
+
+		bool presented;
+		try {
+			// presentKHR should always return Success or Suboptimal, compiler will complain anyways if we don't use the result.
+			auto ignore = Manager::GetGraphicsQueue().presentKHR(presentInfo);
+			m_PresentId = id;
+			presented = true;
+		} catch (const vk::OutOfDateKHRError&) {
+			presented = false;
+		}
+		ReleaseRetired(presented);
+		return presented;
+	}
+
+	void Window::ReleaseRetired(bool presented) {
+		if (!Manager::IsSwapchainMaintenanceSupported()) {
+			/*
+			 * Without present fences, nothing tells us when the presentation engine is done with a retired swapchain.
+			 * Once a frame was presented to the new swapchain, the retired ones are pushed into the DeletionQueue, tagged with that frame.
+			 * Presents execute in queue order, so by the time that frame has finished rendering, the presents queued to the old swapchains
+			 * before it are finished in practice.
+			 */
+			if (!presented || m_Retired.empty())
+				return;
+			DeletionQueue::Push([retired = std::move(m_Retired)] {
+				for (const auto& r : retired)
+					DestroyRetired(r);
+			});
+			m_Retired.clear();
+			return;
+		}
+
+		const auto& dev = Manager::GetDevice();
+		auto signaled = [&dev](vk::Fence f) { return dev.getFenceStatus(f) == vk::Result::eSuccess; };
+		auto recycle = [this, &dev](vk::Fence f) {
+			dev.resetFences(f);
+			m_FreePresentFences.push_back(f);
+		};
+
+		std::erase_if(m_PresentFences, [&](vk::Fence f) {
+			if (!signaled(f))
+				return false;
+			recycle(f);
+			return true;
+		});
+		std::erase_if(m_Retired, [&](const RetiredSwapchain& r) {
+			if (!std::all_of(r.presentFences.begin(), r.presentFences.end(), signaled))
+				return false;
+			DestroyRetired(r);
+			for (auto f : r.presentFences)
+				recycle(f);
+			return true;
+		});
+	}
+
+	void Window::DestroyRetired(const RetiredSwapchain& retired) {
+		for (const auto& v : retired.views)
 			Manager::GetDevice().destroyImageView(v);
+		Manager::GetDevice().destroySwapchainKHR(retired.swapchain);
+	}
+
+	void Window::WaitForPresentQueue(uint32_t maxQueued) {
+		if (!Manager::IsPresentWaitSupported() || m_PresentId <= maxQueued)
+			return;
+
+		// Once the present maxQueued presents ago was displayed, at most maxQueued presents are still queued.
+		// The timeout keeps us from hanging when nothing is displayed anymore, e.g. while the window is minimized.
+		try {
+			auto ignore = Manager::GetDevice().waitForPresentKHR(m_Swapchain, m_PresentId - maxQueued, 100'000'000);
+		} catch (const vk::OutOfDateKHRError&) {
+			// The next Acquire() fails as well, which recreates the swapchain.
+		}
+	}
+
+	void Window::Recreate() {
+		/*
+		 * Frames that are still in flight may render to the old swapchain images, and presents queued to the old swapchain may not be finished.
+		 * The frame fences only cover rendering, not presentation, so instead of waiting for the device to become idle,
+		 * the old swapchain and its ImageViews are kept until ReleaseRetired() knows that no present uses them anymore.
+		 * The old swapchain is retired by passing it as oldSwapchain below, so no new images can be acquired from it.
+		 */
+		auto& retired = m_Retired.emplace_back();
+		retired.views = std::move(m_SwapchainImageViews);
+		retired.presentFences = std::move(m_PresentFences);
 		m_SwapchainImageViews.clear();
+		m_PresentFences.clear();
 
 		auto caps = Manager::GetPhysicalDevice().getSurfaceCapabilitiesKHR(m_Surface);
-		auto modes = Manager::GetPhysicalDevice().getSurfacePresentModesKHR(m_Surface);
+		// Recreation happens on the render thread in the middle of a frame, so the list of modes is only needed until the end of it.
+		std::pmr::polymorphic_allocator<vk::PresentModeKHR> modeAllocator{ Core::FrameArena::GetResource() };
+		auto modes = Manager::GetPhysicalDevice().getSurfacePresentModesKHR(m_Surface, modeAllocator);
 
 		m_SwapchainExtent = caps.currentExtent;
 
-		uint32_t imageCount = 3;
-		if (imageCount < caps.minImageCount)
-			imageCount = caps.minImageCount;
-		if (caps.maxImageCount > 0 && imageCount > caps.maxImageCount)
-			imageCount = caps.maxImageCount;
-
-		vk::PresentModeKHR presentMode = vk::PresentModeKHR::eFifo;
-		for (const auto& mode : modes) {
-			if (mode == vk::PresentModeKHR::eMailbox) {
-				presentMode = mode;
-				break;
-			}
-			if (mode == vk::PresentModeKHR::eImmediate) {
-				presentMode = mode;
-			}
-		}
+		auto imageCount = FramePacing::ChooseImageCount(caps);
+		auto presentMode = FramePacing::ChoosePresentMode(modes);
 
 		vk::SwapchainCreateInfoKHR swapchainInfo{
 			{}, m_Surface, imageCount,
 			m_Format.format, m_Format.colorSpace,
 			m_SwapchainExtent, 1,
-			vk::ImageUsageFlagBits::eColorAttachment,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
 			vk::SharingMode::eExclusive, {},
 			caps.currentTransform, vk::CompositeAlphaFlagBitsKHR::eOpaque,
 			presentMode,
 			true,
 			m_Swapchain // pass old swapchain so that is gets automatically recycled.
 		};
+		retired.swapchain = m_Swapchain;
 		m_Swapchain = Manager::GetDevice().createSwapchainKHR(swapchainInfo);
+		// Present ids count per swapchain.
+		m_PresentId = 0;
 
 		m_SwapchainImages = Manager::GetDevice().getSwapchainImagesKHR(m_Swapchain);
 
@@ -236,4 +358,8 @@ namespace Graphics {
 		glfwPollEvents();
 	}
 
+	void Window::WaitEvents(double timeoutSeconds) {
+		glfwWaitEventsTimeout(timeoutSeconds);
+	}
+
 }
@@ -4,9 +4,11 @@ typedef struct GLFWwindow GLFWwindow;
 
 #include <vulkan/vulkan.hpp>
 
+#include "RenderTarget.h"
+
 namespace Graphics {
 
-	class Window {
+	class Window : public RenderTarget {
 	public:
 		/// <summary>
 		/// Creates an empty window object that does not refer to a window.
@@ -27,7 +29,7 @@ namespace Graphics {
 		Window(Window&& r) noexcept;
 		Window& operator=(Window&& r) noexcept;
 
-		~Window();
+		~Window() override;
 		/// <summary>
 		/// Destroys a window if the given object refers to a valid window.
 		/// </summary>
@@ -48,26 +50,62 @@ namespace Graphics {
 		/// <returns>The Swapchain color space of this window</returns>
 		[[nodiscard]] auto GetColorSpace() const { return m_Format.colorSpace; }
 		/// <returns>The Pixel Format of this window</returns>
-		[[nodiscard]] auto GetFormat() const { return m_Format.format; }
+		[[nodiscard]] vk::Format GetFormat() const override { return m_Format.format; }
 		/// <returns>The size of this window's swapchain</returns>
-		[[nodiscard]] auto GetExtent() const { return m_SwapchainExtent; }
+		[[nodiscard]] vk::Extent2D GetExtent() const override { return m_SwapchainExtent; }
 		/// <returns>The Vulkan Image objects of this window's swapchain</returns>
-		[[nodiscard]] const auto& GetImages() const { return m_SwapchainImages; }
+		[[nodiscard]] const std::vector<vk::Image>& GetImages() const override { return m_SwapchainImages; }
 		/// <returns>The Vulkan ImageViews of this window's swapchain</returns>
-		[[nodiscard]] const auto& GetImageViews() const { return m_SwapchainImageViews; }
+		[[nodiscard]] const std::vector<vk::ImageView>& GetImageViews() const override { return m_SwapchainImageViews; }
 
+		/// <summary>
+		/// Acquires the next swapchain image.
+		/// </summary>
+		[[nodiscard]] std::optional<uint32_t> Acquire(vk::Semaphore imageReady) override;
+		/// <summary>
+		/// Presents a swapchain image to the window.
+		/// </summary>
+		bool Present(uint32_t image, vk::Semaphore renderFinished) override;
 		/// <summary>
 		/// Recreates the window's swapchain and ImageViews with the current size of the window.
-		/// Should only be called by the Renderer when presenting an image failed.
+		/// Should only be called by the Renderer when acquiring or presenting an image failed.
 		/// </summary>
-		void ResizeSwapchain();
+		void Recreate() override;
+		[[nodiscard]] bool UsesSemaphores() const override { return true; }
+		/// <summary>
+		/// Blocks until at most maxQueued presented images wait to be displayed. Does nothing without VK_KHR_present_wait.
+		/// </summary>
+		void WaitForPresentQueue(uint32_t maxQueued) override;
 
 		/// <summary>
 		/// Updates all Window Events.
 		/// </summary>
 		static void UpdateAll();
+		/// <summary>
+		/// Like UpdateAll(), but sleeps until an event arrives or the timeout elapsed.
+		/// </summary>
+		static void WaitEvents(double timeoutSeconds);
 
 	private:
+		/// <summary>
+		/// A swapchain replaced by Recreate(), which presents may still use.
+		/// </summary>
+		struct RetiredSwapchain {
+			vk::SwapchainKHR swapchain;
+			std::vector<vk::ImageView> views;
+			/// <summary>
+			/// Signaled by the presents to the swapchain, only with VK_EXT_swapchain_maintenance1.
+			/// </summary>
+			std::vector<vk::Fence> presentFences;
+		};
+
+		/// <summary>
+		/// Destroys retired swapchains once no present uses them anymore. Called after every present.
+		/// </summary>
+		/// <param name="presented">Whether the present to the current swapchain succeeded</param>
+		void ReleaseRetired(bool presented);
+		static void DestroyRetired(const RetiredSwapchain& retired);
+
 		GLFWwindow* m_Window;
 		vk::SurfaceKHR m_Surface;
 		vk::SwapchainKHR m_Swapchain;
@@ -75,6 +113,19 @@ namespace Graphics {
 		vk::Extent2D m_SwapchainExtent;
 		std::vector<vk::Image> m_SwapchainImages;
 		std::vector<vk::ImageView> m_SwapchainImageViews;
+		/// <summary>
+		/// Id of the last present, see VK_KHR_present_id.
+		/// </summary>
+		uint64_t m_PresentId;
+		/// <summary>
+		/// Fences of presents to m_Swapchain that may not have finished yet, only with VK_EXT_swapchain_maintenance1.
+		/// </summary>
+		std::vector<vk::Fence> m_PresentFences;
+		/// <summary>
+		/// Unsignaled fences to be used by the next presents.
+		/// </summary>
+		std::vector<vk::Fence> m_FreePresentFences;
+		std::vector<RetiredSwapchain> m_Retired;
 	};
 
 }
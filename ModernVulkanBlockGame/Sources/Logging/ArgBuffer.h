@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace Log::Detail {
+
+	/*
+	 * Log arguments are not formatted by the calling thread. Instead, their raw bytes are copied into an ArgBuffer,
+	 * each value preceded by a tag byte describing its type. The same encoding is used in the queue of the logging thread
+	 * and in binary log files, so a binary log stores exactly the bytes the caller produced.
+	 */
+
+	enum class ArgType : uint8_t {
+		Bool,
+		Char,
+		Int64,
+		UInt64,
+		Float,
+		Double,
+		/// <summary>
+		/// uint32_t length followed by the characters, without terminating zero.
+		/// </summary>
+		String,
+		Pointer,
+	};
+
+	/// <summary>
+	/// A growable byte buffer that only allocates once the arguments of a message don't fit into its inline storage.
+	/// </summary>
+	class ArgBuffer {
+	public:
+		static constexpr size_t INLINE_SIZE = 128;
+
+		ArgBuffer() = default;
+		ArgBuffer(const ArgBuffer&) = delete;
+		void operator=(const ArgBuffer&) = delete;
+		ArgBuffer(ArgBuffer&& r) noexcept { *this = std::move(r); }
+		ArgBuffer& operator=(ArgBuffer&& r) noexcept {
+			m_Heap = std::move(r.m_Heap);
+			m_Size = r.m_Size;
+			m_Capacity = r.m_Capacity;
+			if (!m_Heap)
+				memcpy(m_Inline, r.m_Inline, m_Size);
+			r.m_Size = 0;
+			r.m_Capacity = INLINE_SIZE;
+			return *this;
+		}
+
+		[[nodiscard]] const std::byte* Data() const { return m_Heap ? m_Heap.get() : m_Inline; }
+		[[nodiscard]] size_t Size() const { return m_Size; }
+
+		void Append(const void* data, size_t size) {
+			if (m_Size + size > m_Capacity)
+				Grow(m_Size + size);
+			memcpy((m_Heap ? m_Heap.get() : m_Inline) + m_Size, data, size);
+			m_Size += size;
+		}
+
+		template<typename T>
+		void Put(ArgType type, T value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			Append(&type, 1);
+			Append(&value, sizeof(T));
+		}
+
+		void PutString(std::string_view str) {
+			auto type = ArgType::String;
+			auto len = (uint32_t)str.size();
+			Append(&type, 1);
+			Append(&len, sizeof(len));
+			Append(str.data(), str.size());
+		}
+
+	private:
+		void Grow(size_t required) {
+			auto capacity = m_Capacity * 2;
+			while (capacity < required)
+				capacity *= 2;
+			auto heap = std::make_unique<std::byte[]>(capacity);
+			memcpy(heap.get(), Data(), m_Size);
+			m_Heap = std::move(heap);
+			m_Capacity = capacity;
+		}
+
+		std::byte m_Inline[INLINE_SIZE];
+		std::unique_ptr<std::byte[]> m_Heap;
+		size_t m_Size = 0;
+		size_t m_Capacity = INLINE_SIZE;
+	};
+
+	/// <summary>
+	/// Appends a single argument to the buffer. Types without a dedicated tag (e.g. Vulkan enums) are formatted to a string by the caller.
+	/// </summary>
+	/// <param name="formatFallback">Formats a value to a string, used for custom types</param>
+	template<typename T, typename FormatFn>
+	void Encode(ArgBuffer& buf, const T& arg, FormatFn&& formatFallback) {
+		using D = std::remove_cvref_t<T>;
+		if constexpr (std::is_same_v<D, bool>)
+			buf.Put(ArgType::Bool, arg);
+		else if constexpr (std::is_same_v<D, char>)
+			buf.Put(ArgType::Char, arg);
+		else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>)
+			buf.Put(ArgType::Int64, (int64_t)arg);
+		else if constexpr (std::is_integral_v<D>)
+			buf.Put(ArgType::UInt64, (uint64_t)arg);
+		else if constexpr (std::is_same_v<D, float>)
+			buf.Put(ArgType::Float, arg);
+		else if constexpr (std::is_floating_point_v<D>)
+			buf.Put(ArgType::Double, (double)arg);
+		else if constexpr (std::is_same_v<std::decay_t<D>, const char*> || std::is_same_v<std::decay_t<D>, char*>)
+			buf.PutString(arg ? std::string_view{ arg } : std::string_view{ "(null)" });
+		else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+			buf.PutString(std::string_view{ arg });
+		else if constexpr (std::is_pointer_v<D>)
+			buf.Put(ArgType::Pointer, (uint64_t)(uintptr_t)arg);
+		else
+			buf.PutString(formatFallback(arg));
+	}
+
+}
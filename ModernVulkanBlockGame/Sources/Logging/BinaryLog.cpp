@@ -0,0 +1,187 @@
+#include "BinaryLog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "LogFormat.h"
+
+namespace Log {
+
+	static constexpr char MAGIC[8] = { 'M', 'V', 'B', 'G', 'L', 'O', 'G', '1' };
+	static constexpr uint32_t VERSION = 1;
+
+	enum class RecordKind : uint8_t {
+		Site = 1,
+		Message = 2,
+	};
+
+	namespace Detail {
+
+		template<typename T>
+		static void Put(FILE* file, T value) {
+			fwrite(&value, sizeof(T), 1, file);
+		}
+
+		template<typename Length>
+		static void PutString(FILE* file, std::string_view str) {
+			auto len = (Length)std::min(str.size(), (size_t)std::numeric_limits<Length>::max());
+			Put(file, len);
+			fwrite(str.data(), 1, len, file);
+		}
+
+		bool BinaryLogWriter::Open(const std::string& path) {
+			m_File = fopen(path.c_str(), "wb");
+			if (!m_File)
+				return false;
+			fwrite(MAGIC, 1, sizeof(MAGIC), m_File);
+			Put(m_File, VERSION);
+			m_Sites.clear();
+			return true;
+		}
+
+		void BinaryLogWriter::Close() {
+			if (m_File)
+				fclose(m_File);
+			m_File = nullptr;
+		}
+
+		void BinaryLogWriter::Write(const Message& msg, int64_t timeNs, uint32_t thread) {
+			if (!m_File)
+				return;
+
+			SiteKey key{ msg.fmt, msg.loc.file_name(), msg.loc.line(), msg.level };
+			auto [it, inserted] = m_Sites.try_emplace(key, (uint32_t)m_Sites.size());
+			if (inserted) {
+				Put(m_File, RecordKind::Site);
+				Put(m_File, it->second);
+				Put(m_File, msg.level);
+				Put(m_File, (uint32_t)msg.loc.line());
+				PutString<uint16_t>(m_File, msg.loc.file_name());
+				PutString<uint16_t>(m_File, msg.fmt);
+			}
+
+			Put(m_File, RecordKind::Message);
+			Put(m_File, it->second);
+			Put(m_File, timeNs);
+			Put(m_File, thread);
+			Put(m_File, (uint32_t)msg.args.Size());
+			fwrite(msg.args.Data(), 1, msg.args.Size(), m_File);
+		}
+
+		void BinaryLogWriter::Flush() {
+			if (m_File)
+				fflush(m_File);
+		}
+
+	}
+
+	/// <summary>
+	/// Reads values from a file and remembers whether it ended prematurely.
+	/// </summary>
+	class Reader {
+	public:
+		explicit Reader(FILE* file) : m_File{file} { }
+
+		template<typename T>
+		T Get() {
+			T res{};
+			if (fread(&res, sizeof(T), 1, m_File) != 1)
+				m_Failed = true;
+			return res;
+		}
+
+		template<typename Length>
+		std::string GetString() {
+			std::string res(Get<Length>(), '\0');
+			if (!m_Failed && fread(res.data(), 1, res.size(), m_File) != res.size())
+				m_Failed = true;
+			return res;
+		}
+
+		[[nodiscard]] bool Failed() const { return m_Failed; }
+
+	private:
+		FILE* m_File;
+		bool m_Failed = false;
+	};
+
+	struct Site {
+		Level level;
+		uint32_t line;
+		std::string file;
+		std::string fmt;
+	};
+
+	bool DecodeBinaryLog(const std::string& path, std::FILE* out) {
+		std::unique_ptr<FILE, decltype(&fclose)> file{ fopen(path.c_str(), "rb"), &fclose };
+		if (!file) {
+			Error("Failed to open binary log {}", path);
+			return false;
+		}
+
+		Reader reader{ file.get() };
+		char magic[sizeof(MAGIC)];
+		if (fread(magic, 1, sizeof(magic), file.get()) != sizeof(magic) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+			Error("{} is not a binary log", path);
+			return false;
+		}
+		auto version = reader.Get<uint32_t>();
+		if (version != VERSION) {
+			Error("{} has unsupported version {}", path, version);
+			return false;
+		}
+
+		std::unordered_map<uint32_t, Site> sites;
+		std::vector<std::byte> args;
+		while (true) {
+			auto kind = reader.Get<RecordKind>();
+			// The file may end anywhere if the program crashed, we stop at the last complete record.
+			if (reader.Failed())
+				return true;
+
+			if (kind == RecordKind::Site) {
+				auto id = reader.Get<uint32_t>();
+				Site site;
+				site.level = reader.Get<Level>();
+				site.line = reader.Get<uint32_t>();
+				site.file = reader.GetString<uint16_t>();
+				site.fmt = reader.GetString<uint16_t>();
+				if (reader.Failed())
+					return true;
+				sites[id] = std::move(site);
+			} else if (kind == RecordKind::Message) {
+				auto id = reader.Get<uint32_t>();
+				auto timeNs = reader.Get<int64_t>();
+				auto thread = reader.Get<uint32_t>();
+				args.resize(reader.Get<uint32_t>());
+				if (reader.Failed() || fread(args.data(), 1, args.size(), file.get()) != args.size())
+					return true;
+
+				auto it = sites.find(id);
+				if (it == sites.end()) {
+					Error("{} references unknown site {}", path, id);
+					return false;
+				}
+				const auto& site = it->second;
+
+				std::string text;
+				try {
+					text = Detail::FormatArgs(site.fmt.c_str(), args.data(), args.size());
+				} catch (const std::exception& e) {
+					text = format("<invalid log format \"{}\": {}>", site.fmt, e.what());
+				}
+				auto line = Detail::FormatLine(site.level, timeNs, thread, text, site.file, site.line);
+				fwrite(line.data(), 1, line.size(), out);
+			} else {
+				Error("{} contains an unknown record type {}", path, (uint32_t)kind);
+				return false;
+			}
+		}
+	}
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "Log.h"
+
+namespace Log::Detail {
+
+	/*
+	 * Layout of a binary log file, all values little-endian:
+	 *   Header:  "MVBGLOG1", uint32_t version
+	 *   Site:    uint8_t 1, uint32_t id, uint8_t level, uint32_t line, uint16_t length + file name, uint16_t length + format string
+	 *   Message: uint8_t 2, uint32_t site id, int64_t time in ns since the Unix epoch, uint32_t thread, uint32_t length + ArgBuffer bytes
+	 * A site is written right before the first message that uses it.
+	 */
+
+	/// <summary>
+	/// Writes messages to a binary log file. Only used by the logging thread or with the output mutex held.
+	/// </summary>
+	class BinaryLogWriter {
+	public:
+		bool Open(const std::string& path);
+		void Close();
+		[[nodiscard]] bool IsOpen() const { return m_File; }
+
+		void Write(const Message& msg, int64_t timeNs, uint32_t thread);
+		void Flush();
+
+	private:
+		/// <summary>
+		/// Format strings and file names are string literals, so their addresses identify a call site.
+		/// </summary>
+		using SiteKey = std::tuple<const void*, const void*, uint32_t, Level>;
+
+		FILE* m_File = nullptr;
+		std::map<SiteKey, uint32_t> m_Sites;
+	};
+
+}
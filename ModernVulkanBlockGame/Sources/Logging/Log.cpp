@@ -0,0 +1,352 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "BinaryLog.h"
+#include "LogFormat.h"
+#include "Core/MemoryTracker.h"
+
+namespace Log {
+
+	/// <summary>
+	/// A message together with the information added when it was logged.
+	/// </summary>
+	struct Record {
+		Detail::Message msg;
+		std::chrono::system_clock::time_point time;
+		uint32_t thread;
+	};
+
+	/*
+	 * The queue is a bounded multi-producer queue as described by Dmitry Vyukov.
+	 * Every slot has a sequence number telling whether it is free for the producer of a certain position or filled for the consumer of that position.
+	 * Producers claim a position with a single compare-exchange and never wait for each other, except when the queue is full.
+	 */
+	struct Slot {
+		std::atomic<size_t> sequence;
+		Record record;
+	};
+
+	static std::unique_ptr<Slot[]> g_Slots;
+	static size_t g_Mask;
+	static std::atomic<size_t> g_EnqueuePos;
+	static std::atomic<size_t> g_DequeuePos;
+
+	static Config g_Config;
+	static std::thread g_Thread;
+	static std::atomic<bool> g_Running{ false };
+	/// <summary>
+	/// Incremented whenever a message was queued, the logging thread waits on it while the queue is empty.
+	/// </summary>
+	static std::atomic<uint32_t> g_Signal;
+	static std::atomic<uint64_t> g_Pushed;
+	static std::atomic<uint64_t> g_Written;
+	static std::atomic<uint64_t> g_Dropped;
+
+	/// <summary>
+	/// Protects the outputs, which are written by the logging thread, by threads logging synchronously and by the crash handler.
+	/// </summary>
+	static std::recursive_mutex g_OutputMutex;
+	static FILE* g_File;
+	static uint64_t g_FileSize;
+	static Detail::BinaryLogWriter g_BinaryFile;
+
+	static std::atomic<uint32_t> g_NextThreadId;
+	static thread_local uint32_t t_ThreadId = UINT32_MAX;
+
+	static uint32_t GetThreadId() {
+		if (t_ThreadId == UINT32_MAX)
+			t_ThreadId = g_NextThreadId.fetch_add(1, std::memory_order_relaxed);
+		return t_ThreadId;
+	}
+
+	static bool TryPush(Record& record) {
+		auto pos = g_EnqueuePos.load(std::memory_order_relaxed);
+		while (true) {
+			auto& slot = g_Slots[pos & g_Mask];
+			auto seq = slot.sequence.load(std::memory_order_acquire);
+			auto diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (g_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					slot.record = std::move(record);
+					slot.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				// The slot still holds the message from one round earlier, so the queue is full.
+				return false;
+			} else {
+				pos = g_EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	static bool TryPop(Record& record) {
+		auto pos = g_DequeuePos.load(std::memory_order_relaxed);
+		while (true) {
+			auto& slot = g_Slots[pos & g_Mask];
+			auto seq = slot.sequence.load(std::memory_order_acquire);
+			auto diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (g_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					record = std::move(slot.record);
+					slot.sequence.store(pos + g_Mask + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = g_DequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/// <summary>
+	/// Renames the log file to filePath.1, shifting older files up, and opens a new one.
+	/// </summary>
+	static void RotateFile() {
+		fclose(g_File);
+
+		std::error_code ec;
+		const auto& path = g_Config.filePath;
+		std::filesystem::remove(path + "." + std::to_string(g_Config.maxFiles), ec);
+		for (auto i = g_Config.maxFiles; i > 1; i--)
+			std::filesystem::rename(path + "." + std::to_string(i - 1), path + "." + std::to_string(i), ec);
+		if (g_Config.maxFiles > 0)
+			std::filesystem::rename(path, path + ".1", ec);
+
+		g_File = fopen(path.c_str(), "w");
+		g_FileSize = 0;
+	}
+
+	/// <summary>
+	/// Formats a record and writes it to every output.
+	/// </summary>
+	static void Write(const Record& record) {
+		const auto& msg = record.msg;
+		auto timeNs = (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(record.time.time_since_epoch()).count();
+
+		if (g_BinaryFile.IsOpen()) {
+			std::lock_guard lock{ g_OutputMutex };
+			g_BinaryFile.Write(msg, timeNs, record.thread);
+			// The binary log exists so messages don't need to be formatted, so we skip that unless there is a text output.
+			if (!g_Config.console && !g_File)
+				return;
+		}
+
+		std::string text;
+		try {
+			text = Detail::FormatArgs(msg.fmt, msg.args.Data(), msg.args.Size());
+		} catch (const std::exception& e) {
+			// A broken format string must not take down the logging thread.
+			text = format("<invalid log format \"{}\": {}>", msg.fmt, e.what());
+		}
+
+		const char* color = "";
+		switch (msg.level) {
+		case Level::Info: break;
+		case Level::Warning: color = "\033[33m"; break;
+		case Level::Error: color = "\033[31m"; break;
+		}
+
+		auto line = Detail::FormatLine(msg.level, timeNs, record.thread, text, msg.loc.file_name(), msg.loc.line());
+
+		std::lock_guard lock{ g_OutputMutex };
+		if (g_Config.console) {
+			// Colors only make sense on a terminal, not in the log file.
+			if (*color) {
+				fputs(color, stdout);
+				fwrite(line.data(), 1, line.size(), stdout);
+				fputs("\033[0m", stdout);
+			} else {
+				fwrite(line.data(), 1, line.size(), stdout);
+			}
+		}
+		if (g_File) {
+			fwrite(line.data(), 1, line.size(), g_File);
+			g_FileSize += line.size();
+			if (g_FileSize > g_Config.maxFileSize)
+				RotateFile();
+		}
+	}
+
+	static void FlushOutputs() {
+		std::lock_guard lock{ g_OutputMutex };
+		fflush(stdout);
+		if (g_File)
+			fflush(g_File);
+		g_BinaryFile.Flush();
+	}
+
+	/// <summary>
+	/// Writes every message currently in the queue.
+	/// </summary>
+	/// <returns>The number of messages written</returns>
+	static uint64_t Drain() {
+		uint64_t count = 0;
+		Record record;
+		while (TryPop(record)) {
+			Write(record);
+			count++;
+		}
+		return count;
+	}
+
+	static void ThreadMain() {
+		while (true) {
+			auto signal = g_Signal.load(std::memory_order_acquire);
+			auto running = g_Running.load(std::memory_order_acquire);
+
+			auto count = Drain();
+			if (count > 0) {
+				FlushOutputs();
+				g_Written.fetch_add(count, std::memory_order_release);
+				g_Written.notify_all();
+				continue;
+			}
+
+			if (!running)
+				return;
+			// Sleep until a new message was queued. If one was queued since we loaded the signal, this returns immediately.
+			g_Signal.wait(signal, std::memory_order_acquire);
+		}
+	}
+
+	/*
+	 * When the program crashes, the messages explaining why are probably still in the queue. The crash handlers write them synchronously
+	 * before the program terminates. This is not async-signal-safe, but we are going down anyways, so it's worth a try.
+	 */
+	static void OnSignal(int sig) {
+		if (g_Slots) {
+			Drain();
+			FlushOutputs();
+		}
+		std::signal(sig, SIG_DFL);
+		std::raise(sig);
+	}
+
+	static std::terminate_handler g_PrevTerminateHandler;
+	static void OnTerminate() {
+		if (g_Slots) {
+			Drain();
+			FlushOutputs();
+		}
+		if (g_PrevTerminateHandler)
+			g_PrevTerminateHandler();
+		std::abort();
+	}
+
+	void Initialize(const Config& config) {
+		g_Config = config;
+
+		if (!g_Config.filePath.empty()) {
+			g_File = fopen(g_Config.filePath.c_str(), "w");
+			g_FileSize = 0;
+			if (!g_File)
+				Warning("Failed to open log file {}", g_Config.filePath);
+		}
+		if (!g_Config.binaryFilePath.empty() && !g_BinaryFile.Open(g_Config.binaryFilePath))
+			Warning("Failed to open binary log file {}", g_Config.binaryFilePath);
+
+		size_t size = 1;
+		while (size < std::max(g_Config.queueSize, 2u))
+			size *= 2;
+		g_Mask = size - 1;
+		g_Slots = std::make_unique<Slot[]>(size);
+		Core::MemoryTracker::RecordAlloc(Core::MemoryTag::Logging, Core::MemoryDomain::Cpu, size * sizeof(Slot));
+		for (size_t i = 0; i < size; i++)
+			g_Slots[i].sequence.store(i, std::memory_order_relaxed);
+		g_EnqueuePos = 0;
+		g_DequeuePos = 0;
+
+		g_Running = true;
+		g_Thread = std::thread{ ThreadMain };
+
+		for (auto sig : { SIGSEGV, SIGABRT, SIGFPE, SIGILL })
+			std::signal(sig, OnSignal);
+		g_PrevTerminateHandler = std::set_terminate(OnTerminate);
+	}
+
+	void Shutdown() {
+		// Every thread that logs must have stopped, otherwise a message could be queued after the final Drain() below.
+		if (!g_Running)
+			return;
+
+		g_Running.store(false, std::memory_order_release);
+		g_Signal.fetch_add(1, std::memory_order_release);
+		g_Signal.notify_one();
+		g_Thread.join();
+
+		// Messages that were queued while the thread shut down.
+		Drain();
+
+		auto dropped = g_Dropped.load();
+		g_Slots.reset();
+		Core::MemoryTracker::RecordFree(Core::MemoryTag::Logging, Core::MemoryDomain::Cpu, (g_Mask + 1) * sizeof(Slot));
+		if (dropped > 0)
+			Warning("{} log messages were dropped since the log queue was full", dropped);
+
+		FlushOutputs();
+		if (g_File)
+			fclose(g_File);
+		g_File = nullptr;
+		g_BinaryFile.Close();
+	}
+
+	void Flush() {
+		if (!g_Running) {
+			FlushOutputs();
+			return;
+		}
+
+		// Every message pushed so far has been written once the written counter reached the current push counter.
+		auto target = g_Pushed.load(std::memory_order_acquire);
+		auto written = g_Written.load(std::memory_order_acquire);
+		while (written < target) {
+			g_Written.wait(written, std::memory_order_acquire);
+			written = g_Written.load(std::memory_order_acquire);
+		}
+	}
+
+	uint64_t GetDroppedCount() {
+		return g_Dropped.load(std::memory_order_relaxed);
+	}
+
+	namespace Detail {
+		void Submit(Message&& msg) {
+			Record record{ std::move(msg), std::chrono::system_clock::now(), GetThreadId() };
+
+			if (!g_Running.load(std::memory_order_acquire) || !g_Slots) {
+				// Without a logging thread, we write the message ourselves.
+				Write(record);
+				FlushOutputs();
+				return;
+			}
+
+			while (!TryPush(record)) {
+				if (g_Config.overflowPolicy == OverflowPolicy::Drop) {
+					g_Dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				// Make sure the logging thread is awake and give it time to make room.
+				g_Signal.fetch_add(1, std::memory_order_release);
+				g_Signal.notify_one();
+				std::this_thread::yield();
+			}
+
+			g_Pushed.fetch_add(1, std::memory_order_release);
+			g_Signal.fetch_add(1, std::memory_order_release);
+			g_Signal.notify_one();
+		}
+	}
+
+}
@@ -1,15 +1,20 @@
 #pragma once
 
+#include <cstdint>
+#include <cstdio>
 #include <source_location>
-#include <iostream>
+#include <string>
 
 #ifdef __linux__
 // Since neither g++11 nor any clang version supports std::format, we need to use an external library
 #include <fmt/format.h>
+#include <fmt/args.h>
 #else
 #include <format>
 #endif
 
+#include "ArgBuffer.h"
+
 namespace Log {
 
 #ifdef __linux__
@@ -44,6 +49,118 @@ namespace Log {
 		{ }
 	};
 
+	enum class Level : uint8_t {
+		Info,
+		Warning,
+		Error,
+	};
+
+	/// <summary>
+	/// What happens to a message when the queue of the logging thread is full.
+	/// </summary>
+	enum class OverflowPolicy {
+		/// <summary>
+		/// The message is dropped and counted, the caller never waits.
+		/// </summary>
+		Drop,
+		/// <summary>
+		/// The caller waits until the logging thread made room.
+		/// </summary>
+		Block,
+	};
+
+	struct Config {
+		/// <summary>
+		/// Write messages to stdout.
+		/// </summary>
+		bool console = true;
+		/// <summary>
+		/// Additionally write messages to this file, if not empty.
+		/// </summary>
+		std::string filePath;
+		/// <summary>
+		/// When the log file grows larger than this, it is renamed to filePath.1 (the previous one to filePath.2 etc.) and a new file is started.
+		/// </summary>
+		uint64_t maxFileSize = 8 * 1024 * 1024;
+		/// <summary>
+		/// Number of rotated files that are kept in addition to the current one.
+		/// </summary>
+		uint32_t maxFiles = 3;
+		/// <summary>
+		/// Number of messages the queue can hold, rounded up to a power of two.
+		/// </summary>
+		uint32_t queueSize = 4096;
+		OverflowPolicy overflowPolicy = OverflowPolicy::Drop;
+		/// <summary>
+		/// Additionally write messages to this file in the binary format, if not empty. See DecodeBinaryLog().
+		/// </summary>
+		std::string binaryFilePath;
+	};
+
+	/*
+	 * Writing to a terminal can take milliseconds, and std::cout serializes every thread writing to it.
+	 * Therefore the calling thread only copies the raw bytes of the arguments of a message into a lock-free queue. A background thread takes them out,
+	 * formats them, adds a timestamp and writes them to stdout and/or a log file.
+	 * Until Initialize() is called (and after Shutdown()), messages are written synchronously by the calling thread.
+	 *
+	 * The binary log skips formatting entirely: every format string and source location is written once,
+	 * after that a message only consists of its id, timestamp, thread and the argument bytes. DecodeBinaryLog() turns it back into text.
+	 */
+
+	/// <summary>
+	/// Starts the logging thread. Also installs handlers that write every queued message when the program crashes.
+	/// </summary>
+	void Initialize(const Config& config);
+	/// <summary>
+	/// Writes every queued message and stops the logging thread.
+	/// </summary>
+	void Shutdown();
+	/// <summary>
+	/// Blocks until every message logged before this call was written.
+	/// </summary>
+	void Flush();
+	/// <returns>The number of messages that were dropped since the queue was full</returns>
+	[[nodiscard]] uint64_t GetDroppedCount();
+
+	/// <summary>
+	/// Formats every message of a binary log file like the text log does and writes them to out.
+	/// </summary>
+	/// <returns>False if the file could not be read or is corrupted</returns>
+	bool DecodeBinaryLog(const std::string& path, std::FILE* out);
+
+	namespace Detail {
+		/// <summary>
+		/// A message that was not formatted yet.
+		/// </summary>
+		struct Message {
+			Level level;
+			std::source_location loc;
+			const char* fmt;
+			/// <summary>
+			/// The encoded formatting arguments. Strings are copied as well, so the message doesn't refer to the caller's data.
+			/// </summary>
+			ArgBuffer args;
+		};
+
+		/// <summary>
+		/// Queues a message for the logging thread.
+		/// </summary>
+		void Submit(Message&& msg);
+
+		template<typename... Args>
+		void Log(Level level, const FormatWithSourceLoc& fmt, Args&... args) {
+			Message msg{ level, fmt.loc, fmt.fmt, {} };
+#ifdef __linux__
+			(Encode(msg.args, args, [](const auto& v) { return format("{}", v); }), ...);
+#else
+			// std::format has no dynamic argument store the logging thread could format the decoded arguments with, so the caller formats the message.
+			msg.fmt = "{}";
+			msg.args.PutString(std::vformat(fmt.fmt, std::make_format_args(args...)));
+#endif
+			Submit(std::move(msg));
+		}
+	}
+
 	/// <summary>
 	/// Log an Info Message
 	/// </summary>
@@ -51,10 +168,8 @@ namespace Log {
 	/// <param name="...args">Formatting arguments</param>
 	template<Printable... Args>
 	void Info(const FormatWithSourceLoc fmt, Args&&... args) {
-		if /*consteval*/ (ENABLE_INFO_LOG) {
-			auto msg = format(fmt.fmt, args...);
-			std::cout << "[INFO ] " << msg << "\n    at " << fmt.loc.file_name() << ":" << fmt.loc.line() << "\n";
-		}
+		if /*consteval*/ (ENABLE_INFO_LOG)
+			Detail::Log(Level::Info, fmt, args...);
 	}
 
 	/// <summary>
@@ -64,8 +179,7 @@ namespace Log {
 	/// <param name="...args">Formatting arguments</param>
 	template<Printable... Args>
 	void Warning(const FormatWithSourceLoc fmt, Args&&... args) {
-		auto msg = format(fmt.fmt, args...);
-		std::cout << "\033[33m[WARN ] " << msg << "\n    at " << fmt.loc.file_name() << ":" << fmt.loc.line() << "\n\033[0m";
+		Detail::Log(Level::Warning, fmt, args...);
 	}
 
 	/// <summary>
@@ -75,8 +189,7 @@ namespace Log {
 	/// <param name="...args">Formatting arguments</param>
 	template<Printable... Args>
 	void Error(const FormatWithSourceLoc fmt, Args&&... args) {
-		auto msg = format(fmt.fmt, args...);
-		std::cout << "\033[31m[ERROR] " << msg << "\n    at " << fmt.loc.file_name() << ":" << fmt.loc.line() << "\n\033[0m";
+		Detail::Log(Level::Error, fmt, args...);
 	}
-	
+
 }
@@ -0,0 +1,113 @@
+#include "LogFormat.h"
+
+#include <ctime>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+
+#include "ArgBuffer.h"
+
+namespace Log::Detail {
+
+	using Value = std::variant<bool, char, int64_t, uint64_t, float, double, std::string_view, const void*>;
+
+	/// <summary>
+	/// Reads a value of type T and advances the read position.
+	/// </summary>
+	template<typename T>
+	static T Read(const std::byte*& data, const std::byte* end) {
+		if (end - data < (ptrdiff_t)sizeof(T))
+			throw std::runtime_error{ "truncated argument" };
+		T res;
+		memcpy(&res, data, sizeof(T));
+		data += sizeof(T);
+		return res;
+	}
+
+	static std::vector<Value> Decode(const std::byte* data, size_t size) {
+		std::vector<Value> res;
+		const auto* end = data + size;
+		while (data < end) {
+			switch (Read<ArgType>(data, end)) {
+			case ArgType::Bool: res.emplace_back(Read<bool>(data, end)); break;
+			case ArgType::Char: res.emplace_back(Read<char>(data, end)); break;
+			case ArgType::Int64: res.emplace_back(Read<int64_t>(data, end)); break;
+			case ArgType::UInt64: res.emplace_back(Read<uint64_t>(data, end)); break;
+			case ArgType::Float: res.emplace_back(Read<float>(data, end)); break;
+			case ArgType::Double: res.emplace_back(Read<double>(data, end)); break;
+			case ArgType::Pointer: res.emplace_back((const void*)(uintptr_t)Read<uint64_t>(data, end)); break;
+			case ArgType::String: {
+				auto len = Read<uint32_t>(data, end);
+				if ((size_t)(end - data) < len)
+					throw std::runtime_error{ "truncated string argument" };
+				res.emplace_back(std::string_view{ (const char*)data, len });
+				data += len;
+				break;
+			}
+			default:
+				throw std::runtime_error{ "unknown argument type" };
+			}
+		}
+		return res;
+	}
+
+	std::string FormatArgs(const char* fmt, const std::byte* data, size_t size) {
+		auto values = Decode(data, size);
+
+#ifdef __linux__
+		fmt::dynamic_format_arg_store<fmt::format_context> store;
+		store.reserve(values.size(), 0);
+		for (const auto& v : values)
+			std::visit([&store](const auto& x) { store.push_back(x); }, v);
+		return fmt::vformat(fmt, store);
+#else
+		/*
+		 * std::format has no dynamic argument store, so we substitute every replacement field with the default formatting of its argument.
+		 * Format specifications are ignored. Messages logged on these platforms are formatted by the caller anyways (see Detail::Log()),
+		 * so this only matters when decoding a binary log written on Linux.
+		 */
+		std::string res;
+		size_t next = 0;
+		for (const char* c = fmt; *c; c++) {
+			if (c[0] == '{' && c[1] == '{') {
+				res += '{';
+				c++;
+			} else if (c[0] == '}' && c[1] == '}') {
+				res += '}';
+				c++;
+			} else if (*c == '{') {
+				while (*c && *c != '}')
+					c++;
+				if (!*c || next >= values.size())
+					throw std::runtime_error{ "argument not found" };
+				res += std::visit([](const auto& x) { return std::format("{}", x); }, values[next++]);
+			} else {
+				res += *c;
+			}
+		}
+		return res;
+#endif
+	}
+
+	std::string FormatLine(Level level, int64_t timeNs, uint32_t thread, std::string_view text, std::string_view file, uint32_t line) {
+		auto time = (std::time_t)(timeNs / 1'000'000'000);
+		std::tm tm;
+#ifdef _WIN32
+		localtime_s(&tm, &time);
+#else
+		localtime_r(&time, &tm);
+#endif
+		auto ms = (timeNs / 1'000'000) % 1000;
+
+		const char* prefix = "";
+		switch (level) {
+		case Level::Info: prefix = "[INFO ]"; break;
+		case Level::Warning: prefix = "[WARN ]"; break;
+		case Level::Error: prefix = "[ERROR]"; break;
+		}
+
+		return format("[{:02}:{:02}:{:02}.{:03}] {} [T{}] {}\n    at {}:{}\n",
+			tm.tm_hour, tm.tm_min, tm.tm_sec, ms, prefix, thread, text, file, line);
+	}
+
+}
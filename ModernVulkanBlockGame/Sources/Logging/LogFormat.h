@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "Log.h"
+
+namespace Log::Detail {
+
+	/// <summary>
+	/// Formats a message from arguments encoded by an ArgBuffer.
+	/// </summary>
+	/// <remarks>Throws if the arguments are malformed or don't match the format string.</remarks>
+	[[nodiscard]] std::string FormatArgs(const char* fmt, const std::byte* data, size_t size);
+
+	/// <summary>
+	/// Builds a complete log line, e.g. "[12:34:56.789] [WARN ] [T2] message\n    at file.cpp:42\n".
+	/// </summary>
+	/// <param name="timeNs">Wall clock time of the message in nanoseconds since the Unix epoch</param>
+	[[nodiscard]] std::string FormatLine(Level level, int64_t timeNs, uint32_t thread, std::string_view text, std::string_view file, uint32_t line);
+
+}
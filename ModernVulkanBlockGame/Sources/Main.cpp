@@ -1,34 +1,303 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "Logging/Log.h"
+#include "Core/CommandLine.h"
+#include "Core/FixedTimestep.h"
+#include "Core/FrameArena.h"
+#include "Core/FrameStats.h"
+#include "Core/IoService.h"
+#include "Core/JobSystem.h"
+#include "Core/MemoryTracker.h"
+#include "Core/SlabPool.h"
+#include "Core/TaskGraph.h"
+#include "Core/Trace.h"
+#include "Game/ChunkStreaming.h"
+#include "Game/Journal.h"
+#include "Game/RegionStore.h"
+#include "Game/Simulation.h"
+#include "Game/TerrainGenerator.h"
+#include "Graphics/DeletionQueue.h"
+#include "Graphics/FrameCapture.h"
+#include "Graphics/FramePacing.h"
+#include "Graphics/GpuProfiler.h"
 #include "Graphics/Manager.h"
+#include "Graphics/OffscreenTarget.h"
+#include "Graphics/PipelineCompiler.h"
 #include "Graphics/Renderer.h"
 #include "Graphics/Window.h"
 
-int main() {
-	Log::Info("Initializing Graphics System");
-	if(!Graphics::Manager::Initialize()) {
-		Log::Error("Failed to initialize Graphics System, exiting");
+int main(int argc, char** argv) {
+	Core::CommandLine::Parse(argc, argv);
+
+	// Decoding a binary log doesn't need the engine at all.
+	if (auto path = Core::CommandLine::GetString("--decode-log"); !path.empty())
+		return Log::DecodeBinaryLog(path, stdout) ? 0 : 1;
+
+	Log::Config logConfig{};
+	logConfig.filePath = Core::CommandLine::GetString("--log-file");
+	logConfig.binaryFilePath = Core::CommandLine::GetString("--log-binary");
+	logConfig.overflowPolicy = Core::CommandLine::HasOption("--log-block") ? Log::OverflowPolicy::Block : Log::OverflowPolicy::Drop;
+	Log::Initialize(logConfig);
+
+	Core::Trace::SetThreadName("Main");
+	Core::SlabPool::SetHugePages(Core::CommandLine::HasOption("--huge-pages"));
+	Core::JobSystem::Initialize();
+	Core::IoService::Initialize();
+	Game::TerrainGenerator::Initialize();
+
+	// Benchmarking the terrain generator doesn't need the rest of the engine either.
+	if (auto benchChunks = Core::CommandLine::GetInt("--bench-terrain", 0); benchChunks > 0) {
+		Game::TerrainGenerator::RunBenchmark((uint32_t)benchChunks);
+		Game::TerrainGenerator::Terminate();
+		Core::IoService::Terminate();
+		Core::JobSystem::Terminate();
+		Log::Shutdown();
+		return 0;
+	}
+
+	Graphics::FramePacing::Initialize();
+	Game::Simulation::Initialize();
+	Game::ChunkStreaming::Initialize();
+	Game::ChunkStreaming::SetGenerator(Game::TerrainGenerator::Generate);
+	// Without a world directory, nothing is saved and every chunk is generated.
+	if (auto worldPath = Core::CommandLine::GetString("--world"); !worldPath.empty() && Game::RegionStore::Initialize(worldPath)) {
+		// Edits are journaled, so they are durable long before their chunks are saved. Checkpoints save them and shorten the journal.
+		if (Game::Journal::Initialize(worldPath, Game::TerrainGenerator::Generate)) {
+			// A chunk that can't be read is generated, and replaces the damaged one once it is saved.
+			Game::ChunkStreaming::SetLoader([](Game::Chunk& chunk, std::function<void(bool loaded)> done) {
+				Game::RegionStore::Load(chunk, [done = std::move(done)](Game::RegionStore::LoadResult result) { done(result == Game::RegionStore::LoadResult::Loaded); });
+			});
+			Game::ChunkStreaming::SetSaver(Game::RegionStore::Save);
+			Game::Journal::SetCheckpointer(Game::ChunkStreaming::Autosave);
+			Game::ChunkStreaming::SetEditLog(Game::Journal::Record);
+			Game::ChunkStreaming::SetDurabilityCheck(Game::Journal::AreSavesDurable);
+		} else {
+			// The journal that couldn't be replayed is kept. Replaying it later would revert edits saved from now on, so the world is left untouched.
+			Log::Error("The world in {} can't be opened, nothing is loaded or saved", worldPath);
+			Game::RegionStore::Terminate();
+		}
+	}
+
+	// In headless mode, frames are rendered to offscreen images instead of a window, e.g. for benchmarks on machines without a display.
+	bool headless = Core::CommandLine::HasOption("--headless");
+	Graphics::Window wnd;
+	Graphics::OffscreenTarget offscreen;
+
+	/*
+	 * Most initialization steps only depend on the Vulkan device, but not on each other.
+	 * Therefore startup is described as a graph of tasks, which allows e.g. shader loading, pipeline compilation and vertex uploads
+	 * to run on worker threads while the main thread creates the window and swapchain.
+	 * GLFW requires most of its functions to be called from the main thread, so those tasks are bound to it.
+	 */
+	Core::TaskGraph startup;
+	auto shaders = startup.Add("Load Shaders", [] {
+		Graphics::PipelineCompiler::Preload("Assets/Shaders/triangle");
+		return true;
+	});
+	auto manager = startup.Add("Graphics System", [headless] {
+		Log::Info("Initializing Graphics System");
+		return Graphics::Manager::Initialize(headless);
+	}, {}, true);
+	startup.Add("Renderer Frame Resources", [] {
+		Graphics::Renderer::InitializeFrameResources();
+		return true;
+	}, { manager });
+	startup.Add("Renderer Geometry", [] {
+		Graphics::Renderer::InitializeGeometry();
+		return true;
+	}, { manager });
+	Core::TaskGraph::TaskId targetTask;
+	if(headless) {
+		targetTask = startup.Add("Offscreen Target", [&offscreen] {
+			offscreen = Graphics::OffscreenTarget{ { 800, 600 }, vk::Format::eB8G8R8A8Srgb, Graphics::FramePacing::GetConfig().framesInFlight };
+			return true;
+		}, { manager });
+	} else {
+		targetTask = startup.Add("Window", [&wnd] {
+			Log::Info("Creating window");
+			wnd = Graphics::Window{ 800, 600, "Modern Vulkan Block Game" };
+			return wnd.IsValid();
+		}, { manager }, true);
+	}
+	Graphics::RenderTarget& target = headless ? static_cast<Graphics::RenderTarget&>(offscreen) : wnd;
+	// The RenderPasses are created for the format of the target's images, which the window only knows once it chose its swapchain format.
+	startup.Add("Renderer Pipelines", [&target] {
+		Graphics::Renderer::InitializePipelines(target.GetFormat());
+		return true;
+	}, { manager, shaders, targetTask });
+
+	if(!startup.Run()) {
+		startup.PrintReport();
+		Log::Error("Failed to initialize, exiting");
+		Core::IoService::Terminate();
+		Core::JobSystem::Terminate();
+		Log::Shutdown();
 		return 1;
 	}
 
-	Log::Info("Initializing Renderer");
-	Graphics::Renderer::Initialize();
+	// In benchmark mode, a fixed number of frames is rendered, after which the frame statistics are written and the game exits.
+	// Without a window that could be closed, a headless run renders a single frame unless told otherwise.
+	auto benchFrames = Core::CommandLine::GetInt("--bench-frames", headless ? 1 : 0);
+	auto benchOut = Core::CommandLine::GetString("--bench-out");
+	int64_t frames = 0;
+
+	// Renders a single frame and keeps track of startup, statistics and the benchmark. Returns false once the requested number of frames was rendered.
+	bool firstFrame = true;
+	auto renderFrame = [&] {
+		TRACE_ZONE("Frame");
+		auto frameStart = std::chrono::steady_clock::now();
+		Graphics::Renderer::RenderFrame(target);
+		Core::FrameStats::Record(Core::FrameStats::Metric::CpuFrame,
+			(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - frameStart).count());
+
+		if(firstFrame) {
+			firstFrame = false;
+
+			// The time to the first frame is the startup metric the user actually notices.
+			startup.AddMilestone("First Frame");
+			startup.PrintReport();
+			auto reportPath = Core::CommandLine::GetString("--startup-report");
+			if(!reportPath.empty())
+				startup.WriteJsonReport(reportPath);
+
+			// The first frame waits for startup work (e.g. pipeline compilation), which would skew the statistics.
+			Core::FrameStats::Reset();
+
+			// Captures start with the frame after it, whose contents only depend on the frame number in headless mode.
+			auto screenshotPath = Core::CommandLine::GetString("--screenshot");
+			if(!screenshotPath.empty())
+				Graphics::FrameCapture::RequestScreenshot(screenshotPath);
+			auto recordDirectory = Core::CommandLine::GetString("--record");
+			if(!recordDirectory.empty()) {
+				auto format = Core::CommandLine::GetString("--record-format") == "png" ? Graphics::FrameCapture::Format::Png : Graphics::FrameCapture::Format::Raw;
+				Graphics::FrameCapture::StartRecording(recordDirectory, format);
+			}
+			return true;
+		}
+		frames++;
+		return benchFrames <= 0 || frames < benchFrames;
+	};
 
-	Log::Info("Creating window");
-	Graphics::Window wnd{ 800, 600, "Modern Vulkan Block Game" };
+	/*
+	 * The simulation runs at a fixed tick rate on the main thread, independent of how fast frames are rendered.
+	 * After running the ticks that are due, the state of the last two ticks is handed to the Renderer, which interpolates between them.
+	 */
+	Core::FixedTimestep simClock{
+		(double)std::max<int64_t>(Core::CommandLine::GetInt("--tick-rate", 60), 1),
+		(uint32_t)std::max<int64_t>(Core::CommandLine::GetInt("--max-catch-up-ticks", 5), 1)
+	};
+	Graphics::FramePacket packet{};
+	packet.previousTransforms = Game::Simulation::GetPreviousTransforms();
+	packet.currentTransforms = Game::Simulation::GetCurrentTransforms();
+	uint64_t packetSequence = 1;
+	auto updateSimulation = [&](Core::FixedTimestep::Duration elapsed, std::chrono::steady_clock::time_point inputTime) {
+		auto ticks = simClock.Advance(elapsed);
+		for(uint32_t i = 0; i < ticks; i++) {
+			TRACE_ZONE("Simulation Tick");
+			auto tickStart = std::chrono::steady_clock::now();
+			Game::Simulation::Tick(simClock.GetTickSeconds());
+			Core::FrameStats::Record(Core::FrameStats::Metric::SimulationTick,
+				(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tickStart).count());
+		}
+		// Without a tick, the transforms didn't change and only alpha moves on.
+		if(ticks > 0) {
+			// Streaming runs once per update instead of once per tick, so catching up on ticks doesn't multiply its work.
+			auto streamingStart = std::chrono::steady_clock::now();
+			Game::ChunkStreaming::Update(Game::Simulation::GetViewPosition(), Game::Simulation::GetViewDirection());
+			Game::Journal::Update();
+			Core::FrameStats::Record(Core::FrameStats::Metric::StreamingUpdate,
+				(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - streamingStart).count());
 
-	while(!wnd.Closed()) {
-		Graphics::Window::UpdateAll();
-		Graphics::Renderer::RenderFrame(wnd);
+			packet.previousTransforms = Game::Simulation::GetPreviousTransforms();
+			packet.currentTransforms = Game::Simulation::GetCurrentTransforms();
+		}
+		packet.sequence = packetSequence++;
+		packet.time = simClock.GetTime();
+		packet.alpha = simClock.GetAlpha();
+		packet.inputTime = inputTime;
+		Graphics::Renderer::SubmitPacket(packet);
+	};
+
+	if(headless) {
+		// Headless runs are used for image comparisons, so their animation must not depend on how fast frames are rendered.
+		// Every frame after the first advances the simulation by exactly 1/60 s. Without input, there is no need for a separate render thread either.
+		auto frameDuration = std::chrono::duration_cast<Core::FixedTimestep::Duration>(std::chrono::duration<double>(1.0 / 60.0));
+		do {
+			updateSimulation(packetSequence == 1 ? Core::FixedTimestep::Duration{0} : frameDuration, std::chrono::steady_clock::now());
+		} while(renderFrame());
+	} else {
+		/*
+		 * Rendering runs on its own thread, so a slow frame never delays event handling. The main thread handles input and hands the
+		 * newest state to the Renderer as a FramePacket, which the render thread only picks up right before recording a frame.
+		 * This way a frame shows input that is at most about a millisecond old, instead of input polled before waiting for the GPU.
+		 */
+		std::atomic<bool> quit{ false };
+		std::thread renderThread{ [&] {
+			Core::Trace::SetThreadName("Render");
+			while(!quit.load(std::memory_order_acquire) && renderFrame()) { }
+			quit.store(true, std::memory_order_release);
+		} };
+
+		auto lastTime = std::chrono::steady_clock::now();
+		while(!quit.load(std::memory_order_acquire) && !wnd.Closed()) {
+			{
+				TRACE_ZONE("Window::WaitEvents");
+				// Wakes up at least every millisecond, which is how often the packet (and therefore the input) is refreshed.
+				Graphics::Window::WaitEvents(0.001);
+			}
+			auto now = std::chrono::steady_clock::now();
+			updateSimulation(now - lastTime, now);
+			lastTime = now;
+		}
+		quit.store(true, std::memory_order_release);
+		renderThread.join();
 	}
+	if(simClock.GetDroppedTime().count() > 0)
+		Log::Warning("The simulation couldn't keep up and skipped {:.1f} ms", std::chrono::duration<double, std::milli>(simClock.GetDroppedTime()).count());
 
 	Graphics::Manager::WaitIdle();
+	Graphics::GpuProfiler::PrintReport();
+	Core::FrameStats::PrintReport();
+	Game::ChunkStreaming::PrintReport();
+	Game::TerrainGenerator::PrintReport();
+	Core::SlabPool::PrintReport();
+	Core::FrameArena::PrintReport();
+	Core::MemoryTracker::PrintReport();
+	Graphics::Manager::PrintMemoryBudgets();
+	if(!benchOut.empty())
+		Core::FrameStats::WriteJsonReport(benchOut);
+	// Retired swapchains must be destroyed before the surface of their window.
+	Graphics::DeletionQueue::Flush();
 
 	Log::Info("Destroying Window");
 	wnd.Destroy();
+	offscreen.Destroy();
 
 	Log::Info("Terminating Renderer");
 	Graphics::Renderer::Terminate();
 
 	Log::Info("Terminating Graphics System");
 	Graphics::Manager::Terminate();
+
+	Game::ChunkStreaming::Terminate();
+	// Terminating streaming saved the remaining chunks, so only now the stats are complete, and the journal is obsolete.
+	Game::Journal::Terminate();
+	Game::Journal::PrintReport();
+	Game::RegionStore::Terminate();
+	Game::RegionStore::PrintReport();
+	Core::IoService::Terminate();
+	Core::IoService::PrintReport();
+	Game::TerrainGenerator::Terminate();
+	Game::Simulation::Terminate();
+	Core::JobSystem::Terminate();
+
+	// Every thread is finished at this point, so the trace is complete.
+	auto tracePath = Core::CommandLine::GetString("--trace");
+	if(!tracePath.empty())
+		Core::Trace::WriteChromeTrace(tracePath);
+
+	Log::Shutdown();
 }
@@ -3,8 +3,11 @@
 #include "vec2.h"
 #include "vec3.h"
 #include "vec4.h"
+#include "ivec3.h"
+#include "Morton.h"
 #include "Quaternion.h"
 #include "mat4.h"
+#include "Transform.h"
 
 constexpr float PI = 3.14159265358979323846f;
 
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "ivec3.h"
+
+/*
+ * Morton (Z-order) codes interleave the bits of the three coordinates: bit i of x goes to bit 3i, of y to 3i + 1 and of z to 3i + 2.
+ * Sorting by the code walks space along a recursive Z curve, so coordinates close to each other mostly end up close in the order,
+ * unlike x-major order where the neighbor above is a whole row away.
+ * Every axis gets 21 bits, coordinates range from -2^20 to 2^20 - 1.
+ */
+namespace Morton {
+
+	inline constexpr uint32_t BITS = 21;
+	inline constexpr int32_t BIAS = 1 << (BITS - 1);
+	inline constexpr uint64_t X_MASK = 0x1249249249249249ull;
+	inline constexpr uint64_t Y_MASK = X_MASK << 1;
+	inline constexpr uint64_t Z_MASK = X_MASK << 2;
+
+	/// <summary>
+	/// Spreads the lower 21 bits of v so that there are two zero bits between each of them.
+	/// </summary>
+	inline uint64_t Spread(uint32_t v) {
+#if defined(__BMI2__)
+		return _pdep_u64(v, X_MASK);
+#else
+		uint64_t x = v & 0x1FFFFF;
+		x = (x | x << 32) & 0x001F00000000FFFFull;
+		x = (x | x << 16) & 0x001F0000FF0000FFull;
+		x = (x | x << 8) & 0x100F00F00F00F00Full;
+		x = (x | x << 4) & 0x10C30C30C30C30C3ull;
+		x = (x | x << 2) & 0x1249249249249249ull;
+		return x;
+#endif
+	}
+
+	/// <summary>
+	/// Inverse of Spread().
+	/// </summary>
+	inline uint32_t Compact(uint64_t x) {
+#if defined(__BMI2__)
+		return (uint32_t)_pext_u64(x, X_MASK);
+#else
+		x &= 0x1249249249249249ull;
+		x = (x | x >> 2) & 0x10C30C30C30C30C3ull;
+		x = (x | x >> 4) & 0x100F00F00F00F00Full;
+		x = (x | x >> 8) & 0x001F0000FF0000FFull;
+		x = (x | x >> 16) & 0x001F00000000FFFFull;
+		x = (x | x >> 32) & 0x1FFFFF;
+		return (uint32_t)x;
+#endif
+	}
+
+	inline uint64_t Encode(const ivec3& v) {
+		return Spread((uint32_t)(v.x + BIAS)) | Spread((uint32_t)(v.y + BIAS)) << 1 | Spread((uint32_t)(v.z + BIAS)) << 2;
+	}
+
+	inline ivec3 Decode(uint64_t code) {
+		return ivec3{
+			(int32_t)Compact(code) - BIAS,
+			(int32_t)Compact(code >> 1) - BIAS,
+			(int32_t)Compact(code >> 2) - BIAS,
+		};
+	}
+
+	/// <summary>
+	/// Encodes an offset for Add(). Negative components are stored in two's complement, without bias.
+	/// </summary>
+	inline uint64_t EncodeOffset(const ivec3& v) {
+		return Spread((uint32_t)v.x) | Spread((uint32_t)v.y) << 1 | Spread((uint32_t)v.z) << 2;
+	}
+
+	/// <summary>
+	/// Returns Encode(Decode(code) + offset) without decoding.
+	/// </summary>
+	/// <param name="offset">Offset encoded by EncodeOffset()</param>
+	inline uint64_t Add(uint64_t code, uint64_t offset) {
+		/*
+		 * Adding within one axis works like regular addition if the carry can travel over the bits of the other two axes:
+		 * setting those bits in one operand to 1 passes the carry on, masking them off afterwards removes them again.
+		 */
+		auto x = ((code | ~X_MASK) + (offset & X_MASK)) & X_MASK;
+		auto y = ((code | ~Y_MASK) + (offset & Y_MASK)) & Y_MASK;
+		auto z = ((code | ~Z_MASK) + (offset & Z_MASK)) & Z_MASK;
+		return x | y | z;
+	}
+
+}
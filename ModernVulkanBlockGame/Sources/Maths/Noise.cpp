@@ -0,0 +1,177 @@
+#include "Noise.h"
+
+// Keeps the compiler from fusing multiplies and adds, see Noise.h. GCC takes -ffp-contract=off instead.
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Noise {
+
+	/*
+	 * Floats and Ints hold one value for every point of a batch. The noise functions below are written once in terms of them,
+	 * the two implementations only differ in how a single operation is carried out.
+	 */
+#if defined(__AVX2__)
+	struct Floats { __m256 v; };
+	struct Ints { __m256i v; };
+
+	static Floats Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+	static void Store(float* p, Floats a) { _mm256_storeu_ps(p, a.v); }
+	static Floats Splat(float f) { return { _mm256_set1_ps(f) }; }
+	static Ints Splat(uint32_t i) { return { _mm256_set1_epi32((int32_t)i) }; }
+
+	static Floats operator+(Floats a, Floats b) { return { _mm256_add_ps(a.v, b.v) }; }
+	static Floats operator-(Floats a, Floats b) { return { _mm256_sub_ps(a.v, b.v) }; }
+	static Floats operator*(Floats a, Floats b) { return { _mm256_mul_ps(a.v, b.v) }; }
+	static Floats Floor(Floats a) { return { _mm256_floor_ps(a.v) }; }
+	static Ints ToInts(Floats a) { return { _mm256_cvttps_epi32(a.v) }; }
+	static Floats ToFloats(Ints a) { return { _mm256_cvtepi32_ps(a.v) }; }
+
+	static Ints operator+(Ints a, Ints b) { return { _mm256_add_epi32(a.v, b.v) }; }
+	static Ints operator*(Ints a, Ints b) { return { _mm256_mullo_epi32(a.v, b.v) }; }
+	static Ints operator^(Ints a, Ints b) { return { _mm256_xor_si256(a.v, b.v) }; }
+	template<int SHIFT>
+	static Ints ShiftRight(Ints a) { return { _mm256_srli_epi32(a.v, SHIFT) }; }
+#else
+	struct Floats { float v[WIDTH]; };
+	struct Ints { uint32_t v[WIDTH]; };
+
+	static Floats Load(const float* p) { Floats r; for (uint32_t i = 0; i < WIDTH; i++) r.v[i] = p[i]; return r; }
+	static void Store(float* p, Floats a) { for (uint32_t i = 0; i < WIDTH; i++) p[i] = a.v[i]; }
+	static Floats Splat(float f) { Floats r; for (uint32_t i = 0; i < WIDTH; i++) r.v[i] = f; return r; }
+	static Ints Splat(uint32_t n) { Ints r; for (uint32_t i = 0; i < WIDTH; i++) r.v[i] = n; return r; }
+
+	static Floats operator+(Floats a, Floats b) { for (uint32_t i = 0; i < WIDTH; i++) a.v[i] += b.v[i]; return a; }
+	static Floats operator-(Floats a, Floats b) { for (uint32_t i = 0; i < WIDTH; i++) a.v[i] -= b.v[i]; return a; }
+	static Floats operator*(Floats a, Floats b) { for (uint32_t i = 0; i < WIDTH; i++) a.v[i] *= b.v[i]; return a; }
+	// Truncating and correcting negative values vectorizes with SSE2 already, unlike std::floor(). Coordinates are far below 2^31.
+	static Floats Floor(Floats a) {
+		for (uint32_t i = 0; i < WIDTH; i++) {
+			auto t = (float)(int32_t)a.v[i];
+			a.v[i] = t > a.v[i] ? t - 1.0f : t;
+		}
+		return a;
+	}
+	static Ints ToInts(Floats a) { Ints r; for (uint32_t i = 0; i < WIDTH; i++) r.v[i] = (uint32_t)(int32_t)a.v[i]; return r; }
+	static Floats ToFloats(Ints a) { Floats r; for (uint32_t i = 0; i < WIDTH; i++) r.v[i] = (float)(int32_t)a.v[i]; return r; }
+
+	static Ints operator+(Ints a, Ints b) { for (uint32_t i = 0; i < WIDTH; i++) a.v[i] += b.v[i]; return a; }
+	static Ints operator*(Ints a, Ints b) { for (uint32_t i = 0; i < WIDTH; i++) a.v[i] *= b.v[i]; return a; }
+	static Ints operator^(Ints a, Ints b) { for (uint32_t i = 0; i < WIDTH; i++) a.v[i] ^= b.v[i]; return a; }
+	template<int SHIFT>
+	static Ints ShiftRight(Ints a) { for (uint32_t i = 0; i < WIDTH; i++) a.v[i] >>= SHIFT; return a; }
+#endif
+
+	/// <summary>
+	/// Multipliers spreading the lattice coordinates over the hash input, one per axis.
+	/// </summary>
+	static constexpr uint32_t PRIME_X = 0x8DA6B343u;
+	static constexpr uint32_t PRIME_Y = 0xD8163841u;
+	static constexpr uint32_t PRIME_Z = 0xCB1AB31Fu;
+	/// <summary>
+	/// Added to the seed for every octave, so octaves don't share their lattice values.
+	/// </summary>
+	static constexpr uint32_t OCTAVE_SEED_STEP = 0x9E3779B9u;
+
+	/// <summary>
+	/// Turns the combined seed and coordinates of a lattice point into its value in [-1, 1].
+	/// </summary>
+	static Floats Hash(Ints h) {
+		h = h * Splat(0x27D4EB2Du);
+		h = h ^ ShiftRight<15>(h);
+		h = h * Splat(0x2C1B3C6Du);
+		h = h ^ ShiftRight<13>(h);
+		// The top 24 bits convert to float exactly.
+		return ToFloats(ShiftRight<8>(h)) * Splat(2.0f / 16777215.0f) - Splat(1.0f);
+	}
+
+	/// <summary>
+	/// 6t^5 - 15t^4 + 10t^3, whose first and second derivatives are 0 at both ends, so there are no visible creases at lattice lines.
+	/// </summary>
+	static Floats Fade(Floats t) {
+		return t * t * t * (t * (t * Splat(6.0f) - Splat(15.0f)) + Splat(10.0f));
+	}
+
+	static Floats Lerp(Floats a, Floats b, Floats t) {
+		return a + t * (b - a);
+	}
+
+	static Floats Value2D(Ints seed, Floats x, Floats z) {
+		auto fx = Floor(x), fz = Floor(z);
+		auto ux = Fade(x - fx), uz = Fade(z - fz);
+		// (i + 1) * PRIME is i * PRIME + PRIME, so every axis needs a single multiplication.
+		auto hx0 = ToInts(fx) * Splat(PRIME_X), hx1 = hx0 + Splat(PRIME_X);
+		auto hz0 = ToInts(fz) * Splat(PRIME_Z), hz1 = hz0 + Splat(PRIME_Z);
+		auto z0 = Lerp(Hash(seed ^ hx0 ^ hz0), Hash(seed ^ hx1 ^ hz0), ux);
+		auto z1 = Lerp(Hash(seed ^ hx0 ^ hz1), Hash(seed ^ hx1 ^ hz1), ux);
+		return Lerp(z0, z1, uz);
+	}
+
+	static Floats Value3D(Ints seed, Floats x, Floats y, Floats z) {
+		auto fx = Floor(x), fy = Floor(y), fz = Floor(z);
+		auto ux = Fade(x - fx), uy = Fade(y - fy), uz = Fade(z - fz);
+		auto hx0 = ToInts(fx) * Splat(PRIME_X), hx1 = hx0 + Splat(PRIME_X);
+		auto hy0 = ToInts(fy) * Splat(PRIME_Y), hy1 = hy0 + Splat(PRIME_Y);
+		auto hz0 = ToInts(fz) * Splat(PRIME_Z), hz1 = hz0 + Splat(PRIME_Z);
+		auto s0 = seed ^ hz0, s1 = seed ^ hz1;
+		auto y0z0 = Lerp(Hash(s0 ^ hy0 ^ hx0), Hash(s0 ^ hy0 ^ hx1), ux);
+		auto y1z0 = Lerp(Hash(s0 ^ hy1 ^ hx0), Hash(s0 ^ hy1 ^ hx1), ux);
+		auto y0z1 = Lerp(Hash(s1 ^ hy0 ^ hx0), Hash(s1 ^ hy0 ^ hx1), ux);
+		auto y1z1 = Lerp(Hash(s1 ^ hy1 ^ hx0), Hash(s1 ^ hy1 ^ hx1), ux);
+		return Lerp(Lerp(y0z0, y1z0, uy), Lerp(y0z1, y1z1, uy), uz);
+	}
+
+	/// <summary>
+	/// Sums the octaves of fn, normalized so the result stays within [-1, 1].
+	/// </summary>
+	template<typename Fn>
+	static Floats Sum(uint32_t seed, const Fractal& fractal, Fn&& fn) {
+		auto sum = Splat(0.0f);
+		float frequency = fractal.frequency, amplitude = 1.0f, total = 0.0f;
+		for (uint32_t o = 0; o < fractal.octaves; o++) {
+			sum = sum + fn(Splat(seed + o * OCTAVE_SEED_STEP), Splat(frequency)) * Splat(amplitude);
+			total += amplitude;
+			frequency *= fractal.lacunarity;
+			amplitude *= fractal.gain;
+		}
+		return total > 0.0f ? sum * Splat(1.0f / total) : sum;
+	}
+
+	void Evaluate2D(uint32_t seed, const Fractal& fractal, const float* x, const float* z, float* out) {
+		auto px = Load(x), pz = Load(z);
+		Store(out, Sum(seed, fractal, [&](Ints s, Floats f) { return Value2D(s, px * f, pz * f); }));
+	}
+
+	void Evaluate3D(uint32_t seed, const Fractal& fractal, const float* x, const float* y, const float* z, float* out) {
+		auto px = Load(x), py = Load(y), pz = Load(z);
+		Store(out, Sum(seed, fractal, [&](Ints s, Floats f) { return Value3D(s, px * f, py * f, pz * f); }));
+	}
+
+	float Evaluate2D(uint32_t seed, const Fractal& fractal, float x, float z) {
+		float px[WIDTH], pz[WIDTH], out[WIDTH];
+		for (uint32_t i = 0; i < WIDTH; i++) {
+			px[i] = x;
+			pz[i] = z;
+		}
+		Evaluate2D(seed, fractal, px, pz, out);
+		return out[0];
+	}
+
+	float Evaluate3D(uint32_t seed, const Fractal& fractal, float x, float y, float z) {
+		float px[WIDTH], py[WIDTH], pz[WIDTH], out[WIDTH];
+		for (uint32_t i = 0; i < WIDTH; i++) {
+			px[i] = x;
+			py[i] = y;
+			pz[i] = z;
+		}
+		Evaluate3D(seed, fractal, px, py, pz, out);
+		return out[0];
+	}
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Value noise: every point of the integer lattice gets a pseudo random value in [-1, 1] by hashing its coordinates together with a seed,
+ * and the values in between are interpolated along a smooth curve. Summing several octaves of increasing frequency and decreasing amplitude
+ * (fractal noise) gives large features with smaller and smaller details on top.
+ *
+ * Terrain generation evaluates millions of points, so noise is always evaluated for a batch of WIDTH points at once.
+ * With AVX2 (make avx2=1) a batch fits into 256 bit registers. Otherwise the same code runs on plain arrays, which the compiler
+ * vectorizes with whatever instructions are available. Both do the same operations in the same order and never fuse a multiply and an add,
+ * so their results are bit-identical: a seed produces the same world on every build and every thread.
+ * Compilers would fuse them on their own when targeting a CPU with FMA, so contraction is turned off: -ffp-contract=off in the Makefile,
+ * and a pragma in Noise.cpp and TerrainGenerator.cpp for compilers that don't take the flag.
+ */
+namespace Noise {
+
+	inline constexpr uint32_t WIDTH = 8;
+	/// <summary>
+	/// Which of the implementations was compiled in, for reports.
+	/// </summary>
+#if defined(__AVX2__)
+	inline constexpr const char* IMPLEMENTATION = "AVX2";
+#else
+	inline constexpr const char* IMPLEMENTATION = "portable";
+#endif
+
+	struct Fractal {
+		uint32_t octaves = 4;
+		/// <summary>
+		/// Lattice points per unit of the first octave.
+		/// </summary>
+		float frequency = 1.0f / 64.0f;
+		/// <summary>
+		/// Frequency multiplier from one octave to the next.
+		/// </summary>
+		float lacunarity = 2.0f;
+		/// <summary>
+		/// Amplitude multiplier from one octave to the next.
+		/// </summary>
+		float gain = 0.5f;
+	};
+
+	/// <summary>
+	/// Evaluates fractal noise at WIDTH points of a plane.
+	/// </summary>
+	/// <param name="x">WIDTH coordinates</param>
+	/// <param name="out">Receives WIDTH values in [-1, 1]</param>
+	void Evaluate2D(uint32_t seed, const Fractal& fractal, const float* x, const float* z, float* out);
+	/// <summary>
+	/// Evaluates fractal noise at WIDTH points in space.
+	/// </summary>
+	/// <param name="x">WIDTH coordinates</param>
+	/// <param name="out">Receives WIDTH values in [-1, 1]</param>
+	void Evaluate3D(uint32_t seed, const Fractal& fractal, const float* x, const float* y, const float* z, float* out);
+
+	/// <summary>
+	/// Evaluates fractal noise at a single point, same result as the batched version.
+	/// </summary>
+	[[nodiscard]] float Evaluate2D(uint32_t seed, const Fractal& fractal, float x, float z);
+	[[nodiscard]] float Evaluate3D(uint32_t seed, const Fractal& fractal, float x, float y, float z);
+
+}
@@ -200,6 +200,26 @@ struct Quaternion {
 		};
 	}
 
+	/// <summary>
+	/// Normalized linear interpolation between the rotations a and b along the shortest path.
+	/// </summary>
+	static Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t) {
+		/*
+		 * q and -q (all four components negated, unlike Negate()) represent the same rotation. If the dot product is negative,
+		 * interpolating towards b would take the long way around, so we interpolate towards -b instead.
+		 * Unlike slerp, the angular velocity is not constant over t, but for the small steps between two simulation ticks
+		 * the difference is invisible, and it needs no trigonometry.
+		 */
+		float s = a.Dot(b) < 0.0f ? -t : t;
+		float u = 1.0f - t;
+		return Quaternion{
+			a.x * u + b.x * s,
+			a.y * u + b.y * s,
+			a.z * u + b.z * s,
+			a.w * u + b.w * s,
+		}.Normalize();
+	}
+
 	bool operator==(const Quaternion& r) const = default;
 	
 };
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+#include "vec3.h"
+#include "Quaternion.h"
+#include "mat4.h"
+
+/// <summary>
+/// Position, rotation and scale of an object.
+/// </summary>
+struct Transform {
+	vec3 position;
+	Quaternion rotation;
+	vec3 scale;
+
+	/// <summary>
+	/// Creates the identity Transform
+	/// </summary>
+	Transform()
+		: position{}, rotation{}, scale{1.0f, 1.0f, 1.0f}
+	{ }
+
+	Transform(const vec3& position, const Quaternion& rotation, const vec3& scale)
+		: position{position}, rotation{rotation}, scale{scale}
+	{ }
+
+	mat4 LocalToWorld() const {
+		return mat4::LocalToWorld(position, rotation, scale);
+	}
+
+	/// <summary>
+	/// Interpolates count transforms at once: out[i] is from[i] for t = 0 and to[i] for t = 1.
+	/// </summary>
+	/// <remarks>
+	/// Every element is independent of the others and t is shared, so the loop has no branches besides the sign in Nlerp(),
+	/// which lets the compiler keep t and 1 - t in registers and pipeline the square roots of consecutive elements.
+	/// </remarks>
+	static void Interpolate(const Transform* from, const Transform* to, float t, Transform* out, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			out[i].position = vec3::Lerp(from[i].position, to[i].position, t);
+			out[i].rotation = Quaternion::Nlerp(from[i].rotation, to[i].rotation, t);
+			out[i].scale = vec3::Lerp(from[i].scale, to[i].scale, t);
+		}
+	}
+
+	bool operator==(const Transform& r) const = default;
+
+};
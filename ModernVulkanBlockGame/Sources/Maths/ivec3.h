@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "vec3.h"
+
+/// <summary>
+/// Integer vector, e.g. the coordinate of a block or a chunk.
+/// </summary>
+struct ivec3 {
+	int32_t x, y, z;
+
+	constexpr ivec3()
+		: x{}, y{}, z{}
+	{ }
+
+	constexpr ivec3(int32_t x, int32_t y, int32_t z)
+		: x{ x }, y{ y }, z{ z }
+	{ }
+
+	/// <summary>
+	/// Rounds every component towards negative infinity, so e.g. -0.5 belongs to block -1, not block 0.
+	/// </summary>
+	static ivec3 Floor(const vec3& v) {
+		return ivec3{ (int32_t)std::floor(v.x), (int32_t)std::floor(v.y), (int32_t)std::floor(v.z) };
+	}
+
+	vec3 ToVec3() const {
+		return vec3{ (float)x, (float)y, (float)z };
+	}
+
+	constexpr ivec3 operator+(const ivec3& r) const {
+		return ivec3{ x + r.x, y + r.y, z + r.z };
+	}
+	constexpr ivec3 operator-(const ivec3& r) const {
+		return ivec3{ x - r.x, y - r.y, z - r.z };
+	}
+	constexpr ivec3 operator*(int32_t r) const {
+		return ivec3{ x * r, y * r, z * r };
+	}
+
+	constexpr ivec3& operator+=(const ivec3& r) {
+		x += r.x;
+		y += r.y;
+		z += r.z;
+		return *this;
+	}
+	constexpr ivec3& operator-=(const ivec3& r) {
+		x -= r.x;
+		y -= r.y;
+		z -= r.z;
+		return *this;
+	}
+
+	constexpr ivec3 operator-() const {
+		return ivec3{ -x, -y, -z };
+	}
+
+	constexpr bool operator==(const ivec3& b) const = default;
+
+};
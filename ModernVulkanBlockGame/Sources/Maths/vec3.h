@@ -128,6 +128,17 @@ struct vec3 {
 		return Negated();
 	}
 
+	/// <summary>
+	/// Linear interpolation between a and b, returns a for t = 0 and b for t = 1.
+	/// </summary>
+	static vec3 Lerp(const vec3& a, const vec3& b, float t) {
+		return vec3{
+			a.x + (b.x - a.x) * t,
+			a.y + (b.y - a.y) * t,
+			a.z + (b.z - a.z) * t,
+		};
+	}
+
 	bool operator==(const vec3& b) const = default;
 
 };